@@ -0,0 +1,166 @@
+#include "stdafx.h"
+#include "GameBundle.h"
+#include <AssetBundle.h>
+#include <TextureManager.h>
+#include <SDL.h>
+#include <SDL_image.h>
+#include <SDL_mixer.h>
+#include <boost/filesystem.hpp>
+#include <algorithm>
+#include <cctype>
+
+namespace GameBundle
+{
+	namespace
+	{
+		const std::string levelPrefix = "Levels/";
+		const std::string levelExtension = ".Level";
+
+		std::string Lower(std::string _text)
+		{
+			std::transform(_text.begin(), _text.end(), _text.begin(), ::tolower);
+			return _text;
+		}
+
+		//Names of the files in _directory with extension _extension, ignoring case
+		void ListFiles(std::string _directory, std::string _extension, std::vector<std::string>& _files)
+		{
+			if(!boost::filesystem::exists(_directory))
+				return;
+			boost::filesystem::directory_iterator end_itr;
+			for(boost::filesystem::directory_iterator itr = boost::filesystem::directory_iterator(_directory);
+				itr != end_itr;
+				++itr)
+			{
+				if(boost::filesystem::is_regular((itr->status())) &&
+				   Lower(boost::filesystem::extension(*itr)) == Lower(_extension))
+				{
+					_files.push_back(itr->path().leaf());
+				}
+			}
+			std::sort(_files.begin(), _files.end());
+		}
+
+		void AddImages(AssetBundleWriter& _writer)
+		{
+			std::vector<std::string> files;
+			ListFiles("./Animations", ".png", files);
+			for(std::vector<std::string>::iterator it = files.begin(); it != files.end(); ++it)
+			{
+				std::string path = "Animations/" + *it;
+				SDL_Surface* loaded = IMG_Load(path.c_str());
+				SDL_Surface* converted = loaded ? SDL_DisplayFormatAlpha(loaded) : NULL;
+				if(converted)
+					_writer.AddImage(path, converted);
+				else
+					Logger::ErrorOut() << "Unable to bundle image " << path << "\n";
+				SDL_FreeSurface(converted);
+				SDL_FreeSurface(loaded);
+			}
+		}
+
+		void AddAnimationSets(AssetBundleWriter& _writer)
+		{
+			std::vector<std::string> files;
+			ListFiles("./Animations", ".animation", files);
+			for(std::vector<std::string>::iterator it = files.begin(); it != files.end(); ++it)
+			{
+				AnimationSetDescription description;
+				if(!TextureManager::ReadAnimationSet(*it, description))
+				{
+					Logger::ErrorOut() << "Unable to bundle animation set " << *it << "\n";
+					continue;
+				}
+				std::vector<char> data;
+				description.Write(data);
+				_writer.AddData("Animations/" + *it, AssetType::Data, &data[0], static_cast<unsigned int>(data.size()));
+			}
+		}
+
+		void AddSounds(AssetBundleWriter& _writer)
+		{
+			int frequency = 0;
+			Uint16 format = 0;
+			int channels = 0;
+			if(!Mix_QuerySpec(&frequency, &format, &channels))
+			{
+				Logger::ErrorOut() << "Audio isn't open, no sounds bundled\n";
+				return;
+			}
+			std::vector<std::string> files;
+			ListFiles("./Sounds", ".wav", files);
+			for(std::vector<std::string>::iterator it = files.begin(); it != files.end(); ++it)
+			{
+				std::string path = "Sounds/" + *it;
+				Mix_Chunk* sample = Mix_LoadWAV(path.c_str());
+				if(!sample)
+				{
+					Logger::ErrorOut() << "Unable to bundle sound " << path << "\n";
+					continue;
+				}
+				_writer.AddData(path, AssetType::Sound, sample->abuf, sample->alen, frequency, format, channels);
+				Mix_FreeChunk(sample);
+			}
+		}
+
+		void AddLevels(AssetBundleWriter& _writer)
+		{
+			std::vector<std::string> files;
+			ListFiles("./Levels", levelExtension, files);
+			for(std::vector<std::string>::iterator it = files.begin(); it != files.end(); ++it)
+			{
+				std::vector<LevelBrick> bricks;
+				if(!Wall::ReadLevel(*it, bricks))
+					continue;
+				_writer.AddData(levelPrefix + *it, AssetType::Data, bricks.empty() ? NULL : &bricks[0],
+								static_cast<unsigned int>(bricks.size() * sizeof(LevelBrick)));
+			}
+		}
+	}
+
+	bool Write(std::string _path)
+	{
+		AssetBundleWriter writer;
+		AddImages(writer);
+		AddAnimationSets(writer);
+		AddSounds(writer);
+		AddLevels(writer);
+		if(!writer.Write(_path))
+			return false;
+		Logger::DiagnosticOut() << "Bundled " << writer.GetCount() << " assets into " << _path << "\n";
+		return true;
+	}
+
+	bool Mount(std::string _path)
+	{
+		if(!AssetBundle::Instance().Open(_path))
+			return false;
+		Logger::DiagnosticOut() << "Asset bundle " << _path << ": " << AssetBundle::Instance().GetCount() <<
+								   " assets, " << AssetBundle::Instance().GetSize() / 1024 << "KB mapped\n";
+		return true;
+	}
+
+	Wall::SharedPointer LoadWall(std::string _filename)
+	{
+		const AssetBundle::Entry* entry = AssetBundle::Instance().Find(levelPrefix + _filename);
+		if(entry && entry->type == AssetType::Data && entry->size % sizeof(LevelBrick) == 0)
+		{
+			const LevelBrick* bricks = reinterpret_cast<const LevelBrick*>(AssetBundle::Instance().GetData(entry));
+			return Wall::SharedPointer(new Wall(bricks, entry->size / sizeof(LevelBrick)));
+		}
+		return Wall::SharedPointer(new Wall(_filename));
+	}
+
+	void FindLevels(std::vector<std::string>& _levels)
+	{
+		ListFiles("./Levels", levelExtension, _levels);
+		std::vector<std::string> bundled;
+		AssetBundle::Instance().List(levelPrefix, levelExtension, bundled);
+		for(std::vector<std::string>::iterator it = bundled.begin(); it != bundled.end(); ++it)
+		{
+			_levels.push_back(it->substr(levelPrefix.size()));
+		}
+		std::sort(_levels.begin(), _levels.end());
+		_levels.erase(std::unique(_levels.begin(), _levels.end()), _levels.end());
+	}
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <Wall.h>
+#include <string>
+#include <vector>
+
+/* The game's assets prebaked into one AssetBundle: images converted to display format,
+   animation sets and levels compiled to binary, and sounds as PCM in the mixer's format.
+   Anything not in the bundle still loads from the loose files in Animations, Sounds and Levels */
+namespace GameBundle
+{
+	//Bundles every loose asset. Needs the video mode set and the mixer open, as the bundle is in their formats
+	bool Write(std::string _path);
+	//Opens _path as the AssetBundle the caches look in
+	bool Mount(std::string _path);
+
+	//From the bundle if it has the level, otherwise from the file in Levels
+	Wall::SharedPointer LoadWall(std::string _filename);
+	//Level file names from both the bundle and Levels, in order, each once
+	void FindLevels(std::vector<std::string>& _levels);
+}
@@ -0,0 +1,141 @@
+#include "stdafx.h"
+#include "GameSimulation.h"
+#include <FrameScheduler.h>
+#include <SDL.h>
+#include "Logger.h"
+
+GameSimulation::GameSimulation(ArkGame::SharedPointer game) :
+	mGame(game),
+	mThread(NULL),
+	mInputMutex(SDL_CreateMutex()),
+	mStopping(false),
+	mPaused(false),
+	mWallXPending(false),
+	mWallX(0),
+	mTicks(0)
+{
+	//Something to draw before the first tick
+	mGame->FillSnapshot(mSnapshots.GetWriteBuffer());
+	mSnapshots.Publish();
+}
+
+GameSimulation::~GameSimulation(void)
+{
+	Stop();
+	SDL_DestroyMutex(mInputMutex);
+}
+
+void GameSimulation::Start()
+{
+	if(mThread)
+		return;
+	mStopping = false;
+	mThread = SDL_CreateThread(&GameSimulation::ThreadMain, this);
+	if(!mThread)
+		Logger::ErrorOut() << "Unable to start the game simulation thread, ticking on the main thread instead\n";
+}
+
+void GameSimulation::Stop()
+{
+	if(!mThread)
+		return;
+	SDL_mutexP(mInputMutex);
+	mStopping = true;
+	SDL_mutexV(mInputMutex);
+	SDL_WaitThread(mThread, NULL);
+	mThread = NULL;
+}
+
+int GameSimulation::ThreadMain(void* simulation)
+{
+	static_cast<GameSimulation*>(simulation)->Run();
+	return 0;
+}
+
+void GameSimulation::Run()
+{
+	FrameScheduler scheduler(TICK_RATE);
+	float timespan = static_cast<float>(scheduler.GetPeriod());
+	while(WaitWhilePaused())
+	{
+		Step(timespan);
+		scheduler.EndFrame();
+	}
+}
+
+/* Sleeps while paused. False once the thread should stop */
+bool GameSimulation::WaitWhilePaused()
+{
+	while(true)
+	{
+		SDL_mutexP(mInputMutex);
+		bool stopping = mStopping;
+		bool paused = mPaused;
+		SDL_mutexV(mInputMutex);
+		if(stopping)
+			return false;
+		if(!paused)
+			return true;
+		SDL_Delay(10);
+	}
+}
+
+void GameSimulation::Step(float timespan)
+{
+	SDL_mutexP(mInputMutex);
+	if(mWallXPending && mGame->GetWall().get())
+		mGame->GetWall()->SetX(mWallX);
+	mWallXPending = false;
+	SDL_mutexV(mInputMutex);
+
+	mGame->Tick(timespan);
+	std::vector<std::string> sounds = mGame->GetSoundsDue();
+
+	SDL_mutexP(mInputMutex);
+	mSoundsDue.insert(mSoundsDue.end(), sounds.begin(), sounds.end());
+	mTicks++;
+	unsigned int ticks = mTicks;
+	SDL_mutexV(mInputMutex);
+
+	RenderSnapshot& snapshot = mSnapshots.GetWriteBuffer();
+	mGame->FillSnapshot(snapshot);
+	snapshot.mSequence = ticks;
+	mSnapshots.Publish();
+}
+
+void GameSimulation::SetWallX(float x)
+{
+	SDL_mutexP(mInputMutex);
+	mWallX = x;
+	mWallXPending = true;
+	SDL_mutexV(mInputMutex);
+}
+
+void GameSimulation::SetPaused(bool paused)
+{
+	SDL_mutexP(mInputMutex);
+	mPaused = paused;
+	SDL_mutexV(mInputMutex);
+}
+
+void GameSimulation::TakeSoundsDue(std::vector<std::string>& sounds)
+{
+	SDL_mutexP(mInputMutex);
+	sounds.insert(sounds.end(), mSoundsDue.begin(), mSoundsDue.end());
+	mSoundsDue.clear();
+	SDL_mutexV(mInputMutex);
+}
+
+const RenderSnapshot& GameSimulation::GetSnapshot()
+{
+	mSnapshots.Acquire();
+	return mSnapshots.GetReadBuffer();
+}
+
+unsigned int GameSimulation::GetTicks()
+{
+	SDL_mutexP(mInputMutex);
+	unsigned int ticks = mTicks;
+	SDL_mutexV(mInputMutex);
+	return ticks;
+}
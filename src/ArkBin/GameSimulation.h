@@ -0,0 +1,62 @@
+#pragma once
+#include <ArkGame.h>
+#include <RenderSnapshot.h>
+#include <TripleBuffer.h>
+#include <vector>
+#include <string>
+
+struct SDL_Thread;
+struct SDL_mutex;
+
+/* Runs an ArkGame and publishes a RenderSnapshot after every tick.
+   Single threaded, the mode calls Step each frame. Started as a thread, the game ticks at its own
+   fixed rate while the main thread draws whichever snapshot is newest, so a slow tick and a slow
+   draw no longer hold each other up. SDL video and mixer calls all stay on the main thread: input
+   is handed over through SetWallX and SetPaused, and sounds come back through TakeSoundsDue */
+class GameSimulation
+{
+//Constants
+public:
+	static const int TICK_RATE = 50; //Ticks per second when threaded
+//Constructors
+public:
+	GameSimulation(ArkGame::SharedPointer game);
+	~GameSimulation(void);
+//Private members
+private:
+	ArkGame::SharedPointer mGame;
+	TripleBuffer<RenderSnapshot> mSnapshots;
+	SDL_Thread* mThread;
+	SDL_mutex* mInputMutex; //Guards everything below, shared with the main thread
+	bool mStopping;
+	bool mPaused;
+	bool mWallXPending;
+	float mWallX;
+	std::vector<std::string> mSoundsDue;
+	unsigned int mTicks;
+//Private methods
+private:
+	static int ThreadMain(void* simulation);
+	void Run();
+	bool WaitWhilePaused();
+//Public methods
+public:
+	/* Starts ticking on a thread of its own */
+	void Start();
+	/* Waits for the thread to finish its tick and end. Safe to call when not started */
+	void Stop();
+	bool IsThreaded() const {return mThread != NULL;}
+
+	/* Ticks the game once and publishes the result. Only for when not threaded, the thread calls it itself */
+	void Step(float timespan);
+
+	/* Input, taken up at the start of the next tick */
+	void SetWallX(float x);
+	void SetPaused(bool paused);
+	/* Moves the sounds the game has asked for since the last call into sounds */
+	void TakeSoundsDue(std::vector<std::string>& sounds);
+
+	/* Newest snapshot published. Only for the thread that draws */
+	const RenderSnapshot& GetSnapshot();
+	unsigned int GetTicks();
+};
@@ -1,15 +1,41 @@
 #include "stdafx.h"
 #include <sdl.h>
-#include <ctime>
+#include <cstdlib>
+#include <algorithm>
 #include <vmath.h>
 #include <Widget.h>
+#include <ImageCache.h>
+#include <SurfaceBudget.h>
+#include <InputQueue.h>
+#include <FrameScheduler.h>
+#include <HighResClock.h>
+#include <JobSystem.h>
+#include <AssetBundle.h>
+#include <Trace.h>
+#include <AllocationTracker.h>
 #include "IMode.h"
 #include "ModeIntro.h"
+#include "ModeGame.h"
 #include "StandardTextures.h"
 #include "SDLAnimationFrame.h"
+#include "SoundManager.h"
+#include "GameBundle.h"
 
-const float targetFrameTime = 0.02f;
+const unsigned int defaultFrameCap = 50;
+const unsigned int defaultLoadThreads = 3;
+const double loadBudget = 0.004; //Seconds per frame spent finishing loaded assets on the main thread
+const char* defaultBundle = "Ark.bundle";
+const char* traceFile = "Trace.json";
+const unsigned int traceCapacity = 65536; //Events kept, about 4MB
+struct GameSound
+{
+	const char* name;
+	int priority; //Losing a ball must always be heard, another brick bounce can be dropped
+};
+const GameSound gameSounds[] = {{"BrickBounce.wav", 1}, {"BatBounce.wav", 2}, {"BallSplit.wav", 2}, {"BallLost.wav", 3}};
 IMode* gameMode = NULL;
+JobSystem* assetJobs = NULL;
+double startupTime = 0;
 
 
 SDL_Surface* SDL_init(bool grab_input)
@@ -36,14 +62,53 @@ SDL_Surface* SDL_init(bool grab_input)
 	return p_surface;
 }
 
+void StartLoading(unsigned int threads)
+{
+	assetJobs = new JobSystem(threads);
+	StandardTextures::QueueTextures(*assetJobs);
+	ImageCache::Instance().Preload("Animations/NavyButton.png", *assetJobs);
+	for(unsigned int i = 0; i < sizeof(gameSounds) / sizeof(gameSounds[0]); i++)
+	{
+		SampleHandle sample = SoundManager::Instance().Preload(gameSounds[i].name, *assetJobs);
+		SoundManager::Instance().SetPriority(sample, gameSounds[i].priority);
+	}
+}
+
+/* Waits for whatever is still loading, then points the standard textures at what was loaded */
+void FinishLoading()
+{
+	if(!assetJobs)
+		return;
+	assetJobs->WaitAll();
+	StandardTextures::LoadTextures();
+	Logger::DiagnosticOut() << "Startup: assets resident after " << static_cast<int>((HighResClock::Seconds() - startupTime) * 1000) <<
+							   "ms, " << assetJobs->GetCompleted() << " jobs on " << assetJobs->GetWorkerCount() << " threads\n";
+	delete assetJobs;
+	assetJobs = NULL;
+}
+
 bool GameTick(float dt)
 {
+	TraceScope trace("GameTick");
+	if(assetJobs)
+	{
+		assetJobs->Pump(loadBudget);
+		if(assetJobs->IsIdle())
+			FinishLoading();
+	}
 	ModeAction::Enum action = gameMode->Tick(dt);
 	if(action == ModeAction::ChangeMode)
 	{
-		IMode* pendMode = gameMode->Teardown();
-		delete gameMode;
+		//The intro is all that can run before the game's assets are in
+		FinishLoading();
+		IMode* pendMode = NULL;
+		{
+			TraceScope trace("IMode::Teardown");
+			pendMode = gameMode->Teardown();
+			delete gameMode;
+		}
 		gameMode = pendMode;
+		TraceScope trace("IMode::Setup");
 		gameMode->Setup();
 	} else if(action == ModeAction::Exit)
 	{
@@ -55,15 +120,29 @@ bool GameTick(float dt)
 void Draw(SDL_Surface* screenSurface, BlittableRect& screenRect)
 {
 	SDL_FillRect(screenSurface, NULL, 0);
-	gameMode->Draw(screenSurface);
+	{
+		AllocationScope allocations(AllocationTag::Rendering);
+		gameMode->Draw(screenSurface);
+	}
 	Widget::RenderRoot(&screenRect);
+	TraceScope trace("SDL_Flip");
 	SDL_Flip(screenSurface);
 }
 
 int main(int argc, char* argv[])
 {
+	startupTime = HighResClock::Seconds();
+	//Before the loading and simulation threads, which log too
+	Logger::StartWriter();
 	bool bFinished = false;
 	bool bGrab = true;
+	unsigned int loadThreads = defaultLoadThreads;
+	std::string bundle = defaultBundle;
+	std::string makeBundle;
+	unsigned int frames = 0;
+	double pixels_composed = 0;
+	InputQueue input;
+	FrameScheduler scheduler(defaultFrameCap);
 
 	for(int arg = 1; arg < argc; arg++)
 	{
@@ -72,17 +151,96 @@ int main(int argc, char* argv[])
 		{
 			bGrab = false;
 		}
+		//Errors only, diagnostics cost nothing
+		if(!strcmp("-quiet", argv[arg]))
+		{
+			Logger::SetLevel(LogLevel::Error);
+		}
+		//Megabytes of surfaces to keep cached, 0 for no limit
+		if(!strcmp("-surfacebudget", argv[arg]) && arg + 1 < argc)
+		{
+			arg++;
+			SurfaceBudget::Instance().SetCeiling(static_cast<unsigned int>(atoi(argv[arg])) * 1024 * 1024);
+		}
+		//Game simulation on its own thread, overlapping with drawing
+		if(!strcmp("-pipeline", argv[arg]))
+		{
+			ModeGame::SetPipelined(true);
+		}
+		//Frames per second to cap at, 0 to run as fast as possible
+		if(!strcmp("-fps", argv[arg]) && arg + 1 < argc)
+		{
+			arg++;
+			scheduler.SetCap(static_cast<unsigned int>(atoi(argv[arg])));
+		}
+		//Worker threads loading assets at startup, 0 to load them on the main thread
+		if(!strcmp("-loadthreads", argv[arg]) && arg + 1 < argc)
+		{
+			arg++;
+			loadThreads = static_cast<unsigned int>(atoi(argv[arg]));
+		}
+		//Prebaked assets to use before loose files
+		if(!strcmp("-bundle", argv[arg]) && arg + 1 < argc)
+		{
+			arg++;
+			bundle = argv[arg];
+		}
+		//Loose files only
+		if(!strcmp("-nobundle", argv[arg]))
+		{
+			bundle.clear();
+		}
+		//Bakes the loose files into a bundle, then exits
+		if(!strcmp("-makebundle", argv[arg]) && arg + 1 < argc)
+		{
+			arg++;
+			makeBundle = argv[arg];
+		}
+		//Mix sounds ourselves rather than through SDL_mixer
+		if(!strcmp("-softmixer", argv[arg]))
+		{
+			SoundManager::SetSoftwareMixer(true);
+		}
+		//Timeline of frames first to first + count - 1, written to Trace.json for chrome://tracing
+		if(!strcmp("-trace", argv[arg]) && arg + 2 < argc)
+		{
+			unsigned int first = static_cast<unsigned int>(atoi(argv[arg + 1]));
+			unsigned int count = static_cast<unsigned int>(atoi(argv[arg + 2]));
+			arg += 2;
+			Trace::Start(first, count, traceFile, traceCapacity);
+		}
+		//Allocations per frame by subsystem, reported on exit
+		if(!strcmp("-allocstats", argv[arg]))
+		{
+			AllocationTracker::Enable(true);
+		}
 	}
 	
 	SDL_Surface* pScreen = SDL_init(bGrab);
 	BlittableRect screenRect(pScreen, true);
 
-	if(pScreen)
+	if(pScreen && !makeBundle.empty())
 	{
+		//Opening the mixer first puts the sounds in the format it will play them in. The software mixer plays the same format
+		SoundManager::SetSoftwareMixer(false);
+		SoundManager::Instance();
+		GameBundle::Write(makeBundle);
+		bFinished = true;
+	} else if(pScreen)
+	{
+		//Constructed here, bundle or not, before the loading workers could race to do it
+		AssetBundle::Instance();
+		if(!bundle.empty())
+			GameBundle::Mount(bundle);
 		SDLAnimationFrame::screen_ = pScreen;
-		StandardTextures::LoadTextures();
+		//Game assets load while the intro shows. Decoded once here rather than by every mode that builds buttons from them
+		StartLoading(loadThreads);
+		ImageCache::Instance().Preload("Animations/Beta.png");
 		gameMode = new ModeIntro();
-		gameMode->Setup();
+		{
+			TraceScope trace("IMode::Setup");
+			gameMode->Setup();
+		}
 
 		Widget::SetScreenSize(Vector2i(pScreen->w, pScreen->h));
 	} else
@@ -90,33 +248,58 @@ int main(int argc, char* argv[])
 		bFinished = true;
 	}
 	
+	//Game logic steps by the frame period, or by the measured frame time when uncapped
+	float frameTime = scheduler.GetCap() > 0 ? static_cast<float>(scheduler.GetPeriod()) : 1.0f / defaultFrameCap;
+	scheduler.Reset();
 	while(!bFinished)
 	{
-		clock_t start_time = clock();
-		SDL_Event event;
-		while(SDL_PollEvent(&event))
-		{
-			switch(event.type)
-			{
-			case SDL_QUIT:
-				bFinished = true;
-				break;
-			}
-			Widget::DistributeSDLEvents(&event);
-		}
+		input.Poll();
+		bFinished |= input.QuitRequested();
+		input.Dispatch();
 		
-		bFinished |= GameTick(targetFrameTime);
+		bFinished |= GameTick(frameTime);
 		Draw(pScreen, screenRect);
-		clock_t end_time = clock();
-
-		float remainingTime = targetFrameTime - ((float)(end_time - start_time)) / 1000.0f;
-		if(remainingTime > 0)
-		{
-			SDL_Delay(static_cast<int>(remainingTime * 1000));
-		}
+		if(frames == 0)
+			Logger::DiagnosticOut() << "Startup: first frame drawn after " << static_cast<int>((HighResClock::Seconds() - startupTime) * 1000) << "ms\n";
+		frames++;
+		pixels_composed += Widget::GetPixelsComposed();
+		scheduler.EndFrame();
+		Trace::EndFrame();
+		AllocationTracker::EndFrame();
+		//A stall such as dragging the window shouldn't send the game a huge step
+		if(scheduler.GetCap() == 0)
+			frameTime = static_cast<float>(std::min(scheduler.GetLastFrameTime(), 0.1));
 	}
 
+	Logger::DiagnosticOut() << "Image cache hits: " << ImageCache::Instance().GetHits() <<
+							   " misses: " << ImageCache::Instance().GetMisses() << "\n";
+	if(frames > 0)
+		Logger::DiagnosticOut() << "Average pixels composed per frame: " << static_cast<unsigned int>(pixels_composed / frames) << "\n";
+	std::ostringstream surface_report;
+	SurfaceBudget::Instance().Report(surface_report);
+	Logger::DiagnosticOut() << surface_report.str();
+	std::ostringstream frame_report;
+	scheduler.Report(frame_report);
+	Logger::DiagnosticOut() << frame_report.str();
+	std::ostringstream sound_report;
+	SoundManager::Instance().Report(sound_report);
+	Logger::DiagnosticOut() << sound_report.str();
+	if(AllocationTracker::IsEnabled())
+	{
+		std::ostringstream allocation_report;
+		AllocationTracker::Report(allocation_report);
+		Logger::DiagnosticOut() << allocation_report.str();
+	}
+	const InputStats& input_stats = input.GetTotalStats();
+	Logger::DiagnosticOut() << "Input events received: " << input_stats.received <<
+							   " dispatched: " << input_stats.dispatched <<
+							   " mouse moves merged: " << input_stats.motion_coalesced <<
+							   " worst latency: " << static_cast<int>(input_stats.max_latency * 1000) << "ms\n";
+	delete assetJobs;
+	ImageCache::Instance().Purge();
 	SDL_Quit();
+	Trace::Finish();
+	Logger::StopWriter();
 	return 0;
 }
 
@@ -6,18 +6,49 @@
 #include "StandardTextures.h"
 #include <boost/lexical_cast.hpp>
 #include "SoundManager.h"
+#include "GameBundle.h"
 
 using std::vector;
 
+namespace
+{
+	const float spriteStagger = 0.37f; //Seconds between where successive sprites start in their clips
+
+	const Animation* BallClip(const BallSnapshot& /*ball*/)
+	{
+		return StandardTextures::Get(StandardAnimation::Ball);
+	}
+
+	const Animation* BrickClip(const BrickSnapshot& brick)
+	{
+		return StandardTextures::GetBrick(brick.mBrickType, brick.mLives);
+	}
+
+	void DrawPlayhead(const AnimationPlayhead& playhead, Vector2f position)
+	{
+		AnimationFrame* frame = Animation::GetFrame(playhead);
+		if(frame)
+			frame->Draw(position);
+	}
+}
+
+bool ModeGame::pipelined_ = false;
+
 ModeGame::ModeGame(std::string filename) :
-	mGame(new ArkGame())
+	mGame(new ArkGame()),
+	mBallPlayheads(spriteStagger),
+	mBrickPlayheads(spriteStagger)
 {
-	Wall::SharedPointer wall(new Wall(filename));
+	Wall::SharedPointer wall = GameBundle::LoadWall(filename);
 	mGame->SetWall(wall);
+	mSimulation.reset(new GameSimulation(mGame));
+	AnimationPlayhead nothing = {NULL, 0, 0};
+	mPaddlePlayhead = nothing;
 }
 
 IMode* ModeGame::Teardown()
 {
+	mSimulation->Stop();
 	Widget::ClearRoot();
 	return IMode::Teardown();
 }
@@ -37,19 +68,34 @@ void ModeGame::Setup()
 	mMouseMoveKeyback = Widget::OnGlobalMouseMove.connect(boost::bind(&ModeGame::mouseMove, this, _1, _2));
 	back->OnClick.connect(boost::bind(&ModeGame::clickBack, this, _1));
 	betaTag->OnClick.connect(boost::bind(&ModeGame::clickBetaTag, this, _1));
+
+	const Animation* paddle = StandardTextures::Get(StandardAnimation::Paddle);
+	if(paddle)
+		mPaddlePlayhead = paddle->Play(0);
+
+	if(pipelined_)
+		mSimulation->Start();
 }
 
 ModeAction::Enum ModeGame::Tick(float dt)
 {
-	if(!mFeedbackWidget->HasModal())
+	bool paused = mFeedbackWidget->HasModal();
+	if(mSimulation->IsThreaded())
+		mSimulation->SetPaused(paused);
+	if(!paused)
 	{
-		mGame->Tick(dt);
+		if(!mSimulation->IsThreaded())
+			mSimulation->Step(dt);
 
-		std::vector<std::string> sounds_due = mGame->GetSoundsDue();
-		for(std::vector<std::string>::iterator it = sounds_due.begin(); it != sounds_due.end(); ++it)
-		{
-			SoundManager::Instance().PlaySample(*it);
-		}
+		std::vector<std::string> sounds_due;
+		mSimulation->TakeSoundsDue(sounds_due);
+		//All at once, so repeats of a sample in the same tick merge into one voice
+		SoundManager::Instance().PlayEvents(sounds_due);
+
+		//Sprites that appear before the next draw are matched then, starting at their staggered times
+		mBallPlayheads.Advance(dt);
+		mBrickPlayheads.Advance(dt);
+		Animation::Advance(&mPaddlePlayhead, 1, dt);
 
 		ModeAction::Enum result = IMode::Tick(dt);
 		Widget::SetFade(mFade);
@@ -66,63 +112,48 @@ ModeType::Enum ModeGame::GetType()
 
 void ModeGame::Draw(SDL_Surface* screenSurface)
 {
+	//Drawn from a copy of the game's state, which with a pipeline keeps changing on the other thread
+	const RenderSnapshot& snapshot = mSimulation->GetSnapshot();
+
 	//Draw background and score
-	StandardTextures::background_animation->GetFrameByIndex(0)->Draw(Vector2f(0, 0));
-	std::string score_string = boost::lexical_cast<std::string, int>(mGame->GetScore());
+	StandardTextures::Get(StandardAnimation::Background)->GetFrameByIndex(0)->Draw(Vector2f(0, 0));
+	std::string score_string = boost::lexical_cast<std::string, int>(snapshot.mScore);
 	Vector2f score_origin(320 - ((float)score_string.size()) * 40.0f / 2, 350);
 	for(int i = 0; i < score_string.size(); i++)
 	{
 		int val = boost::lexical_cast<int, char>(score_string.at(i));
-		StandardTextures::red_numbers_animation->GetFrameByIndex(val)->Draw(score_origin + Vector2f(i * 40, 0));
+		StandardTextures::Get(StandardAnimation::RedNumbers)->GetFrameByIndex(val)->Draw(score_origin + Vector2f(i * 40, 0));
 	}
 
 
-	vector<Ball::SharedPointer> balls = mGame->GetBalls();
-	for(vector<Ball::SharedPointer>::iterator ball = balls.begin(); ball != balls.end(); ++ball)
+	mBallPlayheads.Match(snapshot.mBalls, &BallClip);
+	mBrickPlayheads.Match(snapshot.mBricks, &BrickClip);
+
+	Animation* trail = StandardTextures::Get(StandardAnimation::BallTrail);
+	for(unsigned int i = 0; i < snapshot.mBalls.size(); i++)
 	{
-		const std::deque<Vector2f> trail = (*ball)->GetTrail();
+		const BallSnapshot& ball = snapshot.mBalls[i];
 		int frame = 0;
-		for(std::deque<Vector2f>::const_iterator it = trail.begin(); it != trail.end(); ++it)
+		for(vector<Vector2f>::const_iterator it = ball.mTrail.begin(); it != ball.mTrail.end(); ++it)
 		{
 			Vector2i trail_inverted_y = *it;
 			trail_inverted_y .y = 480 - trail_inverted_y.y;
-			StandardTextures::ball_trail_animation->GetFrameByIndex(frame++)->Draw(trail_inverted_y);
+			trail->GetFrameByIndex(frame++)->Draw(trail_inverted_y);
 		}
 
-		Vector2i inverted_y = ArkGame::BallToGame(*ball);
+		Vector2i inverted_y = ball.mPosition;
 		inverted_y.y = 480 - inverted_y.y;
-		StandardTextures::ball_animation->GetCurrentFrame()->Draw(inverted_y);
+		DrawPlayhead(mBallPlayheads.Get(i), inverted_y);
 	}
-	if(mGame->GetWall().get())
+	for(unsigned int i = 0; i < snapshot.mBricks.size(); i++)
 	{
-		Wall::SharedPointer wall = mGame->GetWall();
-		vector<Brick::SharedPointer> bricks = wall->GetBricks();
-		for(vector<Brick::SharedPointer>::iterator brick = bricks.begin(); brick != bricks.end(); ++brick)
-		{
-			Animation* sprite;
-			switch((*brick)->GetBrickType())
-			{
-			default:
-			case BrickType::BlueBrick:
-				sprite = StandardTextures::blue_brick_animation[0];
-				break;
-			case BrickType::RedBrick:
-				sprite = StandardTextures::red_brick_animation[(*brick)->GetLives() - 1];
-				break;
-			case BrickType::YellowBrick:
-				sprite = StandardTextures::yellow_brick_animation[(*brick)->GetLives() - 1];
-				break;
-			}
-
-			Vector2i inverted_y = ArkGame::BrickToGame(*brick, wall);
-			inverted_y.y = 480 - inverted_y.y;
-			sprite->GetCurrentFrame()->Draw(inverted_y);
-		}
+		Vector2i inverted_y = snapshot.mBricks[i].mPosition;
+		inverted_y.y = 480 - inverted_y.y;
+		DrawPlayhead(mBrickPlayheads.Get(i), inverted_y);
 	}
-	Paddle::SharedPointer paddle = mGame->GetPaddle();
-	Vector2i inverted_y = ArkGame::PaddleToGame(paddle);
+	Vector2i inverted_y = snapshot.mPaddle;
 	inverted_y.y = 480 - inverted_y.y;
-	StandardTextures::paddle_animation->GetCurrentFrame()->Draw(inverted_y);
+	DrawPlayhead(mPaddlePlayhead, inverted_y);
 
 	
 }
@@ -143,7 +174,8 @@ void ModeGame::mouseMove(Widget* /*widget*/, MouseEventArgs args)
 	Wall::SharedPointer wall = mGame->GetWall();
 	if(wall.get())
 	{
+		//The wall is moved by the simulation, which may be ticking on another thread. Its bounds are fixed once set
 		Vector2f offset((Widget::GetScreenSize().x - wall->GetBounds().x) / 2 + 2 * Brick::BRICK_WIDTH, 0);
-		wall->SetX(args.x - offset.x);
+		mSimulation->SetWallX(args.x - offset.x);
 	}
 }
\ No newline at end of file
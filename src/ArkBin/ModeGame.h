@@ -2,6 +2,9 @@
 #include "IMode.h"
 #include <ArkGame.h>
 #include <Widget.h>
+#include <boost/scoped_ptr.hpp>
+#include "GameSimulation.h"
+#include <Animation.h>
 
 class Widget;
 
@@ -14,8 +17,14 @@ class ModeGame :
 //Private members
 private:
 	ArkGame::SharedPointer mGame;
+	boost::scoped_ptr<GameSimulation> mSimulation;
+	static bool pipelined_;
 	Widget* mFeedbackWidget;
-	boost::signals::scoped_connection mMouseMoveKeyback;
+	ScopedConnection mMouseMoveKeyback;
+	//One playhead per ball and brick, matched to the sprites of the snapshot last drawn by id
+	SpritePlayheads mBallPlayheads;
+	SpritePlayheads mBrickPlayheads;
+	AnimationPlayhead mPaddlePlayhead;
 //Private methods
 private:
 	void clickBack(Widget* /*widget*/);
@@ -30,4 +39,8 @@ public:
 	virtual ModeAction::Enum Tick(float _dt);
 	virtual ModeType::Enum GetType();
 	virtual void Draw(SDL_Surface* screenSurface);
+
+	/* Ticks games on a thread of their own while the main thread draws. Applies to games set up afterwards */
+	static void SetPipelined(bool pipelined){pipelined_ = pipelined;}
+	static bool GetPipelined(){return pipelined_;}
 };
@@ -1,7 +1,6 @@
 #pragma once
 #include "IMode.h"
 #include <vmath.h>
-#include <boost/signal.hpp>
 #include <Widget.h>
 
 /* ModeIntro
@@ -16,7 +15,7 @@ private:
 	Widget* mLogo1;
 	Widget* mLogo2;
 	Widget* mFeedbackWidget;
-	boost::signals::scoped_connection mKeyCallback;
+	ScopedConnection mKeyCallback;
 //Private methods
 private:
 	void KeySkip(Widget* /*widget*/, KeyPressEventArgs /*key_args*/);
@@ -4,7 +4,7 @@
 #include <Widget.h>
 #include "FeedbackWidget.h"
 #include "StandardTextures.h"
-#include <boost/filesystem.hpp>
+#include "GameBundle.h"
 
 ModeMenu::ModeMenu() :
 	mExitClicked(false),
@@ -78,20 +78,7 @@ void ModeMenu::findLevels()
 {
 	/* Load a list of campaigns */
 	mLevels.clear();
-	boost::filesystem::directory_iterator end_itr;	
-	for(boost::filesystem::directory_iterator itr = boost::filesystem::directory_iterator("./Levels");
-		itr != end_itr;
-		++itr)
-	{
-		if(boost::filesystem::is_regular((itr->status())))
-		{
-			std::string ext = boost::filesystem::extension(*itr);
-			if(ext == ".Level")
-			{
-				mLevels.push_back(itr->path().leaf());
-			}
-		}
-	}
+	GameBundle::FindLevels(mLevels);
 }
 
 void ModeMenu::loadLevel()
@@ -99,7 +86,7 @@ void ModeMenu::loadLevel()
 	if(mLevelIndex < mLevels.size())
 	{
 		std::string filename = mLevels[mLevelIndex];
-		mWall = Wall::SharedPointer(new Wall(filename));
+		mWall = GameBundle::LoadWall(filename);
 		//Wall should go in middle of play area relative to left
 		//So move left edge so that middle of wall in centre
 		//eg left = -5, right = 25 -> middle = 10, so position should be -10 + centre position
@@ -142,24 +129,11 @@ void ModeMenu::Draw(SDL_Surface* screenSurface)
 		vector<Brick::SharedPointer> bricks = mWall->GetBricks();
 		for(vector<Brick::SharedPointer>::iterator brick = bricks.begin(); brick != bricks.end(); ++brick)
 		{
-			Animation* sprite;
-			switch((*brick)->GetBrickType())
-			{
-			default:
-			case BrickType::BlueBrick:
-				sprite = StandardTextures::blue_brick_animation[0];
-				break;
-			case BrickType::RedBrick:
-				sprite = StandardTextures::red_brick_animation[(*brick)->GetLives() - 1];
-				break;
-			case BrickType::YellowBrick:
-				sprite = StandardTextures::yellow_brick_animation[(*brick)->GetLives() - 1];
-				break;
-			}
+			Animation* sprite = StandardTextures::GetBrick((*brick)->GetBrickType(), (*brick)->GetLives());
 
 			Vector2i inverted_y = (*brick)->GetPosition() + mWall->GetPosition() + offset + Vector2f(Brick::BRICK_WIDTH / 2, 0);
 			inverted_y.y = 480 - inverted_y.y;
-			sprite->GetCurrentFrame()->Draw(inverted_y);
+			sprite->GetFrameByIndex(0)->Draw(inverted_y);
 		}
 	}
 }
@@ -2,6 +2,7 @@
 #include "SDLAnimationFrame.h"
 #include <SDL.h>
 #include <SDL_image.h>
+#include "SurfaceBudget.h"
 
 SDL_Surface* SDLAnimationFrame::screen_ = NULL;
 
@@ -10,10 +11,12 @@ SDLAnimationFrame::SDLAnimationFrame(int _frame_id, float _time, Vector2i _frame
 : AnimationFrame(_frame_id, _time, _frame_offset)
 {
 	surface_ = _surface;
+	SurfaceBudget::Instance().Add(SurfaceCategory::Animation, SurfaceBudget::SurfaceBytes(surface_));
 }
 
 SDLAnimationFrame::~SDLAnimationFrame(void)
 {
+	SurfaceBudget::Instance().Remove(SurfaceCategory::Animation, SurfaceBudget::SurfaceBytes(surface_));
 	SDL_FreeSurface(surface_);
 }
 
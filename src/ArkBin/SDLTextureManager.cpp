@@ -2,9 +2,11 @@
 #include "SDLTextureManager.h"
 #include "SDLAnimationFrame.h"
 #include <SDL.h>
-#include <SDL_image.h>
 #include <boost/lexical_cast.hpp>
 #include "Logger.h"
+#include "SurfaceBlit.h"
+#include "ImageCache.h"
+#include "AssetBundle.h"
 
 using std::string;
 
@@ -26,32 +28,6 @@ namespace
 	Uint32 bmask = 0x00ff0000;
 	Uint32 amask = 0xff000000;
 #endif
-
-	/* Copies data from RGBA with alpha */
-	/* Otherwise when blitting the dest alpha is not changed, so can't copy subimage */
-	void BlindBlit(SDL_Surface* _src, SDL_Rect* _offset, SDL_Surface* _dest)
-	{
-		int h_c = _src->h - _offset->y - _dest->h;
-		int h = _dest->h + (h_c < 0 ? h_c : 0);
-		int w_c = _src->w - _offset->x - _dest->w;
-		int w = _dest->w + (w_c < 0 ? w_c : 0);
-		int bpp = _src->format->BytesPerPixel;
-		if(_src->format->BytesPerPixel != _dest->format->BytesPerPixel)
-		{
-			Logger::ErrorOut() << "Unable to Acquire resource, source data and dest data have different bpp\n";
-			return;
-		}
-
-		//Copy _dest->h x _dest->w pixels from _src, starting at _offset
-		//TODO fix if x+o.x > w
-		for(int y = 0; y < h; y++)
-		{
-			char* dest = (char*)_dest->pixels + (bpp * y * _dest->w); //Start of dest row
-			char* src = (char*)_src->pixels + (bpp * (_offset->y + y) * _src->w) + //Start of src row
-											  (bpp * _offset->x);					 //Plus offset
-			memcpy(dest, src, bpp * w);
-		}
-	}
 }
 
 
@@ -59,20 +35,14 @@ AnimationFrame* SDLTextureManager::AcquireResource(Vector2i _offset, Vector2i _s
 {
 	static int sample_count = 0;
 
-	SDL_Surface* converted_whole_surface;
-	//Finds texture in cache, or adds it in and then returns it
-	if(surface_cache_.find(_filename) != surface_cache_.end())
-	{
-		converted_whole_surface = surface_cache_[_filename];
-	} else
-	{
-		SDL_Surface* whole_surface = IMG_Load(("Animations/" + _filename).c_str());
-		/* This should ensure the BPP match */
-		converted_whole_surface = SDL_DisplayFormatAlpha(whole_surface);
-		SDL_FreeSurface(whole_surface);
-		whole_surface = NULL;
-		surface_cache_[_filename] = converted_whole_surface;
-	}
+	/* The image cache converts to display format, which should ensure the BPP match.
+	   The sheet is only held while the frame is cut out of it, so it doesn't stay pinned in memory */
+	string path = "Animations/" + _filename;
+	SDL_Surface* converted_whole_surface = ImageCache::Instance().Acquire(path);
+	if(!converted_whole_surface)
+		Logger::ErrorOut() << "Unable to load animation image " << _filename << "\n";
+	else
+		loaded_sheets_.insert(path);
 
 	SDL_Surface* sampled_area = SDL_CreateRGBSurface(surface_flags_, _size.x, _size.y, depth_, rmask, gmask, bmask, amask);
 	SDL_Surface* converted_sample = SDL_DisplayFormatAlpha(sampled_area);
@@ -81,24 +51,32 @@ AnimationFrame* SDLTextureManager::AcquireResource(Vector2i _offset, Vector2i _s
 	
 	// Blitting an opaque pixel to a transparent one results in a transparent pixel!
 	sample_count++;
-	SDL_Rect area;
-	area.x = static_cast<Sint16>(_offset.x);
-	area.y = static_cast<Sint16>(_offset.y);
-	area.w = static_cast<Uint16>(_size.x);
-	area.h = static_cast<Uint16>(_size.y);
-	BlindBlit(converted_whole_surface, &area, converted_sample);
+	if(converted_whole_surface)
+	{
+		SurfaceBlit::Copy(converted_whole_surface, _offset.x, _offset.y, _size.x, _size.y, converted_sample, 0, 0);
+		ImageCache::Instance().Release(converted_whole_surface);
+	}
 	
 	
 	SDL_FreeSurface(sampled_area);
-	SDLAnimationFrame* frame = new SDLAnimationFrame((int)(converted_sample), _time, _frame_offset, converted_sample);
+	//Numbered in the order cut, a surface pointer doesn't fit in an int on 64 bit builds
+	SDLAnimationFrame* frame = new SDLAnimationFrame(sample_count, _time, _frame_offset, converted_sample);
 	return frame;
 }
 
 void SDLTextureManager::InternalClearCache()
 {
-	for(std::map<std::string, SDL_Surface*>::iterator it = surface_cache_.begin(); it != surface_cache_.end(); ++it)
+	for(std::set<string>::iterator it = loaded_sheets_.begin(); it != loaded_sheets_.end(); ++it)
 	{
-		SDL_FreeSurface(it->second);
+		ImageCache::Instance().Purge(*it);
 	}
-	surface_cache_.clear();
+	loaded_sheets_.clear();
+}
+
+bool SDLTextureManager::ReadPrebuilt(const string& _xml_animation_set, AnimationSetDescription& _description)
+{
+	const AssetBundle::Entry* entry = AssetBundle::Instance().Find("Animations/" + _xml_animation_set);
+	if(!entry || entry->type != AssetType::Data)
+		return false;
+	return _description.Read(AssetBundle::Instance().GetData(entry), entry->size);
 }
\ No newline at end of file
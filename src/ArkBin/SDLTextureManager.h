@@ -1,6 +1,7 @@
 #pragma once
 #include <TextureManager.h>
-#include <map>
+#include <set>
+#include <string>
 struct SDL_Surface;
 
 class SDLTextureManager :
@@ -10,9 +11,12 @@ private:
 	static unsigned int surface_flags_;
 	static int depth_;
 
-	std::map<std::string, SDL_Surface*> surface_cache_;
+	//Sprite sheets sliced so far. They stay in ImageCache unreferenced, where SurfaceBudget can evict them
+	std::set<std::string> loaded_sheets_;
 
 	virtual AnimationFrame* AcquireResource(Vector2i _offset, Vector2i _size, std::string _filename, float _time, Vector2i _frame_offset);
 	virtual void InternalClearCache();
+	//Animation sets compiled into the open AssetBundle
+	virtual bool ReadPrebuilt(const std::string& _xml_animation_set, AnimationSetDescription& _description);
 public:
 };
@@ -1,22 +1,109 @@
 #include "StdAfx.h"
 #include "SoundManager.h"
 #include <SDL_mixer.h>
+#include <JobSystem.h>
+#include <AssetBundle.h>
+#include <SoftwareMixer.h>
+#include <Trace.h>
+#include <AllocationTracker.h>
+#include <algorithm>
 
+namespace
+{
+	const int audioRate = 44100;
+
+	/* Mix_LoadWAV reads and converts to the mixer's format, which only needs the audio opened.
+	   With a _frequency the wav is converted for the software mixer instead */
+	class LoadSampleJob : public Job
+	{
+	private:
+		std::string filename_;
+		int frequency_;
+		Mix_Chunk* sample_;
+		std::vector<Sint16> samples_;
+		bool loaded_;
+	public:
+		LoadSampleJob(std::string _filename, int _frequency) : filename_(_filename), frequency_(_frequency), sample_(NULL), loaded_(false){}
+		~LoadSampleJob()
+		{
+			if(sample_)
+				Mix_FreeChunk(sample_);
+		}
+		void Run()
+		{
+			TraceScope trace("LoadSampleJob::Run", filename_.c_str());
+			std::string path = std::string("Sounds/") + filename_;
+			if(frequency_)
+			{
+				loaded_ = SoftwareMixer::LoadWAV(path, frequency_, samples_);
+			} else
+			{
+				sample_ = Mix_LoadWAV(path.c_str());
+				loaded_ = sample_ != NULL;
+			}
+		}
+		void Complete()
+		{
+			TraceScope trace("LoadSampleJob::Complete", filename_.c_str());
+			if(!loaded_)
+			{
+				Logger::ErrorOut() << "Unable to load sound:" << filename_ << "\n";
+				return;
+			}
+			if(frequency_)
+			{
+				SoundManager::Instance().AddSample(filename_, samples_);
+			} else
+			{
+				SoundManager::Instance().AddSample(filename_, sample_);
+				sample_ = NULL;
+			}
+		}
+	};
+}
+
+
+bool SoundManager::software_mixer_ = false;
 
-SoundManager::SoundManager(void)
+SoundManager::SoundManager(void) :
+	mixer_(NULL),
+	voices_(VOICE_COUNT)
 {
-	int audio_rate = 44100;
-	Uint16 audio_format = AUDIO_S16; 
 	int audio_channels = 2;
 	int audio_buffers = 1024;
 
-	if(Mix_OpenAudio(audio_rate, audio_format, audio_channels, audio_buffers))
+	if(software_mixer_)
+	{
+		mixer_ = new SoftwareMixer(VOICE_COUNT, audioRate);
+		SDL_AudioSpec desired;
+		desired.freq = audioRate;
+		desired.format = AUDIO_S16SYS;
+		desired.channels = audio_channels;
+		desired.samples = audio_buffers;
+		desired.callback = &SoftwareMixer::AudioCallback;
+		desired.userdata = mixer_;
+		//No spec back, so SDL converts to whatever the device really wants
+		if(SDL_OpenAudio(&desired, NULL) < 0)
+		{
+			Logger::ErrorOut() << "Unable to open audio!\n";
+			status_ = SoundStatus::ErrorInitialising;
+		} else
+		{
+			SDL_PauseAudio(0);
+			Logger::ErrorOut() << "Sound initialised, software mixer " << (mixer_->GetSIMD() ? "with" : "without") << " SSE2\n";
+			status_ = SoundStatus::OK;
+		}
+		return;
+	}
+
+	if(Mix_OpenAudio(audioRate, AUDIO_S16, audio_channels, audio_buffers))
 	{
 		Logger::ErrorOut() << "Unable to open audio!\n";
 		status_ = SoundStatus::ErrorInitialising;
 	} else
 	{
-		Mix_AllocateChannels(32);
+		//One channel per voice, so the mixer never mixes more than the allocator allows
+		Mix_AllocateChannels(VOICE_COUNT);
 		Logger::ErrorOut() << "Sound initialised\n";
 		status_ = SoundStatus::OK;
 	}
@@ -35,67 +122,224 @@ SoundManager& SoundManager::Instance()
 	return *instance;
 }
 
-void SoundManager::PlaySample(std::string _filename)
+SampleHandle SoundManager::GetHandle(std::string _filename)
 {
-	PlayEnqueuedSample(_filename, 0);
+	std::map<std::string, SampleHandle>::iterator it = handles_.find(_filename);
+	if(it != handles_.end())
+		return it->second;
+	Sample sample;
+	sample.name = _filename;
+	sample.chunk = NULL;
+	sample.frames = NULL;
+	sample.frame_count = 0;
+	sample.priority = 0;
+	samples_.push_back(sample);
+	SampleHandle handle = static_cast<SampleHandle>(samples_.size()) - 1;
+	handles_[_filename] = handle;
+	return handle;
 }
 
-Mix_Chunk* SoundManager::GetChunk(std::string _filename)
+bool SoundManager::IsLoaded(const Sample& _sample) const
 {
-	Mix_Chunk* sample = NULL;
-	if(samples_.find(_filename) != samples_.end())
+	return mixer_ ? _sample.frames != NULL : _sample.chunk != NULL;
+}
+
+bool SoundManager::Load(Sample& _sample)
+{
+	if(IsLoaded(_sample) || LoadBundled(_sample))
+		return true;
+	//Still loading, or never preloaded. Either way this stalls the frame, so say so
+	TraceScope trace("SoundManager::Load", _sample.name.c_str());
+	std::string path = std::string("Sounds/") + _sample.name;
+	if(mixer_)
 	{
-		sample = samples_[_filename];
+		if(SoftwareMixer::LoadWAV(path, audioRate, _sample.loaded) && !_sample.loaded.empty())
+		{
+			_sample.frames = &_sample.loaded[0];
+			_sample.frame_count = static_cast<unsigned int>(_sample.loaded.size() / 2);
+		}
 	} else
 	{
-		sample = Mix_LoadWAV((std::string("Sounds/") + _filename).c_str());
-		
-		if(sample != NULL)
-			samples_[_filename] = sample;
-		else
-			Logger::ErrorOut() << "Unable to load sound:" << _filename << "\n";
+		_sample.chunk = Mix_LoadWAV(path.c_str());
+	}
+	if(!IsLoaded(_sample))
+	{
+		Logger::ErrorOut() << "Unable to load sound:" << _sample.name << "\n";
+		return false;
 	}
-	return sample;
+	Logger::DiagnosticOut() << "Sound loaded on demand:" << _sample.name << "\n";
+	return true;
 }
 
-int SoundManager::PlayLoopingSample(std::string _filename)
+bool SoundManager::LoadBundled(Sample& _sample)
 {
-	//Look the sound up, it's probably already loaded. If not then load it.
-	if(status_ != SoundStatus::OK)
-		return -1;
+	const AssetBundle::Entry* entry = AssetBundle::Instance().Find("Sounds/" + _sample.name);
+	if(!entry || entry->type != AssetType::Sound)
+		return false;
+	//The samples are only usable as they are if the mixer was opened the same way as when bundling
+	int frequency = audioRate;
+	Uint16 format = AUDIO_S16SYS;
+	int channels = 2;
+	if(!mixer_)
+		Mix_QuerySpec(&frequency, &format, &channels);
+	if(entry->params[0] != static_cast<unsigned int>(frequency) || entry->params[1] != format || entry->params[2] != static_cast<unsigned int>(channels))
+		return false;
+	//Plays straight from the bundle
+	const char* data = AssetBundle::Instance().GetData(entry);
+	if(mixer_)
+	{
+		_sample.frames = reinterpret_cast<const Sint16*>(data);
+		_sample.frame_count = entry->size / (2 * sizeof(Sint16));
+	} else
+	{
+		//Freeing the chunk leaves the samples alone
+		_sample.chunk = Mix_QuickLoad_RAW(reinterpret_cast<Uint8*>(const_cast<char*>(data)), entry->size);
+	}
+	return IsLoaded(_sample);
+}
 
-	Mix_Chunk* sample = GetChunk(_filename);
-	if(sample)
+bool SoundManager::PlayVoice(int _voice, Sample& _sample, float _volume, bool _looping)
+{
+	if(mixer_)
 	{
-		//Play the sound
-		return Mix_PlayChannel(-1, sample, -1);
+		mixer_->SetDistance(_voice, 0);
+		mixer_->Play(_voice, _sample.frames, _sample.frame_count, _volume, _looping);
+		return true;
 	}
-	return -1;
+	//Whoever had the channel last may have left it attenuated
+	Mix_SetDistance(_voice, 0);
+	Mix_Volume(_voice, static_cast<int>(_volume * MIX_MAX_VOLUME));
+	return Mix_PlayChannel(_voice, _sample.chunk, _looping ? -1 : 0) >= 0;
 }
 
-int SoundManager::PlayEnqueuedSample(std::string _filename, unsigned char _distance)
+void SoundManager::HaltVoice(int _voice)
+{
+	if(mixer_)
+		mixer_->Stop(_voice);
+	else
+		Mix_HaltChannel(_voice);
+}
+
+void SoundManager::SetVoiceVolume(int _voice, float _volume)
+{
+	if(mixer_)
+		mixer_->SetVolume(_voice, _volume);
+	else
+		Mix_Volume(_voice, static_cast<int>(_volume * MIX_MAX_VOLUME));
+}
+
+SampleHandle SoundManager::LoadSample(std::string _filename)
 {
-	//Look the sound up, it's probably already loaded. If not then load it.
 	if(status_ != SoundStatus::OK)
+		return NoSample;
+	SampleHandle handle = GetHandle(_filename);
+	if(!Load(samples_[handle]))
+		return NoSample;
+	return handle;
+}
+
+void SoundManager::SetPriority(SampleHandle _sample, int _priority)
+{
+	if(_sample >= 0 && _sample < static_cast<SampleHandle>(samples_.size()))
+		samples_[_sample].priority = _priority;
+}
+
+void SoundManager::SyncVoices()
+{
+	if(mixer_)
+	{
+		int voice;
+		while(mixer_->TakeFinished(voice))
+		{
+			voices_.Release(voice);
+		}
+		return;
+	}
+	for(int voice = 0; voice < voices_.GetVoiceCount(); voice++)
+	{
+		if(voices_.GetSample(voice) >= 0 && !Mix_Playing(voice))
+			voices_.Release(voice);
+	}
+}
+
+int SoundManager::Start(SampleHandle _sample, int _count, bool _looping)
+{
+	if(status_ != SoundStatus::OK || _sample < 0 || _sample >= static_cast<SampleHandle>(samples_.size()))
+		return -1;
+	Sample& sample = samples_[_sample];
+	if(!Load(sample))
 		return -1;
 
-	Mix_Chunk* sample = GetChunk(_filename);
-	if(sample)
+	float now = SDL_GetTicks() * 0.001f;
+	VoiceDecision decision = voices_.Request(_sample, sample.priority, now, _count, _looping);
+	switch(decision.mAction)
+	{
+	case VoiceAction::Drop:
+		return -1;
+	case VoiceAction::Merge:
+		SetVoiceVolume(decision.mVoice, decision.mVolume);
+		return decision.mVoice;
+	case VoiceAction::Steal:
+		HaltVoice(decision.mVoice);
+		break;
+	default:
+		break;
+	}
+	if(!PlayVoice(decision.mVoice, sample, decision.mVolume, _looping))
 	{
-		//Play the sound
-		int channel = Mix_PlayChannel(-1, sample, 0);
-		
-		if(channel >= 0) Mix_SetDistance(channel, _distance);
-		return channel;
+		voices_.Release(decision.mVoice);
+		return -1;
 	}
-	return -1;
+	return decision.mVoice;
+}
+
+void SoundManager::Play(SampleHandle _sample, int _count)
+{
+	AllocationScope allocations(AllocationTag::Audio);
+	SyncVoices();
+	Start(_sample, _count, false);
+}
+
+void SoundManager::PlayEvents(const std::vector<std::string>& _filenames)
+{
+	AllocationScope allocations(AllocationTag::Audio);
+	if(status_ != SoundStatus::OK || _filenames.empty())
+		return;
+	SyncVoices();
+	//Identical events end up next to each other, each run is one voice
+	std::vector<std::string> events(_filenames);
+	std::sort(events.begin(), events.end());
+	std::vector<std::string>::iterator run = events.begin();
+	while(run != events.end())
+	{
+		std::vector<std::string>::iterator run_end = std::upper_bound(run, events.end(), *run);
+		Start(GetHandle(*run), static_cast<int>(run_end - run), false);
+		run = run_end;
+	}
+}
+
+void SoundManager::PlaySample(std::string _filename)
+{
+	if(status_ != SoundStatus::OK)
+		return;
+	Play(GetHandle(_filename));
+}
+
+int SoundManager::PlayLoopingSample(std::string _filename)
+{
+	//Look the sound up, it's probably already loaded. If not then load it.
+	if(status_ != SoundStatus::OK)
+		return -1;
+	SyncVoices();
+	return Start(GetHandle(_filename), 1, true);
 }
 
 void SoundManager::StopChannel(int _channel)
 {
 	if(status_ != SoundStatus::OK)
 		return;
-	Mix_HaltChannel(_channel);
+	HaltVoice(_channel);
+	voices_.Release(_channel);
 }
 
 void SoundManager::SetVolume(int _channel, float _volume)
@@ -103,6 +347,54 @@ void SoundManager::SetVolume(int _channel, float _volume)
 	if(status_ != SoundStatus::OK)
 		return;
 	unsigned char distance = (1.0f - _volume) * 255;
-	Mix_SetDistance(_channel, distance);
+	if(mixer_)
+		mixer_->SetDistance(_channel, distance);
+	else
+		Mix_SetDistance(_channel, distance);
+}
+
+SampleHandle SoundManager::Preload(std::string _filename, JobSystem& _jobs)
+{
+	if(status_ != SoundStatus::OK)
+		return NoSample;
+	SampleHandle handle = GetHandle(_filename);
+	if(!IsLoaded(samples_[handle]) && !LoadBundled(samples_[handle]))
+		_jobs.Submit(new LoadSampleJob(_filename, mixer_ ? audioRate : 0));
+	return handle;
 }
 
+void SoundManager::AddSample(std::string _filename, Mix_Chunk* _sample)
+{
+	Sample& sample = samples_[GetHandle(_filename)];
+	if(sample.chunk)
+	{
+		Mix_FreeChunk(_sample);
+		return;
+	}
+	sample.chunk = _sample;
+}
+
+void SoundManager::AddSample(std::string _filename, std::vector<Sint16>& _samples)
+{
+	Sample& sample = samples_[GetHandle(_filename)];
+	if(sample.frames || _samples.empty())
+		return;
+	sample.loaded.swap(_samples);
+	sample.frames = &sample.loaded[0];
+	sample.frame_count = static_cast<unsigned int>(sample.loaded.size() / 2);
+}
+
+void SoundManager::Report(std::ostream& _out) const
+{
+	_out << "Sound events: " << voices_.GetRequested() <<
+			" merged: " << voices_.GetMerged() <<
+			" voices taken over: " << voices_.GetStolen() <<
+			" dropped: " << voices_.GetDropped() <<
+			" voices: " << voices_.GetVoiceCount() << "\n";
+	if(mixer_)
+	{
+		_out << "Software mixer frames: " << mixer_->GetMixedFrames() <<
+				" voice frames: " << mixer_->GetMixedVoiceFrames() <<
+				" commands lost: " << mixer_->GetDroppedCommands() << "\n";
+	}
+}
@@ -1,8 +1,15 @@
 #pragma once
 #include <string>
 #include <map>
+#include <vector>
+#include <deque>
+#include <ostream>
+#include <SDL_types.h>
+#include <VoiceAllocator.h>
 
 struct Mix_Chunk;
+class JobSystem;
+class SoftwareMixer;
 
 namespace SoundStatus
 {
@@ -12,23 +19,74 @@ namespace SoundStatus
 	};
 }
 
+/* Index of a sample, looked up by name once and then used instead of the name */
+typedef int SampleHandle;
+
 class SoundManager
 {
 private:
+	struct Sample
+	{
+		std::string name;
+		Mix_Chunk* chunk;			//Through SDL_mixer
+		const Sint16* frames;		//Through the software mixer, stereo, in the bundle or in loaded
+		unsigned int frame_count;
+		std::vector<Sint16> loaded;
+		int priority;
+	};
+
 	SoundManager(void);
 	~SoundManager(void);
 	SoundStatus::Enum status_;
+	static bool software_mixer_;
+	SoftwareMixer* mixer_;		//NULL when playing through SDL_mixer
+
+	//A deque so samples stay put while the audio thread plays them, however many are added
+	std::deque<Sample> samples_;
+	std::map<std::string, SampleHandle> handles_;
+	VoiceAllocator voices_;
 
-	std::map<std::string, Mix_Chunk*> samples_;
+	SampleHandle GetHandle(std::string _filename);
+	bool IsLoaded(const Sample& _sample) const;
+	/* Loads now if it hasn't been already, false if it can't be */
+	bool Load(Sample& _sample);
+	bool LoadBundled(Sample& _sample);
+	bool PlayVoice(int _voice, Sample& _sample, float _volume, bool _looping);
+	void HaltVoice(int _voice);
+	void SetVoiceVolume(int _voice, float _volume);
+	/* Frees the allocator's voices whose channels have stopped */
+	void SyncVoices();
+	int Start(SampleHandle _sample, int _count, bool _looping);
 
-	Mix_Chunk* GetChunk(std::string _filename);
-	int PlayEnqueuedSample(std::string _filename, unsigned char _distance);
-	
-	
 public:
+	static const int VOICE_COUNT = 16;
+	static const SampleHandle NoSample = -1;
+
 	static SoundManager& Instance();
+	/* Mixes in our own audio callback rather than through SDL_mixer. Only before the first Instance */
+	static void SetSoftwareMixer(bool _software){software_mixer_ = _software;}
+
+	/* Handle of a sample, loaded now if it isn't already. NoSample if it can't be loaded */
+	SampleHandle LoadSample(std::string _filename);
+	/* Higher priority sounds take voices from lower ones when all are busy. Samples start at 0 */
+	void SetPriority(SampleHandle _sample, int _priority);
+	/* _count identical events raised together, played as one voice */
+	void Play(SampleHandle _sample, int _count = 1);
+	/* One tick's worth of events by name. Each sample is looked up once however often it occurs */
+	void PlayEvents(const std::vector<std::string>& _filenames);
+
 	void PlaySample(std::string _filename);
 	int PlayLoopingSample(std::string _filename);
 	void StopChannel(int _channel);
 	void SetVolume(int _channel, float _volume);
+
+	/* Loads a sample on a worker so the first time it plays doesn't stall a frame */
+	SampleHandle Preload(std::string _filename, JobSystem& _jobs);
+	/* Hands over a sample loaded elsewhere. Freed instead if _filename is already loaded */
+	void AddSample(std::string _filename, Mix_Chunk* _sample);
+	/* The same for the software mixer, taking the contents of _samples */
+	void AddSample(std::string _filename, std::vector<Sint16>& _samples);
+
+	/* Events requested, merged into a playing voice, playing after taking a voice, and dropped */
+	void Report(std::ostream& _out) const;
 };
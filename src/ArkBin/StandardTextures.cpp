@@ -6,135 +6,148 @@
 #include <Animation.h>
 #include <SDL.h>
 #include "SDLAnimationFrame.h"
+#include <ImageCache.h>
+#include <JobSystem.h>
+#include <AssetBundle.h>
+#include <Trace.h>
+#include <SDL_image.h>
 #include <boost/lexical_cast.hpp>
+#include <boost/static_assert.hpp>
+#include <algorithm>
 
 namespace StandardTextures
 {
-	Animation* ball_animation = 0;
-	Animation* red_brick_animation[2] = {0, 0};
-	Animation* blue_brick_animation[2] = {0, 0};
-	Animation* yellow_brick_animation[3] = {0, 0, 0};
-	Animation* paddle_animation = 0;
-	Animation* ball_trail_animation = 0;
-	Animation* background_animation = 0;
-	Animation* red_numbers_animation = 0;
+	AnimationHandle handles[StandardAnimation::Count];
 
-	void LoadTextures()
+	namespace
 	{
-		TextureManager::SetTextureManager(new SDLTextureManager());
+		const char* animation_sets[] = {"Ball.animation", "BlueBrick.animation", "RedBrick.animation", "YellowBrick.animation",
+										"Paddle.animation", "Background.animation", "RedNumbers.animation"};
 
-		AnimationSet* ball_animation_set = SDLTextureManager::GetAnimationSet("Ball.animation");
-		if(ball_animation_set)
+		struct StandardAnimationName
 		{
-			ball_animation = ball_animation_set->GetAnimation("Ball");
-			if(!ball_animation )
-			{
-				Logger::ErrorOut() << "Unable to load ball animation\n";
-			}
-
-			ball_trail_animation = ball_animation_set->GetAnimation("Trail");
-			if(!ball_trail_animation )
-			{
-				Logger::ErrorOut() << "Unable to load ball trail animation\n";
-			}
-		} else
+			const char* set;
+			const char* animation;
+			const char* description;
+		};
+		//In the order of StandardAnimation::Enum
+		const StandardAnimationName standard_animations[] =
 		{
-			Logger::ErrorOut() << "Unable to load ball animations\n";
-		}
+			{"Ball.animation", "Ball", "ball"},
+			{"Ball.animation", "Trail", "ball trail"},
+			{"BlueBrick.animation", "Brick", "blue brick undamaged"},
+			{"BlueBrick.animation", "BrickDamaged", "blue brick damaged"},
+			{"RedBrick.animation", "BrickDamaged", "red brick damaged"},
+			{"RedBrick.animation", "Brick", "red brick undamaged"},
+			{"YellowBrick.animation", "BrickDamaged2", "yellow brick damaged 2"},
+			{"YellowBrick.animation", "BrickDamaged", "yellow brick damaged"},
+			{"YellowBrick.animation", "Brick", "yellow brick undamaged"},
+			{"Paddle.animation", "Paddle", "paddle"},
+			{"Background.animation", "Background", "background"},
+			{"RedNumbers.animation", "Numbers", "red numbers"}
+		};
+		BOOST_STATIC_ASSERT(sizeof(standard_animations) / sizeof(standard_animations[0]) == StandardAnimation::Count);
 
-		AnimationSet* blue_brick_animation_set = SDLTextureManager::GetAnimationSet("BlueBrick.animation");
-		if(blue_brick_animation_set)
-		{
-			blue_brick_animation[0] = blue_brick_animation_set->GetAnimation("Brick");
-			if(!blue_brick_animation[0])
-				Logger::ErrorOut() << "Unable to load blue brick undamaged animation\n";
-			blue_brick_animation[1] = blue_brick_animation_set->GetAnimation("BrickDamaged");
-			if(!blue_brick_animation[1])
-				Logger::ErrorOut() << "Unable to load blue brick damaged animation\n";
-		} else
-		{
-			Logger::ErrorOut() << "Unable to load blue brick animations\n";
-		}
+		bool texture_manager_set = false;
 
-		AnimationSet* red_brick_animation_set = SDLTextureManager::GetAnimationSet("RedBrick.animation");
-		if(red_brick_animation_set)
+		/* Also interns the standard handles, so they're ready for whichever way the sets get loaded */
+		void UseSDLTextureManager()
 		{
-			red_brick_animation[1] = red_brick_animation_set->GetAnimation("Brick");
-			if(!red_brick_animation[1])
-				Logger::ErrorOut() << "Unable to load red brick undamaged animation\n";
-			red_brick_animation[0] = red_brick_animation_set->GetAnimation("BrickDamaged");
-			if(!red_brick_animation[0])
-				Logger::ErrorOut() << "Unable to load red brick damaged animation\n";
-		} else
-		{
-			Logger::ErrorOut() << "Unable to load red brick animations\n";
+			if(texture_manager_set)
+				return;
+			TextureManager::SetTextureManager(new SDLTextureManager());
+			texture_manager_set = true;
+			for(int i = 0; i < StandardAnimation::Count; i++)
+			{
+				handles[i] = TextureManager::GetHandle(standard_animations[i].set, standard_animations[i].animation);
+			}
 		}
 
-		AnimationSet* yellow_brick_animation_set = SDLTextureManager::GetAnimationSet("YellowBrick.animation");
-		if(yellow_brick_animation_set)
+		/* Reads the set and decodes every sheet it uses on a worker. On completion the sheets are
+		   converted to display format into the ImageCache, where cutting out the frames finds them */
+		class LoadAnimationSetJob : public Job
 		{
-			yellow_brick_animation[2] = yellow_brick_animation_set->GetAnimation("Brick");
-			if(!yellow_brick_animation[2])
-				Logger::ErrorOut() << "Unable to load yellow brick undamaged animation\n";
-			yellow_brick_animation[1] = yellow_brick_animation_set->GetAnimation("BrickDamaged");
-			if(!yellow_brick_animation[1])
-				Logger::ErrorOut() << "Unable to load yellow brick damaged animation\n";
-			yellow_brick_animation[0] = yellow_brick_animation_set->GetAnimation("BrickDamaged2");
-			if(!yellow_brick_animation[0])
-				Logger::ErrorOut() << "Unable to load yellow brick damaged 2 animation\n";
+		private:
+			std::string name_;
+			AnimationSetDescription description_;
+			std::vector<std::pair<std::string, SDL_Surface*> > sheets_;
+		public:
+			explicit LoadAnimationSetJob(std::string _name) : name_(_name){}
+			~LoadAnimationSetJob()
+			{
+				for(std::vector<std::pair<std::string, SDL_Surface*> >::iterator it = sheets_.begin(); it != sheets_.end(); ++it)
+				{
+					if(it->second)
+						SDL_FreeSurface(it->second);
+				}
+			}
+			void Run()
+			{
+				TraceScope trace("LoadAnimationSetJob::Run", name_.c_str());
+				if(!TextureManager::ReadAnimationSet(name_, description_))
+					return;
+				std::vector<std::string> files = description_.GetFiles();
+				for(std::vector<std::string>::iterator it = files.begin(); it != files.end(); ++it)
+				{
+					std::string path = "Animations/" + *it;
+					//Already decoded, the ImageCache maps it when the frames are cut
+					if(AssetBundle::Instance().Find(path))
+						continue;
+					sheets_.push_back(std::make_pair(path, IMG_Load(path.c_str())));
+				}
+			}
+			void Complete()
+			{
+				TraceScope trace("LoadAnimationSetJob::Complete", name_.c_str());
+				for(std::vector<std::pair<std::string, SDL_Surface*> >::iterator it = sheets_.begin(); it != sheets_.end(); ++it)
+				{
+					//Failures are left to AcquireResource to report
+					if(it->second)
+						ImageCache::Instance().AddDecoded(it->first, it->second);
+					it->second = NULL;
+				}
+				TextureManager::AddAnimationSet(name_, description_);
+			}
+		};
+	}
 
-		} else
+	void QueueTextures(JobSystem& _jobs)
+	{
+		UseSDLTextureManager();
+		for(unsigned int i = 0; i < sizeof(animation_sets) / sizeof(animation_sets[0]); i++)
 		{
-			Logger::ErrorOut() << "Unable to load yellow brick animations\n";
+			_jobs.Submit(new LoadAnimationSetJob(animation_sets[i]));
 		}
+	}
 
-		AnimationSet* paddle_animation_set = SDLTextureManager::GetAnimationSet("Paddle.animation");
-		if(paddle_animation_set )
-		{
-			paddle_animation = paddle_animation_set->GetAnimation("Paddle");
-			if(!paddle_animation)
-				Logger::ErrorOut() << "Unable to load paddle animation\n";
-		} else
-		{
-			Logger::ErrorOut() << "Unable to load paddle animations\n";
-		}
+	void LoadTextures()
+	{
+		UseSDLTextureManager();
 
-		AnimationSet* background_animation_set = SDLTextureManager::GetAnimationSet("Background.animation");
-		if(background_animation_set)
-		{
-			background_animation = background_animation_set->GetAnimation("Background");
-			if(!background_animation)
-				Logger::ErrorOut() << "Unable to load background animation\n";
-		} else
+		for(unsigned int i = 0; i < sizeof(animation_sets) / sizeof(animation_sets[0]); i++)
 		{
-			Logger::ErrorOut() << "Unable to load background animations\n";
+			if(!SDLTextureManager::GetAnimationSet(animation_sets[i]))
+				Logger::ErrorOut() << "Unable to load " << animation_sets[i] << "\n";
 		}
-
-		AnimationSet* red_numbers_animation_set = SDLTextureManager::GetAnimationSet("RedNumbers.animation");
-		if(background_animation_set)
-		{
-			red_numbers_animation = red_numbers_animation_set->GetAnimation("Numbers");
-			if(!red_numbers_animation)
-				Logger::ErrorOut() << "Unable to load red numbers animation\n";
-		} else
+		//Sets loaded on workers resolved their handles as they were added
+		for(int i = 0; i < StandardAnimation::Count; i++)
 		{
-			Logger::ErrorOut() << "Unable to load red numbers animations\n";
+			if(!TextureManager::GetAnimation(handles[i]))
+				Logger::ErrorOut() << "Unable to load " << standard_animations[i].description << " animation\n";
 		}
 	}
 
-	void TickAnimations(float _dt)
+	Animation* GetBrick(BrickType::Enum _brick_type, int _lives)
 	{
-		if(ball_animation)
-			ball_animation->Tick(_dt);
-
-		if(paddle_animation)
-			paddle_animation->Tick(_dt);
-		for(int i = 0; i < 2; i++)
+		switch(_brick_type)
 		{
-			if(red_brick_animation[i])
-				red_brick_animation[i]->Tick(_dt);
-			if(blue_brick_animation[i])
-				blue_brick_animation[i]->Tick(_dt);
+		default:
+		case BrickType::BlueBrick:
+			return Get(StandardAnimation::BlueBrick);
+		case BrickType::RedBrick:
+			return Get(static_cast<StandardAnimation::Enum>(StandardAnimation::RedBrickDamaged + std::max(0, std::min(_lives - 1, 1))));
+		case BrickType::YellowBrick:
+			return Get(static_cast<StandardAnimation::Enum>(StandardAnimation::YellowBrickDamaged2 + std::max(0, std::min(_lives - 1, 2))));
 		}
 	}
-}
\ No newline at end of file
+}
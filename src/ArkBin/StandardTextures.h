@@ -1,20 +1,42 @@
-
+#pragma once
 #include <Animation.h>
 #include <AnimationFrame.h>
-namespace StandardTextures
+#include <TextureManager.h>
+#include <Brick.h>
+class JobSystem;
+
+namespace StandardAnimation
 {
-	extern Animation* ball_animation;
-	extern Animation* ball_trail_animation;
-	extern Animation* red_brick_animation[2];
-	extern Animation* blue_brick_animation[2];
-	extern Animation* yellow_brick_animation[3];
-	extern Animation* paddle_animation;
-	extern Animation* background_animation;
-	extern Animation* red_numbers_animation;
+	enum Enum
+	{
+		Ball,
+		BallTrail,
+		BlueBrick,
+		BlueBrickDamaged,
+		//Bricks with lives are in order of lives left, fewest first
+		RedBrickDamaged,
+		RedBrick,
+		YellowBrickDamaged2,
+		YellowBrickDamaged,
+		YellowBrick,
+		Paddle,
+		Background,
+		RedNumbers,
+		Count
+	};
+}
 
+namespace StandardTextures
+{
+	extern AnimationHandle handles[StandardAnimation::Count];
 
-	//Load textures
+	//Reads the animation sets and decodes their images on _jobs' workers, frames are cut as each completes
+	void QueueTextures(JobSystem& _jobs);
+	//Load textures. Sets queued and completed earlier are picked up, anything else is loaded here
 	void LoadTextures();
-	//Advances animation
-	void TickAnimations(float dt);
-}
\ No newline at end of file
+
+	//NULL until loaded, or if the set failed to load
+	inline Animation* Get(StandardAnimation::Enum _animation){return TextureManager::GetAnimation(handles[_animation]);}
+	//The brick's animation for the lives it has left
+	Animation* GetBrick(BrickType::Enum _brick_type, int _lives);
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstddef>
+#include <iostream>
+
+namespace AllocationTag
+{
+	/* Subsystems allocations are counted against, whichever AllocationScope is innermost on
+	   the thread allocating */
+	enum Enum
+	{
+		Other,
+		Simulation,
+		Widgets,
+		Rendering,
+		Audio,
+		Count
+	};
+}
+
+struct AllocationStats
+{
+	unsigned int allocations;
+	unsigned int bytes;
+};
+
+/* Counts calls to operator new, and the bytes asked for, per frame and per subsystem. Off
+   until enabled, when it costs one test per allocation. Frees aren't counted, it measures churn
+   rather than what's live. Every so often the caller is sampled, so the report can point at
+   where the allocations come from; the addresses are looked up in the map file or a debugger.
+   Tests can use GetCurrent after EndFrame to hold code to an allocation budget */
+class AllocationTracker
+{
+public:
+	static void Enable(bool _enabled);
+	static bool IsEnabled();
+	/* One allocation in _every has its call site sampled, 0 for none */
+	static void SetSampleRate(unsigned int _every);
+	/* Rolls the current counts into the frame just ended and the totals */
+	static void EndFrame();
+	/* Clears the counts, totals and samples */
+	static void Reset();
+
+	/* Since the last EndFrame */
+	static AllocationStats GetCurrent(AllocationTag::Enum _tag);
+	/* The frame ended by the last EndFrame */
+	static AllocationStats GetLastFrame(AllocationTag::Enum _tag);
+	static unsigned int GetFrames();
+
+	/* Averages and peaks per frame by subsystem, then the call sites sampled most */
+	static void Report(std::ostream& _out);
+
+	/* For operator new */
+	static void Count(size_t _bytes, void* _caller);
+	/* Sets the calling thread's tag, returning the one it replaces */
+	static AllocationTag::Enum SetTag(AllocationTag::Enum _tag);
+	static const char* GetTagName(AllocationTag::Enum _tag);
+};
+
+/* Tags the allocations the calling thread makes until it goes out of scope */
+class AllocationScope
+{
+private:
+	AllocationTag::Enum previous_;
+
+	AllocationScope(const AllocationScope&);
+	AllocationScope& operator=(const AllocationScope&);
+
+public:
+	explicit AllocationScope(AllocationTag::Enum _tag) : previous_(AllocationTracker::SetTag(_tag)){}
+	~AllocationScope(){AllocationTracker::SetTag(previous_);}
+};
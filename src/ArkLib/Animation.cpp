@@ -1,6 +1,7 @@
 #include "Animation.h"
 #include "AnimationFrame.h"
 #include <cmath>
+#include <algorithm>
 #include <boost/lexical_cast.hpp>
 
 
@@ -9,9 +10,6 @@ int Animation::count_ = 0;
 Animation::Animation()
 {
 	total_length_ = 0;
-	frame_time_ = 0;
-	current_frame_ = NULL;
-	current_frame_index_ = 0;
 	name_ = "Default" + boost::lexical_cast<string, int>(count_++);
 }
 
@@ -23,53 +21,86 @@ Animation::~Animation()
 	}
 }
 
-void Animation::Tick(float _timespan)
+int Animation::GetFrameIndex(float _time) const
 {
-	frame_time_ += _timespan;
-	//Advance to next frame if time has elapsed
-	while(frame_time_ > current_frame_->GetTime())
+	if(frames_.empty() || total_length_ <= 0)
+		return 0;
+	if(_time < 0 || _time >= total_length_)
 	{
-		frame_time_ -= current_frame_->GetTime();
-		current_frame_index_++;
-		current_frame_index_ %= frames_.size();
-		current_frame_ = frames_[current_frame_index_];
+		_time = fmodf(_time, total_length_);
+		if(_time < 0)
+			_time += total_length_;
 	}
+	//First frame that hasn't finished by _time
+	int index = static_cast<int>(std::upper_bound(frame_ends_.begin(), frame_ends_.end(), _time) - frame_ends_.begin());
+	return std::min(index, static_cast<int>(frames_.size()) - 1);
 }
 
-AnimationFrame* Animation::GetFrame(float _time)
+AnimationFrame* Animation::GetFrame(float _time) const
 {
-	_time = fmodf(_time, total_length_);
-	float total_time_ = 0;
-	for(vector<AnimationFrame*>::iterator it = frames_.begin(); it != frames_.end(); ++it)
-	{
-		total_time_ += (*it)->GetTime();
-		if(total_time_ > _time)
-			return *it;
-	}
-	return frames_[0];
+	if(frames_.empty())
+		return NULL;
+	return frames_[GetFrameIndex(_time)];
 }
 
-AnimationFrame* Animation::GetFrameByIndex(int _index)
+AnimationFrame* Animation::GetFrameByIndex(int _index) const
 {
 	return frames_[_index % frames_.size()];
 }
 
-int Animation::GetFrameID(float _time)
+int Animation::GetFrameID(float _time) const
 {
 	return GetFrame(_time)->GetFrameID();
 }
 
-int Animation::GetCurrentFrameID()
+void Animation::AddFrame(AnimationFrame* _frame)
 {
-	return current_frame_->GetFrameID();
+	frames_.push_back(_frame);
+	total_length_ += _frame->GetTime();
+	frame_ends_.push_back(total_length_);
 }
 
-void Animation::AddFrame(AnimationFrame* _frame)
+AnimationPlayhead Animation::Play(float _time) const
 {
-	frames_.push_back(_frame);
-	if(frames_.size() == 1) 
+	AnimationPlayhead playhead;
+	playhead.clip = this;
+	playhead.time = 0;
+	playhead.frame = 0;
+	if(total_length_ > 0)
 	{
-		current_frame_ = _frame;
+		playhead.time = fmodf(_time, total_length_);
+		if(playhead.time < 0)
+			playhead.time += total_length_;
+		playhead.frame = GetFrameIndex(playhead.time);
 	}
-	total_length_ += _frame->GetTime();
-}
\ No newline at end of file
+	return playhead;
+}
+
+AnimationFrame* Animation::GetFrame(const AnimationPlayhead& _playhead)
+{
+	if(!_playhead.clip || _playhead.clip->frames_.empty())
+		return NULL;
+	return _playhead.clip->frames_[_playhead.frame];
+}
+
+void Animation::Advance(AnimationPlayhead* _playheads, unsigned int _count, float _timespan)
+{
+	for(AnimationPlayhead* playhead = _playheads; playhead != _playheads + _count; ++playhead)
+	{
+		const Animation* clip = playhead->clip;
+		if(!clip || clip->total_length_ <= 0)
+			continue;
+		playhead->time += _timespan;
+		if(playhead->time >= clip->total_length_)
+		{
+			//Wrapped, possibly more than once
+			playhead->time = fmodf(playhead->time, clip->total_length_);
+			playhead->frame = clip->GetFrameIndex(playhead->time);
+			continue;
+		}
+		//A tick rarely gets further than the next frame, so step rather than search
+		const float* frame_ends = &clip->frame_ends_[0];
+		while(playhead->time >= frame_ends[playhead->frame])
+			playhead->frame++;
+	}
+}
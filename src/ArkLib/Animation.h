@@ -5,37 +5,118 @@ using std::vector;
 using std::string;
 
 class AnimationFrame;
+class Animation;
 
+/* Where one sprite is in its clip. The clip is shared, so every ball and brick can be at a
+   different point in the same animation. Small enough to keep thousands in a vector and
+   advance them together with Animation::Advance */
+struct AnimationPlayhead
+{
+	const Animation* clip;	//NULL for nothing to show
+	float time;				//Seconds into the clip, always less than its length
+	int frame;				//Index of the frame showing at time
+};
+
+/* A clip of frames, each shown for its own time. Only changed while loading; playback state
+   lives in AnimationPlayheads */
 class Animation
 {
 private:
 	float total_length_;
 
-	float frame_time_;
-	AnimationFrame* current_frame_;
-	int current_frame_index_;
-
 	vector<AnimationFrame*> frames_;
+	vector<float> frame_ends_;	//Time each frame finishes, so the frame at a time can be binary searched
 	string name_;
 	static int count_;
 public:
 	Animation();
 	~Animation();
 
-	/* Directly access a frame by time */
-	AnimationFrame* GetFrame(float _time);
-	int GetFrameID(float _time);
+	/* Directly access a frame by time, wrapping round past the end */
+	AnimationFrame* GetFrame(float _time) const;
+	int GetFrameIndex(float _time) const;
+	int GetFrameID(float _time) const;
 
 	/* Add a frame to animation */
 	void AddFrame(AnimationFrame* _frame);
 
-	/* Get the current frame. Animation stores time */
-	AnimationFrame* GetCurrentFrame(){return current_frame_;}
 	/* Gets the frame at this index. If index out of bounds then returns frame at mod of _index */
-	AnimationFrame* GetFrameByIndex(int _index);
+	AnimationFrame* GetFrameByIndex(int _index) const;
+	int GetFrameCount() const {return static_cast<int>(frames_.size());}
+	float GetLength() const {return total_length_;}
+
+	/* A playhead on this clip _time seconds in, e.g. to start sprites out of step or to carry on
+	   from where another clip's playhead was */
+	AnimationPlayhead Play(float _time) const;
+	/* The frame a playhead is showing, NULL if it has no clip */
+	static AnimationFrame* GetFrame(const AnimationPlayhead& _playhead);
+	/* Moves _count playheads on by _timespan in one pass. They may be on different clips */
+	static void Advance(AnimationPlayhead* _playheads, unsigned int _count, float _timespan);
 
-	int GetCurrentFrameID();
-	void Tick(float _timespan);
 	string GetName(){return name_;}
 	void SetName(string _name){name_ = _name;}
 };
+
+/* The playheads of a changing set of sprites, such as the balls or bricks of a snapshot, kept
+   matched to the sprites by id. Sprites that are new start part way into their clip so that they
+   don't all animate in step, and a sprite that changes clip, like a brick when hit, carries on
+   from the same time. Nothing is allocated once the sprite count settles */
+class SpritePlayheads
+{
+private:
+	float stagger_;	//Seconds between where successive ids start in their clips
+	vector<unsigned int> ids_;
+	vector<AnimationPlayhead> playheads_;
+	vector<unsigned int> scratch_ids_;
+	vector<AnimationPlayhead> scratch_playheads_;
+
+	static AnimationPlayhead Start(const Animation* _clip, float _time)
+	{
+		if(_clip)
+			return _clip->Play(_time);
+		AnimationPlayhead nothing = {NULL, 0, 0};
+		return nothing;
+	}
+public:
+	explicit SpritePlayheads(float _stagger) : stagger_(_stagger){}
+
+	/* Lines playheads up with _sprites, which have an mId and are in increasing id order.
+	   Afterwards playhead i belongs to sprite i */
+	template<typename T>
+	void Match(const vector<T>& _sprites, const Animation* (*_clip_for)(const T&))
+	{
+		scratch_ids_.clear();
+		scratch_playheads_.clear();
+		unsigned int old = 0;
+		for(typename vector<T>::const_iterator sprite = _sprites.begin(); sprite != _sprites.end(); ++sprite)
+		{
+			const Animation* clip = _clip_for(*sprite);
+			while(old < ids_.size() && ids_[old] < sprite->mId)
+				old++;
+			AnimationPlayhead playhead;
+			if(old < ids_.size() && ids_[old] == sprite->mId)
+			{
+				playhead = playheads_[old];
+				if(playhead.clip != clip)
+					playhead = Start(clip, playhead.time);
+			} else
+			{
+				playhead = Start(clip, sprite->mId * stagger_);
+			}
+			scratch_ids_.push_back(sprite->mId);
+			scratch_playheads_.push_back(playhead);
+		}
+		ids_.swap(scratch_ids_);
+		playheads_.swap(scratch_playheads_);
+	}
+
+	/* Moves every playhead on by _timespan with Animation::Advance */
+	void Advance(float _timespan)
+	{
+		if(!playheads_.empty())
+			Animation::Advance(&playheads_[0], static_cast<unsigned int>(playheads_.size()), _timespan);
+	}
+
+	unsigned int GetCount() const {return static_cast<unsigned int>(playheads_.size());}
+	const AnimationPlayhead& Get(unsigned int _index) const {return playheads_[_index];}
+};
@@ -18,10 +18,11 @@ void AnimationSet::AddAnimation(Animation* _animation)
 	animations_[_animation->GetName()] = _animation;
 }
 
-Animation* AnimationSet::GetAnimation(string _name)
+Animation* AnimationSet::GetAnimation(const string& _name) const
 {
-	if(animations_.find(_name) != animations_.end())
-		return animations_[_name];
+	map<string, Animation*>::const_iterator found = animations_.find(_name);
+	if(found != animations_.end())
+		return found->second;
 	else
 		return NULL;
 }
\ No newline at end of file
@@ -16,7 +16,7 @@ public:
 	~AnimationSet(void);
 
 	void AddAnimation(Animation* _animation);
-	Animation* GetAnimation(string _name);
+	Animation* GetAnimation(const string& _name) const;
 	Animation* GetDefaultAnimation(){return default_animation_;}
 
 	int GetAnimationCount(){return static_cast<int>(animations_.size());}
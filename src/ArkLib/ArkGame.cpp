@@ -1,5 +1,8 @@
 #include "ArkGame.h"
 #include "vmath-collisions.h"
+#include "Trace.h"
+#include "AllocationTracker.h"
+#include "VectorBatch.h"
 
 using std::vector;
 
@@ -9,7 +12,8 @@ ArkGame::ArkGame(void) :
 	mTimer(0),
 	mPaddle(new Paddle()),
 	mScore(0),
-	mBounces(0)
+	mBounces(0),
+	mNextBallId(1)
 {
 	mPaddle->SetBounds(mBounds);
 	mPaddle->SetX(mBounds.x / 2 - mPaddle->GetSize().x / 2);
@@ -21,36 +25,61 @@ ArkGame::~ArkGame(void)
 
 void ArkGame::TickRunning(float timespan)
 {
+	TraceScope trace("ArkGame::TickRunning");
 	vector<Ball::SharedPointer> spawned_balls;
+	//Every brick centre moved out of wall space together, once for all the balls. The wall doesn't
+	//move during the tick, it only loses bricks
+	vector<Brick::SharedPointer> bricks;
+	if(mWall.get())
+	{
+		TraceScope centres_trace("TickRunning.BrickCentres");
+		bricks = mWall->GetBricks();
+		mBrickCentres.resize(bricks.size());
+		for(unsigned int i = 0; i < bricks.size(); i++)
+		{
+			mBrickCentres[i] = bricks[i]->GetPosition() + bricks[i]->GetSize() / 2;
+		}
+		if(!mBrickCentres.empty())
+			VectorBatch::Transform(WallToGame(mWall), &mBrickCentres[0], &mBrickCentres[0], static_cast<unsigned int>(mBrickCentres.size()));
+	}
 	for(vector<Ball::SharedPointer>::iterator ball = mBalls.begin(); ball != mBalls.end(); ++ball)
 	{
 		//Advance the ball and bounce off bounds
-		(*ball)->Tick(timespan);
+		{
+			TraceScope move_trace("TickRunning.BallMove");
+			(*ball)->Tick(timespan);
+		}
 		//Collide with the wall
 		bool ball_hit = false;
 		if(mWall.get())
 		{
+			TraceScope bricks_trace("TickRunning.BrickCollisions");
 			Vector2f brick_bounds[4]; //Bounding hull of brick
 
-			vector<Brick::SharedPointer> bricks = mWall->GetBricks();
-			for(vector<Brick::SharedPointer>::iterator brick = bricks.begin(); brick != bricks.end(); ++brick)
+			Vector2f ball_centre = BallToGame(*ball);
+			for(unsigned int i = 0; i < bricks.size(); i++)
 			{
-				brick_bounds[0] = BrickToGame(*brick, mWall) + Vector2f(-(*brick)->GetSize().x,  (*brick)->GetSize().y) / 2.0f;
-				brick_bounds[1] = BrickToGame(*brick, mWall) + Vector2f( (*brick)->GetSize().x,  (*brick)->GetSize().y) / 2.0f;
-				brick_bounds[2] = BrickToGame(*brick, mWall) + Vector2f( (*brick)->GetSize().x, -(*brick)->GetSize().y) / 2.0f;
-				brick_bounds[3] = BrickToGame(*brick, mWall) + Vector2f(-(*brick)->GetSize().x, -(*brick)->GetSize().y) / 2.0f;
+				Brick::SharedPointer& brick = bricks[i];
+				//Knocked out by an earlier ball, and gone from the wall since
+				if(Brick::IsRemovable(brick))
+					continue;
+				Vector2f half_size = brick->GetSize() / 2.0f;
+				brick_bounds[0] = mBrickCentres[i] + Vector2f(-half_size.x,  half_size.y);
+				brick_bounds[1] = mBrickCentres[i] + Vector2f( half_size.x,  half_size.y);
+				brick_bounds[2] = mBrickCentres[i] + Vector2f( half_size.x, -half_size.y);
+				brick_bounds[3] = mBrickCentres[i] + Vector2f(-half_size.x, -half_size.y);
 
 				Vector2f collision_point;
-				float collision_distance = Collisions2f::PolygonPointDistance(brick_bounds, 4, BallToGame(*ball), collision_point);
+				float collision_distance = Collisions2f::PolygonPointDistance(brick_bounds, 4, ball_centre, collision_point);
 				if(collision_distance < (*ball)->GetRadius())
 				{
-					Vector2f outward_vector = BallToGame(*ball) - collision_point;
+					Vector2f outward_vector = ball_centre - collision_point;
 					if(!(*ball)->GetOverlapping())
 					{
 						mSoundsDue.push_back("BrickBounce.wav");
 						(*ball)->Bounce(outward_vector);
 						(*ball)->SetOverlapping(true);
-						(*brick)->Hit();
+						brick->Hit();
 					}
 					ball_hit = true;
 				}
@@ -63,70 +92,73 @@ void ArkGame::TickRunning(float timespan)
 
 
 		//Collide with the paddle
-		Vector2f paddle_bounds[4]; //Bounding hull of paddle
+		{
+			TraceScope paddle_trace("TickRunning.PaddleCollisions");
+			Vector2f paddle_bounds[4]; //Bounding hull of paddle
 
-		paddle_bounds[0] = PaddleToGame(mPaddle) + Vector2f(-mPaddle->GetSize().x,  mPaddle->GetSize().y) / 2.0f;
-		paddle_bounds[1] = PaddleToGame(mPaddle) + Vector2f( mPaddle->GetSize().x,  mPaddle->GetSize().y) / 2.0f;
-		paddle_bounds[2] = PaddleToGame(mPaddle) + Vector2f( mPaddle->GetSize().x, -mPaddle->GetSize().y) / 2.0f;
-		paddle_bounds[3] = PaddleToGame(mPaddle) + Vector2f(-mPaddle->GetSize().x, -mPaddle->GetSize().y) / 2.0f;
+			paddle_bounds[0] = PaddleToGame(mPaddle) + Vector2f(-mPaddle->GetSize().x,  mPaddle->GetSize().y) / 2.0f;
+			paddle_bounds[1] = PaddleToGame(mPaddle) + Vector2f( mPaddle->GetSize().x,  mPaddle->GetSize().y) / 2.0f;
+			paddle_bounds[2] = PaddleToGame(mPaddle) + Vector2f( mPaddle->GetSize().x, -mPaddle->GetSize().y) / 2.0f;
+			paddle_bounds[3] = PaddleToGame(mPaddle) + Vector2f(-mPaddle->GetSize().x, -mPaddle->GetSize().y) / 2.0f;
 
-		Vector2f paddle_collision_point;
-		float paddle_collision_distance = Collisions2f::PolygonPointDistance(paddle_bounds, 4, BallToGame(*ball), paddle_collision_point);
-		if(paddle_collision_distance < (*ball)->GetRadius())
-		{
-			if(!(*ball)->GetOverlappingPaddle())
+			Vector2f paddle_collision_point;
+			float paddle_collision_distance = Collisions2f::PolygonPointDistance(paddle_bounds, 4, BallToGame(*ball), paddle_collision_point);
+			if(paddle_collision_distance < (*ball)->GetRadius())
 			{
-				mSoundsDue.push_back("BatBounce.wav");
+				if(!(*ball)->GetOverlappingPaddle())
+				{
+					mSoundsDue.push_back("BatBounce.wav");
 
-				const Vector2f down_bias(0, -300); //Increasing this makes bounces more vertically biased
+					const Vector2f down_bias(0, -300); //Increasing this makes bounces more vertically biased
 				
-				(*ball)->Bounce(PaddleToGame(mPaddle) - paddle_collision_point + down_bias);
-				(*ball)->SetOverlappingPaddle(true);
-
-				Vector2f direction = (*ball)->GetVelocity();
-				float magnitude = direction.length();
-				direction.normalize();
-				if(mBounces < 150)
-					magnitude += Ball::BOUNCE_ACCELERATION + (Ball::BOUNCE_ACCELERATION_HIGH - Ball::BOUNCE_ACCELERATION) * ((float)mBounces / 150.0f);
-				else
-					magnitude += Ball::BOUNCE_ACCELERATION_HIGH;
-
-				if(magnitude > Ball::MAXIMUM_SPEED)
-				{
-					mSoundsDue.push_back("BallSplit.wav");
-					Vector2f split_direction;
+					(*ball)->Bounce(PaddleToGame(mPaddle) - paddle_collision_point + down_bias);
+					(*ball)->SetOverlappingPaddle(true);
 
-					if(mBounces < 100)
-						magnitude = Ball::INITIAL_SPEED + (Ball::MAXIMUM_SPEED - Ball::INITIAL_SPEED) * ((float)mBounces) / 120.0f;
+					Vector2f direction = (*ball)->GetVelocity();
+					float magnitude = direction.length();
+					direction.normalize();
+					if(mBounces < 150)
+						magnitude += Ball::BOUNCE_ACCELERATION + (Ball::BOUNCE_ACCELERATION_HIGH - Ball::BOUNCE_ACCELERATION) * ((float)mBounces / 150.0f);
 					else
-						magnitude = Ball::MAXIMUM_SPEED / 1.2f;
+						magnitude += Ball::BOUNCE_ACCELERATION_HIGH;
 
-					if(direction.x < 0)
-						direction.x -= 0.2f;
-					else
-						direction.x += 0.2f;
+					if(magnitude > Ball::MAXIMUM_SPEED)
+					{
+						mSoundsDue.push_back("BallSplit.wav");
+						Vector2f split_direction;
 
-					direction.normalize();
-					split_direction = direction;
-					split_direction.x *= -1;
+						if(mBounces < 100)
+							magnitude = Ball::INITIAL_SPEED + (Ball::MAXIMUM_SPEED - Ball::INITIAL_SPEED) * ((float)mBounces) / 120.0f;
+						else
+							magnitude = Ball::MAXIMUM_SPEED / 1.2f;
 
+						if(direction.x < 0)
+							direction.x -= 0.2f;
+						else
+							direction.x += 0.2f;
 
-					Ball::SharedPointer split_ball(new Ball());
-					split_ball->SetPosition((*ball)->GetPosition());
-					split_ball->SetVelocity(split_direction * (magnitude + 2 * Ball::BOUNCE_ACCELERATION));
-					split_ball->SetOverlappingPaddle(true);
-					spawned_balls.push_back(split_ball);
-				}
-				(*ball)->SetVelocity(direction * magnitude);
+						direction.normalize();
+						split_direction = direction;
+						split_direction.x *= -1;
+
+
+						Ball::SharedPointer split_ball(new Ball());
+						split_ball->SetPosition((*ball)->GetPosition());
+						split_ball->SetVelocity(split_direction * (magnitude + 2 * Ball::BOUNCE_ACCELERATION));
+						split_ball->SetOverlappingPaddle(true);
+						spawned_balls.push_back(split_ball);
+					}
+					(*ball)->SetVelocity(direction * magnitude);
 
-				//Scoring
-				if(mWall.get())
-					mScore += static_cast<int>(mWall->GetBricks().size()) * BOUNCE_POINTS;
-				mBounces++;
+					//Scoring
+					if(mWall.get())
+						mScore += static_cast<int>(mWall->GetBricks().size()) * BOUNCE_POINTS;
+					mBounces++;
+				}
+			} else
+			{
+				(*ball)->SetOverlappingPaddle(false);
 			}
-		} else
-		{
-			(*ball)->SetOverlappingPaddle(false);
 		}
 	}
 	for(vector<Ball::SharedPointer>::iterator it = spawned_balls.begin(); it != spawned_balls.end(); ++it)
@@ -136,6 +168,7 @@ void ArkGame::TickRunning(float timespan)
 
 	if(mWall.get())
 	{
+		TraceScope lost_trace("TickRunning.RemoveLostBalls");
 		int ball_count = static_cast<int>(mBalls.size());
 		mBalls.erase(std::remove_if(mBalls.begin(), mBalls.end(), Ball::IsRemovable), mBalls.end());
 		mScore += static_cast<int>(mWall->GetBricks().size()) * BOUNCE_POINTS * BALL_POINTS * (ball_count - mBalls.size());
@@ -145,7 +178,10 @@ void ArkGame::TickRunning(float timespan)
 		}
 
 	}
-	mPaddle->Tick(timespan, mBalls, mWall);
+	{
+		TraceScope paddle_tick_trace("TickRunning.PaddleTick");
+		mPaddle->Tick(timespan, mBalls, mWall);
+	}
 
 	if(mBalls.size() == 0)
 	{
@@ -156,6 +192,7 @@ void ArkGame::TickRunning(float timespan)
 
 void ArkGame::Tick(float timespan)
 {
+	AllocationScope allocations(AllocationTag::Simulation);
 	mTimer += timespan;
 
 	switch(mPhase)
@@ -204,10 +241,42 @@ void ArkGame::SetWall(Wall::SharedPointer wall)
 
 void ArkGame::AddBall(Ball::SharedPointer ball)
 {
+	ball->SetId(mNextBallId++);
 	mBalls.push_back(ball);
 	ball->SetBounds(mBounds);
 }
 
+void ArkGame::FillSnapshot(RenderSnapshot& snapshot)
+{
+	snapshot.mScore = mScore;
+	snapshot.mPaddle = PaddleToGame(mPaddle);
+
+	snapshot.mBalls.resize(mBalls.size());
+	for(unsigned int i = 0; i < mBalls.size(); i++)
+	{
+		BallSnapshot& ball = snapshot.mBalls[i];
+		ball.mId = mBalls[i]->GetId();
+		ball.mPosition = BallToGame(mBalls[i]);
+		const std::deque<Vector2f>& trail = mBalls[i]->GetTrail();
+		ball.mTrail.assign(trail.begin(), trail.end());
+	}
+
+	if(mWall.get())
+	{
+		const vector<Brick::SharedPointer>& bricks = mWall->GetBricks();
+		snapshot.mBricks.resize(bricks.size());
+		for(unsigned int i = 0; i < bricks.size(); i++)
+		{
+			BrickSnapshot& brick = snapshot.mBricks[i];
+			brick.mId = bricks[i]->GetId();
+			brick.mBrickType = bricks[i]->GetBrickType();
+			brick.mLives = bricks[i]->GetLives();
+			brick.mPosition = BrickToGame(bricks[i], mWall);
+		}
+	} else
+		snapshot.mBricks.clear();
+}
+
 Vector2f ArkGame::BallToGame(Ball::SharedPointer ball)
 {
 	return ball->GetPosition() + Vector2f((640 - ball->GetBounds().x) / 2, 0);
@@ -218,12 +287,21 @@ Vector2f ArkGame::BallToGame(Ball* ball)
 	return ball->GetPosition() + Vector2f((640 - ball->GetBounds().x) / 2, 0);
 }
 
-Vector2f ArkGame::BrickToGame(Brick::SharedPointer brick, Wall::SharedPointer wall)
+Vector2f ArkGame::BrickToGame(const Brick::SharedPointer& brick, const Wall::SharedPointer& wall)
 {
 	return brick->GetPosition() + wall->GetPosition() + (brick->GetSize() / 2) +
 		   Vector2f((640 - wall->GetBounds().x) / 2, 0);
 }
 
+Matrix3f ArkGame::WallToGame(Wall::SharedPointer wall)
+{
+	Vector2f offset = wall->GetPosition() + Vector2f((640 - wall->GetBounds().x) / 2, 0);
+	Matrix3f translation;
+	translation.at(2, 0) = offset.x;
+	translation.at(2, 1) = offset.y;
+	return translation;
+}
+
 Vector2f ArkGame::PaddleToGame(Paddle::SharedPointer paddle)
 {
 	return paddle->GetPosition() + Vector2f((640 - paddle->GetBounds().x) / 2.0, 0) + Vector2f(paddle->GetSize().x / 2, -paddle->GetSize().y / 2);
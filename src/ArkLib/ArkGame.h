@@ -5,6 +5,7 @@
 #include "Wall.h"
 #include "Ball.h"
 #include "Paddle.h"
+#include "RenderSnapshot.h"
 #include <vector>
 
 /* ArkGame represents the moding of the game - it performs all the updates,
@@ -45,7 +46,9 @@ private:
 	Paddle::SharedPointer mPaddle;
 	int mScore;
 	int mBounces;
+	unsigned int mNextBallId;
 	std::vector<std::string> mSoundsDue;
+	std::vector<Vector2f> mBrickCentres; //Game space, kept to save reallocating each tick
 
 //Public getters/setters
 public:
@@ -69,11 +72,16 @@ public:
 //Public methods
 public:
 	void Tick(float timespan);
+	/* Copies what is needed to draw the game. Reuses the snapshot's storage, so refilling
+	   the same snapshot each tick doesn't allocate once the ball and brick counts settle */
+	void FillSnapshot(RenderSnapshot& snapshot);
 	//Gets the balls center in game space 
 	static Vector2f BallToGame(Ball::SharedPointer ball);
 	static Vector2f BallToGame(Ball* ball);
 	//Gets the bricks center in game space
-	static Vector2f BrickToGame(Brick::SharedPointer brick, Wall::SharedPointer wall);
+	static Vector2f BrickToGame(const Brick::SharedPointer& brick, const Wall::SharedPointer& wall);
+	//Moves points from the walls space to game space
+	static Matrix3f WallToGame(Wall::SharedPointer wall);
 	//Gets the paddles center in game space
 	static Vector2f PaddleToGame(Paddle::SharedPointer paddle);
 //Private methods
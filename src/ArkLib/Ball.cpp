@@ -12,7 +12,8 @@ Ball::Ball(void) :
 	mOverlapping(false),
 	mOverlappingPaddle(false),
 	mTrailTime(0),
-	mTrailOffset(0, 0)
+	mTrailOffset(0, 0),
+	mId(0)
 {
 }
 
@@ -42,6 +42,7 @@ private:
 	std::deque<Vector2f> mTrail;
 	float mTrailTime;
 	Vector2f mTrailOffset;
+	unsigned int mId;
 //Public getters/setters
 public:
 	//Gets/sets the centre of the ball
@@ -63,7 +64,11 @@ public:
 	bool GetOverlappingPaddle() const {return mOverlappingPaddle;}
 	void SetOverlappingPaddle(bool overlapping) {mOverlappingPaddle = overlapping;}
 
-	const std::deque<Vector2f> GetTrail() const {return mTrail;}
+	const std::deque<Vector2f>& GetTrail() const {return mTrail;}
+
+	//Set by the game, increasing in the order balls are added
+	unsigned int GetId() const {return mId;}
+	void SetId(unsigned int id){mId = id;}
 
 //Public methods
 public:
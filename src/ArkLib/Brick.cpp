@@ -8,7 +8,8 @@ bool Brick::IsRemovable(SharedPointer brick)
 Brick::Brick(BrickType::Enum brickType) :
 	mBrickType(brickType),
 	mSize((float)BRICK_WIDTH, (float)BRICK_HEIGHT),
-	mPosition(0, 0)
+	mPosition(0, 0),
+	mId(0)
 {
 	switch(mBrickType)
 	{
@@ -38,6 +38,7 @@ private:
 	Vector2f mSize;
 	Vector2f mPosition;
 	int mLives;
+	unsigned int mId;
 
 //Public getters/setters
 public:
@@ -48,5 +49,8 @@ public:
 	void SetPosition(Vector2f position){mPosition = position;}
 
 	int GetLives(){return mLives;}
+	//Set by the wall, increasing in the order bricks are added
+	unsigned int GetId() const {return mId;}
+	void SetId(unsigned int id){mId = id;}
 	void Hit(){mLives--;}
 };
@@ -2,24 +2,74 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <string>
+#include <cstring>
 #include "vmath.h"
 
+namespace LogLevel
+{
+	/* Most severe first, setting a level keeps it and everything before it */
+	enum Enum
+	{
+		Error,
+		Diagnostic,
+		Count
+	};
+}
+
+class LogWriter;
+
+/* Error and diagnostic text logs, each written to its own file and the console.
+   Until StartWriter is called every value is written as it's logged, from one thread only.
+   Once the writer is running, logging a value only copies a small record (level, time, format
+   and the value) into a ring belonging to the calling thread; a background thread formats and
+   writes them, so no thread waits on the disk or console and any thread may log. Lines from
+   different threads are kept whole and written in the order they were started.
+   Values logged at a level past SetLevel are dropped inline before any work is done */
 class Logger
 {
 private:
-	Logger(std::string _filename);
+	Logger(LogLevel::Enum _level, std::string _filename);
+	LogLevel::Enum level_;
 	std::ofstream output_;
+	static LogLevel::Enum threshold_;
+
+	bool IsEnabled() const {return level_ <= threshold_;}
+	void Write(int _value);
+	void Write(unsigned int _value);
+	void Write(float _value);
+	void Write(double _value);
+	void Write(const char* _text, size_t _length);
+	void Write(const Vector3f& _value);
+	void Write(const Vector2f& _value);
+	/* Formatted text straight to the file and console */
+	void Output(const std::string& _text);
+	static Logger& ForLevel(LogLevel::Enum _level);
+	friend class LogWriter;
 
 public:
 	static Logger& ErrorOut();
 	static Logger& DiagnosticOut();
 	~Logger(void);
 
-	Logger& Logger::operator <<( int i );
-	Logger& Logger::operator <<( unsigned int i );
-	Logger& Logger::operator <<( float i );
-	Logger& Logger::operator <<( double i );
-	Logger& Logger::operator <<( std::string i );
-	Logger& Logger::operator <<(Vector3f v);
-	Logger& Logger::operator <<(Vector2f v);
+	static void SetLevel(LogLevel::Enum _level){threshold_ = _level;}
+	static LogLevel::Enum GetLevel(){return threshold_;}
+	/* Starts the background writer. Call before any other thread logs */
+	static void StartWriter();
+	/* Stops the background writer once everything queued is written, back to writing as logged.
+	   Must be called before exit, while the log files are still open */
+	static void StopWriter();
+	/* Waits until everything already logged, by any thread, is in the files */
+	static void Flush();
+	/* Records lost because a thread logged faster than the writer could keep up */
+	static unsigned int GetDropped();
+
+	Logger& operator <<(int i){if(IsEnabled()) Write(i); return *this;}
+	Logger& operator <<(unsigned int i){if(IsEnabled()) Write(i); return *this;}
+	Logger& operator <<(float i){if(IsEnabled()) Write(i); return *this;}
+	Logger& operator <<(double i){if(IsEnabled()) Write(i); return *this;}
+	Logger& operator <<(const char* i){if(IsEnabled()) Write(i, strlen(i)); return *this;}
+	Logger& operator <<(const std::string& i){if(IsEnabled()) Write(i.data(), i.size()); return *this;}
+	Logger& operator <<(const Vector3f& v){if(IsEnabled()) Write(v); return *this;}
+	Logger& operator <<(const Vector2f& v){if(IsEnabled()) Write(v); return *this;}
 };
@@ -0,0 +1,33 @@
+#pragma once
+#include "vmath.h"
+#include "Brick.h"
+#include <vector>
+
+/* Everything needed to draw a frame of the game, copied out of ArkGame so that it can be drawn
+   while the game carries on. Positions are in game space, y up, as from ArkGame::BallToGame.
+   Balls and bricks keep their ids from one snapshot to the next, and stay in increasing id order */
+struct BallSnapshot
+{
+	unsigned int mId;
+	Vector2f mPosition;
+	std::vector<Vector2f> mTrail;
+};
+
+struct BrickSnapshot
+{
+	unsigned int mId;
+	BrickType::Enum mBrickType;
+	int mLives;
+	Vector2f mPosition;
+};
+
+struct RenderSnapshot
+{
+	unsigned int mSequence; //Game tick the snapshot was taken after, set by whoever publishes it
+	int mScore;
+	Vector2f mPaddle;
+	std::vector<BallSnapshot> mBalls;
+	std::vector<BrickSnapshot> mBricks;
+
+	RenderSnapshot() : mSequence(0), mScore(0){}
+};
@@ -4,6 +4,9 @@
 #include "AnimationSet.h"
 #include <TinyXML.h>
 #include "Logger.h"
+#include <algorithm>
+#include <cstring>
+#include <sstream>
 
 using std::string;
 using std::map;
@@ -17,9 +20,116 @@ TextureManager* TextureManager::GetInstance()
 	return instance_;
 }
 
-AnimationSet* TextureManager::AddAnimationSet(string _xml_animation_set)
+std::vector<string> AnimationSetDescription::GetFiles() const
 {
-	AnimationSet* p_animation_set = new AnimationSet();
+	std::vector<string> files;
+	for(std::vector<AnimationDescription>::const_iterator animation = animations.begin(); animation != animations.end(); ++animation)
+	{
+		for(std::vector<Frame>::const_iterator frame = animation->frames.begin(); frame != animation->frames.end(); ++frame)
+		{
+			if(std::find(files.begin(), files.end(), frame->file) == files.end())
+				files.push_back(frame->file);
+		}
+	}
+	return files;
+}
+
+namespace
+{
+	template<typename T>
+	void WriteValue(std::vector<char>& _data, const T& _value)
+	{
+		const char* bytes = reinterpret_cast<const char*>(&_value);
+		_data.insert(_data.end(), bytes, bytes + sizeof(T));
+	}
+
+	void WriteString(std::vector<char>& _data, const string& _value)
+	{
+		WriteValue(_data, static_cast<unsigned int>(_value.size()));
+		_data.insert(_data.end(), _value.begin(), _value.end());
+	}
+
+	/* Reads from a buffer, failing rather than running past its end */
+	class Reader
+	{
+	private:
+		const char* data_;
+		unsigned int left_;
+	public:
+		Reader(const char* _data, unsigned int _size) : data_(_data), left_(_size){}
+		template<typename T>
+		bool Value(T& _value)
+		{
+			if(left_ < sizeof(T))
+				return false;
+			memcpy(&_value, data_, sizeof(T));
+			data_ += sizeof(T);
+			left_ -= sizeof(T);
+			return true;
+		}
+		bool String(string& _value)
+		{
+			unsigned int length = 0;
+			if(!Value(length) || left_ < length)
+				return false;
+			_value.assign(data_, length);
+			data_ += length;
+			left_ -= length;
+			return true;
+		}
+	};
+}
+
+void AnimationSetDescription::Write(std::vector<char>& _data) const
+{
+	WriteValue(_data, static_cast<unsigned int>(animations.size()));
+	for(std::vector<AnimationDescription>::const_iterator animation = animations.begin(); animation != animations.end(); ++animation)
+	{
+		WriteString(_data, animation->name);
+		WriteValue(_data, static_cast<unsigned int>(animation->frames.size()));
+		for(std::vector<Frame>::const_iterator frame = animation->frames.begin(); frame != animation->frames.end(); ++frame)
+		{
+			WriteValue(_data, frame->offset);
+			WriteValue(_data, frame->size);
+			WriteValue(_data, frame->frame_offset);
+			WriteValue(_data, frame->time);
+			WriteString(_data, frame->file);
+		}
+	}
+}
+
+bool AnimationSetDescription::Read(const char* _data, unsigned int _size)
+{
+	Reader reader(_data, _size);
+	unsigned int animation_count = 0;
+	if(!reader.Value(animation_count))
+		return false;
+	std::vector<AnimationDescription> read;
+	for(unsigned int i = 0; i < animation_count; i++)
+	{
+		read.push_back(AnimationDescription());
+		AnimationDescription& animation = read.back();
+		unsigned int frame_count = 0;
+		if(!reader.String(animation.name) || !reader.Value(frame_count))
+			return false;
+		for(unsigned int j = 0; j < frame_count; j++)
+		{
+			Frame frame;
+			if(!reader.Value(frame.offset) || !reader.Value(frame.size) || !reader.Value(frame.frame_offset) ||
+			   !reader.Value(frame.time) || !reader.String(frame.file))
+				return false;
+			animation.frames.push_back(frame);
+		}
+	}
+	animations.swap(read);
+	return true;
+}
+
+bool TextureManager::ReadAnimationSet(const string& _xml_animation_set, AnimationSetDescription& _description)
+{
+	if(instance_ && instance_->ReadPrebuilt(_xml_animation_set, _description))
+		return true;
+
 	bool error = false;
 
 	TiXmlDocument animation_set_doc;
@@ -36,12 +146,13 @@ AnimationSet* TextureManager::AddAnimationSet(string _xml_animation_set)
 			int animation_id = 0;
 			while(p_animation_el)
 			{
-				Animation* p_animation = new Animation();
-				string name;
-				if(p_animation_el->QueryValueAttribute("Name", &name) != TIXML_SUCCESS)
-					Logger::DiagnosticOut() << _xml_animation_set << ": Animation ID: " << animation_id << ": Animation not named\n";
-				else
-					p_animation->SetName(name);
+				AnimationSetDescription::AnimationDescription animation;
+				if(p_animation_el->QueryValueAttribute("Name", &animation.name) != TIXML_SUCCESS)
+				{
+					std::ostringstream message;
+					message << _xml_animation_set << ": Animation ID: " << animation_id << ": Animation not named";
+					_description.diagnostics.push_back(message.str());
+				}
 
 				TiXmlElement* p_frame_el = p_animation_el->FirstChildElement("Frame");
 				while(p_frame_el)
@@ -60,74 +171,133 @@ AnimationSet* TextureManager::AddAnimationSet(string _xml_animation_set)
 					   p_frame_el->QueryValueAttribute("File", &file) == TIXML_SUCCESS &&
 					   p_frame_el->QueryFloatAttribute("Time", &frame_time) == TIXML_SUCCESS)
 					{
+						AnimationSetDescription::Frame frame;
+						frame.offset = Vector2i(left, top);
+						frame.size = Vector2i(width, height);
+						frame.file = file;
+						frame.time = frame_time;
 						//Optional parameters
-						Vector2i frame_offset = Vector2i(0,0);
-						p_frame_el->QueryIntAttribute("OffsetX", &frame_offset.x);
-						p_frame_el->QueryIntAttribute("OffsetY", &frame_offset.y);
-						AnimationFrame* p_frame = instance_->AcquireResource(Vector2i(left, top), Vector2i(width, height), file, frame_time, frame_offset);
-						p_animation->AddFrame(p_frame);
+						frame.frame_offset = Vector2i(0,0);
+						p_frame_el->QueryIntAttribute("OffsetX", &frame.frame_offset.x);
+						p_frame_el->QueryIntAttribute("OffsetY", &frame.frame_offset.y);
+						animation.frames.push_back(frame);
 					} else
 					{
-						Logger::ErrorOut() << "Error parsing a frame - either Width, height, left, top, file or time is missing\n";
+						_description.errors.push_back("Error parsing a frame - either Width, height, left, top, file or time is missing");
 						error = true;
 					}
 
 					p_frame_el = p_frame_el->NextSiblingElement("Frame");
 				}
 				p_animation_el = p_animation_el->NextSiblingElement("Animation");
-				p_animation_set->AddAnimation(p_animation);
+				_description.animations.push_back(animation);
 				animation_id++;
 			}
 		} else
 		{
-			Logger::ErrorOut() << "Root 'AnimationSet' element missing\n";
+			_description.errors.push_back("Root 'AnimationSet' element missing");
 			error = true;
 		}
 	} else
 	{
-		Logger::ErrorOut() << "Unable to open file: " << _xml_animation_set << "\n" <<
-								animation_set_doc.ErrorDesc() << "\n";
+		_description.errors.push_back("Unable to open file: " + _xml_animation_set + "\n" + animation_set_doc.ErrorDesc());
 		error = true;
 	}
+	return !error;
+}
 
-	if(error)
+AnimationSet* TextureManager::AddAnimationSet(const string& _xml_animation_set, const AnimationSetDescription& _description)
+{
+	for(std::vector<string>::const_iterator it = _description.diagnostics.begin(); it != _description.diagnostics.end(); ++it)
 	{
-		delete p_animation_set;
-		p_animation_set = NULL;
-	} else
+		Logger::DiagnosticOut() << *it << "\n";
+	}
+	for(std::vector<string>::const_iterator it = _description.errors.begin(); it != _description.errors.end(); ++it)
 	{
-		GetInstance()->animations_[_xml_animation_set] = p_animation_set;
+		Logger::ErrorOut() << *it << "\n";
 	}
+	if(!_description.errors.empty())
+		return NULL;
+
+	TextureManager* instance = GetInstance();
+	map<string, AnimationSet*>::iterator loaded = instance->animations_.find(_xml_animation_set);
+	if(loaded != instance->animations_.end())
+		return loaded->second;
 
+	AnimationSet* p_animation_set = new AnimationSet();
+	for(std::vector<AnimationSetDescription::AnimationDescription>::const_iterator animation = _description.animations.begin(); animation != _description.animations.end(); ++animation)
+	{
+		Animation* p_animation = new Animation();
+		if(!animation->name.empty())
+			p_animation->SetName(animation->name);
+		for(std::vector<AnimationSetDescription::Frame>::const_iterator frame = animation->frames.begin(); frame != animation->frames.end(); ++frame)
+		{
+			AnimationFrame* p_frame = instance->AcquireResource(frame->offset, frame->size, frame->file, frame->time, frame->frame_offset);
+			p_animation->AddFrame(p_frame);
+		}
+		p_animation_set->AddAnimation(p_animation);
+	}
+	instance->animations_[_xml_animation_set] = p_animation_set;
+	instance->ResolveHandles(_xml_animation_set, p_animation_set);
 	return p_animation_set;
 }
 
-AnimationSet* TextureManager::GetAnimationSet(string _xml_animation_set)
+AnimationSet* TextureManager::AddAnimationSet(const string& _xml_animation_set)
 {
-	if(GetInstance()->animations_.find(_xml_animation_set) != GetInstance()->animations_.end())
-	{
-		return GetInstance()->animations_[_xml_animation_set];
-	} else
-	{
-		return GetInstance()->AddAnimationSet(_xml_animation_set);
-	}
+	AnimationSetDescription description;
+	ReadAnimationSet(_xml_animation_set, description);
+	return AddAnimationSet(_xml_animation_set, description);
+}
+
+AnimationSet* TextureManager::GetAnimationSet(const string& _xml_animation_set)
+{
+	map<string, AnimationSet*>::iterator loaded = GetInstance()->animations_.find(_xml_animation_set);
+	if(loaded != GetInstance()->animations_.end())
+		return loaded->second;
+	return AddAnimationSet(_xml_animation_set);
 }
 
 
 /* Either loads the animation, or if already loaded returns a copy of it */
 /* If there is more than one animation then the first is returned */
-Animation* TextureManager::GetAnimation(std::string _xml_animation)
+Animation* TextureManager::GetAnimation(const std::string& _xml_animation)
 {
-	if(GetInstance()->animations_.find(_xml_animation) !=  GetInstance()->animations_.end())
-	{
-		return GetInstance()->animations_[_xml_animation]->GetDefaultAnimation();
-	} else
+	AnimationSet* as = GetAnimationSet(_xml_animation);
+	if(as)
+		return as->GetDefaultAnimation();
+	else
+		return NULL;
+}
+
+AnimationHandle TextureManager::GetHandle(const string& _xml_animation_set, const string& _animation)
+{
+	TextureManager* instance = GetInstance();
+	//Neither name can contain a newline, so the key is unambiguous
+	string key = _xml_animation_set + "\n" + _animation;
+	map<string, AnimationHandle>::iterator interned = instance->handles_.find(key);
+	if(interned != instance->handles_.end())
+		return interned->second;
+
+	AnimationHandle handle = static_cast<AnimationHandle>(instance->handle_names_.size());
+	HandleName name;
+	name.set = _xml_animation_set;
+	name.animation = _animation;
+	instance->handle_names_.push_back(name);
+	instance->resolved_.push_back(NULL);
+	instance->handles_[key] = handle;
+
+	map<string, AnimationSet*>::iterator loaded = instance->animations_.find(_xml_animation_set);
+	if(loaded != instance->animations_.end())
+		instance->resolved_[handle] = loaded->second->GetAnimation(_animation);
+	return handle;
+}
+
+void TextureManager::ResolveHandles(const string& _xml_animation_set, AnimationSet* _set)
+{
+	for(unsigned int handle = 0; handle < handle_names_.size(); handle++)
 	{
-		AnimationSet* as = GetInstance()->AddAnimationSet(_xml_animation);
-		if(as)
-			return as->GetDefaultAnimation();
-		else
-			return NULL;
+		if(handle_names_[handle].set == _xml_animation_set)
+			resolved_[handle] = _set->GetAnimation(handle_names_[handle].animation);
 	}
 }
 
@@ -137,6 +307,12 @@ AnimationFrame* TextureManager::AcquireResource(Vector2i /*_offset*/, Vector2i /
 	//Nothing done, override in SDL/OpenGL implementations
 	return new AnimationFrame(-1, _time, _frame_offset);
 }
+bool TextureManager::ReadPrebuilt(const std::string& /*_xml_animation_set*/, AnimationSetDescription& /*_description*/)
+{
+	//Nothing prebuilt, the XML is read
+	return false;
+}
+
 void TextureManager::InternalClearCache()
 {
 	//Nothing done, override in SDL/OpenGL implementations
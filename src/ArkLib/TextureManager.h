@@ -1,19 +1,65 @@
 #pragma once
 #include <map>
 #include <string>
+#include <vector>
 #include "vmath.h"
 
 class Animation;
 class AnimationFrame;
 class AnimationSet;
 
+/* An animation set file that has been read but not yet turned into frames. Reading touches
+   nothing shared, so it can happen on a worker thread while the frames are made on the main one */
+struct AnimationSetDescription
+{
+	struct Frame
+	{
+		Vector2i offset;
+		Vector2i size;
+		Vector2i frame_offset;
+		std::string file;
+		float time;
+	};
+	struct AnimationDescription
+	{
+		std::string name;
+		std::vector<Frame> frames;
+	};
+	std::vector<AnimationDescription> animations;
+	/* Problems found while reading, logged when the set is added */
+	std::vector<std::string> diagnostics;
+	std::vector<std::string> errors;
+
+	/* Each image file the frames are cut from, once */
+	std::vector<std::string> GetFiles() const;
+
+	/* Flat binary form, for prebuilt asset bundles. Only read back on the machine type that wrote it.
+	   Read returns false, leaving the description as it was, if _data is cut short */
+	void Write(std::vector<char>& _data) const;
+	bool Read(const char* _data, unsigned int _size);
+};
+
+/* Index of an animation in a set, interned by name once and then used instead of the names */
+typedef int AnimationHandle;
+
 class TextureManager
 {
 private:
+	struct HandleName
+	{
+		std::string set;
+		std::string animation;
+	};
+
 	std::map<std::string, AnimationSet*> animations_;
+	std::map<std::string, AnimationHandle> handles_;	//Keyed by set and animation name
+	std::vector<HandleName> handle_names_;
+	std::vector<Animation*> resolved_;				//By handle, NULL until the set is loaded
 	static TextureManager* instance_;
 	static TextureManager* GetInstance();
-	static AnimationSet* AddAnimationSet(std::string _xml_animation_set);
+	static AnimationSet* AddAnimationSet(const std::string& _xml_animation_set);
+	/* Points the handles waiting on a set at its animations */
+	void ResolveHandles(const std::string& _xml_animation_set, AnimationSet* _set);
 
 	/* To be overriden in implementing classes (SDL/OpenGL/DirectX) */
 	/* Should return an ID that can be used to find resource */
@@ -21,10 +67,32 @@ private:
 	/* To be overriden in implementing classes (SDL/OpenGL/DirectX) */
 	/* Should clear any cache used while loading, but not invalidate the actual loaded textures */
 	virtual void InternalClearCache();
+	/* May be overriden to supply sets that were read ahead of time, e.g. from an asset bundle */
+	/* Called from any thread, so must only read */
+	virtual bool ReadPrebuilt(const std::string& _xml_animation_set, AnimationSetDescription& _description);
 public:
-	
-	static AnimationSet* GetAnimationSet(std::string _xml_animation_set);
-	static Animation* GetAnimation(std::string _xml_animation);
+	static const AnimationHandle NoAnimation = -1;
+
+	static AnimationSet* GetAnimationSet(const std::string& _xml_animation_set);
+	/* Reads an animation set file without creating any frames. Safe to call from any thread.
+	   Returns false if the set can't be used, the reasons are in _description.errors */
+	static bool ReadAnimationSet(const std::string& _xml_animation_set, AnimationSetDescription& _description);
+	/* Creates the frames for a set read earlier and adds it under _xml_animation_set. Logs what
+	   reading found. If the set was loaded meanwhile the one already loaded is returned */
+	static AnimationSet* AddAnimationSet(const std::string& _xml_animation_set, const AnimationSetDescription& _description);
+	static Animation* GetAnimation(const std::string& _xml_animation);
+
+	/* The same handle for the same names every time. Doesn't load the set, the handle resolves
+	   once the set is loaded by any means */
+	static AnimationHandle GetHandle(const std::string& _xml_animation_set, const std::string& _animation);
+	/* An array lookup, for draw time. NULL if the set isn't loaded or has no such animation */
+	static Animation* GetAnimation(AnimationHandle _handle)
+	{
+		TextureManager* instance = GetInstance();
+		if(_handle < 0 || _handle >= static_cast<AnimationHandle>(instance->resolved_.size()))
+			return NULL;
+		return instance->resolved_[_handle];
+	}
 
 	static void SetTextureManager(TextureManager* _instance){instance_ = _instance;}
 	static void Release();
@@ -0,0 +1,214 @@
+#include "Trace.h"
+#include "Logger.h"
+#include <vector>
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <intrin.h>
+#pragma intrinsic(_ReadWriteBarrier)
+#define TRACE_THREAD_LOCAL __declspec(thread)
+#define TRACE_BARRIER() _ReadWriteBarrier()
+#else
+#include <time.h>
+#define TRACE_THREAD_LOCAL __thread
+#define TRACE_BARRIER() __sync_synchronize()
+#endif
+
+namespace
+{
+	/* One timed scope, as recorded */
+	struct TraceEvent
+	{
+		const char* name;
+		char detail[40];
+		double start;
+		double end;
+		unsigned int frame;
+		unsigned int thread;
+		volatile bool complete;	//Set once the rest has been filled in
+	};
+
+	std::vector<TraceEvent> events;
+	volatile long claimed = 0;	//Events handed out, including ones that didn't fit
+	volatile long dropped = 0;
+	volatile long threads = 0;
+	TRACE_THREAD_LOCAL long threadId = 0;	//Small numbers from 1 read better in a viewer than system ids
+	std::string filename;
+	unsigned int frame = 0;
+	unsigned int firstFrame = 0;
+	unsigned int endFrame = 0;
+	bool pending = false;		//Started and not yet written
+	double origin = 0;
+
+#ifdef _WIN32
+	double QueryPeriod()
+	{
+		LARGE_INTEGER frequency;
+		QueryPerformanceFrequency(&frequency);
+		return 1.0 / static_cast<double>(frequency.QuadPart);
+	}
+
+	const double clockPeriod = QueryPeriod();
+
+	long Increment(volatile long* _value)
+	{
+		return InterlockedIncrement(_value);
+	}
+#else
+	long Increment(volatile long* _value)
+	{
+		return __sync_add_and_fetch(_value, 1);
+	}
+#endif
+
+	void WriteString(std::ostream& _out, const char* _text)
+	{
+		_out << '"';
+		for(const char* c = _text; *c; ++c)
+		{
+			if(*c == '"' || *c == '\\')
+				_out << '\\' << *c;
+			else if(static_cast<unsigned char>(*c) < 0x20)
+				_out << ' ';
+			else
+				_out << *c;
+		}
+		_out << '"';
+	}
+
+	void Write()
+	{
+		std::ofstream out(filename.c_str(), std::ios::trunc);
+		if(!out)
+		{
+			Logger::ErrorOut() << "Unable to write trace " << filename << "\n";
+			return;
+		}
+		out.setf(std::ios::fixed);
+		out.precision(3);
+		out << "{\"traceEvents\":[";
+		unsigned int written = 0;
+		unsigned int count = std::min(static_cast<unsigned int>(claimed), static_cast<unsigned int>(events.size()));
+		for(unsigned int i = 0; i < count; i++)
+		{
+			const TraceEvent& event = events[i];
+			if(!event.complete)
+				continue;
+			out << (written ? ",\n" : "\n") << "{\"name\":";
+			WriteString(out, event.name);
+			//Complete events, microseconds from the start of the trace
+			out << ",\"ph\":\"X\",\"ts\":" << (event.start - origin) * 1e6 << ",\"dur\":" << (event.end - event.start) * 1e6 <<
+				   ",\"pid\":1,\"tid\":" << event.thread << ",\"args\":{\"frame\":" << event.frame;
+			if(event.detail[0])
+			{
+				out << ",\"detail\":";
+				WriteString(out, event.detail);
+			}
+			out << "}}";
+			written++;
+		}
+		out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+		Logger::DiagnosticOut() << "Trace: " << written << " events written to " << filename << ", " <<
+								   static_cast<int>(dropped) << " dropped\n";
+	}
+}
+
+volatile bool Trace::recording_ = false;
+
+#ifdef _WIN32
+double Trace::Now()
+{
+	LARGE_INTEGER count;
+	QueryPerformanceCounter(&count);
+	return static_cast<double>(count.QuadPart) * clockPeriod;
+}
+#else
+double Trace::Now()
+{
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return static_cast<double>(now.tv_sec) + static_cast<double>(now.tv_nsec) * 1e-9;
+}
+#endif
+
+void Trace::Start(unsigned int _first, unsigned int _frames, const std::string& _filename, unsigned int _capacity)
+{
+	recording_ = false;
+	events.clear();
+	events.resize(_capacity);
+	claimed = 0;
+	dropped = 0;
+	filename = _filename;
+	frame = 0;
+	firstFrame = _first;
+	endFrame = _first + _frames;
+	origin = Now();
+	pending = _frames > 0 && _capacity > 0;
+	recording_ = pending && _first == 0;
+}
+
+void Trace::EndFrame()
+{
+	if(!pending)
+		return;
+	frame++;
+	if(frame < endFrame)
+	{
+		recording_ = frame >= firstFrame;
+		return;
+	}
+	recording_ = false;
+	pending = false;
+	Write();
+}
+
+void Trace::Finish()
+{
+	if(!pending)
+		return;
+	recording_ = false;
+	pending = false;
+	Write();
+}
+
+void Trace::Record(const char* _name, const char* _detail, double _start, double _end)
+{
+	if(!recording_)
+		return;
+	if(!threadId)
+		threadId = Increment(&threads);
+	long index = Increment(&claimed) - 1;
+	if(index >= static_cast<long>(events.size()))
+	{
+		Increment(&dropped);
+		return;
+	}
+	TraceEvent& event = events[index];
+	event.name = _name;
+	event.detail[0] = 0;
+	if(_detail)
+	{
+		strncpy(event.detail, _detail, sizeof(event.detail) - 1);
+		event.detail[sizeof(event.detail) - 1] = 0;
+	}
+	event.start = _start;
+	event.end = _end;
+	event.frame = frame;
+	event.thread = static_cast<unsigned int>(threadId);
+	TRACE_BARRIER();
+	event.complete = true;
+}
+
+unsigned int Trace::GetRecorded()
+{
+	return static_cast<unsigned int>(claimed - dropped);
+}
+
+unsigned int Trace::GetDropped()
+{
+	return static_cast<unsigned int>(dropped);
+}
@@ -0,0 +1,389 @@
+#include "VectorBatch.h"
+#include <algorithm>
+#include <boost/static_assert.hpp>
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#include <xmmintrin.h>
+#define VECTORBATCH_SSE
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#define VECTORBATCH_SSE
+#endif
+
+//The arrays are read as plain floats
+BOOST_STATIC_ASSERT(sizeof(Vector2f) == 2 * sizeof(float));
+BOOST_STATIC_ASSERT(sizeof(Vector4f) == 4 * sizeof(float));
+
+namespace
+{
+	bool DetectSIMD()
+	{
+#if defined(VECTORBATCH_SSE) && defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		return (info[3] & (1 << 25)) != 0;
+#elif defined(VECTORBATCH_SSE)
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	/* Whether to take the SIMD path. Made on first use rather than at static initialisation, so
+	   nothing depends on the order statics in other files are set up */
+	bool& SimdEnabled()
+	{
+		static bool enabled = VectorBatch::HasSIMD();
+		return enabled;
+	}
+
+	/* The scalar versions, also used for what is left over after the last whole group of four */
+	void TransformScalar(const Matrix3f& _matrix, const Vector2f* _in, Vector2f* _out, unsigned int _count)
+	{
+		for(unsigned int i = 0; i < _count; i++)
+		{
+			Vector3f transformed = _matrix * Vector3f(_in[i].x, _in[i].y, 1);
+			_out[i] = Vector2f(transformed.x, transformed.y);
+		}
+	}
+
+	void TransformScalar(const Matrix4f& _matrix, const Vector4f* _in, Vector4f* _out, unsigned int _count)
+	{
+		for(unsigned int i = 0; i < _count; i++)
+		{
+			_out[i] = _matrix * _in[i];
+		}
+	}
+
+	template <class V>
+	void NormalizeScalar(V* _vectors, unsigned int _count)
+	{
+		for(unsigned int i = 0; i < _count; i++)
+		{
+			_vectors[i].normalize();
+		}
+	}
+
+	void DotScalar(const Vector2f* _a, const Vector2f* _b, float* _out, unsigned int _count)
+	{
+		for(unsigned int i = 0; i < _count; i++)
+		{
+			_out[i] = _a[i].x * _b[i].x + _a[i].y * _b[i].y;
+		}
+	}
+
+	void DotScalar(const Vector4f* _a, const Vector4f* _b, float* _out, unsigned int _count)
+	{
+		for(unsigned int i = 0; i < _count; i++)
+		{
+			_out[i] = _a[i].x * _b[i].x + _a[i].y * _b[i].y + _a[i].z * _b[i].z + _a[i].w * _b[i].w;
+		}
+	}
+
+	void MinMaxScalar(const Vector2f* _in, unsigned int _count, Vector2f& _min, Vector2f& _max)
+	{
+		for(unsigned int i = 0; i < _count; i++)
+		{
+			_min.x = std::min(_min.x, _in[i].x);
+			_min.y = std::min(_min.y, _in[i].y);
+			_max.x = std::max(_max.x, _in[i].x);
+			_max.y = std::max(_max.y, _in[i].y);
+		}
+	}
+
+	void MinMaxScalar(const Vector4f* _in, unsigned int _count, Vector4f& _min, Vector4f& _max)
+	{
+		for(unsigned int i = 0; i < _count; i++)
+		{
+			_min.x = std::min(_min.x, _in[i].x);
+			_min.y = std::min(_min.y, _in[i].y);
+			_min.z = std::min(_min.z, _in[i].z);
+			_min.w = std::min(_min.w, _in[i].w);
+			_max.x = std::max(_max.x, _in[i].x);
+			_max.y = std::max(_max.y, _in[i].y);
+			_max.z = std::max(_max.z, _in[i].z);
+			_max.w = std::max(_max.w, _in[i].w);
+		}
+	}
+
+#ifdef VECTORBATCH_SSE
+	/* Four Vector2f split into their x and y. Arrays of vectors aren't aligned, so loads are unaligned */
+	void Load2(const Vector2f* _in, __m128& _x, __m128& _y)
+	{
+		__m128 first = _mm_loadu_ps(&_in[0].x);
+		__m128 second = _mm_loadu_ps(&_in[2].x);
+		_x = _mm_shuffle_ps(first, second, _MM_SHUFFLE(2, 0, 2, 0));
+		_y = _mm_shuffle_ps(first, second, _MM_SHUFFLE(3, 1, 3, 1));
+	}
+
+	void Store2(Vector2f* _out, __m128 _x, __m128 _y)
+	{
+		_mm_storeu_ps(&_out[0].x, _mm_unpacklo_ps(_x, _y));
+		_mm_storeu_ps(&_out[2].x, _mm_unpacklo_ps(_mm_movehl_ps(_x, _x), _mm_movehl_ps(_y, _y)));
+	}
+
+	/* Four Vector4f with their components gathered, so each lane works through one vector in the
+	   same order as the scalar code, and rounds the same */
+	void Load4(const Vector4f* _in, __m128& _x, __m128& _y, __m128& _z, __m128& _w)
+	{
+		_x = _mm_loadu_ps(&_in[0].x);
+		_y = _mm_loadu_ps(&_in[1].x);
+		_z = _mm_loadu_ps(&_in[2].x);
+		_w = _mm_loadu_ps(&_in[3].x);
+		_MM_TRANSPOSE4_PS(_x, _y, _z, _w);
+	}
+
+	void Store4(Vector4f* _out, __m128 _x, __m128 _y, __m128 _z, __m128 _w)
+	{
+		_MM_TRANSPOSE4_PS(_x, _y, _z, _w);
+		_mm_storeu_ps(&_out[0].x, _x);
+		_mm_storeu_ps(&_out[1].x, _y);
+		_mm_storeu_ps(&_out[2].x, _z);
+		_mm_storeu_ps(&_out[3].x, _w);
+	}
+
+	unsigned int TransformSSE(const Matrix3f& _matrix, const Vector2f* _in, Vector2f* _out, unsigned int _count)
+	{
+		const __m128 m0 = _mm_set1_ps(_matrix.data[0]);
+		const __m128 m1 = _mm_set1_ps(_matrix.data[1]);
+		const __m128 m3 = _mm_set1_ps(_matrix.data[3]);
+		const __m128 m4 = _mm_set1_ps(_matrix.data[4]);
+		const __m128 m6 = _mm_set1_ps(_matrix.data[6]);
+		const __m128 m7 = _mm_set1_ps(_matrix.data[7]);
+		unsigned int i = 0;
+		for(; i + 4 <= _count; i += 4)
+		{
+			__m128 x, y;
+			Load2(_in + i, x, y);
+			__m128 out_x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m0, x), _mm_mul_ps(m3, y)), m6);
+			__m128 out_y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m1, x), _mm_mul_ps(m4, y)), m7);
+			Store2(_out + i, out_x, out_y);
+		}
+		return i;
+	}
+
+	unsigned int TransformSSE(const Matrix4f& _matrix, const Vector4f* _in, Vector4f* _out, unsigned int _count)
+	{
+		//Columns, the matrix is stored column major
+		const __m128 c0 = _mm_loadu_ps(&_matrix.data[0]);
+		const __m128 c1 = _mm_loadu_ps(&_matrix.data[4]);
+		const __m128 c2 = _mm_loadu_ps(&_matrix.data[8]);
+		const __m128 c3 = _mm_loadu_ps(&_matrix.data[12]);
+		for(unsigned int i = 0; i < _count; i++)
+		{
+			__m128 x = _mm_set1_ps(_in[i].x);
+			__m128 y = _mm_set1_ps(_in[i].y);
+			__m128 z = _mm_set1_ps(_in[i].z);
+			__m128 w = _mm_set1_ps(_in[i].w);
+			__m128 out = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, x), _mm_mul_ps(c1, y)), _mm_mul_ps(c2, z)), _mm_mul_ps(c3, w));
+			_mm_storeu_ps(&_out[i].x, out);
+		}
+		return _count;
+	}
+
+	unsigned int NormalizeSSE(Vector2f* _vectors, unsigned int _count)
+	{
+		unsigned int i = 0;
+		for(; i + 4 <= _count; i += 4)
+		{
+			__m128 x, y;
+			Load2(_vectors + i, x, y);
+			//A full square root and divide rather than the estimate, to match normalize()
+			__m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)));
+			Store2(_vectors + i, _mm_div_ps(x, length), _mm_div_ps(y, length));
+		}
+		return i;
+	}
+
+	unsigned int NormalizeSSE(Vector4f* _vectors, unsigned int _count)
+	{
+		unsigned int i = 0;
+		for(; i + 4 <= _count; i += 4)
+		{
+			__m128 x, y, z, w;
+			Load4(_vectors + i, x, y, z, w);
+			__m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)), _mm_mul_ps(w, w)));
+			Store4(_vectors + i, _mm_div_ps(x, length), _mm_div_ps(y, length), _mm_div_ps(z, length), _mm_div_ps(w, length));
+		}
+		return i;
+	}
+
+	unsigned int DotSSE(const Vector2f* _a, const Vector2f* _b, float* _out, unsigned int _count)
+	{
+		unsigned int i = 0;
+		for(; i + 4 <= _count; i += 4)
+		{
+			__m128 ax, ay, bx, by;
+			Load2(_a + i, ax, ay);
+			Load2(_b + i, bx, by);
+			_mm_storeu_ps(_out + i, _mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)));
+		}
+		return i;
+	}
+
+	unsigned int DotSSE(const Vector4f* _a, const Vector4f* _b, float* _out, unsigned int _count)
+	{
+		unsigned int i = 0;
+		for(; i + 4 <= _count; i += 4)
+		{
+			__m128 ax, ay, az, aw, bx, by, bz, bw;
+			Load4(_a + i, ax, ay, az, aw);
+			Load4(_b + i, bx, by, bz, bw);
+			__m128 dot = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz)), _mm_mul_ps(aw, bw));
+			_mm_storeu_ps(_out + i, dot);
+		}
+		return i;
+	}
+
+	/* Pairs of vectors at a time, then the two halves are folded together */
+	unsigned int MinMaxSSE(const Vector2f* _in, unsigned int _count, Vector2f& _min, Vector2f& _max)
+	{
+		if(_count < 2)
+			return 0;
+		__m128 low = _mm_loadu_ps(&_in[0].x);
+		__m128 high = low;
+		unsigned int i = 2;
+		for(; i + 2 <= _count; i += 2)
+		{
+			__m128 pair = _mm_loadu_ps(&_in[i].x);
+			low = _mm_min_ps(low, pair);
+			high = _mm_max_ps(high, pair);
+		}
+		low = _mm_min_ps(low, _mm_movehl_ps(low, low));
+		high = _mm_max_ps(high, _mm_movehl_ps(high, high));
+		float folded[4];
+		_mm_storeu_ps(folded, _mm_unpacklo_ps(low, high));
+		_min.x = std::min(_min.x, folded[0]);
+		_max.x = std::max(_max.x, folded[1]);
+		_min.y = std::min(_min.y, folded[2]);
+		_max.y = std::max(_max.y, folded[3]);
+		return i;
+	}
+
+	unsigned int MinMaxSSE(const Vector4f* _in, unsigned int _count, Vector4f& _min, Vector4f& _max)
+	{
+		if(_count == 0)
+			return 0;
+		__m128 low = _mm_loadu_ps(&_min.x);
+		__m128 high = _mm_loadu_ps(&_max.x);
+		for(unsigned int i = 0; i < _count; i++)
+		{
+			__m128 vector = _mm_loadu_ps(&_in[i].x);
+			low = _mm_min_ps(low, vector);
+			high = _mm_max_ps(high, vector);
+		}
+		_mm_storeu_ps(&_min.x, low);
+		_mm_storeu_ps(&_max.x, high);
+		return _count;
+	}
+#endif
+}
+
+bool VectorBatch::HasSIMD()
+{
+	static bool has_simd = DetectSIMD();
+	return has_simd;
+}
+
+void VectorBatch::SetSIMD(bool _simd)
+{
+	SimdEnabled() = _simd && HasSIMD();
+}
+
+bool VectorBatch::GetSIMD()
+{
+	return SimdEnabled();
+}
+
+void VectorBatch::Transform(const Matrix3f& _matrix, const Vector2f* _in, Vector2f* _out, unsigned int _count)
+{
+	unsigned int done = 0;
+#ifdef VECTORBATCH_SSE
+	if(SimdEnabled())
+		done = TransformSSE(_matrix, _in, _out, _count);
+#endif
+	TransformScalar(_matrix, _in + done, _out + done, _count - done);
+}
+
+void VectorBatch::Transform(const Matrix4f& _matrix, const Vector4f* _in, Vector4f* _out, unsigned int _count)
+{
+	unsigned int done = 0;
+#ifdef VECTORBATCH_SSE
+	if(SimdEnabled())
+		done = TransformSSE(_matrix, _in, _out, _count);
+#endif
+	TransformScalar(_matrix, _in + done, _out + done, _count - done);
+}
+
+void VectorBatch::Normalize(Vector2f* _vectors, unsigned int _count)
+{
+	unsigned int done = 0;
+#ifdef VECTORBATCH_SSE
+	if(SimdEnabled())
+		done = NormalizeSSE(_vectors, _count);
+#endif
+	NormalizeScalar(_vectors + done, _count - done);
+}
+
+void VectorBatch::Normalize(Vector4f* _vectors, unsigned int _count)
+{
+	unsigned int done = 0;
+#ifdef VECTORBATCH_SSE
+	if(SimdEnabled())
+		done = NormalizeSSE(_vectors, _count);
+#endif
+	NormalizeScalar(_vectors + done, _count - done);
+}
+
+void VectorBatch::Dot(const Vector2f* _a, const Vector2f* _b, float* _out, unsigned int _count)
+{
+	unsigned int done = 0;
+#ifdef VECTORBATCH_SSE
+	if(SimdEnabled())
+		done = DotSSE(_a, _b, _out, _count);
+#endif
+	DotScalar(_a + done, _b + done, _out + done, _count - done);
+}
+
+void VectorBatch::Dot(const Vector4f* _a, const Vector4f* _b, float* _out, unsigned int _count)
+{
+	unsigned int done = 0;
+#ifdef VECTORBATCH_SSE
+	if(SimdEnabled())
+		done = DotSSE(_a, _b, _out, _count);
+#endif
+	DotScalar(_a + done, _b + done, _out + done, _count - done);
+}
+
+void VectorBatch::MinMax(const Vector2f* _in, unsigned int _count, Vector2f& _min, Vector2f& _max)
+{
+	if(_count == 0)
+		return;
+	Vector2f low = _in[0];
+	Vector2f high = _in[0];
+	unsigned int done = 0;
+#ifdef VECTORBATCH_SSE
+	if(SimdEnabled())
+		done = MinMaxSSE(_in, _count, low, high);
+#endif
+	MinMaxScalar(_in + done, _count - done, low, high);
+	_min = low;
+	_max = high;
+}
+
+void VectorBatch::MinMax(const Vector4f* _in, unsigned int _count, Vector4f& _min, Vector4f& _max)
+{
+	if(_count == 0)
+		return;
+	Vector4f low = _in[0];
+	Vector4f high = _in[0];
+	unsigned int done = 0;
+#ifdef VECTORBATCH_SSE
+	if(SimdEnabled())
+		done = MinMaxSSE(_in, _count, low, high);
+#endif
+	MinMaxScalar(_in + done, _count - done, low, high);
+	_min = low;
+	_max = high;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "vmath.h"
+
+/* Operations over arrays of float vectors, four at a time with SSE where it's available. The
+   vector classes stay plain scalar templates: a single Vector2f or Vector3f gains nothing from a
+   register it only part fills, and aligning them to 16 bytes would change their layout. Results
+   match the scalar vmath operations to within rounding, and exactly where the scalar code uses
+   SSE as well. Input and output arrays may be the same, but shouldn't otherwise overlap */
+class VectorBatch
+{
+public:
+	static bool HasSIMD();
+	/* Runs without SSE when false, for comparing the two. Has no effect where SSE isn't available */
+	static void SetSIMD(bool _simd);
+	static bool GetSIMD();
+
+	/* The x and y of _matrix * Vector3f(x, y, 1), i.e. points through a 2D affine transform */
+	static void Transform(const Matrix3f& _matrix, const Vector2f* _in, Vector2f* _out, unsigned int _count);
+	/* _matrix * _in[i] */
+	static void Transform(const Matrix4f& _matrix, const Vector4f* _in, Vector4f* _out, unsigned int _count);
+
+	/* As normalize() on each, so zero length vectors come out as NaNs the same way */
+	static void Normalize(Vector2f* _vectors, unsigned int _count);
+	static void Normalize(Vector4f* _vectors, unsigned int _count);
+
+	/* _out[i] is the dot product of _a[i] and _b[i] */
+	static void Dot(const Vector2f* _a, const Vector2f* _b, float* _out, unsigned int _count);
+	static void Dot(const Vector4f* _a, const Vector4f* _b, float* _out, unsigned int _count);
+
+	/* Smallest and largest of each component, the corners of the bounding box. _min and _max are
+	   left alone when _count is 0 */
+	static void MinMax(const Vector2f* _in, unsigned int _count, Vector2f& _min, Vector2f& _max);
+	static void MinMax(const Vector4f* _in, unsigned int _count, Vector4f& _min, Vector4f& _max);
+};
@@ -0,0 +1,96 @@
+#include "VoiceAllocator.h"
+#include <algorithm>
+
+const float VoiceAllocator::MERGE_WINDOW = 0.05f;
+const float VoiceAllocator::BASE_VOLUME = 0.7f;
+const float VoiceAllocator::MERGE_VOLUME = 0.1f;
+
+VoiceAllocator::VoiceAllocator(int voices) :
+	mRequested(0),
+	mMerged(0),
+	mStolen(0),
+	mDropped(0)
+{
+	Voice free_voice = {-1, 0, 0, 0, false};
+	mVoices.resize(voices, free_voice);
+}
+
+float VoiceAllocator::VolumeFor(int events)
+{
+	return std::min(1.0f, BASE_VOLUME + MERGE_VOLUME * (events - 1));
+}
+
+int VoiceAllocator::GetActiveCount() const
+{
+	int active = 0;
+	for(std::vector<Voice>::const_iterator it = mVoices.begin(); it != mVoices.end(); ++it)
+	{
+		if(it->mSample >= 0)
+			active++;
+	}
+	return active;
+}
+
+VoiceDecision VoiceAllocator::Request(int sample, int priority, float now, int count, bool looping)
+{
+	mRequested += count;
+	VoiceDecision decision = {VoiceAction::Drop, -1, 0};
+
+	int free_voice = -1;
+	int victim = -1;
+	for(int i = 0; i < (int)mVoices.size(); i++)
+	{
+		Voice& voice = mVoices[i];
+		if(voice.mSample < 0)
+		{
+			if(free_voice < 0)
+				free_voice = i;
+			continue;
+		}
+		if(!looping && !voice.mLooping && voice.mSample == sample && now - voice.mStart <= MERGE_WINDOW)
+		{
+			voice.mEvents += count;
+			mMerged += count;
+			decision.mAction = VoiceAction::Merge;
+			decision.mVoice = i;
+			decision.mVolume = VolumeFor(voice.mEvents);
+			return decision;
+		}
+		//Lowest priority first, then the one that has been playing longest
+		if(!voice.mLooping && voice.mPriority <= priority &&
+		   (victim < 0 || voice.mPriority < mVoices[victim].mPriority ||
+		    (voice.mPriority == mVoices[victim].mPriority && voice.mStart < mVoices[victim].mStart)))
+			victim = i;
+	}
+
+	if(free_voice >= 0)
+	{
+		decision.mAction = VoiceAction::Play;
+		decision.mVoice = free_voice;
+	} else if(victim >= 0)
+	{
+		decision.mAction = VoiceAction::Steal;
+		decision.mVoice = victim;
+		mStolen++;
+	} else
+	{
+		mDropped += count;
+		return decision;
+	}
+	//Events arriving together are merged from the start
+	mMerged += count - 1;
+	Voice& voice = mVoices[decision.mVoice];
+	voice.mSample = sample;
+	voice.mPriority = priority;
+	voice.mStart = now;
+	voice.mEvents = count;
+	voice.mLooping = looping;
+	decision.mVolume = looping ? 1.0f : VolumeFor(count);
+	return decision;
+}
+
+void VoiceAllocator::Release(int voice)
+{
+	if(voice >= 0 && voice < (int)mVoices.size())
+		mVoices[voice].mSample = -1;
+}
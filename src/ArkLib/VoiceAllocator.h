@@ -0,0 +1,74 @@
+#pragma once
+#include <vector>
+
+namespace VoiceAction
+{
+	enum Enum
+	{
+		Play,	//Start on a free voice
+		Merge,	//Already playing on this voice, just make it louder
+		Steal,	//Stop what this voice is playing and start on it
+		Drop	//Every voice is busy with something more important
+	};
+}
+
+struct VoiceDecision
+{
+	VoiceAction::Enum mAction;
+	int mVoice;
+	float mVolume; //0 to 1
+};
+
+/* Decides which mixer voice each sound event gets, so the number playing stays fixed however many
+ * events the game raises. Events for a sample that started within the merge window are folded
+ * into its voice, which gets louder instead of another voice playing the same thing. When every
+ * voice is busy the lowest priority, oldest one is taken over, unless everything playing matters
+ * more than the new event. Looping voices are never merged into or taken over.
+ * Knows nothing of the mixer: the caller plays what it's told and reports voices that finish.
+ */
+class VoiceAllocator
+{
+//Constants
+public:
+	static const float MERGE_WINDOW;	//Seconds
+	static const float BASE_VOLUME;		//One event
+	static const float MERGE_VOLUME;	//Added per event merged in
+//Constructors
+public:
+	VoiceAllocator(int voices);
+//Private types
+private:
+	struct Voice
+	{
+		int mSample; //-1 when free
+		int mPriority;
+		float mStart;
+		int mEvents;
+		bool mLooping;
+	};
+//Private members
+private:
+	std::vector<Voice> mVoices;
+	unsigned int mRequested;
+	unsigned int mMerged;
+	unsigned int mStolen;
+	unsigned int mDropped;
+//Private methods
+private:
+	static float VolumeFor(int events);
+//Public getters/setters
+public:
+	int GetVoiceCount() const {return (int)mVoices.size();}
+	int GetActiveCount() const;
+	int GetSample(int voice) const {return mVoices[voice].mSample;}
+	unsigned int GetRequested() const {return mRequested;}
+	unsigned int GetMerged() const {return mMerged;}
+	unsigned int GetStolen() const {return mStolen;}
+	unsigned int GetDropped() const {return mDropped;}
+//Public methods
+public:
+	/* Places count identical events for sample, raised at time now in seconds */
+	VoiceDecision Request(int sample, int priority, float now, int count = 1, bool looping = false);
+	/* The voice has finished or been stopped */
+	void Release(int voice);
+};
@@ -12,7 +12,8 @@ Wall::Wall(void) :
 	mBounds((float)DEFAULT_BOUNDS_W, (float)DEFAULT_BOUNDS_H),
 	mTopEdge(0),
 	mBottomEdge(0),
-	mBorder((float)DEFAULT_BORDER)
+	mBorder((float)DEFAULT_BORDER),
+	mNextBrickId(1)
 {
 }
 
@@ -21,7 +22,28 @@ Wall::Wall(std::string filename) :
 	mLeftEdge(0),
 	mRightEdge(0),
 	mBounds((float)DEFAULT_BOUNDS_W, (float)DEFAULT_BOUNDS_H),
-	mBorder((float)DEFAULT_BORDER)
+	mBorder((float)DEFAULT_BORDER),
+	mNextBrickId(1)
+{
+	vector<LevelBrick> bricks;
+	if(ReadLevel(filename, bricks) && bricks.size() > 0)
+		AddLevelBricks(&bricks[0], bricks.size());
+}
+
+Wall::Wall(const LevelBrick* bricks, unsigned int count) :
+	mPosition((float)INITIAL_X, (float)FIXED_Y),
+	mLeftEdge(0),
+	mRightEdge(0),
+	mBounds((float)DEFAULT_BOUNDS_W, (float)DEFAULT_BOUNDS_H),
+	mTopEdge(0),
+	mBottomEdge(0),
+	mBorder((float)DEFAULT_BORDER),
+	mNextBrickId(1)
+{
+	AddLevelBricks(bricks, count);
+}
+
+bool Wall::ReadLevel(std::string filename, vector<LevelBrick>& bricks)
 {
 	TiXmlDocument doc("Levels\\" + filename);
 	if(doc.LoadFile())
@@ -32,33 +54,17 @@ Wall::Wall(std::string filename) :
 			TiXmlElement* brick = wall->FirstChildElement("Brick");
 			while(brick)
 			{
-				Vector2f brick_position;
-				int brick_colour = 0;
-				if(brick->QueryFloatAttribute("x", &brick_position.x) == TIXML_SUCCESS &&
-				   brick->QueryFloatAttribute("y", &brick_position.y) == TIXML_SUCCESS &&
-				   brick->QueryIntAttribute("c", &brick_colour) == TIXML_SUCCESS)
+				LevelBrick level_brick;
+				if(brick->QueryFloatAttribute("x", &level_brick.x) == TIXML_SUCCESS &&
+				   brick->QueryFloatAttribute("y", &level_brick.y) == TIXML_SUCCESS &&
+				   brick->QueryIntAttribute("c", &level_brick.c) == TIXML_SUCCESS)
 				{
-					Brick::SharedPointer brick;
-					switch(brick_colour)
-					{
-					default:
-					case 1:
-						brick = Brick::SharedPointer(new Brick(BrickType::BlueBrick));
-						break;
-					case 2:
-						brick = Brick::SharedPointer(new Brick(BrickType::RedBrick));
-						break;
-					case 3:
-						brick = Brick::SharedPointer(new Brick(BrickType::YellowBrick));
-						break;
-					}
-					brick->SetPosition(brick_position);
-					AddBrick(brick);
-					
+					bricks.push_back(level_brick);
 				} else
 					Logger::DiagnosticOut() << "Brick must have x, y and c attributes\n";
 				brick = brick->NextSiblingElement("Brick");
 			}
+			return true;
 		} else
 		{
 			Logger::ErrorOut() << "Wall root element missing from " << filename << "\n";
@@ -67,6 +73,30 @@ Wall::Wall(std::string filename) :
 	{
 		Logger::ErrorOut() << "Unable to open " << filename << "\n";
 	}
+	return false;
+}
+
+void Wall::AddLevelBricks(const LevelBrick* bricks, unsigned int count)
+{
+	for(unsigned int i = 0; i < count; i++)
+	{
+		Brick::SharedPointer brick;
+		switch(bricks[i].c)
+		{
+		default:
+		case 1:
+			brick = Brick::SharedPointer(new Brick(BrickType::BlueBrick));
+			break;
+		case 2:
+			brick = Brick::SharedPointer(new Brick(BrickType::RedBrick));
+			break;
+		case 3:
+			brick = Brick::SharedPointer(new Brick(BrickType::YellowBrick));
+			break;
+		}
+		brick->SetPosition(Vector2f(bricks[i].x, bricks[i].y));
+		AddBrick(brick);
+	}
 }
 
 Wall::~Wall(void)
@@ -75,6 +105,7 @@ Wall::~Wall(void)
 
 void Wall::AddBrick(Brick::SharedPointer brick)
 {
+	brick->SetId(mNextBrickId++);
 	mBricks.push_back(brick);
 	RecalculateBounds();
 }
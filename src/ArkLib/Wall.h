@@ -6,6 +6,15 @@
 #include "Brick.h"
 #include "Ball.h"
 
+/* A brick as a level file describes it, colour as numbered in the file.
+   Kept plain so levels can be compiled into an asset bundle as an array of these */
+struct LevelBrick
+{
+	float x;
+	float y;
+	int c;
+};
+
 class Wall
 {
 //Typedefs
@@ -22,6 +31,7 @@ public:
 public:
 	Wall(void);
 	Wall(std::string filename);
+	Wall(const LevelBrick* bricks, unsigned int count);
 	~Wall(void);
 
 //Private members
@@ -35,10 +45,11 @@ private:
 	float mBorder;
 	std::vector<Brick::SharedPointer> mBricks;
 	std::vector<Ball::WeakPointer> mOverlappingBalls;
+	unsigned int mNextBrickId;
 
 //Public getters/setters
 public:
-	std::vector<Brick::SharedPointer> GetBricks() const {return mBricks;}
+	const std::vector<Brick::SharedPointer>& GetBricks() const {return mBricks;}
 	void AddBrick(Brick::SharedPointer brick);
 
 	//void AddOverlappingBall(
@@ -58,6 +69,11 @@ public:
 //Private methods
 private:
 	void RecalculateBounds();
+	void AddLevelBricks(const LevelBrick* bricks, unsigned int count);
+//Static methods
+public:
+	/* Reads the bricks from a level file in Levels, false if it couldn't be read */
+	static bool ReadLevel(std::string filename, std::vector<LevelBrick>& bricks);
 //Public methods
 public:
 	void Tick();
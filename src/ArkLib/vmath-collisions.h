@@ -2,6 +2,8 @@
 
 #include "vmath.h"
 #include <cmath>
+#include <vector>
+#include <algorithm>
 #include <cfloat>
 
 /**
@@ -663,7 +665,421 @@ public:
       return min_d;
    }
 
+	/**
+	* A convex polygon with its edge normals worked out once, for repeated separating axis tests.
+	* Points may wind either way, and the outline is closed automatically (at least three points)
+	*/
+	struct Convex
+	{
+		std::vector<Vector2<T> > points;
+		std::vector<Vector2<T> > normals; //Unit length and pointing out, one per edge
+		std::vector<T> offsets;				//How far each edge lies along its normal
+		Vector2<T> min;
+		Vector2<T> max;
+
+		Convex(const Vector2<T>* hull, const int num_points)
+		: points(hull, hull + num_points)
+		{
+			min = max = hull[0];
+			T area = 0;
+			for(int i = 0; i < num_points; i++)
+			{
+				area += hull[i].x * hull[(i + 1) % num_points].y - hull[(i + 1) % num_points].x * hull[i].y;
+				min = Vector2<T>(std::min(min.x, hull[i].x), std::min(min.y, hull[i].y));
+				max = Vector2<T>(std::max(max.x, hull[i].x), std::max(max.y, hull[i].y));
+			}
+			//Clockwise outlines would otherwise get normals pointing in
+			T out = area < 0 ? (T)-1 : (T)1;
+			for(int i = 0; i < num_points; i++)
+			{
+				Vector2<T> edge = hull[(i + 1) % num_points] - hull[i];
+				T length = (T)sqrt((double)(edge.x * edge.x + edge.y * edge.y));
+				if(length > 0)
+				{
+					normals.push_back(Vector2<T>(edge.y * out / length, -edge.x * out / length));
+					offsets.push_back(normals.back().x * hull[i].x + normals.back().y * hull[i].y);
+				}
+			}
+		}
+	};
+
+	/**
+	* Determines if two convex polygons overlap, including one containing the other. Touching
+	* edges don't count
+	* @param a First polygon
+	* @param b Second polygon
+	*/
+	static bool ConvexIntersectsConvex(const Convex& a, const Convex& b)
+	{
+		if(!BoxesOverlap(a.min, a.max, b.min, b.max))
+			return false;
+		return !FaceSeparates(a, b) && !FaceSeparates(b, a);
+	}
+
+	/**
+	* Determines if a circle overlaps a convex polygon, including the centre being inside it
+	* @param centre The centre of the circle
+	* @param radius The radius of the circle
+	* @param hull The polygon
+	*/
+	static bool CircleIntersectsConvex(const Vector2<T> centre, const T radius, const Convex& hull)
+	{
+		if(centre.x + radius <= hull.min.x || centre.x - radius >= hull.max.x ||
+		   centre.y + radius <= hull.min.y || centre.y - radius >= hull.max.y)
+			return false;
+		bool inside = true;
+		for(unsigned int i = 0; i < hull.normals.size(); i++)
+		{
+			T beyond = centre.x * hull.normals[i].x + centre.y * hull.normals[i].y - hull.offsets[i];
+			if(beyond >= radius)
+				return false;
+			if(beyond > 0)
+				inside = false;
+		}
+		if(inside)
+			return true;
+		//Past a corner the only axis that can separate runs from the nearest vertex to the centre
+		unsigned int nearest = 0;
+		for(unsigned int i = 1; i < hull.points.size(); i++)
+		{
+			if(DistanceSqr(hull.points[i], centre) < DistanceSqr(hull.points[nearest], centre))
+				nearest = i;
+		}
+		Vector2<T> axis = centre - hull.points[nearest];
+		T length = (T)sqrt((double)(axis.x * axis.x + axis.y * axis.y));
+		if(length == 0)
+			return true;
+		axis /= length;
+		T min, max;
+		Project(&hull.points[0], (int)hull.points.size(), axis, min, max);
+		return centre.x * axis.x + centre.y * axis.y - radius < max;
+	}
+
+	/**
+	* Determines if two triangles overlap, including one containing the other. Touching edges
+	* don't count
+	*/
+	static bool TrianglesIntersect(const Vector2<T>* a, const Vector2<T>* b)
+	{
+		Vector2<T> axes[6];
+		TriangleNormals(a, axes);
+		TriangleNormals(b, axes + 3);
+		return !Separated(a, 3, b, 3, axes, 6);
+	}
+
+	/**
+	* Bounding volume hierarchy over a triangle list, for testing meshes against each other and
+	* against line segments without trying every triangle. Built once, the mesh mustn't move after
+	*/
+	class MeshTree
+	{
+	private:
+		struct Node
+		{
+			Vector2<T> min;
+			Vector2<T> max;
+			int first;	//First child node, or first triangle in order_ for a leaf
+			int count;	//Triangles under a leaf, 0 for a branch
+		};
+
+		/* Orders triangles by the centre of their bounds along one axis */
+		struct CentreLess
+		{
+			const std::vector<Vector2<T> >* centres;
+			bool y;
+			bool operator()(int _a, int _b) const
+			{
+				return y ? (*centres)[_a].y < (*centres)[_b].y : (*centres)[_a].x < (*centres)[_b].x;
+			}
+		};
+
+		static const int leaf_triangles = 2;
+
+		std::vector<Vector2<T> > triangles_;	//Three points each
+		std::vector<Vector2<T> > normals_;		//Three edge normals each
+		std::vector<int> order_;				//Triangles in leaf order
+		std::vector<Node> nodes_;				//Root first, children of a branch together
+
+		void Bound(Node& _node, const std::vector<Vector2<T> >& _mins, const std::vector<Vector2<T> >& _maxs) const
+		{
+			_node.min = _mins[order_[_node.first]];
+			_node.max = _maxs[order_[_node.first]];
+			for(int i = _node.first + 1; i < _node.first + _node.count; i++)
+			{
+				_node.min = Vector2<T>(std::min(_node.min.x, _mins[order_[i]].x), std::min(_node.min.y, _mins[order_[i]].y));
+				_node.max = Vector2<T>(std::max(_node.max.x, _maxs[order_[i]].x), std::max(_node.max.y, _maxs[order_[i]].y));
+			}
+		}
+
+		/* Splits at the median along the longer side, until few enough triangles are left */
+		void Build(int _node, const std::vector<Vector2<T> >& _mins, const std::vector<Vector2<T> >& _maxs, const std::vector<Vector2<T> >& _centres)
+		{
+			Bound(nodes_[_node], _mins, _maxs);
+			int first = nodes_[_node].first;
+			int count = nodes_[_node].count;
+			if(count <= leaf_triangles)
+				return;
+			CentreLess less;
+			less.centres = &_centres;
+			less.y = nodes_[_node].max.y - nodes_[_node].min.y > nodes_[_node].max.x - nodes_[_node].min.x;
+			int half = count / 2;
+			std::nth_element(order_.begin() + first, order_.begin() + first + half, order_.begin() + first + count, less);
+
+			int children = (int)nodes_.size();
+			Node child;
+			child.first = first;
+			child.count = half;
+			nodes_.push_back(child);
+			child.first = first + half;
+			child.count = count - half;
+			nodes_.push_back(child);
+			nodes_[_node].first = children;
+			nodes_[_node].count = 0;
+			Build(children, _mins, _maxs, _centres);
+			Build(children + 1, _mins, _maxs, _centres);
+		}
+
+		bool LeafIntersects(const Node& _leaf, const MeshTree& _other, const Node& _other_leaf) const
+		{
+			for(int i = _leaf.first; i < _leaf.first + _leaf.count; i++)
+			{
+				for(int j = _other_leaf.first; j < _other_leaf.first + _other_leaf.count; j++)
+				{
+					const Vector2<T>* a = &triangles_[order_[i] * 3];
+					const Vector2<T>* b = &_other.triangles_[_other.order_[j] * 3];
+					Vector2<T> axes[6];
+					std::copy(&normals_[order_[i] * 3], &normals_[order_[i] * 3] + 3, axes);
+					std::copy(&_other.normals_[_other.order_[j] * 3], &_other.normals_[_other.order_[j] * 3] + 3, axes + 3);
+					if(!Separated(a, 3, b, 3, axes, 6))
+						return true;
+				}
+			}
+			return false;
+		}
+
+	public:
+		MeshTree(const Vector2<T>* mesh, const int num_triangles)
+		: triangles_(mesh, mesh + num_triangles * 3), normals_(num_triangles * 3), order_(num_triangles)
+		{
+			if(num_triangles == 0)
+				return;
+			std::vector<Vector2<T> > mins(num_triangles), maxs(num_triangles), centres(num_triangles);
+			for(int i = 0; i < num_triangles; i++)
+			{
+				const Vector2<T>* triangle = &triangles_[i * 3];
+				TriangleNormals(triangle, &normals_[i * 3]);
+				mins[i] = maxs[i] = triangle[0];
+				for(int j = 1; j < 3; j++)
+				{
+					mins[i] = Vector2<T>(std::min(mins[i].x, triangle[j].x), std::min(mins[i].y, triangle[j].y));
+					maxs[i] = Vector2<T>(std::max(maxs[i].x, triangle[j].x), std::max(maxs[i].y, triangle[j].y));
+				}
+				centres[i] = (mins[i] + maxs[i]) / 2;
+				order_[i] = i;
+			}
+			nodes_.reserve(num_triangles * 2);
+			Node root;
+			root.first = 0;
+			root.count = num_triangles;
+			nodes_.push_back(root);
+			Build(0, mins, maxs, centres);
+		}
+
+		int GetTriangleCount() const {return (int)order_.size();}
+		int GetNodeCount() const {return (int)nodes_.size();}
+
+		/**
+		* Determines if any triangle overlaps any of another mesh's, including one containing
+		* the other
+		*/
+		bool Intersects(const MeshTree& other) const
+		{
+			if(nodes_.empty() || other.nodes_.empty())
+				return false;
+			std::vector<std::pair<int, int> > pending;
+			pending.push_back(std::make_pair(0, 0));
+			while(!pending.empty())
+			{
+				int a_index = pending.back().first;
+				int b_index = pending.back().second;
+				const Node& a = nodes_[a_index];
+				const Node& b = other.nodes_[b_index];
+				pending.pop_back();
+				if(!BoxesOverlap(a.min, a.max, b.min, b.max))
+					continue;
+				if(a.count && b.count)
+				{
+					if(LeafIntersects(a, other, b))
+						return true;
+				} else if(!a.count && (b.count || (a.max - a.min).lengthSq() > (b.max - b.min).lengthSq()))
+				{
+					//Descend the bigger branch
+					pending.push_back(std::make_pair(a.first, b_index));
+					pending.push_back(std::make_pair(a.first + 1, b_index));
+				} else
+				{
+					pending.push_back(std::make_pair(a_index, b.first));
+					pending.push_back(std::make_pair(a_index, b.first + 1));
+				}
+			}
+			return false;
+		}
+
+		/**
+		* Determines if a line segment crosses a triangle edge, finding the crossing nearest P1
+		* @param P1 The first point in the line segment
+		* @param P2 The second point in the line segment
+		* @param out The crossing nearest P1. Only set if there is one
+		*/
+		bool LineIntersects(const Vector2<T> P1, const Vector2<T> P2, Vector2<T>& out) const
+		{
+			if(nodes_.empty())
+				return false;
+			Vector2<T> seg_min(std::min(P1.x, P2.x), std::min(P1.y, P2.y));
+			Vector2<T> seg_max(std::max(P1.x, P2.x), std::max(P1.y, P2.y));
+			T nearest = 0;
+			bool found = false;
+			std::vector<int> pending(1, 0);
+			while(!pending.empty())
+			{
+				const Node& node = nodes_[pending.back()];
+				pending.pop_back();
+				if(!BoxesTouch(seg_min, seg_max, node.min, node.max) || !LineCrossesBox(P1, P2, node.min, node.max))
+					continue;
+				if(!node.count)
+				{
+					pending.push_back(node.first);
+					pending.push_back(node.first + 1);
+					continue;
+				}
+				for(int i = node.first; i < node.first + node.count; i++)
+				{
+					const Vector2<T>* triangle = &triangles_[order_[i] * 3];
+					for(int edge = 0; edge < 3; edge++)
+					{
+						Vector2<T> crossing;
+						if(LineSegmentsIntersect(P1, P2, triangle[edge], triangle[(edge + 1) % 3], crossing))
+						{
+							T distance = DistanceSqr(crossing, P1);
+							if(!found || distance < nearest)
+							{
+								nearest = distance;
+								out = crossing;
+								found = true;
+								//Nothing further along can be nearer
+								seg_min = Vector2<T>(std::min(P1.x, crossing.x), std::min(P1.y, crossing.y));
+								seg_max = Vector2<T>(std::max(P1.x, crossing.x), std::max(P1.y, crossing.y));
+							}
+						}
+					}
+				}
+			}
+			return found;
+		}
+	};
+
 private:
+	/**
+	* Determines if two boxes overlap by more than touching
+	*/
+	static bool BoxesOverlap(const Vector2<T> min_a, const Vector2<T> max_a, const Vector2<T> min_b, const Vector2<T> max_b)
+	{
+		return min_a.x < max_b.x && min_b.x < max_a.x && min_a.y < max_b.y && min_b.y < max_a.y;
+	}
+
+	/**
+	* Determines if two boxes overlap or touch
+	*/
+	static bool BoxesTouch(const Vector2<T> min_a, const Vector2<T> max_a, const Vector2<T> min_b, const Vector2<T> max_b)
+	{
+		return min_a.x <= max_b.x && min_b.x <= max_a.x && min_a.y <= max_b.y && min_b.y <= max_a.y;
+	}
+
+	/**
+	* Determines if a line segment passes through or touches a box, by clipping it to each pair of sides
+	*/
+	static bool LineCrossesBox(const Vector2<T> P1, const Vector2<T> P2, const Vector2<T> min, const Vector2<T> max)
+	{
+		double enter = 0;
+		double leave = 1;
+		return ClipToSlab(P1.x, P2.x - P1.x, min.x, max.x, enter, leave) &&
+			   ClipToSlab(P1.y, P2.y - P1.y, min.y, max.y, enter, leave);
+	}
+
+	static bool ClipToSlab(const T start, const T delta, const T low, const T high, double& enter, double& leave)
+	{
+		if(delta == 0)
+			return start >= low && start <= high;
+		double t1 = (double)(low - start) / delta;
+		double t2 = (double)(high - start) / delta;
+		if(t1 > t2)
+			std::swap(t1, t2);
+		enter = std::max(enter, t1);
+		leave = std::min(leave, t2);
+		return enter <= leave;
+	}
+
+	/**
+	* Determines if any of the axes separates two point sets, so they can't overlap
+	* @param axes Axes to project on to, which needn't be normalised
+	*/
+	static bool Separated(const Vector2<T>* a, const int num_a, const Vector2<T>* b, const int num_b, const Vector2<T>* axes, const int num_axes)
+	{
+		for(int i = 0; i < num_axes; i++)
+		{
+			T min_a, max_a, min_b, max_b;
+			Project(a, num_a, axes[i], min_a, max_a);
+			Project(b, num_b, axes[i], min_b, max_b);
+			if(max_a <= min_b || max_b <= min_a)
+				return true;
+		}
+		return false;
+	}
+
+	/**
+	* Determines if any edge of a separates it from b. With the normals pointing out, a lies
+	* entirely behind each edge so only b needs projecting
+	*/
+	static bool FaceSeparates(const Convex& a, const Convex& b)
+	{
+		for(unsigned int i = 0; i < a.normals.size(); i++)
+		{
+			T min, max;
+			Project(&b.points[0], (int)b.points.size(), a.normals[i], min, max);
+			if(min >= a.offsets[i])
+				return true;
+		}
+		return false;
+	}
+
+	/**
+	* Finds the range covered by points projected on to an axis
+	*/
+	static void Project(const Vector2<T>* points, const int num_points, const Vector2<T> axis, T& min, T& max)
+	{
+		min = max = points[0].x * axis.x + points[0].y * axis.y;
+		for(int i = 1; i < num_points; i++)
+		{
+			T along = points[i].x * axis.x + points[i].y * axis.y;
+			if(along < min)
+				min = along;
+			if(along > max)
+				max = along;
+		}
+	}
+
+	/**
+	* Finds the edge normals of a triangle, unnormalised as only the sign of a projection gap matters
+	*/
+	static void TriangleNormals(const Vector2<T>* triangle, Vector2<T>* out)
+	{
+		for(int i = 0; i < 3; i++)
+		{
+			Vector2<T> edge = triangle[(i + 1) % 3] - triangle[i];
+			out[i] = Vector2<T>(edge.y, -edge.x);
+		}
+	}
+
 	/**
 	* Gets twice the area of a triangle using the determinant method.
 	* @param a Triangle point a
@@ -0,0 +1,103 @@
+#include "stdafx.h"
+#include <AllocationTracker.h>
+#include <ArkGame.h>
+#include <Wall.h>
+#include <Brick.h>
+#include <sstream>
+#include <string>
+
+namespace
+{
+	//Stored through, so the compiler can't leave out a new and delete that cancel out
+	int* volatile allocated = NULL;
+	const unsigned int tickAllocationBudget = 8;
+
+	void NewAndDelete(int _count)
+	{
+		allocated = new int[_count];
+		delete[] allocated;
+	}
+
+	/* Twenty bricks in two rows and the first ball in play */
+	ArkGame::SharedPointer RunningGame()
+	{
+		ArkGame::SharedPointer game(new ArkGame());
+		game->SetBounds(Vector2f(640, 480));
+		Wall::SharedPointer wall(new Wall());
+		for(int i = 0; i < 20; i++)
+		{
+			Brick::SharedPointer brick(new Brick(BrickType::BlueBrick));
+			brick->SetPosition(Vector2f(static_cast<float>((i % 10) * 48), static_cast<float>((i / 10) * 24)));
+			wall->AddBrick(brick);
+		}
+		game->SetWall(wall);
+		game->Tick(static_cast<float>(ArkGame::STARTING_TIME) / 1000.0f);
+		return game;
+	}
+}
+
+TEST(AllocationTrackerCountsByTagAndFrame)
+{
+	AllocationTracker::Reset();
+	AllocationTracker::Enable(true);
+	AllocationTracker::EndFrame();
+	{
+		AllocationScope scope(AllocationTag::Simulation);
+		NewAndDelete(10);
+		{
+			AllocationScope inner(AllocationTag::Audio);
+			NewAndDelete(1);
+		}
+		NewAndDelete(1);
+	}
+	AllocationStats simulation = AllocationTracker::GetCurrent(AllocationTag::Simulation);
+	AllocationStats audio = AllocationTracker::GetCurrent(AllocationTag::Audio);
+	AllocationTracker::EndFrame();
+	AllocationTracker::Enable(false);
+	NewAndDelete(1);
+
+	CHECK_EQUAL(2u, simulation.allocations);
+	CHECK_EQUAL(static_cast<unsigned int>(11 * sizeof(int)), simulation.bytes);
+	CHECK_EQUAL(1u, audio.allocations);
+	CHECK_EQUAL(2u, AllocationTracker::GetLastFrame(AllocationTag::Simulation).allocations);
+	CHECK_EQUAL(0u, AllocationTracker::GetCurrent(AllocationTag::Simulation).allocations);
+	CHECK_EQUAL(0u, AllocationTracker::GetCurrent(AllocationTag::Other).allocations);
+	CHECK_EQUAL(2u, AllocationTracker::GetFrames());
+}
+
+TEST(AllocationTrackerSamplesCallSites)
+{
+	AllocationTracker::Reset();
+	AllocationTracker::SetSampleRate(1);
+	AllocationTracker::Enable(true);
+	{
+		AllocationScope scope(AllocationTag::Widgets);
+		for(int i = 0; i < 5; i++)
+		{
+			NewAndDelete(1);
+		}
+	}
+	AllocationTracker::Enable(false);
+	AllocationTracker::EndFrame();
+	AllocationTracker::SetSampleRate(64);
+
+	std::ostringstream report;
+	AllocationTracker::Report(report);
+	CHECK(report.str().find("Widgets: 5 allocations (peak 5)") != std::string::npos);
+	CHECK(report.str().find("Widgets: 5 samples") != std::string::npos);
+	AllocationTracker::Reset();
+}
+
+TEST(GameTickStaysInItsAllocationBudget)
+{
+	ArkGame::SharedPointer game = RunningGame();
+	game->Tick(0.01f);
+	AllocationTracker::Reset();
+	AllocationTracker::Enable(true);
+	AllocationTracker::EndFrame();
+	game->Tick(0.01f);
+	AllocationStats tick = AllocationTracker::GetCurrent(AllocationTag::Simulation);
+	AllocationTracker::Enable(false);
+	AllocationTracker::Reset();
+	CHECK(tick.allocations <= tickAllocationBudget);
+}
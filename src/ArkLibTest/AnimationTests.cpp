@@ -0,0 +1,158 @@
+#include "stdafx.h"
+#include <Animation.h>
+#include <AnimationFrame.h>
+#include <AnimationSet.h>
+#include <TextureManager.h>
+#include <RenderSnapshot.h>
+
+namespace
+{
+	//Frames 0, 1 and 2 showing for 0.1, 0.2 and 0.3 seconds
+	void AddFrames(Animation& animation)
+	{
+		animation.AddFrame(new AnimationFrame(0, 0.1f, Vector2i(0, 0)));
+		animation.AddFrame(new AnimationFrame(1, 0.2f, Vector2i(0, 0)));
+		animation.AddFrame(new AnimationFrame(2, 0.3f, Vector2i(0, 0)));
+	}
+}
+
+TEST(AnimationFrameAtTime)
+{
+	Animation animation;
+	AddFrames(animation);
+	CHECK_EQUAL(3, animation.GetFrameCount());
+	CHECK_CLOSE(0.6f, animation.GetLength(), 0.0001f);
+	CHECK_EQUAL(0, animation.GetFrameID(0.0f));
+	CHECK_EQUAL(0, animation.GetFrameID(0.05f));
+	CHECK_EQUAL(1, animation.GetFrameID(0.15f));
+	CHECK_EQUAL(1, animation.GetFrameID(0.25f));
+	CHECK_EQUAL(2, animation.GetFrameID(0.45f));
+	//Wraps round
+	CHECK_EQUAL(0, animation.GetFrameID(0.65f));
+	CHECK_EQUAL(2, animation.GetFrameID(1.55f));
+	CHECK_EQUAL(2, animation.GetFrameID(-0.05f));
+}
+
+TEST(AnimationPlayheadsAreIndependent)
+{
+	Animation animation;
+	AddFrames(animation);
+	AnimationPlayhead playheads[2] = {animation.Play(0.0f), animation.Play(0.35f)};
+	CHECK(playheads[0].clip == &animation);
+	CHECK_EQUAL(0, playheads[0].frame);
+	CHECK_EQUAL(2, playheads[1].frame);
+
+	Animation::Advance(playheads, 2, 0.15f);
+	CHECK_EQUAL(1, Animation::GetFrame(playheads[0])->GetFrameID());
+	CHECK_EQUAL(2, Animation::GetFrame(playheads[1])->GetFrameID());
+	Animation::Advance(playheads, 2, 0.15f);
+	CHECK_EQUAL(2, playheads[0].frame);
+	//0.65 wraps to 0.05
+	CHECK_EQUAL(0, playheads[1].frame);
+	CHECK_CLOSE(0.05f, playheads[1].time, 0.0001f);
+
+	//A long tick goes round more than once
+	Animation::Advance(playheads, 2, 1.3f);
+	CHECK_CLOSE(0.4f, playheads[0].time, 0.0001f);
+	CHECK_EQUAL(2, playheads[0].frame);
+}
+
+TEST(AnimationAdvancesPlayheadsOnDifferentClips)
+{
+	Animation three;
+	AddFrames(three);
+	Animation one;
+	one.AddFrame(new AnimationFrame(7, 1.0f, Vector2i(0, 0)));
+
+	std::vector<AnimationPlayhead> playheads(1000, three.Play(0.0f));
+	for(unsigned int i = 0; i < playheads.size(); i += 2)
+	{
+		playheads[i] = one.Play(0.0f);
+	}
+	AnimationPlayhead nothing = {NULL, 0, 0};
+	playheads.push_back(nothing);
+
+	Animation::Advance(&playheads[0], static_cast<unsigned int>(playheads.size()), 0.5f);
+	CHECK_EQUAL(7, Animation::GetFrame(playheads[0])->GetFrameID());
+	CHECK_EQUAL(2, Animation::GetFrame(playheads[1])->GetFrameID());
+	CHECK_EQUAL(2, Animation::GetFrame(playheads[999])->GetFrameID());
+	CHECK(Animation::GetFrame(playheads[1000]) == NULL);
+}
+
+TEST(AnimationHandlesResolveWhenTheSetIsAdded)
+{
+	AnimationHandle spin = TextureManager::GetHandle("HandleTest.animation", "Spin");
+	AnimationHandle missing = TextureManager::GetHandle("HandleTest.animation", "Missing");
+	CHECK(spin != missing);
+	CHECK_EQUAL(spin, TextureManager::GetHandle("HandleTest.animation", "Spin"));
+	CHECK(TextureManager::GetAnimation(spin) == NULL);
+	CHECK(TextureManager::GetAnimation(TextureManager::NoAnimation) == NULL);
+
+	AnimationSetDescription description;
+	AnimationSetDescription::AnimationDescription animation;
+	animation.name = "Spin";
+	AnimationSetDescription::Frame frame = {Vector2i(0, 0), Vector2i(8, 8), Vector2i(0, 0), "Spin.png", 0.5f};
+	animation.frames.push_back(frame);
+	animation.frames.push_back(frame);
+	description.animations.push_back(animation);
+	AnimationSet* set = TextureManager::AddAnimationSet("HandleTest.animation", description);
+	CHECK(set != NULL);
+
+	Animation* resolved = TextureManager::GetAnimation(spin);
+	CHECK(resolved != NULL);
+	if(resolved)
+		CHECK_EQUAL(2, resolved->GetFrameCount());
+	CHECK(resolved == set->GetAnimation("Spin"));
+	CHECK(TextureManager::GetAnimation(missing) == NULL);
+	//Interned after the set was loaded
+	CHECK(TextureManager::GetAnimation(TextureManager::GetHandle("HandleTest.animation", "Spin")) == resolved);
+}
+
+namespace
+{
+	Animation* testClip = NULL;
+
+	const Animation* TestClip(const BallSnapshot& /*ball*/)
+	{
+		return testClip;
+	}
+
+	BallSnapshot TestBall(unsigned int id)
+	{
+		BallSnapshot ball;
+		ball.mId = id;
+		return ball;
+	}
+}
+
+TEST(SpritePlayheadsMoveOnEachTick)
+{
+	Animation animation;
+	AddFrames(animation);
+	testClip = &animation;
+	//As ModeGame does, matched to the snapshot on draw and advanced on tick
+	SpritePlayheads playheads(0.35f);
+	std::vector<BallSnapshot> balls;
+	balls.push_back(TestBall(0));
+	balls.push_back(TestBall(1));
+	playheads.Match(balls, &TestClip);
+	CHECK_EQUAL(2u, playheads.GetCount());
+	CHECK_EQUAL(0, playheads.Get(0).frame);
+	//Started out of step
+	CHECK_EQUAL(2, playheads.Get(1).frame);
+
+	playheads.Advance(0.15f);
+	CHECK_EQUAL(1, playheads.Get(0).frame);
+	playheads.Advance(0.15f);
+	CHECK_EQUAL(2, playheads.Get(0).frame);
+	CHECK_EQUAL(0, playheads.Get(1).frame);
+
+	//Matching again keeps the time of sprites still there, and starts new ones
+	balls.erase(balls.begin());
+	balls.push_back(TestBall(3));
+	playheads.Match(balls, &TestClip);
+	CHECK_EQUAL(2u, playheads.GetCount());
+	CHECK_CLOSE(0.05f, playheads.Get(0).time, 0.0001f);
+	CHECK_CLOSE(0.45f, playheads.Get(1).time, 0.0001f);
+	testClip = NULL;
+}
@@ -0,0 +1,226 @@
+#include "stdafx.h"
+#include <vmath-collisions.h>
+#include <vector>
+#include <cstdlib>
+#include <cmath>
+
+namespace
+{
+	const int caseCount = 2000;
+
+	/* Off any simple grid, so random shapes almost never touch exactly */
+	float RandomFloat(float _range)
+	{
+		return static_cast<float>(rand() % 20001 - 10000) / 10000.0f * _range + 0.0137f;
+	}
+
+	Vector2f RandomPoint(float _range)
+	{
+		return Vector2f(RandomFloat(_range), RandomFloat(_range));
+	}
+
+	std::vector<Vector2f> RandomMesh(int _triangles, float _range, float _size)
+	{
+		std::vector<Vector2f> mesh;
+		for(int i = 0; i < _triangles; i++)
+		{
+			Vector2f centre = RandomPoint(_range);
+			for(int j = 0; j < 3; j++)
+				mesh.push_back(centre + RandomPoint(_size));
+		}
+		return mesh;
+	}
+
+	/* A regular polygon squashed and turned, so always convex */
+	std::vector<Vector2f> RandomConvex(int _points, float _range, float _size)
+	{
+		Vector2f centre = RandomPoint(_range);
+		float angle = RandomFloat(3.14159f);
+		float squash = 0.3f + std::fabs(RandomFloat(1.0f));
+		std::vector<Vector2f> hull;
+		for(int i = 0; i < _points; i++)
+		{
+			float around = 6.28318f * i / _points;
+			Vector2f point(std::cos(around) * _size, std::sin(around) * _size * squash);
+			hull.push_back(centre + Vector2f(point.x * std::cos(angle) - point.y * std::sin(angle),
+											 point.x * std::sin(angle) + point.y * std::cos(angle)));
+		}
+		return hull;
+	}
+
+	bool VertexInside(const Vector2f* _triangle, const Vector2f* _other)
+	{
+		for(int i = 0; i < 3; i++)
+		{
+			if(Collisions2f::PointInTriangle(_other[0], _other[1], _other[2], _triangle[i]))
+				return true;
+		}
+		return false;
+	}
+
+	bool InsideConvex(const std::vector<Vector2f>& _hull, const Vector2f _point)
+	{
+		for(unsigned int i = 1; i + 1 < _hull.size(); i++)
+		{
+			if(Collisions2f::PointInTriangle(_hull[0], _hull[i], _hull[i + 1], _point))
+				return true;
+		}
+		return false;
+	}
+}
+
+TEST(ConvexIntersectsConvexAgreesWithEdgeTest)
+{
+	srand(3);
+	int hits = 0;
+	for(int i = 0; i < caseCount; i++)
+	{
+		std::vector<Vector2f> a = RandomMesh(1, 10, 5);
+		std::vector<Vector2f> b = RandomMesh(1, 10, 5);
+		//Edges crossing, or one inside the other which the edge test misses
+		bool expected = Collisions2f::PolygonIntersectsPolygon(&a[0], 1, &b[0], 1) ||
+						VertexInside(&a[0], &b[0]) || VertexInside(&b[0], &a[0]);
+		CHECK_EQUAL(expected, Collisions2f::ConvexIntersectsConvex(Collisions2f::Convex(&a[0], 3), Collisions2f::Convex(&b[0], 3)));
+		CHECK_EQUAL(expected, Collisions2f::TrianglesIntersect(&a[0], &b[0]));
+		hits += expected;
+	}
+	//Both outcomes are covered
+	CHECK(hits > caseCount / 10 && hits < caseCount * 9 / 10);
+
+	srand(5);
+	for(int i = 0; i < caseCount; i++)
+	{
+		std::vector<Vector2f> a = RandomConvex(3 + i % 6, 10, 6);
+		std::vector<Vector2f> b = RandomConvex(3 + i % 5, 10, 6);
+		//Fanned into triangles, the edge test plus containment is exact
+		std::vector<Vector2f> mesh_a, mesh_b;
+		for(unsigned int j = 1; j + 1 < a.size(); j++)
+		{
+			mesh_a.push_back(a[0]);
+			mesh_a.push_back(a[j]);
+			mesh_a.push_back(a[j + 1]);
+		}
+		for(unsigned int j = 1; j + 1 < b.size(); j++)
+		{
+			mesh_b.push_back(b[0]);
+			mesh_b.push_back(b[j]);
+			mesh_b.push_back(b[j + 1]);
+		}
+		bool expected = InsideConvex(a, b[0]) || InsideConvex(b, a[0]);
+		for(unsigned int j = 0; j < mesh_a.size() && !expected; j += 3)
+		{
+			for(unsigned int k = 0; k < mesh_b.size() && !expected; k += 3)
+			{
+				expected = Collisions2f::PolygonIntersectsPolygon(&mesh_a[j], 1, &mesh_b[k], 1) ||
+						   VertexInside(&mesh_a[j], &mesh_b[k]) || VertexInside(&mesh_b[k], &mesh_a[j]);
+			}
+		}
+		CHECK_EQUAL(expected, Collisions2f::ConvexIntersectsConvex(Collisions2f::Convex(&a[0], (int)a.size()), Collisions2f::Convex(&b[0], (int)b.size())));
+	}
+}
+
+TEST(ConvexIntersectsConvexFindsContainment)
+{
+	Vector2f outer[] = {Vector2f(0, 0), Vector2f(10, 0), Vector2f(10, 10), Vector2f(0, 10)};
+	Vector2f inner[] = {Vector2f(6, 2), Vector2f(8, 2), Vector2f(7, 4)};
+	Vector2f outer_mesh[] = {outer[0], outer[1], outer[2], outer[0], outer[2], outer[3]};
+	CHECK(!Collisions2f::PolygonIntersectsPolygon(outer_mesh, 2, inner, 1));
+	CHECK(Collisions2f::ConvexIntersectsConvex(Collisions2f::Convex(outer, 4), Collisions2f::Convex(inner, 3)));
+	CHECK(Collisions2f::ConvexIntersectsConvex(Collisions2f::Convex(inner, 3), Collisions2f::Convex(outer, 4)));
+
+	//Sharing an edge is only touching
+	Vector2f beside[] = {Vector2f(10, 0), Vector2f(20, 0), Vector2f(20, 10), Vector2f(10, 10)};
+	CHECK(!Collisions2f::ConvexIntersectsConvex(Collisions2f::Convex(outer, 4), Collisions2f::Convex(beside, 4)));
+}
+
+TEST(CircleIntersectsConvexAgreesWithDistance)
+{
+	srand(9);
+	int hits = 0;
+	for(int i = 0; i < caseCount; i++)
+	{
+		std::vector<Vector2f> hull = RandomConvex(3 + i % 6, 10, 6);
+		Vector2f centre = RandomPoint(12);
+		float radius = 0.5f + std::fabs(RandomFloat(4));
+		Vector2f closest;
+		bool expected = InsideConvex(hull, centre) ||
+						Collisions2f::PolygonPointDistance(&hull[0], (int)hull.size(), centre, closest) < radius;
+		CHECK_EQUAL(expected, Collisions2f::CircleIntersectsConvex(centre, radius, Collisions2f::Convex(&hull[0], (int)hull.size())));
+		hits += expected;
+	}
+	CHECK(hits > caseCount / 10 && hits < caseCount * 9 / 10);
+}
+
+TEST(MeshTreeIntersectsAgreesWithBruteForce)
+{
+	srand(13);
+	int hits = 0;
+	for(int i = 0; i < 200; i++)
+	{
+		int triangles_a = 1 + i % 40;
+		int triangles_b = 1 + (i * 7) % 30;
+		std::vector<Vector2f> a = RandomMesh(triangles_a, 40, 2);
+		std::vector<Vector2f> b = RandomMesh(triangles_b, 40, 2);
+		bool crossing = Collisions2f::PolygonIntersectsPolygon(&a[0], triangles_a, &b[0], triangles_b);
+		bool expected = false;
+		for(int j = 0; j < triangles_a && !expected; j++)
+		{
+			for(int k = 0; k < triangles_b && !expected; k++)
+				expected = Collisions2f::TrianglesIntersect(&a[j * 3], &b[k * 3]);
+		}
+		//Anything the edge test finds is found, plus containment
+		CHECK(expected || !crossing);
+
+		Collisions2f::MeshTree tree_a(&a[0], triangles_a);
+		Collisions2f::MeshTree tree_b(&b[0], triangles_b);
+		CHECK_EQUAL(triangles_a, tree_a.GetTriangleCount());
+		CHECK_EQUAL(expected, tree_a.Intersects(tree_b));
+		CHECK_EQUAL(expected, tree_b.Intersects(tree_a));
+		hits += expected;
+	}
+	CHECK(hits > 20 && hits < 180);
+
+	std::vector<Vector2f> some = RandomMesh(4, 1, 1);
+	CHECK(!Collisions2f::MeshTree(0, 0).Intersects(Collisions2f::MeshTree(&some[0], 4)));
+}
+
+TEST(MeshTreeLineIntersectsAgreesWithLineInPolygon)
+{
+	srand(17);
+	const int triangles = 64;
+	std::vector<Vector2f> mesh = RandomMesh(triangles, 40, 3);
+	Collisions2f::MeshTree tree(&mesh[0], triangles);
+	int hits = 0;
+	for(int i = 0; i < caseCount; i++)
+	{
+		Vector2f P1 = RandomPoint(50);
+		Vector2f P2 = P1 + RandomPoint(20);
+		bool expected = false;
+		float nearest = 0;
+		Vector2f expected_out;
+		for(int j = 0; j < triangles; j++)
+		{
+			const Vector2f* triangle = &mesh[j * 3];
+			Vector2f closed[] = {triangle[0], triangle[1], triangle[2], triangle[0]};
+			if(!Collisions2f::LineInPolygon(P1, P2, closed, 4))
+				continue;
+			for(int edge = 0; edge < 3; edge++)
+			{
+				Vector2f crossing;
+				if(Collisions2f::LineSegmentsIntersect(P1, P2, closed[edge], closed[edge + 1], crossing) &&
+				   (!expected || Collisions2f::DistanceSqr(crossing, P1) < nearest))
+				{
+					nearest = Collisions2f::DistanceSqr(crossing, P1);
+					expected_out = crossing;
+					expected = true;
+				}
+			}
+		}
+		Vector2f out;
+		CHECK_EQUAL(expected, tree.LineIntersects(P1, P2, out));
+		if(expected)
+			CHECK_EQUAL(expected_out, out);
+		hits += expected;
+	}
+	CHECK(hits > caseCount / 10 && hits < caseCount * 9 / 10);
+}
@@ -185,4 +185,32 @@ TEST(AdditionalBalls)
 
 TEST(Scoring)
 {
-}
\ No newline at end of file
+}
+TEST(SnapshotCopiesGameState)
+{
+	ArkGame::SharedPointer game(new ArkGame());
+	Wall::SharedPointer wall(new Wall());
+	Brick::SharedPointer brick(new Brick(BrickType::YellowBrick));
+	wall->AddBrick(brick);
+	game->SetWall(wall);
+	game->Tick(((float)ArkGame::STARTING_TIME) / 1000.0f);
+
+	RenderSnapshot snapshot;
+	game->FillSnapshot(snapshot);
+	CHECK_EQUAL(1, snapshot.mBalls.size());
+	CHECK_EQUAL(ArkGame::BallToGame(game->GetBalls()[0]), snapshot.mBalls[0].mPosition);
+	CHECK_EQUAL(1, snapshot.mBricks.size());
+	CHECK_EQUAL(BrickType::YellowBrick, snapshot.mBricks[0].mBrickType);
+	CHECK_EQUAL(3, snapshot.mBricks[0].mLives);
+	CHECK_EQUAL(ArkGame::BrickToGame(brick, wall), snapshot.mBricks[0].mPosition);
+	CHECK_EQUAL(ArkGame::PaddleToGame(game->GetPaddle()), snapshot.mPaddle);
+	CHECK_EQUAL(game->GetScore(), snapshot.mScore);
+
+	//The snapshot doesn't follow the game once taken
+	brick->Hit();
+	wall->SetX(wall->GetPosition().x + 10);
+	CHECK_EQUAL(3, snapshot.mBricks[0].mLives);
+	game->FillSnapshot(snapshot);
+	CHECK_EQUAL(2, snapshot.mBricks[0].mLives);
+	CHECK_EQUAL(ArkGame::BrickToGame(brick, wall), snapshot.mBricks[0].mPosition);
+}
@@ -0,0 +1,115 @@
+#include "stdafx.h"
+#include <Logger.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+namespace
+{
+	const int threadLines = 100;	//Few enough records to fit a ring without waiting on the writer
+
+	std::string ReadLog(const char* _filename)
+	{
+		std::ifstream file(_filename);
+		std::ostringstream contents;
+		contents << file.rdbuf();
+		return contents.str();
+	}
+
+	int CountOf(const std::string& _text, const std::string& _find)
+	{
+		int count = 0;
+		for(size_t at = _text.find(_find); at != std::string::npos; at = _text.find(_find, at + 1))
+		{
+			count++;
+		}
+		return count;
+	}
+
+	/* Each line is split over several records, long enough for its text to take more than one */
+	void LogLines(const char* _name)
+	{
+		for(int line = 0; line < threadLines; line++)
+		{
+			Logger::DiagnosticOut() << "LoggerThread " << _name << " writes a line long enough to be split " << 7 << " " << 0.25f << "\n";
+		}
+	}
+
+#ifdef _WIN32
+	DWORD WINAPI LogLinesMain(LPVOID _name)
+	{
+		LogLines(static_cast<const char*>(_name));
+		return 0;
+	}
+#else
+	void* LogLinesMain(void* _name)
+	{
+		LogLines(static_cast<const char*>(_name));
+		return NULL;
+	}
+#endif
+}
+
+TEST(LoggerWritesValuesAsLogged)
+{
+	Logger::DiagnosticOut() << "LoggerValues " << 3 << " " << 4u << " " << 0.5f << " " << Vector2f(1, 2) << " " << Vector3f(1, 2, 3) << "\n";
+	Logger::Flush();
+	CHECK_EQUAL(1, CountOf(ReadLog("Diagnostic.txt"), "LoggerValues 3 4 0.5 (1,2) (1,2,3)\n"));
+}
+
+TEST(LoggerIgnoresLevelsPastTheThreshold)
+{
+	Logger::SetLevel(LogLevel::Error);
+	Logger::DiagnosticOut() << "LoggerFiltered\n";
+	Logger::ErrorOut() << "LoggerNotFiltered\n";
+	Logger::SetLevel(LogLevel::Diagnostic);
+	Logger::Flush();
+	CHECK_EQUAL(0, CountOf(ReadLog("Diagnostic.txt"), "LoggerFiltered"));
+	CHECK_EQUAL(1, CountOf(ReadLog("ErrorLog.txt"), "LoggerNotFiltered\n"));
+}
+
+TEST(LoggerWriterKeepsEachThreadsLinesWhole)
+{
+	Logger::StartWriter();
+	const char* names[] = {"A", "B"};
+#ifdef _WIN32
+	HANDLE threads[2];
+	for(int i = 0; i < 2; i++)
+		threads[i] = CreateThread(NULL, 0, LogLinesMain, const_cast<char*>(names[i]), 0, NULL);
+#else
+	pthread_t threads[2];
+	for(int i = 0; i < 2; i++)
+		pthread_create(&threads[i], NULL, LogLinesMain, const_cast<char*>(names[i]));
+#endif
+	LogLines("Main");
+#ifdef _WIN32
+	WaitForMultipleObjects(2, threads, TRUE, INFINITE);
+	for(int i = 0; i < 2; i++)
+		CloseHandle(threads[i]);
+#else
+	for(int i = 0; i < 2; i++)
+		pthread_join(threads[i], NULL);
+#endif
+	//An unfinished line is written once the writer stops
+	Logger::DiagnosticOut() << "LoggerUnfinished";
+	Logger::Flush();
+	std::string flushed = ReadLog("Diagnostic.txt");
+	Logger::StopWriter();
+	std::string log = ReadLog("Diagnostic.txt");
+
+	CHECK_EQUAL(0u, Logger::GetDropped());
+	CHECK_EQUAL(threadLines, CountOf(flushed, "LoggerThread Main writes a line long enough to be split 7 0.25\n"));
+	CHECK_EQUAL(threadLines, CountOf(log, "LoggerThread A writes a line long enough to be split 7 0.25\n"));
+	CHECK_EQUAL(threadLines, CountOf(log, "LoggerThread B writes a line long enough to be split 7 0.25\n"));
+	CHECK_EQUAL(threadLines * 3, CountOf(log, "LoggerThread"));
+	CHECK_EQUAL(0, CountOf(flushed, "LoggerUnfinished"));
+	CHECK_EQUAL(1, CountOf(log, "LoggerUnfinished"));
+	Logger::DiagnosticOut() << "\n";
+}
@@ -0,0 +1,74 @@
+#include "stdafx.h"
+#include <Trace.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cstdio>
+
+namespace
+{
+	const char* traceFile = "TraceTest.json";
+
+	std::string ReadTrace()
+	{
+		std::ifstream file(traceFile);
+		std::ostringstream contents;
+		contents << file.rdbuf();
+		return contents.str();
+	}
+}
+
+TEST(TraceRecordsOnlyTheFramesAskedFor)
+{
+	Trace::Start(1, 2, traceFile, 16);
+	{
+		TraceScope before("TraceBefore");
+	}
+	CHECK(!Trace::IsRecording());
+	Trace::EndFrame();
+	CHECK(Trace::IsRecording());
+	{
+		TraceScope outer("TraceOuter", "Levels\\Level \"1\"");
+		TraceScope inner("TraceInner");
+	}
+	Trace::EndFrame();
+	{
+		TraceScope second("TraceSecondFrame");
+	}
+	CHECK_EQUAL(3u, Trace::GetRecorded());
+	//Written once the last frame ends
+	CHECK(ReadTrace().empty());
+	Trace::EndFrame();
+	CHECK(!Trace::IsRecording());
+	{
+		TraceScope after("TraceAfter");
+	}
+
+	std::string trace = ReadTrace();
+	CHECK(trace.find("{\"traceEvents\":[") == 0);
+	CHECK(trace.find("TraceBefore") == std::string::npos);
+	CHECK(trace.find("TraceAfter") == std::string::npos);
+	CHECK(trace.find("{\"name\":\"TraceInner\",\"ph\":\"X\"") != std::string::npos);
+	CHECK(trace.find("\"args\":{\"frame\":1,\"detail\":\"Levels\\\\Level \\\"1\\\"\"}") != std::string::npos);
+	CHECK(trace.find("\"name\":\"TraceSecondFrame\"") != std::string::npos);
+	CHECK(trace.find("\"args\":{\"frame\":2}") != std::string::npos);
+	remove(traceFile);
+}
+
+TEST(TraceDropsEventsPastItsCapacity)
+{
+	Trace::Start(0, 5, traceFile, 2);
+	for(int i = 0; i < 5; i++)
+	{
+		TraceScope scope("TraceFull");
+	}
+	CHECK_EQUAL(2u, Trace::GetRecorded());
+	CHECK_EQUAL(3u, Trace::GetDropped());
+	//Written early when the range isn't over
+	Trace::Finish();
+	CHECK(!Trace::IsRecording());
+	std::string trace = ReadTrace();
+	CHECK(trace.find("TraceFull") != trace.rfind("TraceFull"));
+	CHECK(trace.find("},\n{") == trace.rfind("},\n{"));
+	remove(traceFile);
+}
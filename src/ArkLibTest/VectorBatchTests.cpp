@@ -0,0 +1,241 @@
+#include "stdafx.h"
+#include <VectorBatch.h>
+#include <vector>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+
+namespace
+{
+	const unsigned int vectorCount = 103;	//Not a multiple of four, so the scalar tail is tested too
+	const float tolerance = 1e-5f;
+
+	float RandomFloat()
+	{
+		return static_cast<float>(rand() % 20001 - 10000) / 100.0f;
+	}
+
+	std::vector<Vector2f> RandomVector2s()
+	{
+		srand(7);
+		std::vector<Vector2f> vectors;
+		for(unsigned int i = 0; i < vectorCount; i++)
+			vectors.push_back(Vector2f(RandomFloat(), RandomFloat()));
+		return vectors;
+	}
+
+	std::vector<Vector4f> RandomVector4s()
+	{
+		srand(11);
+		std::vector<Vector4f> vectors;
+		for(unsigned int i = 0; i < vectorCount; i++)
+			vectors.push_back(Vector4f(RandomFloat(), RandomFloat(), RandomFloat(), RandomFloat()));
+		return vectors;
+	}
+
+	/* Relative to the size of what's expected, as the inputs run to hundreds */
+	bool Close(float _expected, float _actual)
+	{
+		return std::fabs(_expected - _actual) <= tolerance * std::max(1.0f, std::fabs(_expected));
+	}
+}
+
+TEST(VectorBatchTransformMatchesVmath)
+{
+	Matrix3f matrix;
+	matrix.at(0, 0) = 0.8f;
+	matrix.at(1, 0) = -0.6f;
+	matrix.at(0, 1) = 0.6f;
+	matrix.at(1, 1) = 0.8f;
+	matrix.at(2, 0) = 32.5f;
+	matrix.at(2, 1) = -7.25f;
+	Matrix4f matrix4 = Matrix4f::createTranslation(1.5f, -2, 3);
+	matrix4.at(0, 1) = 0.5f;
+	matrix4.at(2, 3) = -0.25f;
+	for(int simd = 0; simd < 2; simd++)
+	{
+		VectorBatch::SetSIMD(simd != 0);
+		std::vector<Vector2f> points = RandomVector2s();
+		std::vector<Vector2f> moved(points.size());
+		VectorBatch::Transform(matrix, &points[0], &moved[0], vectorCount);
+		for(unsigned int i = 0; i < vectorCount; i++)
+		{
+			Vector3f expected = matrix * Vector3f(points[i].x, points[i].y, 1);
+			CHECK(Close(expected.x, moved[i].x));
+			CHECK(Close(expected.y, moved[i].y));
+		}
+		//In place
+		VectorBatch::Transform(matrix, &points[0], &points[0], vectorCount);
+		for(unsigned int i = 0; i < vectorCount; i++)
+			CHECK(moved[i] == points[i]);
+
+		std::vector<Vector4f> vectors = RandomVector4s();
+		std::vector<Vector4f> moved4(vectors.size());
+		VectorBatch::Transform(matrix4, &vectors[0], &moved4[0], vectorCount);
+		for(unsigned int i = 0; i < vectorCount; i++)
+		{
+			Vector4f expected = matrix4 * vectors[i];
+			CHECK(Close(expected.x, moved4[i].x));
+			CHECK(Close(expected.y, moved4[i].y));
+			CHECK(Close(expected.z, moved4[i].z));
+			CHECK(Close(expected.w, moved4[i].w));
+		}
+	}
+	VectorBatch::SetSIMD(true);
+}
+
+TEST(VectorBatchNormalizeMatchesVmath)
+{
+	for(int simd = 0; simd < 2; simd++)
+	{
+		VectorBatch::SetSIMD(simd != 0);
+		std::vector<Vector2f> vectors = RandomVector2s();
+		vectors[1] = Vector2f(0, 0);
+		std::vector<Vector2f> normalized = vectors;
+		VectorBatch::Normalize(&normalized[0], vectorCount);
+		for(unsigned int i = 0; i < vectorCount; i++)
+		{
+			Vector2f expected = vectors[i];
+			expected.normalize();
+			if(i == 1)
+			{
+				//Zero length comes out as NaNs, as it does from normalize()
+				CHECK(normalized[i].x != normalized[i].x);
+				CHECK(expected.x != expected.x);
+				continue;
+			}
+			CHECK(Close(expected.x, normalized[i].x));
+			CHECK(Close(expected.y, normalized[i].y));
+			CHECK(Close(1.0f, normalized[i].length()));
+		}
+
+		std::vector<Vector4f> vectors4 = RandomVector4s();
+		std::vector<Vector4f> normalized4 = vectors4;
+		VectorBatch::Normalize(&normalized4[0], vectorCount);
+		for(unsigned int i = 0; i < vectorCount; i++)
+		{
+			Vector4f expected = vectors4[i];
+			expected.normalize();
+			CHECK(Close(expected.x, normalized4[i].x));
+			CHECK(Close(expected.y, normalized4[i].y));
+			CHECK(Close(expected.z, normalized4[i].z));
+			CHECK(Close(expected.w, normalized4[i].w));
+		}
+	}
+	VectorBatch::SetSIMD(true);
+}
+
+TEST(VectorBatchDotMatchesVmath)
+{
+	for(int simd = 0; simd < 2; simd++)
+	{
+		VectorBatch::SetSIMD(simd != 0);
+		std::vector<Vector2f> a = RandomVector2s();
+		std::vector<Vector2f> b(a.rbegin(), a.rend());
+		std::vector<float> dots(vectorCount);
+		VectorBatch::Dot(&a[0], &b[0], &dots[0], vectorCount);
+		for(unsigned int i = 0; i < vectorCount; i++)
+			CHECK(Close(a[i].x * b[i].x + a[i].y * b[i].y, dots[i]));
+
+		std::vector<Vector4f> a4 = RandomVector4s();
+		std::vector<Vector4f> b4(a4.rbegin(), a4.rend());
+		VectorBatch::Dot(&a4[0], &b4[0], &dots[0], vectorCount);
+		for(unsigned int i = 0; i < vectorCount; i++)
+			CHECK(Close(a4[i].x * b4[i].x + a4[i].y * b4[i].y + a4[i].z * b4[i].z + a4[i].w * b4[i].w, dots[i]));
+	}
+	VectorBatch::SetSIMD(true);
+}
+
+TEST(VectorBatchMinMaxFindsBounds)
+{
+	for(int simd = 0; simd < 2; simd++)
+	{
+		VectorBatch::SetSIMD(simd != 0);
+		std::vector<Vector2f> points = RandomVector2s();
+		//Every count up to a few groups, to cover each way the tail can fall
+		for(unsigned int count = 1; count <= 9; count++)
+		{
+			Vector2f expected_min = points[0];
+			Vector2f expected_max = points[0];
+			for(unsigned int i = 1; i < count; i++)
+			{
+				expected_min = Vector2f(std::min(expected_min.x, points[i].x), std::min(expected_min.y, points[i].y));
+				expected_max = Vector2f(std::max(expected_max.x, points[i].x), std::max(expected_max.y, points[i].y));
+			}
+			Vector2f low, high;
+			VectorBatch::MinMax(&points[0], count, low, high);
+			CHECK(expected_min == low);
+			CHECK(expected_max == high);
+		}
+
+		std::vector<Vector4f> vectors = RandomVector4s();
+		Vector4f expected_min = vectors[0];
+		Vector4f expected_max = vectors[0];
+		for(unsigned int i = 1; i < vectorCount; i++)
+		{
+			expected_min = Vector4f(std::min(expected_min.x, vectors[i].x), std::min(expected_min.y, vectors[i].y),
+									std::min(expected_min.z, vectors[i].z), std::min(expected_min.w, vectors[i].w));
+			expected_max = Vector4f(std::max(expected_max.x, vectors[i].x), std::max(expected_max.y, vectors[i].y),
+									std::max(expected_max.z, vectors[i].z), std::max(expected_max.w, vectors[i].w));
+		}
+		Vector4f low, high;
+		VectorBatch::MinMax(&vectors[0], vectorCount, low, high);
+		CHECK(expected_min == low);
+		CHECK(expected_max == high);
+
+		//Nothing to bound, left as they were
+		Vector2f untouched_min(1, 2), untouched_max(3, 4);
+		VectorBatch::MinMax(&points[0], 0, untouched_min, untouched_max);
+		CHECK(Vector2f(1, 2) == untouched_min);
+		CHECK(Vector2f(3, 4) == untouched_max);
+	}
+	VectorBatch::SetSIMD(true);
+}
+
+#ifdef VMATH_HAS_SSE
+TEST(Vector4SSEMatchesScalar)
+{
+	std::vector<Vector4f> a = RandomVector4s();
+	std::vector<Vector4f> b(a.rbegin(), a.rend());
+	for(unsigned int i = 0; i < vectorCount; i++)
+	{
+		const Vector4f& u = a[i];
+		const Vector4f& v = b[i];
+		//Written out rather than through Vector4f, which is itself SSE when VMATH_SSE is defined
+		float dot = u.x * v.x + u.y * v.y + u.z * v.z + u.w * v.w;
+		float length_sq = u.x * u.x + u.y * u.y + u.z * u.z + u.w * u.w;
+		float length = std::sqrt(length_sq);
+		CHECK(Close(dot, Vector4SSE::dotProduct(u, v)));
+		CHECK(Close(dot, u.dotProduct(v)));
+		CHECK(Close(length_sq, Vector4SSE::lengthSq(u)));
+		CHECK(Close(length_sq, u.lengthSq()));
+		CHECK(Close(length, Vector4SSE::length(u)));
+		CHECK(Close(length, u.length()));
+
+		Vector4f normalized = u;
+		Vector4SSE::normalize(normalized);
+		Vector4f expected = u;
+		expected.normalize();
+		CHECK(Close(u.x / length, normalized.x));
+		CHECK(Close(u.w / length, normalized.w));
+		CHECK(Close(expected.y, normalized.y));
+		CHECK(Close(expected.z, normalized.z));
+
+		//One rounding per lane either way, so these are exact
+		Vector4f sum = Vector4SSE::add(u, v);
+		Vector4f difference = Vector4SSE::sub(u, v);
+		Vector4f product = Vector4SSE::mul(u, v);
+		Vector4f scaled = Vector4SSE::mul(u, 0.37f);
+		CHECK_EQUAL(u.x + v.x, sum.x);
+		CHECK_EQUAL(u.w + v.w, sum.w);
+		CHECK_EQUAL(u.y - v.y, difference.y);
+		CHECK_EQUAL(u.z * v.z, product.z);
+		CHECK_EQUAL(u.x * 0.37f, scaled.x);
+		CHECK_EQUAL(u.w * 0.37f, scaled.w);
+		CHECK_EQUAL((u + v).z, sum.z);
+		CHECK_EQUAL((u - v).w, difference.w);
+		CHECK_EQUAL((u * v).x, product.x);
+		CHECK_EQUAL((u * 0.37f).y, scaled.y);
+	}
+}
+#endif
@@ -0,0 +1,92 @@
+#include "stdafx.h"
+#include <VoiceAllocator.h>
+
+TEST(VoiceAllocatorMergesEventsWithinWindow)
+{
+	VoiceAllocator voices(4);
+	VoiceDecision first = voices.Request(0, 1, 1.0f);
+	CHECK_EQUAL(VoiceAction::Play, first.mAction);
+	CHECK_CLOSE(VoiceAllocator::BASE_VOLUME, first.mVolume, 0.001f);
+
+	VoiceDecision second = voices.Request(0, 1, 1.0f + VoiceAllocator::MERGE_WINDOW / 2);
+	CHECK_EQUAL(VoiceAction::Merge, second.mAction);
+	CHECK_EQUAL(first.mVoice, second.mVoice);
+	CHECK(second.mVolume > first.mVolume);
+	CHECK_EQUAL(1, voices.GetActiveCount());
+
+	//Too late to merge, so it gets a voice of its own
+	VoiceDecision third = voices.Request(0, 1, 1.0f + VoiceAllocator::MERGE_WINDOW * 2);
+	CHECK_EQUAL(VoiceAction::Play, third.mAction);
+	CHECK(third.mVoice != first.mVoice);
+
+	//A burst raised in the same tick is one voice from the start
+	VoiceDecision burst = voices.Request(1, 1, 2.0f, 20);
+	CHECK_EQUAL(VoiceAction::Play, burst.mAction);
+	CHECK_CLOSE(1.0f, burst.mVolume, 0.001f);
+	CHECK_EQUAL(3, voices.GetActiveCount());
+	CHECK_EQUAL(23u, voices.GetRequested());
+	CHECK_EQUAL(20u, voices.GetMerged());
+}
+
+TEST(VoiceAllocatorStealsLowestPriorityOldest)
+{
+	VoiceAllocator voices(3);
+	voices.Request(0, 2, 0.0f);
+	voices.Request(1, 1, 1.0f);
+	voices.Request(2, 1, 2.0f);
+
+	VoiceDecision decision = voices.Request(3, 1, 3.0f);
+	CHECK_EQUAL(VoiceAction::Steal, decision.mAction);
+	CHECK_EQUAL(1, decision.mVoice);
+	CHECK_EQUAL(3, voices.GetSample(1));
+
+	decision = voices.Request(4, 2, 4.0f);
+	CHECK_EQUAL(VoiceAction::Steal, decision.mAction);
+	CHECK_EQUAL(2, decision.mVoice);
+	CHECK_EQUAL(2u, voices.GetStolen());
+}
+
+TEST(VoiceAllocatorDropsWhenEverythingMattersMore)
+{
+	VoiceAllocator voices(2);
+	voices.Request(0, 3, 0.0f);
+	voices.Request(1, 3, 1.0f);
+
+	VoiceDecision decision = voices.Request(2, 1, 2.0f, 5);
+	CHECK_EQUAL(VoiceAction::Drop, decision.mAction);
+	CHECK_EQUAL(-1, decision.mVoice);
+	CHECK_EQUAL(5u, voices.GetDropped());
+	CHECK_EQUAL(0, voices.GetSample(0));
+	CHECK_EQUAL(1, voices.GetSample(1));
+}
+
+TEST(VoiceAllocatorLeavesLoopingVoicesAlone)
+{
+	VoiceAllocator voices(1);
+	VoiceDecision loop = voices.Request(0, 0, 0.0f, 1, true);
+	CHECK_EQUAL(VoiceAction::Play, loop.mAction);
+	CHECK_CLOSE(1.0f, loop.mVolume, 0.001f);
+
+	//Neither merged into nor taken over, even by the same sample at a higher priority
+	CHECK_EQUAL(VoiceAction::Drop, voices.Request(0, 5, 0.0f).mAction);
+	CHECK_EQUAL(VoiceAction::Drop, voices.Request(1, 5, 1.0f).mAction);
+	CHECK_EQUAL(0u, voices.GetMerged());
+}
+
+TEST(VoiceAllocatorReusesReleasedVoices)
+{
+	VoiceAllocator voices(1);
+	voices.Request(0, 3, 0.0f);
+	voices.Release(0);
+	CHECK_EQUAL(0, voices.GetActiveCount());
+	CHECK_EQUAL(-1, voices.GetSample(0));
+
+	VoiceDecision decision = voices.Request(1, 0, 0.01f);
+	CHECK_EQUAL(VoiceAction::Play, decision.mAction);
+	CHECK_EQUAL(0, decision.mVoice);
+	CHECK_EQUAL(0u, voices.GetStolen());
+	//Out of range releases are ignored
+	voices.Release(-1);
+	voices.Release(7);
+	CHECK_EQUAL(1, voices.GetActiveCount());
+}
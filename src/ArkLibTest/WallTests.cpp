@@ -36,4 +36,25 @@ TEST(WallFromXML)
 {
 	Wall::SharedPointer wall(new Wall("TestWall.Level"));
 	CHECK_EQUAL(3, wall->GetBricks().size());
-}
\ No newline at end of file
+}
+
+TEST(WallFromLevelBricks)
+{
+	std::vector<LevelBrick> bricks;
+	CHECK(Wall::ReadLevel("TestWall.Level", bricks));
+	CHECK_EQUAL(3, bricks.size());
+
+	if(bricks.size() == 3)
+	{
+		//Compiled levels build the same wall as the file
+		Wall::SharedPointer from_file(new Wall("TestWall.Level"));
+		Wall::SharedPointer from_bricks(new Wall(&bricks[0], bricks.size()));
+		CHECK_EQUAL(from_file->GetBricks().size(), from_bricks->GetBricks().size());
+		CHECK_EQUAL(from_file->GetLeftEdge(), from_bricks->GetLeftEdge());
+		CHECK_EQUAL(from_file->GetTopEdge(), from_bricks->GetTopEdge());
+		CHECK_EQUAL(from_file->GetBricks()[0]->GetBrickType(), from_bricks->GetBricks()[0]->GetBrickType());
+	}
+
+	std::vector<LevelBrick> missing;
+	CHECK(!Wall::ReadLevel("Missing.Level", missing));
+}
@@ -0,0 +1,312 @@
+#include "Logger.h"
+#include "AssetBundle.h"
+#include <SDL.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	const unsigned int alignment = 16;
+
+	unsigned int Align(unsigned int _offset)
+	{
+		return (_offset + alignment - 1) & ~(alignment - 1);
+	}
+}
+
+AssetBundle::AssetBundle()
+: data_(NULL), size_(0), index_(NULL), names_(NULL), count_(0)
+#ifdef _WIN32
+, file_(INVALID_HANDLE_VALUE), mapping_(NULL)
+#endif
+{
+}
+
+AssetBundle::~AssetBundle()
+{
+	Close();
+}
+
+AssetBundle& AssetBundle::Instance()
+{
+	static AssetBundle instance;
+	return instance;
+}
+
+bool AssetBundle::Open(const std::string& _path)
+{
+	Close();
+#ifdef _WIN32
+	file_ = CreateFileA(_path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if(file_ == INVALID_HANDLE_VALUE)
+		return false;
+	size_ = GetFileSize(file_, NULL);
+	mapping_ = CreateFileMappingA(file_, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+	if(mapping_)
+		data_ = static_cast<const char*>(MapViewOfFile(mapping_, FILE_MAP_COPY, 0, 0, 0));
+#else
+	int file = open(_path.c_str(), O_RDONLY);
+	if(file < 0)
+		return false;
+	struct stat status;
+	if(fstat(file, &status) == 0 && status.st_size > 0)
+	{
+		size_ = static_cast<unsigned int>(status.st_size);
+		void* mapped = mmap(NULL, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+		if(mapped != MAP_FAILED)
+			data_ = static_cast<const char*>(mapped);
+	}
+	//The mapping holds its own reference to the file
+	close(file);
+#endif
+	if(!data_ || !Validate())
+	{
+		Logger::ErrorOut() << "Unable to use asset bundle " << _path << "\n";
+		Close();
+		return false;
+	}
+	path_ = _path;
+	return true;
+}
+
+void AssetBundle::Close()
+{
+#ifdef _WIN32
+	if(data_)
+		UnmapViewOfFile(data_);
+	if(mapping_)
+		CloseHandle(mapping_);
+	if(file_ != INVALID_HANDLE_VALUE)
+		CloseHandle(file_);
+	mapping_ = NULL;
+	file_ = INVALID_HANDLE_VALUE;
+#else
+	if(data_)
+		munmap(const_cast<char*>(data_), size_);
+#endif
+	data_ = NULL;
+	size_ = 0;
+	index_ = NULL;
+	names_ = NULL;
+	count_ = 0;
+	path_.clear();
+}
+
+/* Everything is checked once here, so lookups can trust the index */
+bool AssetBundle::Validate()
+{
+	if(size_ < sizeof(Header))
+		return false;
+	const Header* header = reinterpret_cast<const Header*>(data_);
+	if(header->magic != magic || header->version != version)
+		return false;
+	if(header->index_offset % sizeof(unsigned int) != 0 || header->index_offset > size_ ||
+	   header->count > (size_ - header->index_offset) / sizeof(Entry))
+		return false;
+	if(header->names_offset > size_ || header->names_size > size_ - header->names_offset)
+		return false;
+
+	index_ = reinterpret_cast<const Entry*>(data_ + header->index_offset);
+	names_ = data_ + header->names_offset;
+	count_ = header->count;
+	for(unsigned int i = 0; i < count_; i++)
+	{
+		const Entry& entry = index_[i];
+		if(entry.offset > size_ || entry.size > size_ - entry.offset)
+			return false;
+		if(entry.name_offset > header->names_size || entry.name_length > header->names_size - entry.name_offset)
+			return false;
+		if(entry.type == AssetType::Image)
+		{
+			if(entry.size < sizeof(ImageHeader))
+				return false;
+			const ImageHeader* image = reinterpret_cast<const ImageHeader*>(data_ + entry.offset);
+			if(image->w <= 0 || image->h <= 0 || image->bpp != 32 || image->pitch < image->w * 4 ||
+			   static_cast<unsigned int>(image->pitch) * image->h > entry.size - sizeof(ImageHeader))
+				return false;
+		}
+		//Find is a binary search
+		if(i > 0 && !(GetName(index_[i - 1]) < GetName(entry)))
+			return false;
+	}
+	return true;
+}
+
+std::string AssetBundle::GetName(const Entry& _entry) const
+{
+	return std::string(names_ + _entry.name_offset, _entry.name_length);
+}
+
+const AssetBundle::Entry* AssetBundle::Find(const std::string& _name) const
+{
+	unsigned int low = 0;
+	unsigned int high = count_;
+	while(low < high)
+	{
+		unsigned int middle = (low + high) / 2;
+		int order = _name.compare(0, std::string::npos, names_ + index_[middle].name_offset, index_[middle].name_length);
+		if(order == 0)
+			return &index_[middle];
+		if(order < 0)
+			high = middle;
+		else
+			low = middle + 1;
+	}
+	return NULL;
+}
+
+void AssetBundle::List(const std::string& _prefix, const std::string& _suffix, std::vector<std::string>& _names) const
+{
+	for(unsigned int i = 0; i < count_; i++)
+	{
+		std::string name = GetName(index_[i]);
+		if(name.size() >= _prefix.size() + _suffix.size() &&
+		   name.compare(0, _prefix.size(), _prefix) == 0 &&
+		   name.compare(name.size() - _suffix.size(), _suffix.size(), _suffix) == 0)
+			_names.push_back(name);
+	}
+}
+
+SDL_Surface* AssetBundle::CreateSurface(const std::string& _name) const
+{
+	const Entry* entry = Find(_name);
+	if(!entry || entry->type != AssetType::Image)
+		return NULL;
+	const ImageHeader* image = reinterpret_cast<const ImageHeader*>(GetData(entry));
+	void* pixels = const_cast<char*>(GetData(entry) + sizeof(ImageHeader));
+	SDL_Surface* surface = SDL_CreateRGBSurfaceFrom(pixels, image->w, image->h, image->bpp, image->pitch,
+													image->rmask, image->gmask, image->bmask, image->amask);
+	//As SDL_DisplayFormatAlpha leaves it
+	if(surface && image->amask)
+		SDL_SetAlpha(surface, SDL_SRCALPHA, SDL_ALPHA_OPAQUE);
+	return surface;
+}
+
+void AssetBundleWriter::AddData(const std::string& _name, AssetType::Enum _type, const void* _data, unsigned int _size,
+								unsigned int _param0, unsigned int _param1, unsigned int _param2)
+{
+	Asset* asset = NULL;
+	for(std::vector<Asset>::iterator it = assets_.begin(); it != assets_.end(); ++it)
+	{
+		if(it->name == _name)
+			asset = &*it;
+	}
+	if(!asset)
+	{
+		assets_.push_back(Asset());
+		asset = &assets_.back();
+		asset->name = _name;
+	}
+	asset->type = _type;
+	const char* bytes = static_cast<const char*>(_data);
+	asset->data.assign(bytes, bytes + _size);
+	asset->params[0] = _param0;
+	asset->params[1] = _param1;
+	asset->params[2] = _param2;
+}
+
+bool AssetBundleWriter::AddImage(const std::string& _name, SDL_Surface* _surface)
+{
+	if(!_surface || _surface->format->BitsPerPixel != 32)
+	{
+		Logger::ErrorOut() << "Only 32 bit images can be bundled: " << _name << "\n";
+		return false;
+	}
+	AssetBundle::ImageHeader image;
+	image.w = _surface->w;
+	image.h = _surface->h;
+	image.pitch = _surface->w * 4;
+	image.bpp = 32;
+	image.rmask = _surface->format->Rmask;
+	image.gmask = _surface->format->Gmask;
+	image.bmask = _surface->format->Bmask;
+	image.amask = _surface->format->Amask;
+
+	//Rows are packed, the surface's own pitch may be padded
+	std::vector<char> data(sizeof(image) + image.pitch * image.h);
+	memcpy(&data[0], &image, sizeof(image));
+	SDL_LockSurface(_surface);
+	for(int y = 0; y < image.h; y++)
+	{
+		memcpy(&data[sizeof(image) + y * image.pitch], static_cast<char*>(_surface->pixels) + y * _surface->pitch, image.pitch);
+	}
+	SDL_UnlockSurface(_surface);
+	AddData(_name, AssetType::Image, &data[0], static_cast<unsigned int>(data.size()));
+	return true;
+}
+
+namespace
+{
+	bool NameOrder(const std::pair<std::string, unsigned int>& _a, const std::pair<std::string, unsigned int>& _b)
+	{
+		return _a.first < _b.first;
+	}
+}
+
+bool AssetBundleWriter::Write(const std::string& _path) const
+{
+	//Sorted for AssetBundle::Find, the second is the asset's position in assets_
+	std::vector<std::pair<std::string, unsigned int> > order;
+	for(unsigned int i = 0; i < assets_.size(); i++)
+	{
+		order.push_back(std::make_pair(assets_[i].name, i));
+	}
+	std::sort(order.begin(), order.end(), NameOrder);
+
+	std::vector<AssetBundle::Entry> index(assets_.size());
+	std::string names;
+	unsigned int offset = Align(sizeof(AssetBundle::Header));
+	for(unsigned int i = 0; i < order.size(); i++)
+	{
+		const Asset& asset = assets_[order[i].second];
+		AssetBundle::Entry& entry = index[i];
+		entry.name_offset = static_cast<unsigned int>(names.size());
+		entry.name_length = static_cast<unsigned int>(asset.name.size());
+		entry.type = asset.type;
+		entry.offset = offset;
+		entry.size = static_cast<unsigned int>(asset.data.size());
+		std::copy(asset.params, asset.params + 3, entry.params);
+		names += asset.name;
+		offset = Align(offset + entry.size);
+	}
+
+	AssetBundle::Header header;
+	header.magic = AssetBundle::magic;
+	header.version = AssetBundle::version;
+	header.count = static_cast<unsigned int>(index.size());
+	header.index_offset = offset;
+	header.names_offset = offset + static_cast<unsigned int>(index.size() * sizeof(AssetBundle::Entry));
+	header.names_size = static_cast<unsigned int>(names.size());
+
+	std::ofstream out(_path.c_str(), std::ios::binary | std::ios::trunc);
+	if(!out)
+	{
+		Logger::ErrorOut() << "Unable to write asset bundle " << _path << "\n";
+		return false;
+	}
+	const char padding[alignment] = {0};
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	out.write(padding, Align(sizeof(header)) - sizeof(header));
+	for(unsigned int i = 0; i < order.size(); i++)
+	{
+		const std::vector<char>& data = assets_[order[i].second].data;
+		if(!data.empty())
+			out.write(&data[0], data.size());
+		out.write(padding, Align(index[i].offset + index[i].size) - (index[i].offset + index[i].size));
+	}
+	if(!index.empty())
+		out.write(reinterpret_cast<const char*>(&index[0]), index.size() * sizeof(AssetBundle::Entry));
+	out.write(names.data(), names.size());
+	return out.good();
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include <string>
+#include <vector>
+
+struct SDL_Surface;
+
+namespace AssetType
+{
+	enum Enum
+	{
+		Data,	//Bytes the game knows how to read, e.g. animation tables and compiled levels
+		Image,	//An ImageHeader then the pixels, already in display format
+		Sound	//PCM in the mixer's format; params are frequency, format and channels
+	};
+}
+
+/* Many assets in one file, read through a memory map so nothing is copied or decoded at load time.
+   Layout: a Header, then each asset's bytes 16 byte aligned, then an index of Entry sorted by
+   name, then the names. Everything is in the byte order of the machine that wrote it */
+class AssetBundle
+{
+public:
+	static const unsigned int magic = 0x424B5241; //"ARKB"
+	static const unsigned int version = 1;
+
+	struct Header
+	{
+		unsigned int magic;
+		unsigned int version;
+		unsigned int count;
+		unsigned int index_offset;
+		unsigned int names_offset;
+		unsigned int names_size;
+	};
+	struct Entry
+	{
+		unsigned int name_offset;	//Into the names, which aren't terminated
+		unsigned int name_length;
+		unsigned int type;
+		unsigned int offset;
+		unsigned int size;
+		unsigned int params[3];
+	};
+	struct ImageHeader
+	{
+		int w;
+		int h;
+		int pitch;
+		unsigned int bpp;
+		unsigned int rmask;
+		unsigned int gmask;
+		unsigned int bmask;
+		unsigned int amask;
+	};
+
+private:
+	const char* data_;
+	unsigned int size_;
+	const Entry* index_;
+	const char* names_;
+	unsigned int count_;
+	std::string path_;
+#ifdef _WIN32
+	void* file_;
+	void* mapping_;
+#endif
+
+	bool Validate();
+	std::string GetName(const Entry& _entry) const;
+
+	AssetBundle(const AssetBundle&);
+	AssetBundle& operator=(const AssetBundle&);
+
+public:
+	AssetBundle();
+	~AssetBundle();
+	/* The bundle the game's caches look in before going to loose files. First called on the main
+	   thread, before any worker looks in it */
+	static AssetBundle& Instance();
+
+	/* Maps _path, replacing whatever was open. False, with nothing open, if it isn't a valid bundle */
+	bool Open(const std::string& _path);
+	/* Surfaces created from the bundle must be freed first */
+	void Close();
+	bool IsOpen() const {return data_ != NULL;}
+	const std::string& GetPath() const {return path_;}
+	unsigned int GetCount() const {return count_;}
+	unsigned int GetSize() const {return size_;}
+
+	/* NULL if there is no asset named _name, or no bundle is open */
+	const Entry* Find(const std::string& _name) const;
+	const char* GetData(const Entry* _entry) const {return data_ + _entry->offset;}
+	/* Names starting with _prefix and ending with _suffix, in order */
+	void List(const std::string& _prefix, const std::string& _suffix, std::vector<std::string>& _names) const;
+
+	/* Wraps an image's pixels in a surface without copying them. The pixels are mapped copy on
+	   write, so a stray write changes only this process' view. NULL if _name isn't an image */
+	SDL_Surface* CreateSurface(const std::string& _name) const;
+};
+
+/* Collects assets in memory and writes them out as a bundle */
+class AssetBundleWriter
+{
+private:
+	struct Asset
+	{
+		std::string name;
+		AssetType::Enum type;
+		std::vector<char> data;
+		unsigned int params[3];
+	};
+	std::vector<Asset> assets_;
+
+public:
+	/* Replaces any asset already added under _name */
+	void AddData(const std::string& _name, AssetType::Enum _type, const void* _data, unsigned int _size,
+				 unsigned int _param0 = 0, unsigned int _param1 = 0, unsigned int _param2 = 0);
+	/* Stores the pixels as they are, so convert to display format first */
+	bool AddImage(const std::string& _name, SDL_Surface* _surface);
+	unsigned int GetCount() const {return static_cast<unsigned int>(assets_.size());}
+	bool Write(const std::string& _path) const;
+};
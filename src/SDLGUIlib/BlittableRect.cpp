@@ -1,12 +1,13 @@
 #include "Logger.h"
 #include "BlittableRect.h"
+#include "SurfaceBlit.h"
+#include "ImageCache.h"
 #include <SDL.h>
 #include <SDL_image.h>
 
 
 unsigned int BlittableRect::surface_flags_ = SDL_SWSURFACE | SDL_SRCALPHA;
 int BlittableRect::depth_ = 32;
-unsigned int BlittableRect::bytes_used = 0;
 
 SDL_Surface* font = NULL;
 SDL_Surface* font_small = NULL;
@@ -26,134 +27,27 @@ namespace
 	Uint32 bmask = 0x00ff0000;
 	Uint32 amask = 0xff000000;
 #endif
-
-	/* Copies data from RGBA with alpha */
-	/* Otherwise when blitting the dest alpha is not changed, so can't copy subimage */
-	void BlindBlit(SDL_Surface* _src, SDL_Surface* _dest, SDL_Rect* _offset)
-	{
-		SDL_LockSurface(_src);
-		SDL_LockSurface(_dest);
-		//Clamp height and width
-		int w = _src->w + _offset->x < _dest->w ? _src->w : _dest->w - _offset->x;
-		w = w < 0 ? 0 : w;
-		int h = _src->h + _offset->y < _dest->h ? _src->h : _dest->h - _offset->y;
-		h = h < 0 ? 0 : h;
-		int bpp = _src->format->BytesPerPixel;
-
-		if(_src->format->BytesPerPixel != _dest->format->BytesPerPixel)
-		{
-			Logger::ErrorOut() << "Unable to Acquire resource, source data and dest data have different bpp\n";
-			return;
-		}
-
-		//Copy w x h pixels from _src to _dest
-		//TODO fix negative offset
-		for(int y = 0; y < h; y++)
-		{
-			char* dest = (char*)_dest->pixels + (bpp * (_offset->y + y) * _dest->w) +	//Start of dest row
-												(bpp * _offset->x);						//Plus offset
-			char* src = (char*)_src->pixels + (bpp * y * _src->w);//Start of src row
-			memcpy(dest, src, bpp * w);
-		}
-		SDL_UnlockSurface(_src);
-		SDL_UnlockSurface(_dest);
-	}
-
-	/* Copies data from RGBA with alpha */
-	/* This version copies a subimage to an offset position */
-	void BlindBlit(SDL_Surface* _src, SDL_Rect* _src_rect, SDL_Surface* _dest, Vector2i _dest_offset)
-	{
-		SDL_LockSurface(_src);
-		SDL_LockSurface(_dest);
-		//Clamp src_rect so won't read past end of image
-		SDL_Rect src_rect = *_src_rect;
-		src_rect.w = static_cast<Uint16>(src_rect.w + src_rect.x > _src->w ? _src->w - src_rect.x : src_rect.w);
-		src_rect.h = static_cast<Uint16>(src_rect.h + src_rect.y > _src->h ? _src->h - src_rect.y : src_rect.h);
-
-		//Clamp height and width
-		int w = src_rect.w + _dest_offset.x > _dest->w ? _dest->w - _dest_offset.x : src_rect.w;
-		w = w < 0 ? 0 : w;
-		int h = src_rect.h + _dest_offset.y > _dest->h ? _dest->h - _dest_offset.y : src_rect.h;
-		h = h < 0 ? 0 : h;
-
-		int bpp = _src->format->BytesPerPixel;
-
-		if(_src->format->BytesPerPixel != _dest->format->BytesPerPixel)
-		{
-			Logger::ErrorOut() << "Unable to Acquire resource, source data and dest data have different bpp\n";
-			return;
-		}
-
-		//Copy w x h pixels from _src to _dest
-		//TODO fix negative offset
-		for(int y = 0; y < h; y++)
-		{
-			char* dest = (char*)_dest->pixels + (bpp * (_dest_offset.y + y) * _dest->w) +	//Start of dest row
-												(bpp * _dest_offset.x);						//Plus offset
-			
-			char* src = (char*)_src->pixels +   (bpp * (src_rect.y + y) * _src->w) +		//Start of src row
-												(bpp * src_rect.x);						//Plus offset
-
-			memcpy(dest, src, bpp * w);
-		}
-		SDL_UnlockSurface(_src);
-		SDL_UnlockSurface(_dest);
-	}
-
-	
-	void SampleSurface(SDL_Surface* _src, SDL_Surface* _dest)
-	{
-		if(_src == NULL)
-		{
-			Logger::ErrorOut() << "Source is NULL in SampleSurface\n";
-			return;
-		}
-		SDL_LockSurface(_src);
-		SDL_LockSurface(_dest);
-		int bpp = _src->format->BytesPerPixel;
-		if(_src->format->BytesPerPixel != _dest->format->BytesPerPixel)
-		{
-			Logger::ErrorOut() << "Unable to Acquire resource, source data and dest data have different bpp\n";
-			return;
-		}
-
-		for(int y = 0; y < _dest->h; y++)
-		{
-			for(int x = 0; x < _dest->w; x++)
-			{
-				int sample_x = static_cast<int>(((float)_src->w / (float)_dest->w) * x);
-				int sample_y = static_cast<int>(((float)_src->h / (float)_dest->h) * y);
-				char* dest = (char*)_dest->pixels + (_dest->pitch * y) +
-													(bpp * x);		
-				char* src = (char*)_src->pixels + (_src->pitch * sample_y) +
-												  (bpp * sample_x);//Start of src row
-				
-				for(int b = 0; b < bpp; b++)
-				{
-					*dest = *src;
-					dest++;
-					src++;
-				}
-			}
-		}
-		SDL_UnlockSurface(_src);
-		SDL_UnlockSurface(_dest);
-	}
 }
 
 
 BlittableRect::BlittableRect(SDL_Surface* _surface, bool _dont_free_surface)
-: size_(Vector2i(_surface->w, _surface->h)), surface_(_surface), dont_free_(_dont_free_surface), error_occurred_(false)
+: size_(Vector2i(_surface->w, _surface->h)), surface_(_surface), dont_free_(_dont_free_surface), error_occurred_(false), shared_(false), category_(SurfaceCategory::Rect), budget_bytes_(0)
 {
-	bytes_used += surface_->w * _surface->h * _surface->format->BytesPerPixel;
+	if(!dont_free_)
+		Account();
 }
 
+BlittableRect::BlittableRect(SDL_Surface* _shared_surface, const std::string& _key)
+: size_(Vector2i(_shared_surface->w, _shared_surface->h)), surface_(_shared_surface), error_occurred_(false), dont_free_(false), shared_(true), source_key_(_key), category_(SurfaceCategory::Rect), budget_bytes_(0)
+{
+}
 
 BlittableRect::BlittableRect(Vector2i _size)
-	: size_(_size)
+	: size_(_size), category_(SurfaceCategory::Rect), budget_bytes_(0)
 {
 	error_occurred_ = false;
 	dont_free_ = false;
+	shared_ = false;
 	surface_ = SDL_CreateRGBSurface(surface_flags_, _size.x, _size.y, depth_, rmask, gmask, bmask, amask);
 	if(!surface_)
 	{
@@ -164,14 +58,16 @@ BlittableRect::BlittableRect(Vector2i _size)
 	SDL_FreeSurface(surface_);
 	surface_ = conv_surface;
 	SDL_FillRect(surface_, NULL, SDL_MapRGBA(surface_->format, 0,0,0,255));
-	bytes_used += surface_->w * surface_->h * surface_->format->BytesPerPixel;
+	Account();
 }
 
 BlittableRect::BlittableRect(std::string _filename)
+: category_(SurfaceCategory::Rect), budget_bytes_(0)
 {
 	error_occurred_ = false;
 	dont_free_ = false;
-	surface_ = IMG_Load(("Animations/" + _filename).c_str());
+	shared_ = false;
+	surface_ = ImageCache::Instance().Acquire("Animations/" + _filename);
 	if(!surface_)
 	{
 		error_occurred_ = true;
@@ -179,39 +75,36 @@ BlittableRect::BlittableRect(std::string _filename)
 		size_ = Vector2i(32, 32);
 		return; //Oh shit, TODO errors here
 	}
-	SDL_Surface* conv_surface = SDL_DisplayFormatAlpha(surface_);
-	SDL_FreeSurface(surface_);
-	surface_ = conv_surface;
+	shared_ = true;
 	size_ = Vector2i(surface_->w, surface_->h);
-	bytes_used += surface_->w * surface_->h * surface_->format->BytesPerPixel;
+	source_key_ = "Animations/" + _filename;
 }
 
 BlittableRect::BlittableRect(std::string _filename, bool _dont_append_animations)
+: category_(SurfaceCategory::Rect), budget_bytes_(0)
 {
 	error_occurred_ = false;
 	dont_free_ = false;
-	if(_dont_append_animations)
-		surface_ = IMG_Load(_filename.c_str());
-	else
-		surface_ = IMG_Load(("Animations/" + _filename).c_str());
+	shared_ = false;
+	std::string path = _dont_append_animations ? _filename : "Animations/" + _filename;
+	surface_ = ImageCache::Instance().Acquire(path);
 	if(!surface_)
 	{
 		error_occurred_ = true;
 		Logger::ErrorOut() << "Unable to load image " << _filename << "\n";
 		return; //Oh shit, TODO errors here
 	}
-	SDL_Surface* conv_surface = SDL_DisplayFormatAlpha(surface_);
-	SDL_FreeSurface(surface_);
-	surface_ = conv_surface;
+	shared_ = true;
 	size_ = Vector2i(surface_->w, surface_->h);
-	bytes_used += surface_->w * surface_->h * surface_->format->BytesPerPixel;
+	source_key_ = path;
 }
 
 BlittableRect::BlittableRect(std::string _filename, Vector2i _size) 
-: size_(_size)
+: size_(_size), category_(SurfaceCategory::Rect), budget_bytes_(0)
 {
 	error_occurred_ = false;
 	dont_free_ = false;
+	shared_ = false;
 	surface_ = SDL_CreateRGBSurface(surface_flags_, _size.x, _size.y, depth_, rmask, gmask, bmask, amask);
 	if(!surface_)
 	{
@@ -219,7 +112,7 @@ BlittableRect::BlittableRect(std::string _filename, Vector2i _size)
 		Logger::ErrorOut() << "Unable to create empty image of size " << _size << "\n";
 		return; //Oh shit, TODO errors here
 	}
-	SDL_Surface* file_surface = IMG_Load(_filename.c_str());
+	SDL_Surface* file_surface = ImageCache::Instance().Acquire(_filename);
 	if(!file_surface)
 	{
 		error_occurred_ = true;
@@ -227,26 +120,28 @@ BlittableRect::BlittableRect(std::string _filename, Vector2i _size)
 		return; //Oh shit, TODO errors here
 	}
 	SDL_BlitSurface(file_surface, NULL, surface_, NULL);
-	SDL_FreeSurface(file_surface);
+	ImageCache::Instance().Release(file_surface);
 
 
 	SDL_Surface* conv_surface = SDL_DisplayFormatAlpha(surface_);
 	SDL_FreeSurface(surface_);
 	surface_ = conv_surface;
-	bytes_used += surface_->w * surface_->h * surface_->format->BytesPerPixel;
+	Account();
 }
 
 
 BlittableRect::~BlittableRect(void)
 {
-	if(error_occurred_ == false && dont_free_ == false)
+	if(error_occurred_ == false && dont_free_ == false && shared_)
+	{
+		ImageCache::Instance().Release(surface_);
+	} else if(error_occurred_ == false && dont_free_ == false)
 	{
-		bytes_used -= surface_->w * surface_->h * surface_->format->BytesPerPixel;
-		//Logger::DiagnosticOut() << "Surface memory used: " << (int)bytes_used << "\n";
+		Unaccount();
 		SDL_FreeSurface(surface_);
 	} else
 	{
-		Logger::DiagnosticOut() << "Not freeing: Surface memory used: " << (int)bytes_used << "\n";
+		Logger::DiagnosticOut() << "Not freeing: Surface memory used: " << (int)SurfaceBudget::Instance().GetTotal() << "\n";
 	}
 }
 
@@ -257,6 +152,7 @@ void BlittableRect::Blit(Vector2i _position, BlittableRect* _dest)
 	dst_rect.y = static_cast<Sint16>(_position.y);
 	dst_rect.w = static_cast<Uint16>(size_.x);
 	dst_rect.h = static_cast<Uint16>(size_.y);
+	_dest->Modify();
 	SDL_BlitSurface(surface_, NULL, _dest->surface_, &dst_rect);
 }
 
@@ -264,26 +160,17 @@ void BlittableRect::RawBlit(Vector2i _position, BlittableRect* _dest)
 {
 	if(!surface_ || !_dest)
 		return;
-	SDL_Rect dst_rect;
-	dst_rect.x = static_cast<Sint16>(_position.x);
-	dst_rect.y = static_cast<Sint16>(_position.y);
-	dst_rect.w = static_cast<Uint16>(size_.x);
-	dst_rect.h = static_cast<Uint16>(size_.y);
-	BlindBlit(surface_, _dest->surface_, &dst_rect);	
+	_dest->Modify();
+	SurfaceBlit::Copy(surface_, _dest->surface_, _position.x, _position.y);
 }
 
 void BlittableRect::RawBlit(Vector2i _src_position, Vector2i _src_size, Vector2i _dest_position, BlittableRect* _dest)
 {
 	if(!surface_ || !_dest)
 		return;
-	SDL_Rect src_rect;
-	src_rect.x = static_cast<Sint16>(_src_position.x);
-	src_rect.y = static_cast<Sint16>(_src_position.y);
-	src_rect.w = static_cast<Uint16>(_src_size.x);
-	src_rect.h = static_cast<Uint16>(_src_size.y);
-	
-
-	BlindBlit(surface_, &src_rect, _dest->surface_, _dest_position);
+	_dest->Modify();
+	SurfaceBlit::Copy(surface_, _src_position.x, _src_position.y, _src_size.x, _src_size.y,
+					  _dest->surface_, _dest_position.x, _dest_position.y);
 }
 
 void BlittableRect::Fade(float _degree, unsigned char r, unsigned char g, unsigned char b)
@@ -293,16 +180,39 @@ void BlittableRect::Fade(float _degree, unsigned char r, unsigned char g, unsign
 	unsigned char a = static_cast<unsigned char>(255 * _degree);
 	SDL_FillRect(fade_surface, NULL, SDL_MapRGBA(fade_surface->format, r, g, b, a));
 	
+	Modify();
 	SDL_BlitSurface(fade_surface, NULL, surface_, NULL);
 	SDL_FreeSurface(fade_surface);
 }
 
 void BlittableRect::Fill(unsigned char a, unsigned char r, unsigned char g, unsigned char b)
 {
+	Modify();
 	SDL_FillRect(surface_, NULL, SDL_MapRGBA(surface_->format, r, g, b, a));
 }
 
-void BlittableRect::MeasureText(WidgetText _text, Vector2i& top_left, Vector2i& bottom_right)
+void BlittableRect::SetClip(Vector2i _position, Vector2i _size)
+{
+	if(!surface_)
+		return;
+	//The clip rect is part of the surface, so don't set it on one that's shared
+	if(shared_)
+		Modify();
+	SDL_Rect clip;
+	clip.x = static_cast<Sint16>(_position.x);
+	clip.y = static_cast<Sint16>(_position.y);
+	clip.w = static_cast<Uint16>(_size.x < 0 ? 0 : _size.x);
+	clip.h = static_cast<Uint16>(_size.y < 0 ? 0 : _size.y);
+	SDL_SetClipRect(surface_, &clip);
+}
+
+void BlittableRect::ClearClip()
+{
+	if(surface_)
+		SDL_SetClipRect(surface_, NULL);
+}
+
+void BlittableRect::MeasureText(const WidgetText& _text, Vector2i& top_left, Vector2i& bottom_right)
 {
 	int font_width;
 	int font_height;
@@ -323,8 +233,8 @@ void BlittableRect::MeasureText(WidgetText _text, Vector2i& top_left, Vector2i&
 	int out_y = 0;
 //Find longest line for right aligned
 	int longest_line = 0;
-	std::vector<std::string> text_lines = _text.GetTextLines();
-	for(std::vector<std::string>::iterator it = text_lines.begin(); it != text_lines.end(); ++it)
+	const std::vector<std::string>& text_lines = _text.GetTextLines();
+	for(std::vector<std::string>::const_iterator it = text_lines.begin(); it != text_lines.end(); ++it)
 	{
 		if((int)it->length() > longest_line)
 			longest_line = (int)it->length();
@@ -377,7 +287,7 @@ void BlittableRect::MeasureText(WidgetText _text, Vector2i& top_left, Vector2i&
 	bottom_right.y = top_left.y + static_cast<int>(text_lines.size());
 }
 
-void BlittableRect::BlitText(WidgetText _text)
+void BlittableRect::BlitText(const WidgetText& _text)
 {
 	int font_width;
 	int font_height;
@@ -417,8 +327,8 @@ void BlittableRect::BlitText(WidgetText _text)
 	int init_out_x = 0;
 	int init_out_y = 0;
 	int longest_line = 0;
-	std::vector<std::string> text_lines = _text.GetTextLines();
-	for(std::vector<std::string>::iterator it = text_lines.begin(); it != text_lines.end(); ++it)
+	const std::vector<std::string>& text_lines = _text.GetTextLines();
+	for(std::vector<std::string>::const_iterator it = text_lines.begin(); it != text_lines.end(); ++it)
 	{
 		if((int)it->length() > longest_line)
 			longest_line = (int)it->length();
@@ -465,8 +375,9 @@ void BlittableRect::BlitText(WidgetText _text)
 	}
 	int out_x = init_out_x;
 	int out_y = init_out_y;
+	Modify();
 	
-	for(std::vector<std::string>::iterator it = text_lines.begin(); it != text_lines.end(); ++it)
+	for(std::vector<std::string>::const_iterator it = text_lines.begin(); it != text_lines.end(); ++it)
 	{
 		if(_text.GetAlignment() == TextAlignment::Top ||
 		   _text.GetAlignment() == TextAlignment::Centre ||
@@ -518,9 +429,35 @@ void BlittableRect::BlitText(WidgetText _text)
 }
 
 BlittableRect* BlittableRect::Resize(Vector2i _new_size)
+{
+	return Resize(_new_size, ScaleFilter::Nearest);
+}
+
+BlittableRect* BlittableRect::Resize(Vector2i _new_size, ScaleFilter::Enum _filter)
 {
 	BlittableRect* sample = new BlittableRect(_new_size);
-	SampleSurface(surface_, sample->surface_);
+	if(!surface_)
+	{
+		Logger::ErrorOut() << "Source is NULL in Resize\n";
+		return sample;
+	}
+	if(source_key_.length() > 0)
+	{
+		SDL_Surface* cached = ScaledImageCache::Instance().Find(source_key_, _new_size, _filter);
+		if(cached)
+		{
+			SurfaceBlit::Copy(cached, sample->surface_, 0, 0);
+			return sample;
+		}
+	}
+
+	ImageScaler::Scale(surface_, sample->surface_, _filter);
+
+	if(source_key_.length() > 0)
+	{
+		SDL_Surface* copy = SDL_ConvertSurface(sample->surface_, sample->surface_->format, sample->surface_->flags);
+		ScaledImageCache::Instance().Insert(source_key_, _new_size, _filter, copy);
+	}
 	return sample;
 }
 
@@ -531,5 +468,69 @@ void BlittableRect::Save(std::string _filename)
 
 void BlittableRect::SetAlpha(unsigned char a)
 {
+	Modify();
 	SDL_SetAlpha(surface_, 0, a);
-}
\ No newline at end of file
+}
+
+void BlittableRect::Modify()
+{
+	source_key_.clear();
+	if(!shared_)
+		return;
+	SDL_Surface* copy = SDL_ConvertSurface(surface_, surface_->format, surface_->flags);
+	if(!copy)
+	{
+		Logger::ErrorOut() << "Unable to copy shared image before modifying it\n";
+		return;
+	}
+	ImageCache::Instance().Release(surface_);
+	surface_ = copy;
+	shared_ = false;
+	Account();
+}
+
+void BlittableRect::ShareAs(const std::string& _key)
+{
+	if(shared_ || error_occurred_ || dont_free_)
+		return;
+	if(ImageCache::Instance().Adopt(_key, surface_))
+	{
+		Unaccount();
+		shared_ = true;
+		source_key_ = _key;
+	}
+}
+
+BlittableRect* BlittableRect::FromImageCache(const std::string& _key)
+{
+	SDL_Surface* surface = ImageCache::Instance().Find(_key);
+	if(!surface)
+		return NULL;
+	return new BlittableRect(surface, _key);
+}
+
+void BlittableRect::Account()
+{
+	Unaccount();
+	budget_bytes_ = SurfaceBudget::SurfaceBytes(surface_);
+	SurfaceBudget::Instance().Add(category_, budget_bytes_);
+}
+
+void BlittableRect::Unaccount()
+{
+	if(budget_bytes_ == 0)
+		return;
+	SurfaceBudget::Instance().Remove(category_, budget_bytes_);
+	budget_bytes_ = 0;
+}
+
+void BlittableRect::SetCategory(SurfaceCategory::Enum _category)
+{
+	if(_category == category_)
+		return;
+	bool accounted = budget_bytes_ > 0;
+	Unaccount();
+	category_ = _category;
+	if(accounted)
+		Account();
+}
@@ -3,6 +3,9 @@
 #include <vector>
 #include <string>
 #include "WidgetText.h"
+#include "ImageScaler.h"
+#include "SurfaceBlit.h"
+#include "SurfaceBudget.h"
 
 struct SDL_Surface;
 
@@ -11,13 +14,33 @@ class BlittableRect
 private:
 	static unsigned int surface_flags_;
 	static int depth_;
-	static unsigned int bytes_used;
 	Vector2i size_;
 	SDL_Surface* surface_;
 	bool error_occurred_;
 	bool dont_free_;
+	bool shared_; //surface_ belongs to ImageCache and must be copied before it is changed
+	std::string source_key_; //Identifies unmodified image content for ScaledImageCache, empty if none
+	SurfaceCategory::Enum category_;
+	unsigned int budget_bytes_; //Bytes of surface_ counted against SurfaceBudget, 0 unless the rect owns it
+
+	/* Counts an owned surface_ against SurfaceBudget, or stops counting it */
+	void Account();
+	void Unaccount();
+
+	/* Called before the pixels change. Takes a private copy of a shared surface and forgets the source key */
+	void Modify();
+	BlittableRect(SDL_Surface* _shared_surface, const std::string& _key);
 
 public:
+	/* Keeps the rect's surface locked for a run of RawBlits to or from it */
+	class ScopedLock
+	{
+	private:
+		SurfaceLock lock_;
+	public:
+		explicit ScopedLock(BlittableRect* _rect) : lock_(_rect->surface_){}
+	};
+
 	BlittableRect(SDL_Surface* _surface, bool _dont_free_surface);
 	BlittableRect(Vector2i _size);
 	BlittableRect(std::string _filename);
@@ -30,15 +53,31 @@ public:
 	void RawBlit(Vector2i _src_position, Vector2i _size, Vector2i _position, BlittableRect* _dest);
 	void Fade(float _degree, unsigned char r, unsigned char g, unsigned char b);
 	void SetAlpha(unsigned char a);
-	void MeasureText(WidgetText _text, Vector2i& top_left, Vector2i& bottom_right);
-	void BlitText(WidgetText _text);
+	void MeasureText(const WidgetText& _text, Vector2i& top_left, Vector2i& bottom_right);
+	void BlitText(const WidgetText& _text);
 	void Fill(unsigned char a, unsigned char r, unsigned char g, unsigned char b);
 	void Save(std::string _filename);
+	/* Restricts everything drawn into this rect, raw blits included, to an area until ClearClip */
+	void SetClip(Vector2i _position, Vector2i _size);
+	void ClearClip();
 	
 	bool GetError(){return error_occurred_;}
+	bool IsShared(){return shared_;}
+	/* What the rect's own surface is counted as in SurfaceBudget, Rect by default */
+	void SetCategory(SurfaceCategory::Enum _category);
+	SurfaceCategory::Enum GetCategory(){return category_;}
 	
 	Vector2i GetSize(){return size_;}
 	BlittableRect* Resize(Vector2i _new_size);
+	BlittableRect* Resize(Vector2i _new_size, ScaleFilter::Enum _filter);
+
+	/* Moves this rect's surface into ImageCache under _key so that later FromImageCache calls share it */
+	void ShareAs(const std::string& _key);
+	/* A new rect sharing the image cached under _key, or NULL if there isn't one. Never loads from disk */
+	static BlittableRect* FromImageCache(const std::string& _key);
+
+	std::string GetSourceKey(){return source_key_;}
+	void SetSourceKey(std::string _key){source_key_ = _key;}
 
 	static void SetSurfaceFlags(unsigned int flags);
 };
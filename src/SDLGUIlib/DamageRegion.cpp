@@ -0,0 +1,98 @@
+#include "DamageRegion.h"
+#include <algorithm>
+
+bool DamageRect::Contains(const DamageRect& _rect) const
+{
+	if(_rect.IsEmpty())
+		return true;
+	return _rect.position.x >= position.x && _rect.position.y >= position.y &&
+		   _rect.position.x + _rect.size.x <= position.x + size.x &&
+		   _rect.position.y + _rect.size.y <= position.y + size.y;
+}
+
+bool DamageRect::Intersects(const DamageRect& _rect) const
+{
+	return !Intersection(_rect).IsEmpty();
+}
+
+DamageRect DamageRect::Intersection(const DamageRect& _rect) const
+{
+	int left = std::max(position.x, _rect.position.x);
+	int top = std::max(position.y, _rect.position.y);
+	int right = std::min(position.x + size.x, _rect.position.x + _rect.size.x);
+	int bottom = std::min(position.y + size.y, _rect.position.y + _rect.size.y);
+	if(right <= left || bottom <= top)
+		return DamageRect();
+	return DamageRect(Vector2i(left, top), Vector2i(right - left, bottom - top));
+}
+
+DamageRect DamageRect::Bounds(const DamageRect& _rect) const
+{
+	if(IsEmpty())
+		return _rect;
+	if(_rect.IsEmpty())
+		return *this;
+	int left = std::min(position.x, _rect.position.x);
+	int top = std::min(position.y, _rect.position.y);
+	int right = std::max(position.x + size.x, _rect.position.x + _rect.size.x);
+	int bottom = std::max(position.y + size.y, _rect.position.y + _rect.size.y);
+	return DamageRect(Vector2i(left, top), Vector2i(right - left, bottom - top));
+}
+
+void DamageRegion::Add(const DamageRect& _rect)
+{
+	if(_rect.IsEmpty())
+		return;
+	DamageRect rect = _rect;
+	for(std::vector<DamageRect>::iterator it = rects_.begin(); it != rects_.end(); ++it)
+	{
+		if(it->Contains(rect))
+			return;
+	}
+
+	//Absorb anything the new rect covers, or that it can be merged with for free
+	bool merged = true;
+	while(merged)
+	{
+		merged = false;
+		for(std::vector<DamageRect>::iterator it = rects_.begin(); it != rects_.end(); ++it)
+		{
+			DamageRect bounds = rect.Bounds(*it);
+			if(bounds.GetArea() <= rect.GetArea() + it->GetArea() - rect.Intersection(*it).GetArea())
+			{
+				rect = bounds;
+				rects_.erase(it);
+				merged = true;
+				break;
+			}
+		}
+	}
+	rects_.push_back(rect);
+
+	if(rects_.size() > max_rects)
+	{
+		DamageRect bounds = GetBounds();
+		rects_.clear();
+		rects_.push_back(bounds);
+	}
+}
+
+int DamageRegion::GetArea() const
+{
+	int area = 0;
+	for(std::vector<DamageRect>::const_iterator it = rects_.begin(); it != rects_.end(); ++it)
+	{
+		area += it->GetArea();
+	}
+	return area;
+}
+
+DamageRect DamageRegion::GetBounds() const
+{
+	DamageRect bounds;
+	for(std::vector<DamageRect>::const_iterator it = rects_.begin(); it != rects_.end(); ++it)
+	{
+		bounds = bounds.Bounds(*it);
+	}
+	return bounds;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "vmath.h"
+#include <vector>
+
+/* An axis aligned area, in the coordinates of whichever widget holds it */
+struct DamageRect
+{
+	Vector2i position;
+	Vector2i size;
+
+	DamageRect() : position(0, 0), size(0, 0){}
+	DamageRect(Vector2i _position, Vector2i _size) : position(_position), size(_size){}
+
+	bool IsEmpty() const {return size.x <= 0 || size.y <= 0;}
+	int GetArea() const {return IsEmpty() ? 0 : size.x * size.y;}
+	bool Contains(const DamageRect& _rect) const;
+	bool Intersects(const DamageRect& _rect) const;
+	DamageRect Intersection(const DamageRect& _rect) const;
+	DamageRect Bounds(const DamageRect& _rect) const;
+};
+
+/* The parts of a widget that need recomposing.
+   Rects are merged whenever their bounding box costs no more than drawing them separately,
+   and the list collapses to one bounding box past max_rects so it stays cheap to walk */
+class DamageRegion
+{
+private:
+	std::vector<DamageRect> rects_;
+public:
+	static const unsigned int max_rects = 8;
+
+	void Add(const DamageRect& _rect);
+	void Clear(){rects_.clear();}
+	bool IsEmpty() const {return rects_.empty();}
+	const std::vector<DamageRect>& GetRects() const {return rects_;}
+	int GetArea() const;
+	DamageRect GetBounds() const;
+};
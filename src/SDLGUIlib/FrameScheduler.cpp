@@ -0,0 +1,224 @@
+#include "Logger.h"
+#include "FrameScheduler.h"
+#include "HighResClock.h"
+#include <SDL.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <mmsystem.h>
+#endif
+
+namespace
+{
+	const double initial_sleep_margin = 0.002;
+	const double min_sleep_margin = 0.0005;
+	const double max_sleep_margin = 0.004;
+}
+
+const double FrameHistogram::bin_width = 0.00025;
+
+FrameHistogram::FrameHistogram()
+: bins_(bin_count + 1, 0), count_(0), total_(0.0), worst_(0.0)
+{
+}
+
+void FrameHistogram::Add(double _seconds)
+{
+	int bin = static_cast<int>(_seconds / bin_width);
+	if(bin < 0)
+		bin = 0;
+	if(bin > bin_count)
+		bin = bin_count;
+	bins_[bin]++;
+	count_++;
+	total_ += _seconds;
+	if(_seconds > worst_)
+		worst_ = _seconds;
+}
+
+void FrameHistogram::Remove(double _seconds)
+{
+	int bin = static_cast<int>(_seconds / bin_width);
+	if(bin < 0)
+		bin = 0;
+	if(bin > bin_count)
+		bin = bin_count;
+	if(bins_[bin] == 0)
+		return;
+	bins_[bin]--;
+	count_--;
+	total_ -= _seconds;
+}
+
+void FrameHistogram::Clear()
+{
+	bins_.assign(bin_count + 1, 0);
+	count_ = 0;
+	total_ = 0.0;
+	worst_ = 0.0;
+}
+
+double FrameHistogram::Percentile(double _fraction) const
+{
+	if(count_ == 0)
+		return 0.0;
+	unsigned int needed = static_cast<unsigned int>(_fraction * count_ + 0.999999);
+	if(needed < 1)
+		needed = 1;
+	unsigned int seen = 0;
+	for(int bin = 0; bin < bin_count; bin++)
+	{
+		seen += bins_[bin];
+		if(seen >= needed)
+			return (bin + 1) * bin_width;
+	}
+	return worst_;
+}
+
+void FrameHistogram::Report(std::ostream& _out) const
+{
+	for(int bin = 0; bin <= bin_count; bin++)
+	{
+		if(bins_[bin] == 0)
+			continue;
+		if(bin < bin_count)
+			_out << bin * bin_width * 1000 << "-" << (bin + 1) * bin_width * 1000 << "ms: " << bins_[bin] << "\n";
+		else
+			_out << bin * bin_width * 1000 << "ms+: " << bins_[bin] << "\n";
+	}
+}
+
+FrameScheduler::FrameScheduler(unsigned int _cap)
+: cap_(0), period_(0.0), last_frame_time_(0.0), sleep_margin_(initial_sleep_margin),
+  recent_(recent_frames, 0.0), recent_missed_(recent_frames, false), recent_next_(0), total_missed_(0)
+{
+#ifdef _WIN32
+	//Without this, sleeps are rounded up to the 15.6ms scheduler tick
+	timeBeginPeriod(1);
+#endif
+	SetCap(_cap);
+	Reset();
+}
+
+FrameScheduler::~FrameScheduler()
+{
+#ifdef _WIN32
+	timeEndPeriod(1);
+#endif
+}
+
+void FrameScheduler::SetCap(unsigned int _cap)
+{
+	cap_ = _cap;
+	period_ = cap_ > 0 ? 1.0 / cap_ : 0.0;
+}
+
+void FrameScheduler::Reset()
+{
+	frame_start_ = HighResClock::Seconds();
+}
+
+void FrameScheduler::WaitUntil(double _deadline)
+{
+	double now = HighResClock::Seconds();
+	double sleep = _deadline - now - sleep_margin_;
+	if(sleep >= 0.001)
+	{
+		Uint32 sleep_ms = static_cast<Uint32>(sleep * 1000);
+		SDL_Delay(sleep_ms);
+		double woke = HighResClock::Seconds();
+		//Follows the overshoot quickly when it grows, slowly when it shrinks
+		double overshoot = (woke - now) - sleep_ms * 0.001;
+		if(overshoot > sleep_margin_)
+			sleep_margin_ = overshoot;
+		else
+			sleep_margin_ = sleep_margin_ * 0.95 + overshoot * 0.05;
+		if(sleep_margin_ < min_sleep_margin)
+			sleep_margin_ = min_sleep_margin;
+		if(sleep_margin_ > max_sleep_margin)
+			sleep_margin_ = max_sleep_margin;
+	}
+	while(HighResClock::Seconds() < _deadline)
+	{
+	}
+}
+
+void FrameScheduler::EndFrame()
+{
+	bool missed = false;
+	double now = HighResClock::Seconds();
+	if(period_ > 0.0)
+	{
+		double deadline = frame_start_ + period_;
+		if(now > deadline)
+			missed = true;
+		else
+		{
+			WaitUntil(deadline);
+			now = HighResClock::Seconds();
+		}
+	}
+	last_frame_time_ = now - frame_start_;
+	//A late frame starts the next one from now, rather than rushing the following frames to catch up
+	frame_start_ = now;
+	Record(last_frame_time_, missed);
+}
+
+void FrameScheduler::Record(double _frame_time, bool _missed)
+{
+	if(recent_histogram_.GetCount() == recent_frames)
+		recent_histogram_.Remove(recent_[recent_next_]);
+	recent_[recent_next_] = _frame_time;
+	recent_missed_[recent_next_] = _missed;
+	recent_next_ = (recent_next_ + 1) % recent_frames;
+	recent_histogram_.Add(_frame_time);
+	total_histogram_.Add(_frame_time);
+	if(_missed)
+		total_missed_++;
+}
+
+FrameStats FrameScheduler::GetRecentStats() const
+{
+	FrameStats stats;
+	stats.frames = recent_histogram_.GetCount();
+	stats.average = recent_histogram_.GetAverage();
+	stats.p95 = recent_histogram_.Percentile(0.95);
+	stats.p99 = recent_histogram_.Percentile(0.99);
+	//The window may not be full yet, its oldest slots are the ones before recent_next_
+	for(unsigned int i = 0; i < stats.frames; i++)
+	{
+		unsigned int slot = (recent_next_ + recent_frames - 1 - i) % recent_frames;
+		if(recent_[slot] > stats.worst)
+			stats.worst = recent_[slot];
+		if(recent_missed_[slot])
+			stats.missed++;
+	}
+	return stats;
+}
+
+FrameStats FrameScheduler::GetTotalStats() const
+{
+	FrameStats stats;
+	stats.frames = total_histogram_.GetCount();
+	stats.missed = total_missed_;
+	stats.average = total_histogram_.GetAverage();
+	stats.p95 = total_histogram_.Percentile(0.95);
+	stats.p99 = total_histogram_.Percentile(0.99);
+	stats.worst = total_histogram_.GetWorst();
+	return stats;
+}
+
+void FrameScheduler::Report(std::ostream& _out) const
+{
+	FrameStats stats = GetTotalStats();
+	_out << "Frames: " << stats.frames << " cap: ";
+	if(cap_ > 0)
+		_out << cap_ << "fps";
+	else
+		_out << "none";
+	_out << " missed deadlines: " << stats.missed << "\n";
+	_out << "Frame time average: " << stats.average * 1000 << "ms p95: " << stats.p95 * 1000 <<
+		"ms p99: " << stats.p99 * 1000 << "ms worst: " << stats.worst * 1000 << "ms\n";
+	total_histogram_.Report(_out);
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <vector>
+#include <ostream>
+
+/* Frame times of one frame or many, in seconds */
+struct FrameStats
+{
+	unsigned int frames;
+	unsigned int missed;	//Frames that ran past their deadline
+	double average;
+	double p95;
+	double p99;
+	double worst;
+
+	FrameStats() : frames(0), missed(0), average(0.0), p95(0.0), p99(0.0), worst(0.0){}
+};
+
+/* Counts frame times in quarter millisecond bins up to 100ms, anything longer in one last bin.
+   Percentiles are the upper edge of the bin they fall in */
+class FrameHistogram
+{
+private:
+	std::vector<unsigned int> bins_;
+	unsigned int count_;
+	double total_;
+	double worst_;
+
+public:
+	static const int bin_count = 400;
+	static const double bin_width;
+
+	FrameHistogram();
+	void Add(double _seconds);
+	/* Takes back a time added earlier. The worst time is left as it was */
+	void Remove(double _seconds);
+	void Clear();
+
+	unsigned int GetCount() const {return count_;}
+	double GetAverage() const {return count_ > 0 ? total_ / count_ : 0.0;}
+	double GetWorst() const {return worst_;}
+	/* Time _fraction of frames took no longer than, e.g. 0.95 for the 95th percentile */
+	double Percentile(double _fraction) const;
+	/* One line per bin with frames in it */
+	void Report(std::ostream& _out) const;
+};
+
+/* Paces the main loop to a frame cap. EndFrame sleeps for most of the time left and spins
+   for the rest, as sleeps can overshoot by a millisecond or more; how far they overshoot is
+   learnt as the game runs. Frame times are kept for the last recent_frames and the whole run */
+class FrameScheduler
+{
+private:
+	unsigned int cap_;
+	double period_;
+	double frame_start_;
+	double last_frame_time_;
+	double sleep_margin_;	//Time left spinning instead of sleeping
+
+	std::vector<double> recent_;		//Ring of the last frame times
+	std::vector<bool> recent_missed_;
+	unsigned int recent_next_;
+	FrameHistogram recent_histogram_;
+	FrameHistogram total_histogram_;
+	unsigned int total_missed_;
+
+	void WaitUntil(double _deadline);
+	void Record(double _frame_time, bool _missed);
+
+public:
+	static const unsigned int recent_frames = 300;
+
+	/* _cap is in frames per second, 0 for no cap */
+	explicit FrameScheduler(unsigned int _cap);
+	~FrameScheduler();
+
+	void SetCap(unsigned int _cap);
+	unsigned int GetCap() const {return cap_;}
+	/* Seconds each frame is given, 0 without a cap */
+	double GetPeriod() const {return period_;}
+
+	/* Starts timing the next frame from now, e.g. after a long load */
+	void Reset();
+	/* Waits until the frame's time is up then starts the next. Call once per frame after drawing */
+	void EndFrame();
+
+	/* Time between the last two EndFrames, waiting included */
+	double GetLastFrameTime() const {return last_frame_time_;}
+	FrameStats GetRecentStats() const;
+	FrameStats GetTotalStats() const;
+	/* Totals and the histogram of every frame */
+	void Report(std::ostream& _out) const;
+};
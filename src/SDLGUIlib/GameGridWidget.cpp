@@ -7,13 +7,9 @@ GameGridWidget::GameGridWidget(Vector2i _grid_size, Vector2i _item_size)
 	item_size_ = _item_size;
 	rejects_focus_ = true;
 	size_ = _grid_size * _item_size;
-	delete blit_rect_;
-	delete back_rect_;
-	blit_rect_ = new BlittableRect(size_);
-	back_rect_ = new BlittableRect(size_);
+	UpdateHitArea();
 	offset_ = Vector2i(0, 0);
-
-	back_rect_->Fill(0,0,0,0); //Clear the image and make transparent
+	transparent_ = true; //Only what OnDraw adds shows, so there are no pixels of its own to keep
 
 	OnKeyUp.connect(boost::bind(&GameGridWidget::GridKeyUp, this, _1, _2));
 	OnMouseClick.connect(boost::bind(&GameGridWidget::GridMouseClick, this, _1, _2));			
@@ -45,8 +45,8 @@ public:
 	virtual ~GameGridWidget(void);
 
 	/* Typedefs */
-	typedef boost::signal<void (Widget*, GridKeyPressEventArgs)> GridKeyEvent;
-	typedef boost::signal<void (Widget*, GridGestureEventArgs)> GridGestureEvent;
+	typedef Signal<void (Widget*, GridKeyPressEventArgs)> GridKeyEvent;
+	typedef Signal<void (Widget*, GridGestureEventArgs)> GridGestureEvent;
 
 	/* Properties */
 	Vector2i GetGridSize(){return grid_size_;}
@@ -0,0 +1,29 @@
+#include "HighResClock.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+double HighResClock::Seconds()
+{
+	static double period = 0.0;
+	if(period == 0.0)
+	{
+		LARGE_INTEGER frequency;
+		QueryPerformanceFrequency(&frequency);
+		period = 1.0 / static_cast<double>(frequency.QuadPart);
+	}
+	LARGE_INTEGER count;
+	QueryPerformanceCounter(&count);
+	return static_cast<double>(count.QuadPart) * period;
+}
+#else
+#include <time.h>
+
+double HighResClock::Seconds()
+{
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return static_cast<double>(now.tv_sec) + static_cast<double>(now.tv_nsec) * 1e-9;
+}
+#endif
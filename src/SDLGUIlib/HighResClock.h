@@ -0,0 +1,10 @@
+#pragma once
+
+/* Monotonic clock with better than millisecond resolution, for timing frames and benchmarks.
+   It never jumps when the system time is changed */
+class HighResClock
+{
+public:
+	/* Seconds since an arbitrary fixed point, only meaningful as a difference */
+	static double Seconds();
+};
@@ -0,0 +1,288 @@
+#include "Logger.h"
+#include "ImageCache.h"
+#include "JobSystem.h"
+#include "AssetBundle.h"
+#include "Trace.h"
+#include <SDL.h>
+#include <SDL_image.h>
+
+namespace
+{
+	/* Whether _surface is already what SDL_DisplayFormatAlpha would make of it */
+	bool IsDisplayFormatAlpha(SDL_Surface* _surface)
+	{
+		SDL_Surface* probe = SDL_CreateRGBSurface(SDL_SWSURFACE, 1, 1, 32, 0xff, 0xff00, 0xff0000, 0xff000000);
+		SDL_Surface* display = probe ? SDL_DisplayFormatAlpha(probe) : NULL;
+		bool matches = display &&
+					   display->format->BitsPerPixel == _surface->format->BitsPerPixel &&
+					   display->format->Rmask == _surface->format->Rmask &&
+					   display->format->Gmask == _surface->format->Gmask &&
+					   display->format->Bmask == _surface->format->Bmask &&
+					   display->format->Amask == _surface->format->Amask;
+		SDL_FreeSurface(display);
+		SDL_FreeSurface(probe);
+		return matches;
+	}
+
+	/* IMG_Load on a worker, the display format conversion waits for Complete */
+	class DecodeImageJob : public Job
+	{
+	private:
+		std::string path_;
+		SDL_Surface* loaded_;
+	public:
+		explicit DecodeImageJob(const std::string& _path) : path_(_path), loaded_(NULL){}
+		~DecodeImageJob()
+		{
+			if(loaded_)
+				SDL_FreeSurface(loaded_);
+		}
+		void Run()
+		{
+			TraceScope trace("DecodeImageJob::Run", path_.c_str());
+			loaded_ = IMG_Load(path_.c_str());
+		}
+		void Complete()
+		{
+			TraceScope trace("DecodeImageJob::Complete", path_.c_str());
+			if(!loaded_)
+			{
+				Logger::ErrorOut() << "Unable to preload image " << path_ << "\n";
+				return;
+			}
+			ImageCache::Instance().AddDecoded(path_, loaded_);
+			loaded_ = NULL;
+		}
+	};
+}
+
+ImageCache::ImageCache()
+: hits_(0), misses_(0)
+{
+	//Constructed first, so the budget is still there when the cache is destroyed
+	SurfaceBudget::Instance().Register(this);
+}
+
+ImageCache::~ImageCache()
+{
+	SurfaceBudget::Instance().Unregister(this);
+	//Anything still referenced belongs to a BlittableRect that outlived the cache
+	for(CacheMap::iterator it = cache_.begin(); it != cache_.end(); ++it)
+	{
+		if(it->second.references == 0)
+		{
+			SurfaceBudget::Instance().Remove(SurfaceCategory::Image, SurfaceBudget::SurfaceBytes(it->second.surface));
+			SDL_FreeSurface(it->second.surface);
+		}
+	}
+	cache_.clear();
+	paths_.clear();
+}
+
+ImageCache& ImageCache::Instance()
+{
+	static ImageCache instance;
+	return instance;
+}
+
+ImageCache::CacheMap::iterator ImageCache::Load(const std::string& _path)
+{
+	CacheMap::iterator it = cache_.find(_path);
+	if(it != cache_.end())
+	{
+		hits_++;
+		it->second.last_used = SurfaceBudget::Instance().Touch();
+		return it;
+	}
+	misses_++;
+
+	//Bundled images were converted when the bundle was made, so usually they're used in place
+	SDL_Surface* mapped = AssetBundle::Instance().CreateSurface(_path);
+	if(mapped)
+		return Insert(_path, mapped, !IsDisplayFormatAlpha(mapped));
+
+	TraceScope trace("ImageCache::Load", _path.c_str());
+	SDL_Surface* loaded = IMG_Load(_path.c_str());
+	if(!loaded)
+		return cache_.end();
+	return Insert(_path, loaded, true);
+}
+
+ImageCache::CacheMap::iterator ImageCache::Insert(const std::string& _path, SDL_Surface* _loaded, bool _convert)
+{
+	SDL_Surface* converted = _loaded;
+	if(_convert)
+	{
+		converted = SDL_DisplayFormatAlpha(_loaded);
+		SDL_FreeSurface(_loaded);
+	}
+	if(!converted)
+	{
+		Logger::ErrorOut() << "Unable to convert image " << _path << " to display format\n";
+		return cache_.end();
+	}
+
+	Entry entry;
+	entry.surface = converted;
+	entry.references = 0;
+	entry.last_used = SurfaceBudget::Instance().Touch();
+	SurfaceBudget::Instance().Add(SurfaceCategory::Image, SurfaceBudget::SurfaceBytes(converted));
+	paths_[converted] = _path;
+	return cache_.insert(CacheMap::value_type(_path, entry)).first;
+}
+
+void ImageCache::FreeEntry(CacheMap::iterator _it)
+{
+	paths_.erase(_it->second.surface);
+	SurfaceBudget::Instance().Remove(SurfaceCategory::Image, SurfaceBudget::SurfaceBytes(_it->second.surface));
+	SDL_FreeSurface(_it->second.surface);
+	cache_.erase(_it);
+}
+
+SDL_Surface* ImageCache::Acquire(const std::string& _path)
+{
+	CacheMap::iterator it = Load(_path);
+	if(it == cache_.end())
+		return NULL;
+	it->second.references++;
+	return it->second.surface;
+}
+
+SDL_Surface* ImageCache::Find(const std::string& _key)
+{
+	CacheMap::iterator it = cache_.find(_key);
+	if(it == cache_.end())
+	{
+		misses_++;
+		return NULL;
+	}
+	hits_++;
+	it->second.references++;
+	it->second.last_used = SurfaceBudget::Instance().Touch();
+	return it->second.surface;
+}
+
+bool ImageCache::Adopt(const std::string& _key, SDL_Surface* _surface)
+{
+	if(!_surface || cache_.find(_key) != cache_.end())
+		return false;
+	Entry entry;
+	entry.surface = _surface;
+	entry.references = 1;
+	entry.last_used = SurfaceBudget::Instance().Touch();
+	SurfaceBudget::Instance().Add(SurfaceCategory::Image, SurfaceBudget::SurfaceBytes(_surface));
+	paths_[_surface] = _key;
+	cache_.insert(CacheMap::value_type(_key, entry));
+	return true;
+}
+
+void ImageCache::Release(SDL_Surface* _surface)
+{
+	SurfaceMap::iterator path = paths_.find(_surface);
+	if(path == paths_.end())
+	{
+		Logger::ErrorOut() << "Releasing an image that isn't in the image cache\n";
+		return;
+	}
+	CacheMap::iterator it = cache_.find(path->second);
+	if(it->second.references > 0)
+		it->second.references--;
+}
+
+bool ImageCache::IsCached(SDL_Surface* _surface)
+{
+	return paths_.find(_surface) != paths_.end();
+}
+
+bool ImageCache::Preload(const std::string& _path)
+{
+	CacheMap::iterator it = Load(_path);
+	if(it == cache_.end())
+	{
+		Logger::ErrorOut() << "Unable to preload image " << _path << "\n";
+		return false;
+	}
+	return true;
+}
+
+void ImageCache::Preload(const std::string& _path, JobSystem& _jobs)
+{
+	if(cache_.find(_path) != cache_.end())
+		return;
+	//Nothing to decode
+	if(AssetBundle::Instance().Find(_path))
+	{
+		Preload(_path);
+		return;
+	}
+	_jobs.Submit(new DecodeImageJob(_path));
+}
+
+bool ImageCache::AddDecoded(const std::string& _path, SDL_Surface* _loaded)
+{
+	if(!_loaded)
+		return false;
+	//Acquired synchronously while the job was running
+	if(cache_.find(_path) != cache_.end())
+	{
+		SDL_FreeSurface(_loaded);
+		return true;
+	}
+	return Insert(_path, _loaded, true) != cache_.end();
+}
+
+void ImageCache::Purge()
+{
+	CacheMap::iterator it = cache_.begin();
+	while(it != cache_.end())
+	{
+		CacheMap::iterator next = it;
+		++next;
+		if(it->second.references == 0)
+			FreeEntry(it);
+		it = next;
+	}
+}
+
+void ImageCache::Purge(const std::string& _path)
+{
+	CacheMap::iterator it = cache_.find(_path);
+	if(it != cache_.end() && it->second.references == 0)
+		FreeEntry(it);
+}
+
+unsigned int ImageCache::GetBytes()
+{
+	unsigned int bytes = 0;
+	for(CacheMap::iterator it = cache_.begin(); it != cache_.end(); ++it)
+	{
+		bytes += it->second.surface->pitch * it->second.surface->h;
+	}
+	return bytes;
+}
+
+bool ImageCache::GetOldest(unsigned int& _last_used)
+{
+	bool found = false;
+	for(CacheMap::iterator it = cache_.begin(); it != cache_.end(); ++it)
+	{
+		if(it->second.references == 0 && (!found || it->second.last_used < _last_used))
+		{
+			_last_used = it->second.last_used;
+			found = true;
+		}
+	}
+	return found;
+}
+
+void ImageCache::EvictOldest()
+{
+	CacheMap::iterator oldest = cache_.end();
+	for(CacheMap::iterator it = cache_.begin(); it != cache_.end(); ++it)
+	{
+		if(it->second.references == 0 && (oldest == cache_.end() || it->second.last_used < oldest->second.last_used))
+			oldest = it;
+	}
+	if(oldest != cache_.end())
+		FreeEntry(oldest);
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <map>
+#include <string>
+#include "SurfaceBudget.h"
+
+struct SDL_Surface;
+class JobSystem;
+
+/* Process wide cache of decoded, display formatted images keyed by path.
+   Surfaces handed out are shared and must be treated as read only; BlittableRect copies
+   a shared surface before modifying it. Unreferenced images stay cached until purged or
+   evicted by SurfaceBudget, so rebuilding the same widgets doesn't go back to disk.
+   Images in the open AssetBundle are served from it, loose files are the fallback */
+class ImageCache : public SurfaceBudget::Evictable
+{
+private:
+	struct Entry
+	{
+		SDL_Surface* surface;
+		int references;
+		unsigned int last_used; //SurfaceBudget stamp of the last Acquire or Find
+	};
+	typedef std::map<std::string, Entry> CacheMap;
+	typedef std::map<SDL_Surface*, std::string> SurfaceMap;
+
+	ImageCache();
+	CacheMap cache_;
+	SurfaceMap paths_;
+	unsigned int hits_;
+	unsigned int misses_;
+
+	CacheMap::iterator Load(const std::string& _path);
+	/* Takes ownership of _loaded, converting it to display format unless told it already is */
+	CacheMap::iterator Insert(const std::string& _path, SDL_Surface* _loaded, bool _convert);
+	void FreeEntry(CacheMap::iterator _it);
+
+public:
+	static ImageCache& Instance();
+	~ImageCache();
+
+	/* Returns the decoded image and adds a reference, or NULL if it couldn't be loaded */
+	SDL_Surface* Acquire(const std::string& _path);
+	/* As Acquire, but never loads from disk. For images added with Adopt */
+	SDL_Surface* Find(const std::string& _key);
+	/* Hands a surface built at runtime to the cache under _key, with one reference held by the caller.
+	   Returns false, leaving the caller owning the surface, if _key is already cached */
+	bool Adopt(const std::string& _key, SDL_Surface* _surface);
+	/* Drops a reference taken by Acquire, Find or Adopt */
+	void Release(SDL_Surface* _surface);
+	bool IsCached(SDL_Surface* _surface);
+
+	/* Decodes ahead of time, so that later Acquires don't touch the disk */
+	bool Preload(const std::string& _path);
+	/* As Preload, but decodes on a worker and converts to display format when the job completes */
+	void Preload(const std::string& _path, JobSystem& _jobs);
+	/* Converts an image decoded elsewhere, e.g. on a worker thread, and caches it unreferenced.
+	   Takes ownership of _loaded. Returns false if it couldn't be converted; if _path was
+	   already cached the existing image is kept */
+	bool AddDecoded(const std::string& _path, SDL_Surface* _loaded);
+	/* Frees every image that is no longer referenced */
+	void Purge();
+	/* Frees one image if it is no longer referenced */
+	void Purge(const std::string& _path);
+
+	unsigned int GetHits(){return hits_;}
+	unsigned int GetMisses(){return misses_;}
+	unsigned int GetCount(){return static_cast<unsigned int>(cache_.size());}
+	unsigned int GetBytes();
+
+	/* SurfaceBudget::Evictable, the least recently used unreferenced image */
+	bool GetOldest(unsigned int& _last_used);
+	void EvictOldest();
+};
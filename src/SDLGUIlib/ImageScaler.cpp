@@ -0,0 +1,368 @@
+#include "Logger.h"
+#include "ImageScaler.h"
+#include "SurfaceBlit.h"
+#include <SDL.h>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <emmintrin.h>
+#define IMAGESCALER_SSE2
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define IMAGESCALER_SSE2
+#endif
+
+namespace
+{
+	/* For each target index, the first source index it samples */
+	void BuildNearestTable(int _src_length, int _dest_length, std::vector<int>& _table)
+	{
+		_table.resize(_dest_length);
+		for(int i = 0; i < _dest_length; i++)
+		{
+			_table[i] = static_cast<int>((static_cast<long long>(i) * _src_length) / _dest_length);
+		}
+	}
+
+	/* For each target index, the [start, end) span of source indices it covers. Always at least one wide */
+	void BuildSpanTable(int _src_length, int _dest_length, std::vector<int>& _start, std::vector<int>& _end)
+	{
+		_start.resize(_dest_length);
+		_end.resize(_dest_length);
+		for(int i = 0; i < _dest_length; i++)
+		{
+			int start = static_cast<int>((static_cast<long long>(i) * _src_length) / _dest_length);
+			int end = static_cast<int>((static_cast<long long>(i + 1) * _src_length) / _dest_length);
+			if(end <= start)
+				end = start + 1;
+			if(end > _src_length)
+				end = _src_length;
+			_start[i] = start;
+			_end[i] = end;
+		}
+	}
+
+	void ScaleNearest32(SDL_Surface* _src, SDL_Surface* _dest)
+	{
+		std::vector<int> rows;
+		std::vector<int> cols;
+		BuildNearestTable(_src->h, _dest->h, rows);
+		BuildNearestTable(_src->w, _dest->w, cols);
+
+		const int w = _dest->w;
+		for(int y = 0; y < _dest->h; y++)
+		{
+			Uint32* dest = reinterpret_cast<Uint32*>(static_cast<Uint8*>(_dest->pixels) + _dest->pitch * y);
+			if(y > 0 && rows[y] == rows[y - 1])
+			{ //Upscaling repeats rows, so copy the one just produced
+				memcpy(dest, static_cast<Uint8*>(_dest->pixels) + _dest->pitch * (y - 1), w * 4);
+				continue;
+			}
+			const Uint32* src = reinterpret_cast<const Uint32*>(static_cast<const Uint8*>(_src->pixels) + _src->pitch * rows[y]);
+			const int* col = &cols[0];
+			for(int x = 0; x < w; x++)
+				dest[x] = src[col[x]];
+		}
+	}
+
+	void ScaleNearestGeneric(SDL_Surface* _src, SDL_Surface* _dest)
+	{
+		const int bpp = _src->format->BytesPerPixel;
+		std::vector<int> rows;
+		std::vector<int> cols;
+		BuildNearestTable(_src->h, _dest->h, rows);
+		BuildNearestTable(_src->w, _dest->w, cols);
+		for(unsigned int i = 0; i < cols.size(); i++)
+			cols[i] *= bpp;
+
+		for(int y = 0; y < _dest->h; y++)
+		{
+			Uint8* dest = static_cast<Uint8*>(_dest->pixels) + _dest->pitch * y;
+			const Uint8* src = static_cast<const Uint8*>(_src->pixels) + _src->pitch * rows[y];
+			for(int x = 0; x < _dest->w; x++)
+			{
+				memcpy(dest, src + cols[x], bpp);
+				dest += bpp;
+			}
+		}
+	}
+
+	/* Averages each of the four bytes of the covered pixels independently, so is independent of channel order */
+	void ScaleBox32(SDL_Surface* _src, SDL_Surface* _dest)
+	{
+		std::vector<int> row_start, row_end;
+		std::vector<int> col_start, col_end;
+		BuildSpanTable(_src->h, _dest->h, row_start, row_end);
+		BuildSpanTable(_src->w, _dest->w, col_start, col_end);
+
+		for(int y = 0; y < _dest->h; y++)
+		{
+			Uint32* dest = reinterpret_cast<Uint32*>(static_cast<Uint8*>(_dest->pixels) + _dest->pitch * y);
+			for(int x = 0; x < _dest->w; x++)
+			{
+				Uint32 sum[4] = {0, 0, 0, 0};
+				for(int sy = row_start[y]; sy < row_end[y]; sy++)
+				{
+					const Uint32* src = reinterpret_cast<const Uint32*>(static_cast<const Uint8*>(_src->pixels) + _src->pitch * sy);
+					for(int sx = col_start[x]; sx < col_end[x]; sx++)
+					{
+						Uint32 p = src[sx];
+						sum[0] += p & 0xff;
+						sum[1] += (p >> 8) & 0xff;
+						sum[2] += (p >> 16) & 0xff;
+						sum[3] += p >> 24;
+					}
+				}
+				Uint32 count = (row_end[y] - row_start[y]) * (col_end[x] - col_start[x]);
+				Uint32 half = count / 2;
+				dest[x] = ((sum[0] + half) / count) |
+						  (((sum[1] + half) / count) << 8) |
+						  (((sum[2] + half) / count) << 16) |
+						  (((sum[3] + half) / count) << 24);
+			}
+		}
+	}
+
+#ifdef IMAGESCALER_SSE2
+	/* As ScaleBox32, but widens each pixel to four 32 bit lanes and accumulates two pixels per step */
+	void ScaleBox32SSE2(SDL_Surface* _src, SDL_Surface* _dest)
+	{
+		std::vector<int> row_start, row_end;
+		std::vector<int> col_start, col_end;
+		BuildSpanTable(_src->h, _dest->h, row_start, row_end);
+		BuildSpanTable(_src->w, _dest->w, col_start, col_end);
+
+		const __m128i zero = _mm_setzero_si128();
+		for(int y = 0; y < _dest->h; y++)
+		{
+			Uint32* dest = reinterpret_cast<Uint32*>(static_cast<Uint8*>(_dest->pixels) + _dest->pitch * y);
+			for(int x = 0; x < _dest->w; x++)
+			{
+				__m128i sum = zero;
+				const int x0 = col_start[x];
+				const int x1 = col_end[x];
+				for(int sy = row_start[y]; sy < row_end[y]; sy++)
+				{
+					const Uint32* src = reinterpret_cast<const Uint32*>(static_cast<const Uint8*>(_src->pixels) + _src->pitch * sy);
+					int sx = x0;
+					for(; sx + 2 <= x1; sx += 2)
+					{
+						__m128i two = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + sx)), zero);
+						sum = _mm_add_epi32(sum, _mm_unpacklo_epi16(two, zero));
+						sum = _mm_add_epi32(sum, _mm_unpackhi_epi16(two, zero));
+					}
+					if(sx < x1)
+					{
+						__m128i one = _mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(src[sx])), zero);
+						sum = _mm_add_epi32(sum, _mm_unpacklo_epi16(one, zero));
+					}
+				}
+				//Rounds as ScaleBox32 does. Up to 65536 pixels the float quotient is never
+				//within an ulp of the next whole number, so truncating it is exact
+				const Uint32 count = (row_end[y] - row_start[y]) * (x1 - x0);
+				sum = _mm_add_epi32(sum, _mm_set1_epi32(static_cast<int>(count / 2)));
+				__m128i avg;
+				if(count <= 65536)
+				{
+					avg = _mm_cvttps_epi32(_mm_div_ps(_mm_cvtepi32_ps(sum), _mm_set1_ps(static_cast<float>(count))));
+				} else
+				{
+					Uint32 lanes[4];
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), sum);
+					avg = _mm_setr_epi32(lanes[0] / count, lanes[1] / count, lanes[2] / count, lanes[3] / count);
+				}
+				avg = _mm_packs_epi32(avg, avg);
+				avg = _mm_packus_epi16(avg, avg);
+				dest[x] = static_cast<Uint32>(_mm_cvtsi128_si32(avg));
+			}
+		}
+	}
+
+	/* Set on first use, so it doesn't rely on SurfaceBlit's statics being initialised first */
+	bool& SimdEnabled()
+	{
+		static bool enabled = ImageScaler::HasSIMD();
+		return enabled;
+	}
+#endif
+}
+
+bool ImageScaler::HasSIMD()
+{
+	return SurfaceBlit::HasSIMD();
+}
+
+void ImageScaler::SetSIMD(bool _simd)
+{
+#ifdef IMAGESCALER_SSE2
+	SimdEnabled() = _simd && HasSIMD();
+#endif
+}
+
+bool ImageScaler::GetSIMD()
+{
+#ifdef IMAGESCALER_SSE2
+	return SimdEnabled();
+#else
+	return false;
+#endif
+}
+
+bool ImageScaler::Scale(SDL_Surface* _src, SDL_Surface* _dest, ScaleFilter::Enum _filter)
+{
+	if(_src == NULL || _dest == NULL)
+	{
+		Logger::ErrorOut() << "Source or dest is NULL in ImageScaler::Scale\n";
+		return false;
+	}
+	if(_src->format->BytesPerPixel != _dest->format->BytesPerPixel)
+	{
+		Logger::ErrorOut() << "Unable to scale image, source data and dest data have different bpp\n";
+		return false;
+	}
+	if(_src->w <= 0 || _src->h <= 0 || _dest->w <= 0 || _dest->h <= 0)
+		return true;
+
+	SurfaceLock src_lock(_src);
+	SurfaceLock dest_lock(_dest);
+
+	if(_src->format->BytesPerPixel != 4)
+	{
+		ScaleNearestGeneric(_src, _dest);
+	} else if(_filter == ScaleFilter::Box)
+	{
+#ifdef IMAGESCALER_SSE2
+		if(SimdEnabled())
+			ScaleBox32SSE2(_src, _dest);
+		else
+			ScaleBox32(_src, _dest);
+#else
+		ScaleBox32(_src, _dest);
+#endif
+	} else
+	{
+		ScaleNearest32(_src, _dest);
+	}
+	return true;
+}
+
+
+bool ScaledImageCache::Key::operator<(const Key& _other) const
+{
+	if(w != _other.w)
+		return w < _other.w;
+	if(h != _other.h)
+		return h < _other.h;
+	if(filter != _other.filter)
+		return filter < _other.filter;
+	return source < _other.source;
+}
+
+ScaledImageCache::ScaledImageCache()
+: capacity_(64), hits_(0), misses_(0)
+{
+	SurfaceBudget::Instance().Register(this);
+}
+
+ScaledImageCache::~ScaledImageCache()
+{
+	SurfaceBudget::Instance().Unregister(this);
+	Clear();
+}
+
+ScaledImageCache& ScaledImageCache::Instance()
+{
+	static ScaledImageCache instance;
+	return instance;
+}
+
+ScaledImageCache::Key ScaledImageCache::MakeKey(const std::string& _source, Vector2i _size, ScaleFilter::Enum _filter)
+{
+	Key key;
+	key.source = _source;
+	key.w = _size.x;
+	key.h = _size.y;
+	key.filter = _filter;
+	return key;
+}
+
+SDL_Surface* ScaledImageCache::Find(const std::string& _source, Vector2i _size, ScaleFilter::Enum _filter)
+{
+	CacheMap::iterator it = cache_.find(MakeKey(_source, _size, _filter));
+	if(it == cache_.end())
+	{
+		misses_++;
+		return NULL;
+	}
+	hits_++;
+	it->second.last_used = SurfaceBudget::Instance().Touch();
+	return it->second.surface;
+}
+
+void ScaledImageCache::Insert(const std::string& _source, Vector2i _size, ScaleFilter::Enum _filter, SDL_Surface* _surface)
+{
+	if(!_surface)
+		return;
+	if(capacity_ == 0)
+	{
+		SDL_FreeSurface(_surface);
+		return;
+	}
+	Key key = MakeKey(_source, _size, _filter);
+	CacheMap::iterator it = cache_.find(key);
+	if(it != cache_.end())
+		FreeEntry(it);
+	while(cache_.size() >= capacity_)
+		EvictOldest();
+
+	Entry entry;
+	entry.surface = _surface;
+	entry.last_used = SurfaceBudget::Instance().Touch();
+	SurfaceBudget::Instance().Add(SurfaceCategory::Scaled, SurfaceBudget::SurfaceBytes(_surface));
+	cache_[key] = entry;
+}
+
+void ScaledImageCache::FreeEntry(CacheMap::iterator _it)
+{
+	SurfaceBudget::Instance().Remove(SurfaceCategory::Scaled, SurfaceBudget::SurfaceBytes(_it->second.surface));
+	SDL_FreeSurface(_it->second.surface);
+	cache_.erase(_it);
+}
+
+bool ScaledImageCache::GetOldest(unsigned int& _last_used)
+{
+	if(cache_.empty())
+		return false;
+	_last_used = cache_.begin()->second.last_used;
+	for(CacheMap::iterator it = cache_.begin(); it != cache_.end(); ++it)
+	{
+		if(it->second.last_used < _last_used)
+			_last_used = it->second.last_used;
+	}
+	return true;
+}
+
+void ScaledImageCache::EvictOldest()
+{
+	CacheMap::iterator oldest = cache_.begin();
+	for(CacheMap::iterator it = cache_.begin(); it != cache_.end(); ++it)
+	{
+		if(it->second.last_used < oldest->second.last_used)
+			oldest = it;
+	}
+	if(oldest != cache_.end())
+		FreeEntry(oldest);
+}
+
+void ScaledImageCache::Clear()
+{
+	while(!cache_.empty())
+		FreeEntry(cache_.begin());
+}
+
+void ScaledImageCache::SetCapacity(unsigned int _entries)
+{
+	capacity_ = _entries;
+	while(cache_.size() > capacity_)
+		EvictOldest();
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include "vmath.h"
+#include <map>
+#include <string>
+#include "SurfaceBudget.h"
+
+struct SDL_Surface;
+
+namespace ScaleFilter
+{
+	enum Enum
+	{
+		Nearest, //Point sampling, fastest, fine for icons and upscaling
+		Box		 //Averages every source pixel under the target pixel, better thumbnails
+	};
+}
+
+/* Resamples one surface onto another of the same pixel format.
+   Row and column source indices are worked out once per call rather than per pixel,
+   and 32 bit surfaces are copied a whole pixel at a time */
+class ImageScaler
+{
+public:
+	static bool Scale(SDL_Surface* _src, SDL_Surface* _dest, ScaleFilter::Enum _filter);
+	static bool HasSIMD();
+	/* Box filters without SSE2 when false, for comparing the two. Has no effect where SSE2 isn't available */
+	static void SetSIMD(bool _simd);
+	static bool GetSIMD();
+};
+
+/* Keeps the results of recent resizes keyed by (source, target size, filter)
+   so that the same image resized to the same size is only sampled once.
+   Only sources with a key (typically the filename they were loaded from) can be cached.
+   Least recently used entries go first, whether over capacity or evicted by SurfaceBudget */
+class ScaledImageCache : public SurfaceBudget::Evictable
+{
+private:
+	struct Key
+	{
+		std::string source;
+		int w;
+		int h;
+		ScaleFilter::Enum filter;
+		bool operator<(const Key& _other) const;
+	};
+	struct Entry
+	{
+		SDL_Surface* surface;
+		unsigned int last_used;
+	};
+	typedef std::map<Key, Entry> CacheMap;
+
+	ScaledImageCache();
+	CacheMap cache_;
+	unsigned int capacity_;
+	unsigned int hits_;
+	unsigned int misses_;
+
+	void FreeEntry(CacheMap::iterator _it);
+	static Key MakeKey(const std::string& _source, Vector2i _size, ScaleFilter::Enum _filter);
+
+public:
+	static ScaledImageCache& Instance();
+	~ScaledImageCache();
+
+	SDL_Surface* Find(const std::string& _source, Vector2i _size, ScaleFilter::Enum _filter);
+	/* Takes ownership of _surface */
+	void Insert(const std::string& _source, Vector2i _size, ScaleFilter::Enum _filter, SDL_Surface* _surface);
+	void Clear();
+
+	void SetCapacity(unsigned int _entries);
+	unsigned int GetCapacity(){return capacity_;}
+	unsigned int GetCount(){return static_cast<unsigned int>(cache_.size());}
+	unsigned int GetHits(){return hits_;}
+	unsigned int GetMisses(){return misses_;}
+
+	/* SurfaceBudget::Evictable */
+	bool GetOldest(unsigned int& _last_used);
+	void EvictOldest();
+};
@@ -0,0 +1,77 @@
+#include "Logger.h"
+#include "InputQueue.h"
+#include "HighResClock.h"
+#include "Widget.h"
+
+void InputStats::Add(const InputStats& _frame)
+{
+	received += _frame.received;
+	dispatched += _frame.dispatched;
+	motion_coalesced += _frame.motion_coalesced;
+	if(_frame.max_latency > max_latency)
+		max_latency = _frame.max_latency;
+}
+
+InputQueue::InputQueue()
+: frames_(0), quit_(false)
+{
+}
+
+void InputQueue::Poll()
+{
+	SDL_Event event;
+	while(SDL_PollEvent(&event))
+	{
+		Push(event, HighResClock::Seconds());
+	}
+}
+
+void InputQueue::Push(const SDL_Event& _event, double _time)
+{
+	pending_stats_.received++;
+	if(_event.type == SDL_QUIT)
+		quit_ = true;
+
+	if(_event.type == SDL_MOUSEMOTION && !events_.empty() && events_.back().event.type == SDL_MOUSEMOTION)
+	{
+		//Keep the newest position and button state, but the relative motion of both
+		SDL_MouseMotionEvent& last = events_.back().event.motion;
+		Sint16 xrel = static_cast<Sint16>(last.xrel + _event.motion.xrel);
+		Sint16 yrel = static_cast<Sint16>(last.yrel + _event.motion.yrel);
+		last = _event.motion;
+		last.xrel = xrel;
+		last.yrel = yrel;
+		//The earlier timestamp is kept, it's how long the move has been waiting
+		pending_stats_.motion_coalesced++;
+		return;
+	}
+
+	TimedEvent timed;
+	timed.event = _event;
+	timed.time = _time;
+	events_.push_back(timed);
+}
+
+void InputQueue::Dispatch()
+{
+	double now = HighResClock::Seconds();
+	for(std::vector<TimedEvent>::iterator it = events_.begin(); it != events_.end(); ++it)
+	{
+		if(now - it->time > pending_stats_.max_latency)
+			pending_stats_.max_latency = now - it->time;
+		Widget::DistributeSDLEvents(&it->event);
+		pending_stats_.dispatched++;
+	}
+	events_.clear();
+
+	frame_stats_ = pending_stats_;
+	total_stats_.Add(frame_stats_);
+	pending_stats_ = InputStats();
+	frames_++;
+}
+
+void InputQueue::Clear()
+{
+	events_.clear();
+	pending_stats_ = InputStats();
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <vector>
+#include <sdl.h>
+
+/* Counters for one frame of input, or totals over many */
+struct InputStats
+{
+	unsigned int received;			//Events taken from SDL
+	unsigned int dispatched;		//Events handed to the widgets
+	unsigned int motion_coalesced;	//Mouse moves folded into a later one
+	double max_latency;				//Longest wait between receiving an event and dispatching it, in seconds
+
+	InputStats() : received(0), dispatched(0), motion_coalesced(0), max_latency(0.0){}
+	void Add(const InputStats& _frame);
+};
+
+/* Collects a frame's SDL events before they go to the widgets.
+   Mouse moves with nothing between them are merged into the latest, as only the final position
+   matters once per frame; buttons and keys keep their order and the position they happened at.
+   Dispatch cost is then bounded by the number of clicks and keypresses rather than the mouse poll rate */
+class InputQueue
+{
+public:
+	struct TimedEvent
+	{
+		SDL_Event event;
+		double time;	//HighResClock seconds when the event was received
+	};
+
+private:
+	std::vector<TimedEvent> events_;
+	InputStats pending_stats_;	//For the events queued since the last Dispatch
+	InputStats frame_stats_;
+	InputStats total_stats_;
+	unsigned int frames_;
+	bool quit_;
+
+public:
+	InputQueue();
+
+	/* Takes everything SDL has waiting */
+	void Poll();
+	/* Queues one event, merging it with the previous one if both are mouse moves */
+	void Push(const SDL_Event& _event, double _time);
+	/* Sends the queued events to Widget::DistributeSDLEvents in order and empties the queue */
+	void Dispatch();
+	void Clear();
+
+	/* True once an SDL_QUIT has been received */
+	bool QuitRequested(){return quit_;}
+	const std::vector<TimedEvent>& GetEvents(){return events_;}
+	/* Stats for the last frame dispatched */
+	const InputStats& GetFrameStats(){return frame_stats_;}
+	const InputStats& GetTotalStats(){return total_stats_;}
+	unsigned int GetFrames(){return frames_;}
+};
@@ -9,11 +9,9 @@ ItemBrowserWidget::ItemBrowserWidget(vector<std::string> _items, Vector2i _grid_
 	item_size_ = _item_size;
 	page_ = 0;
 	size_ = _grid_size * _item_size;
+	UpdateHitArea();
 	//SetRejectsFocus(true);
 	SetHidesHighlight(true);
-	delete blit_rect_;
-	delete back_rect_;
-	blit_rect_ = new BlittableRect(size_);
 	back_rect_ = new BlittableRect(size_);
 	back_rect_->Fill(255, 255, 255, 255); //Clear the image
 
@@ -70,12 +68,12 @@ void ItemBrowserWidget::PerformItemLayout()
 		BlittableRect* scaled = NULL;
 		if(blittable)
 		{ //Downsample to correct size
-			scaled = blittable->Resize(item_size_);
+			scaled = blittable->Resize(item_size_, ScaleFilter::Box);
 			delete blittable;
 		} else
 		{
 			blittable = new BlittableRect("ErrorLoading.png");
-			scaled = blittable->Resize(item_size_);
+			scaled = blittable->Resize(item_size_, ScaleFilter::Box);
 			delete blittable;
 		}
 		Widget* item_widget = new Widget(scaled);
@@ -26,9 +26,9 @@ protected:
 	Widget* last_clicked_;
 public:
 	/* Typedefs */
-	typedef boost::signal<void (Widget*, BlittableRect**, std::string)> ItemRenderEvent;
-	typedef boost::signal<void (Widget*, std::string)> ItemClickEvent;
-	typedef boost::signal<void (Widget*, int, int)> PageChangeEvent;
+	typedef Signal<void (Widget*, BlittableRect**, std::string)> ItemRenderEvent;
+	typedef Signal<void (Widget*, std::string)> ItemClickEvent;
+	typedef Signal<void (Widget*, int, int)> PageChangeEvent;
 
 	/* Constructors */
 	ItemBrowserWidget(vector<std::string> _items, Vector2i _grid_size, Vector2i _item_size);
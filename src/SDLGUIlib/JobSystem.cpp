@@ -0,0 +1,132 @@
+#include "Logger.h"
+#include "JobSystem.h"
+#include "HighResClock.h"
+#include <SDL.h>
+#include <SDL_thread.h>
+
+JobSystem::JobSystem(unsigned int _workers)
+: mutex_(SDL_CreateMutex()), queued_cond_(SDL_CreateCond()), done_cond_(SDL_CreateCond()),
+  running_(0), outstanding_(0), completed_(0), stopping_(false)
+{
+	for(unsigned int i = 0; i < _workers; i++)
+	{
+		SDL_Thread* worker = SDL_CreateThread(&JobSystem::WorkerMain, this);
+		if(!worker)
+		{
+			Logger::ErrorOut() << "Unable to start job worker " << (int)i << ", continuing with " << (int)workers_.size() << "\n";
+			break;
+		}
+		workers_.push_back(worker);
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	SDL_mutexP(mutex_);
+	stopping_ = true;
+	SDL_CondBroadcast(queued_cond_);
+	SDL_mutexV(mutex_);
+	for(std::vector<SDL_Thread*>::iterator it = workers_.begin(); it != workers_.end(); ++it)
+	{
+		SDL_WaitThread(*it, NULL);
+	}
+	for(std::deque<Job*>::iterator it = queued_.begin(); it != queued_.end(); ++it)
+	{
+		delete *it;
+	}
+	for(std::deque<Job*>::iterator it = done_.begin(); it != done_.end(); ++it)
+	{
+		delete *it;
+	}
+	SDL_DestroyCond(done_cond_);
+	SDL_DestroyCond(queued_cond_);
+	SDL_DestroyMutex(mutex_);
+}
+
+int JobSystem::WorkerMain(void* _jobs)
+{
+	static_cast<JobSystem*>(_jobs)->Work();
+	return 0;
+}
+
+void JobSystem::Work()
+{
+	SDL_mutexP(mutex_);
+	while(true)
+	{
+		while(queued_.empty() && !stopping_)
+			SDL_CondWait(queued_cond_, mutex_);
+		if(stopping_)
+			break;
+		Job* job = queued_.front();
+		queued_.pop_front();
+		running_++;
+		SDL_mutexV(mutex_);
+
+		job->Run();
+
+		SDL_mutexP(mutex_);
+		running_--;
+		done_.push_back(job);
+		SDL_CondBroadcast(done_cond_);
+	}
+	SDL_mutexV(mutex_);
+}
+
+void JobSystem::Submit(Job* _job)
+{
+	if(!_job)
+		return;
+	outstanding_++;
+	if(workers_.empty())
+	{
+		_job->Run();
+		done_.push_back(_job);
+		return;
+	}
+	SDL_mutexP(mutex_);
+	queued_.push_back(_job);
+	SDL_CondSignal(queued_cond_);
+	SDL_mutexV(mutex_);
+}
+
+unsigned int JobSystem::Pump(double _budget)
+{
+	double start = HighResClock::Seconds();
+	unsigned int count = 0;
+	while(true)
+	{
+		//Taken one at a time, so jobs finishing while others complete are picked up too
+		SDL_mutexP(mutex_);
+		Job* job = NULL;
+		if(!done_.empty())
+		{
+			job = done_.front();
+			done_.pop_front();
+		}
+		SDL_mutexV(mutex_);
+		if(!job)
+			break;
+
+		job->Complete();
+		delete job;
+		outstanding_--;
+		completed_++;
+		count++;
+		if(_budget > 0.0 && HighResClock::Seconds() - start >= _budget)
+			break;
+	}
+	return count;
+}
+
+void JobSystem::WaitAll()
+{
+	while(outstanding_ > 0)
+	{
+		SDL_mutexP(mutex_);
+		while(done_.empty())
+			SDL_CondWait(done_cond_, mutex_);
+		SDL_mutexV(mutex_);
+		Pump(0.0);
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <deque>
+#include <vector>
+
+struct SDL_Thread;
+struct SDL_mutex;
+struct SDL_cond;
+
+/* A piece of work split in two: Run happens on a worker thread and must not touch the screen
+   or the widgets, and may only log once the Logger's writer is running; Complete happens
+   afterwards on the thread that pumps the JobSystem and is where results are handed over,
+   e.g. converting a decoded image to display format */
+class Job
+{
+public:
+	virtual ~Job(){}
+	virtual void Run() = 0;
+	virtual void Complete(){}
+};
+
+/* Runs jobs on a fixed pool of worker threads. Jobs start in the order submitted, the owner
+   pumps finished ones back each frame so Complete never runs on a worker. With no workers
+   Submit runs the job there and then, and Complete waits for the next Pump as usual.
+   The JobSystem deletes each job after completing it */
+class JobSystem
+{
+private:
+	std::vector<SDL_Thread*> workers_;
+	SDL_mutex* mutex_;		//Guards everything below
+	SDL_cond* queued_cond_;	//Signalled when a job is queued or the workers should stop
+	SDL_cond* done_cond_;	//Signalled when a worker finishes a job
+	std::deque<Job*> queued_;
+	std::deque<Job*> done_;
+	unsigned int running_;
+	unsigned int outstanding_;	//Submitted but not yet completed
+	unsigned int completed_;
+	bool stopping_;
+
+	static int WorkerMain(void* _jobs);
+	void Work();
+
+	JobSystem(const JobSystem&);
+	JobSystem& operator=(const JobSystem&);
+
+public:
+	explicit JobSystem(unsigned int _workers);
+	/* Waits for running jobs, queued and finished ones are deleted without completing */
+	~JobSystem();
+
+	void Submit(Job* _job);
+	/* Completes finished jobs until none are left or _budget seconds have passed, 0 for no limit.
+	   Returns the number completed */
+	unsigned int Pump(double _budget);
+	/* Blocks until every job submitted has run, then completes them all */
+	void WaitAll();
+
+	unsigned int GetWorkerCount() const {return static_cast<unsigned int>(workers_.size());}
+	unsigned int GetOutstanding() const {return outstanding_;}
+	unsigned int GetCompleted() const {return completed_;}
+	bool IsIdle() const {return outstanding_ == 0;}
+};
@@ -0,0 +1,71 @@
+#pragma once
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#pragma intrinsic(_ReadWriteBarrier)
+//x86 never reorders stores with stores or loads with loads, so only the compiler needs holding back
+#define SPSCQUEUE_BARRIER() _ReadWriteBarrier()
+#else
+#define SPSCQUEUE_BARRIER() __sync_synchronize()
+#endif
+
+/* Fixed size queue from exactly one writer thread to exactly one reader thread, neither of which
+   ever waits on a lock. Each side only writes its own index, and publishes it after the slot it
+   covers has been written or read. For the audio callback, which can't be kept waiting on a
+   mutex held by the game thread. Holds one less than the capacity asked for */
+template<typename T>
+class SPSCQueue
+{
+private:
+	std::vector<T> slots_;
+	unsigned int mask_;
+	volatile unsigned int head_;	//Next slot to read, only written by the reader
+	volatile unsigned int tail_;	//Next slot to write, only written by the writer
+
+	SPSCQueue(const SPSCQueue&);
+	SPSCQueue& operator=(const SPSCQueue&);
+
+	static unsigned int RoundUp(unsigned int _capacity)
+	{
+		unsigned int size = 2;
+		while(size < _capacity)
+			size <<= 1;
+		return size;
+	}
+
+public:
+	/* _capacity is rounded up to a power of two */
+	explicit SPSCQueue(unsigned int _capacity)
+	: slots_(RoundUp(_capacity)), mask_(RoundUp(_capacity) - 1), head_(0), tail_(0){}
+
+	/* Writer only. False if the queue is full, in which case _value isn't queued */
+	bool Push(const T& _value)
+	{
+		unsigned int tail = tail_;
+		unsigned int next = (tail + 1) & mask_;
+		if(next == head_)
+			return false;
+		slots_[tail] = _value;
+		SPSCQUEUE_BARRIER();
+		tail_ = next;
+		return true;
+	}
+
+	/* Reader only. False if there was nothing to take */
+	bool Pop(T& _value)
+	{
+		unsigned int head = head_;
+		if(head == tail_)
+			return false;
+		SPSCQUEUE_BARRIER();
+		_value = slots_[head];
+		SPSCQUEUE_BARRIER();
+		head_ = (head + 1) & mask_;
+		return true;
+	}
+
+	/* Either side, only a snapshot while the other side is running */
+	bool IsEmpty() const {return head_ == tail_;}
+	unsigned int GetCapacity() const {return mask_;}
+};
@@ -0,0 +1,127 @@
+#include "Logger.h"
+#include "Signal.h"
+
+SignalBase::SignalBase()
+: next_id_(1), depth_(0), has_removed_(false)
+{
+}
+
+SignalBase::~SignalBase()
+{
+	//Connections that outlive the signal find it gone
+	if(self_)
+		*self_ = NULL;
+}
+
+SignalConnection SignalBase::Connect(const DelegateBase& _delegate)
+{
+	if(_delegate.IsEmpty())
+		return SignalConnection();
+	//Only made once something connects, an unused signal never allocates
+	if(!self_)
+		self_.reset(new SignalBase*(this));
+	unsigned int id = next_id_++;
+	if(depth_ > 0)
+	{
+		pending_.push_back(_delegate);
+		pending_ids_.push_back(id);
+	} else
+		slots_.push_back(Slot(_delegate, id));
+	return SignalConnection(self_, id);
+}
+
+void SignalBase::Disconnect(unsigned int _id)
+{
+	if(_id == 0)
+		return;
+	for(std::vector<Slot>::iterator it = slots_.begin(); it != slots_.end(); ++it)
+	{
+		if(it->id == _id)
+		{
+			if(depth_ > 0)
+			{
+				it->id = 0;
+				has_removed_ = true;
+			} else
+				slots_.erase(it);
+			return;
+		}
+	}
+	for(std::size_t i = 0; i < pending_ids_.size(); i++)
+	{
+		if(pending_ids_[i] == _id)
+		{
+			pending_.erase(pending_.begin() + i);
+			pending_ids_.erase(pending_ids_.begin() + i);
+			return;
+		}
+	}
+}
+
+bool SignalBase::IsConnected(unsigned int _id) const
+{
+	if(_id == 0)
+		return false;
+	for(std::vector<Slot>::const_iterator it = slots_.begin(); it != slots_.end(); ++it)
+	{
+		if(it->id == _id)
+			return true;
+	}
+	for(std::vector<unsigned int>::const_iterator it = pending_ids_.begin(); it != pending_ids_.end(); ++it)
+	{
+		if(*it == _id)
+			return true;
+	}
+	return false;
+}
+
+void SignalBase::EndDispatch()
+{
+	depth_--;
+	if(depth_ > 0)
+		return;
+	if(has_removed_)
+	{
+		std::vector<Slot> live;
+		live.reserve(slots_.size());
+		for(std::vector<Slot>::iterator it = slots_.begin(); it != slots_.end(); ++it)
+		{
+			if(it->id)
+				live.push_back(*it);
+		}
+		slots_.swap(live);
+		has_removed_ = false;
+	}
+	for(std::size_t i = 0; i < pending_.size(); i++)
+	{
+		slots_.push_back(Slot(pending_[i], pending_ids_[i]));
+	}
+	pending_.clear();
+	pending_ids_.clear();
+}
+
+void SignalBase::disconnect_all_slots()
+{
+	if(depth_ > 0)
+	{
+		for(std::vector<Slot>::iterator it = slots_.begin(); it != slots_.end(); ++it)
+		{
+			it->id = 0;
+		}
+		has_removed_ = true;
+	} else
+		slots_.clear();
+	pending_.clear();
+	pending_ids_.clear();
+}
+
+std::size_t SignalBase::num_slots() const
+{
+	std::size_t count = pending_.size();
+	for(std::vector<Slot>::const_iterator it = slots_.begin(); it != slots_.end(); ++it)
+	{
+		if(it->id)
+			count++;
+	}
+	return count;
+}
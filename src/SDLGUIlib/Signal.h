@@ -0,0 +1,405 @@
+#pragma once
+#include <vector>
+#include <new>
+#include <boost/shared_ptr.hpp>
+#include <boost/type_traits/alignment_of.hpp>
+
+/* Delegates and signals for widget events.
+   A delegate holds any callable - function pointer, boost::bind result or functor object - in a small
+   inline buffer, so the usual bound member function is stored without allocating. Anything larger
+   than the buffer falls back to the heap.
+   A signal keeps its slots in a vector, so firing one with nothing connected is a size check.
+   Connecting or disconnecting from inside a slot is safe: slots connected during a dispatch are first
+   called by the next one, and disconnected slots are skipped and then removed once dispatch ends.
+   Only void returning signatures of up to three arguments are supported, which is all the widgets use.
+   The method names follow boost::signal, which this replaced, so connect calls read the same */
+
+namespace SignalDetail
+{
+	const std::size_t buffer_size = 4 * sizeof(void*);
+
+	union Buffer
+	{
+		void* object;	//Callables too large for bytes are allocated and pointed to
+		double align;
+		char bytes[buffer_size];
+	};
+
+	namespace Operation
+	{
+		enum Enum
+		{
+			Clone, Destroy
+		};
+	}
+
+	typedef void (*Manager)(Operation::Enum _operation, const Buffer& _source, Buffer& _dest);
+	typedef void (*ErasedInvoker)();
+
+	/* Stores, copies and destroys a callable of type F in a Buffer */
+	template<typename F>
+	struct Functor
+	{
+		static bool IsSmall()
+		{
+			return sizeof(F) <= buffer_size && boost::alignment_of<F>::value <= boost::alignment_of<Buffer>::value;
+		}
+		static F* Get(Buffer& _buffer)
+		{
+			if(IsSmall())
+				return reinterpret_cast<F*>(_buffer.bytes);
+			return static_cast<F*>(_buffer.object);
+		}
+		static void Store(Buffer& _buffer, const F& _f)
+		{
+			if(IsSmall())
+				new (_buffer.bytes) F(_f);
+			else
+				_buffer.object = new F(_f);
+		}
+		static void Manage(Operation::Enum _operation, const Buffer& _source, Buffer& _dest)
+		{
+			F* source = Get(const_cast<Buffer&>(_source));
+			if(_operation == Operation::Clone)
+				Store(_dest, *source);
+			else if(IsSmall())
+				source->~F();
+			else
+				delete source;
+		}
+	};
+}
+
+/* The signature independent part of a delegate: the stored callable and how to copy and free it */
+class DelegateBase
+{
+private:
+	SignalDetail::Buffer buffer_;
+	SignalDetail::Manager manager_;
+	SignalDetail::ErasedInvoker invoker_;
+
+protected:
+	template<typename F>
+	void Assign(const F& _f, SignalDetail::ErasedInvoker _invoker)
+	{
+		Reset();
+		SignalDetail::Functor<F>::Store(buffer_, _f);
+		manager_ = &SignalDetail::Functor<F>::Manage;
+		invoker_ = _invoker;
+	}
+	static SignalDetail::Buffer& BufferOf(const DelegateBase& _delegate){return const_cast<SignalDetail::Buffer&>(_delegate.buffer_);}
+	static SignalDetail::ErasedInvoker InvokerOf(const DelegateBase& _delegate){return _delegate.invoker_;}
+
+public:
+	DelegateBase() : manager_(NULL), invoker_(NULL){}
+	DelegateBase(const DelegateBase& _other)
+	: manager_(_other.manager_), invoker_(_other.invoker_)
+	{
+		if(manager_)
+			manager_(SignalDetail::Operation::Clone, _other.buffer_, buffer_);
+	}
+	DelegateBase& operator=(const DelegateBase& _other)
+	{
+		if(this != &_other)
+		{
+			Reset();
+			if(_other.manager_)
+				_other.manager_(SignalDetail::Operation::Clone, _other.buffer_, buffer_);
+			manager_ = _other.manager_;
+			invoker_ = _other.invoker_;
+		}
+		return *this;
+	}
+	~DelegateBase()
+	{
+		Reset();
+	}
+
+	void Reset()
+	{
+		if(manager_)
+			manager_(SignalDetail::Operation::Destroy, buffer_, buffer_);
+		manager_ = NULL;
+		invoker_ = NULL;
+	}
+	bool IsEmpty() const {return invoker_ == NULL;}
+};
+
+template<typename Signature>
+class Delegate;
+
+template<>
+class Delegate<void ()> : public DelegateBase
+{
+private:
+	typedef void (*Invoker)(SignalDetail::Buffer&);
+	template<typename F>
+	static void Invoke(SignalDetail::Buffer& _buffer)
+	{
+		(*SignalDetail::Functor<F>::Get(_buffer))();
+	}
+public:
+	Delegate(){}
+	template<typename F>
+	Delegate(F _f){Assign(_f, reinterpret_cast<SignalDetail::ErasedInvoker>(&Invoke<F>));}
+	static void Call(const DelegateBase& _delegate)
+	{
+		reinterpret_cast<Invoker>(InvokerOf(_delegate))(BufferOf(_delegate));
+	}
+	void operator()(){Call(*this);}
+};
+
+template<typename A1>
+class Delegate<void (A1)> : public DelegateBase
+{
+private:
+	typedef void (*Invoker)(SignalDetail::Buffer&, A1);
+	template<typename F>
+	static void Invoke(SignalDetail::Buffer& _buffer, A1 _a1)
+	{
+		(*SignalDetail::Functor<F>::Get(_buffer))(_a1);
+	}
+public:
+	Delegate(){}
+	template<typename F>
+	Delegate(F _f){Assign(_f, reinterpret_cast<SignalDetail::ErasedInvoker>(&Invoke<F>));}
+	static void Call(const DelegateBase& _delegate, A1 _a1)
+	{
+		reinterpret_cast<Invoker>(InvokerOf(_delegate))(BufferOf(_delegate), _a1);
+	}
+	void operator()(A1 _a1){Call(*this, _a1);}
+};
+
+template<typename A1, typename A2>
+class Delegate<void (A1, A2)> : public DelegateBase
+{
+private:
+	typedef void (*Invoker)(SignalDetail::Buffer&, A1, A2);
+	template<typename F>
+	static void Invoke(SignalDetail::Buffer& _buffer, A1 _a1, A2 _a2)
+	{
+		(*SignalDetail::Functor<F>::Get(_buffer))(_a1, _a2);
+	}
+public:
+	Delegate(){}
+	template<typename F>
+	Delegate(F _f){Assign(_f, reinterpret_cast<SignalDetail::ErasedInvoker>(&Invoke<F>));}
+	static void Call(const DelegateBase& _delegate, A1 _a1, A2 _a2)
+	{
+		reinterpret_cast<Invoker>(InvokerOf(_delegate))(BufferOf(_delegate), _a1, _a2);
+	}
+	void operator()(A1 _a1, A2 _a2){Call(*this, _a1, _a2);}
+};
+
+template<typename A1, typename A2, typename A3>
+class Delegate<void (A1, A2, A3)> : public DelegateBase
+{
+private:
+	typedef void (*Invoker)(SignalDetail::Buffer&, A1, A2, A3);
+	template<typename F>
+	static void Invoke(SignalDetail::Buffer& _buffer, A1 _a1, A2 _a2, A3 _a3)
+	{
+		(*SignalDetail::Functor<F>::Get(_buffer))(_a1, _a2, _a3);
+	}
+public:
+	Delegate(){}
+	template<typename F>
+	Delegate(F _f){Assign(_f, reinterpret_cast<SignalDetail::ErasedInvoker>(&Invoke<F>));}
+	static void Call(const DelegateBase& _delegate, A1 _a1, A2 _a2, A3 _a3)
+	{
+		reinterpret_cast<Invoker>(InvokerOf(_delegate))(BufferOf(_delegate), _a1, _a2, _a3);
+	}
+	void operator()(A1 _a1, A2 _a2, A3 _a3){Call(*this, _a1, _a2, _a3);}
+};
+
+class SignalConnection;
+
+/* Slot bookkeeping shared by every signature */
+class SignalBase
+{
+private:
+	friend class SignalConnection;
+	SignalBase(const SignalBase&);
+	SignalBase& operator=(const SignalBase&);
+
+	std::vector<DelegateBase> pending_;	//Connected during dispatch
+	std::vector<unsigned int> pending_ids_;
+	boost::shared_ptr<SignalBase*> self_;	//Shared with connections, cleared when the signal goes
+	unsigned int next_id_;
+	int depth_;
+	bool has_removed_;
+
+	void Disconnect(unsigned int _id);
+	bool IsConnected(unsigned int _id) const;
+	void EndDispatch();
+
+protected:
+	struct Slot
+	{
+		DelegateBase delegate;
+		unsigned int id;	//0 once disconnected
+		Slot(const DelegateBase& _delegate, unsigned int _id) : delegate(_delegate), id(_id){}
+	};
+	std::vector<Slot> slots_;
+
+	SignalConnection Connect(const DelegateBase& _delegate);
+
+	/* Held for the length of a dispatch, so slots_ isn't changed under it */
+	class DispatchScope
+	{
+	private:
+		SignalBase& signal_;
+		DispatchScope& operator=(const DispatchScope&);
+	public:
+		explicit DispatchScope(SignalBase& _signal) : signal_(_signal){signal_.depth_++;}
+		~DispatchScope(){signal_.EndDispatch();}
+	};
+
+public:
+	SignalBase();
+	~SignalBase();
+
+	void disconnect_all_slots();
+	std::size_t num_slots() const;
+	bool empty() const {return num_slots() == 0;}
+};
+
+/* Handle returned by connect. Outliving the signal is fine, disconnecting then does nothing */
+class SignalConnection
+{
+private:
+	boost::shared_ptr<SignalBase*> signal_;
+	unsigned int id_;
+public:
+	SignalConnection() : id_(0){}
+	SignalConnection(const boost::shared_ptr<SignalBase*>& _signal, unsigned int _id) : signal_(_signal), id_(_id){}
+
+	void disconnect()
+	{
+		if(signal_ && *signal_)
+			(*signal_)->Disconnect(id_);
+		signal_.reset();
+	}
+	bool connected() const {return signal_ && *signal_ && (*signal_)->IsConnected(id_);}
+};
+
+/* Disconnects when destroyed. Copying hands the connection over, so returning one
+   by value doesn't disconnect it when the temporary goes */
+class ScopedConnection
+{
+private:
+	mutable SignalConnection connection_;
+	SignalConnection Release() const
+	{
+		SignalConnection released = connection_;
+		connection_ = SignalConnection();
+		return released;
+	}
+public:
+	ScopedConnection(){}
+	ScopedConnection(const SignalConnection& _connection) : connection_(_connection){}
+	ScopedConnection(const ScopedConnection& _other) : connection_(_other.Release()){}
+	~ScopedConnection(){connection_.disconnect();}
+
+	ScopedConnection& operator=(const SignalConnection& _connection)
+	{
+		connection_.disconnect();
+		connection_ = _connection;
+		return *this;
+	}
+	ScopedConnection& operator=(const ScopedConnection& _other)
+	{
+		if(this != &_other)
+		{
+			connection_.disconnect();
+			connection_ = _other.Release();
+		}
+		return *this;
+	}
+
+	void disconnect(){connection_.disconnect();}
+	bool connected() const {return connection_.connected();}
+};
+
+template<typename Signature>
+class Signal;
+
+template<>
+class Signal<void ()> : public SignalBase
+{
+public:
+	typedef Delegate<void ()> SlotType;
+	template<typename F>
+	SignalConnection connect(F _f){return Connect(SlotType(_f));}
+	void operator()()
+	{
+		if(slots_.empty())
+			return;
+		DispatchScope scope(*this);
+		for(std::size_t i = 0, count = slots_.size(); i < count; i++)
+		{
+			if(slots_[i].id)
+				SlotType::Call(slots_[i].delegate);
+		}
+	}
+};
+
+template<typename A1>
+class Signal<void (A1)> : public SignalBase
+{
+public:
+	typedef Delegate<void (A1)> SlotType;
+	template<typename F>
+	SignalConnection connect(F _f){return Connect(SlotType(_f));}
+	void operator()(A1 _a1)
+	{
+		if(slots_.empty())
+			return;
+		DispatchScope scope(*this);
+		for(std::size_t i = 0, count = slots_.size(); i < count; i++)
+		{
+			if(slots_[i].id)
+				SlotType::Call(slots_[i].delegate, _a1);
+		}
+	}
+};
+
+template<typename A1, typename A2>
+class Signal<void (A1, A2)> : public SignalBase
+{
+public:
+	typedef Delegate<void (A1, A2)> SlotType;
+	template<typename F>
+	SignalConnection connect(F _f){return Connect(SlotType(_f));}
+	void operator()(A1 _a1, A2 _a2)
+	{
+		if(slots_.empty())
+			return;
+		DispatchScope scope(*this);
+		for(std::size_t i = 0, count = slots_.size(); i < count; i++)
+		{
+			if(slots_[i].id)
+				SlotType::Call(slots_[i].delegate, _a1, _a2);
+		}
+	}
+};
+
+template<typename A1, typename A2, typename A3>
+class Signal<void (A1, A2, A3)> : public SignalBase
+{
+public:
+	typedef Delegate<void (A1, A2, A3)> SlotType;
+	template<typename F>
+	SignalConnection connect(F _f){return Connect(SlotType(_f));}
+	void operator()(A1 _a1, A2 _a2, A3 _a3)
+	{
+		if(slots_.empty())
+			return;
+		DispatchScope scope(*this);
+		for(std::size_t i = 0, count = slots_.size(); i < count; i++)
+		{
+			if(slots_[i].id)
+				SlotType::Call(slots_[i].delegate, _a1, _a2, _a3);
+		}
+	}
+};
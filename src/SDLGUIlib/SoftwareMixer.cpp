@@ -0,0 +1,304 @@
+#include "Logger.h"
+#include "SoftwareMixer.h"
+#include "AllocationTracker.h"
+#include <SDL.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#include <emmintrin.h>
+#define SOFTWAREMIXER_SSE2
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SOFTWAREMIXER_SSE2
+#endif
+
+namespace
+{
+	bool DetectSIMD()
+	{
+#if defined(SOFTWAREMIXER_SSE2) && defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		return (info[3] & (1 << 26)) != 0;
+#elif defined(SOFTWAREMIXER_SSE2)
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	/* Adds _count samples scaled by _gain into the accumulator */
+	void Accumulate(float* _accumulator, const Sint16* _samples, int _count, float _gain)
+	{
+		for(int i = 0; i < _count; i++)
+		{
+			_accumulator[i] += _samples[i] * _gain;
+		}
+	}
+
+	/* Rounds the accumulator to the nearest sample and clips it into the output */
+	void Store(Sint16* _out, const float* _accumulator, int _count)
+	{
+		for(int i = 0; i < _count; i++)
+		{
+			float value = floorf(_accumulator[i] + 0.5f);
+			if(value > 32767.0f)
+				value = 32767.0f;
+			else if(value < -32768.0f)
+				value = -32768.0f;
+			_out[i] = static_cast<Sint16>(value);
+		}
+	}
+
+#ifdef SOFTWAREMIXER_SSE2
+	void AccumulateSSE2(float* _accumulator, const Sint16* _samples, int _count, float _gain)
+	{
+		__m128 gain = _mm_set1_ps(_gain);
+		int i = 0;
+		for(; i + 8 <= _count; i += 8)
+		{
+			__m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_samples + i));
+			//Each sample paired with itself then shifted down, which sign extends it to 32 bits
+			__m128 low = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(packed, packed), 16));
+			__m128 high = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(packed, packed), 16));
+			_mm_storeu_ps(_accumulator + i, _mm_add_ps(_mm_loadu_ps(_accumulator + i), _mm_mul_ps(low, gain)));
+			_mm_storeu_ps(_accumulator + i + 4, _mm_add_ps(_mm_loadu_ps(_accumulator + i + 4), _mm_mul_ps(high, gain)));
+		}
+		Accumulate(_accumulator + i, _samples + i, _count - i, _gain);
+	}
+
+	/* floorf(x + 0.5f) as Store does, rather than the half to even of _mm_cvtps_epi32. Clipped
+	   first so everything fits the conversion, then truncated and stepped down where that rounded up */
+	__m128i RoundSSE2(__m128 _values)
+	{
+		__m128 half_up = _mm_add_ps(_values, _mm_set1_ps(0.5f));
+		half_up = _mm_min_ps(_mm_max_ps(half_up, _mm_set1_ps(-32768.0f)), _mm_set1_ps(32767.0f));
+		__m128i truncated = _mm_cvttps_epi32(half_up);
+		//All ones, i.e. -1, in lanes where truncating went above the value
+		__m128 above = _mm_cmpgt_ps(_mm_cvtepi32_ps(truncated), half_up);
+		return _mm_add_epi32(truncated, _mm_castps_si128(above));
+	}
+
+	void StoreSSE2(Sint16* _out, const float* _accumulator, int _count)
+	{
+		int i = 0;
+		for(; i + 8 <= _count; i += 8)
+		{
+			__m128i low = RoundSSE2(_mm_loadu_ps(_accumulator + i));
+			__m128i high = RoundSSE2(_mm_loadu_ps(_accumulator + i + 4));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(_out + i), _mm_packs_epi32(low, high));
+		}
+		Store(_out + i, _accumulator + i, _count - i);
+	}
+#endif
+}
+
+SoftwareMixer::SoftwareMixer(int _voices, int _frequency)
+: accumulator_(BLOCK_FRAMES * 2, 0.0f), mixed_frames_(0), mixed_voice_frames_(0),
+  generations_(_voices, 0), dropped_commands_(0),
+  commands_(QUEUE_SIZE), finished_(QUEUE_SIZE), frequency_(_frequency), simd_(HasSIMD())
+{
+	Voice silent = {NULL, 0, 0, 0, false, 1.0f, 0.0f};
+	voices_.resize(_voices, silent);
+}
+
+bool SoftwareMixer::HasSIMD()
+{
+	static bool has_simd = DetectSIMD();
+	return has_simd;
+}
+
+void SoftwareMixer::SetSIMD(bool _simd)
+{
+	simd_ = _simd && HasSIMD();
+}
+
+void SoftwareMixer::Send(const MixCommand& _command)
+{
+	if(_command.voice < 0 || _command.voice >= static_cast<int>(generations_.size()))
+		return;
+	if(!commands_.Push(_command))
+		dropped_commands_++;
+}
+
+void SoftwareMixer::Play(int _voice, const Sint16* _samples, unsigned int _frames, float _volume, bool _looping)
+{
+	if(_voice < 0 || _voice >= static_cast<int>(generations_.size()))
+		return;
+	MixCommand command = {MixCommandType::Play, _voice, ++generations_[_voice], _samples, _frames, _looping, _volume};
+	Send(command);
+}
+
+void SoftwareMixer::Stop(int _voice)
+{
+	if(_voice < 0 || _voice >= static_cast<int>(generations_.size()))
+		return;
+	//Anything already reported for the voice is stale now
+	MixCommand command = {MixCommandType::Stop, _voice, ++generations_[_voice], NULL, 0, false, 0.0f};
+	Send(command);
+}
+
+void SoftwareMixer::SetVolume(int _voice, float _volume)
+{
+	MixCommand command = {MixCommandType::Volume, _voice, 0, NULL, 0, false, _volume};
+	Send(command);
+}
+
+void SoftwareMixer::SetDistance(int _voice, unsigned char _distance)
+{
+	MixCommand command = {MixCommandType::Distance, _voice, 0, NULL, 0, false, _distance};
+	Send(command);
+}
+
+bool SoftwareMixer::TakeFinished(int& _voice)
+{
+	MixCommand finished;
+	while(finished_.Pop(finished))
+	{
+		if(finished.generation == generations_[finished.voice])
+		{
+			_voice = finished.voice;
+			return true;
+		}
+	}
+	return false;
+}
+
+void SoftwareMixer::Apply(const MixCommand& _command)
+{
+	Voice& voice = voices_[_command.voice];
+	switch(_command.type)
+	{
+	case MixCommandType::Play:
+		voice.samples = _command.frames > 0 ? _command.samples : NULL;
+		voice.frames = _command.frames;
+		voice.position = 0;
+		voice.generation = _command.generation;
+		voice.looping = _command.looping;
+		voice.volume = _command.value;
+		break;
+	case MixCommandType::Stop:
+		voice.samples = NULL;
+		break;
+	case MixCommandType::Volume:
+		voice.volume = _command.value;
+		break;
+	case MixCommandType::Distance:
+		voice.distance = _command.value;
+		break;
+	}
+}
+
+void SoftwareMixer::MixVoice(Voice& _voice, int _voice_index, int _frames)
+{
+	float gain = _voice.volume * (255.0f - _voice.distance) / 255.0f;
+	int mixed = 0;
+	while(mixed < _frames && _voice.samples)
+	{
+		int run = std::min(_frames - mixed, static_cast<int>(_voice.frames - _voice.position));
+		const Sint16* samples = _voice.samples + _voice.position * 2;
+		float* accumulator = &accumulator_[mixed * 2];
+#ifdef SOFTWAREMIXER_SSE2
+		if(simd_)
+			AccumulateSSE2(accumulator, samples, run * 2, gain);
+		else
+#endif
+			Accumulate(accumulator, samples, run * 2, gain);
+		mixed += run;
+		_voice.position += run;
+		if(_voice.position >= _voice.frames)
+		{
+			_voice.position = 0;
+			if(!_voice.looping)
+			{
+				_voice.samples = NULL;
+				MixCommand finished = {MixCommandType::Stop, _voice_index, _voice.generation, NULL, 0, false, 0.0f};
+				//Full only if the game thread has stopped asking, in which case it won't miss this either
+				finished_.Push(finished);
+			}
+		}
+	}
+	mixed_voice_frames_ += mixed;
+}
+
+void SoftwareMixer::Mix(Sint16* _out, int _frames)
+{
+	MixCommand command;
+	while(commands_.Pop(command))
+	{
+		Apply(command);
+	}
+
+	while(_frames > 0)
+	{
+		int block = std::min(_frames, static_cast<int>(BLOCK_FRAMES));
+		bool silent = true;
+		for(int i = 0; i < static_cast<int>(voices_.size()); i++)
+		{
+			if(!voices_[i].samples)
+				continue;
+			if(silent)
+			{
+				std::fill(accumulator_.begin(), accumulator_.begin() + block * 2, 0.0f);
+				silent = false;
+			}
+			MixVoice(voices_[i], i, block);
+		}
+		if(silent)
+		{
+			memset(_out, 0, block * 2 * sizeof(Sint16));
+		} else
+		{
+#ifdef SOFTWAREMIXER_SSE2
+			if(simd_)
+				StoreSSE2(_out, &accumulator_[0], block * 2);
+			else
+#endif
+				Store(_out, &accumulator_[0], block * 2);
+		}
+		mixed_frames_ += block;
+		_out += block * 2;
+		_frames -= block;
+	}
+}
+
+void SoftwareMixer::AudioCallback(void* _mixer, Uint8* _stream, int _length)
+{
+	//Should never allocate, counted so it's noticed if it does
+	AllocationScope allocations(AllocationTag::Audio);
+	static_cast<SoftwareMixer*>(_mixer)->Mix(reinterpret_cast<Sint16*>(_stream), _length / static_cast<int>(2 * sizeof(Sint16)));
+}
+
+bool SoftwareMixer::LoadWAV(const std::string& _filename, int _frequency, std::vector<Sint16>& _samples)
+{
+	SDL_AudioSpec spec;
+	Uint8* buffer = NULL;
+	Uint32 length = 0;
+	if(!SDL_LoadWAV(_filename.c_str(), &spec, &buffer, &length))
+		return false;
+
+	SDL_AudioCVT convert;
+	if(SDL_BuildAudioCVT(&convert, spec.format, spec.channels, spec.freq, AUDIO_S16SYS, 2, _frequency) < 0)
+	{
+		SDL_FreeWAV(buffer);
+		return false;
+	}
+	std::vector<Uint8> converted(length * convert.len_mult + 2 * sizeof(Sint16));
+	memcpy(&converted[0], buffer, length);
+	SDL_FreeWAV(buffer);
+	convert.buf = &converted[0];
+	convert.len = static_cast<int>(length);
+	if(convert.needed && SDL_ConvertAudio(&convert) < 0)
+		return false;
+	int converted_length = convert.needed ? convert.len_cvt : convert.len;
+
+	_samples.resize(converted_length / sizeof(Sint16));
+	if(!_samples.empty())
+		memcpy(&_samples[0], &converted[0], _samples.size() * sizeof(Sint16));
+	//Whole frames only
+	_samples.resize(_samples.size() & ~static_cast<size_t>(1));
+	return true;
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <SDL_types.h>
+#include "SPSCQueue.h"
+
+namespace MixCommandType
+{
+	enum Enum
+	{
+		Play, Stop, Volume, Distance
+	};
+}
+
+struct MixCommand
+{
+	MixCommandType::Enum type;
+	int voice;
+	unsigned int generation;	//Play only, tells a finished voice from one that has been restarted since
+	const Sint16* samples;		//Play only
+	unsigned int frames;		//Play only
+	bool looping;				//Play only
+	float value;				//Volume 0 to 1, or distance 0 (near) to 255 (far)
+};
+
+/* Mixes a fixed number of voices of 16 bit stereo samples at one frequency, four samples at a
+   time with SSE2 where it's available. Owned by the game thread, which sends commands through a
+   lock free queue; Mix runs on the audio thread, which only ever reads the samples and reports
+   voices that play to the end through a second queue. Without an audio device Mix can be called
+   directly, which is how the tests and benchmarks run it.
+   The samples must stay put until the voice playing them has been stopped or reported finished */
+class SoftwareMixer
+{
+public:
+	static const int BLOCK_FRAMES = 256;	//Mixed at a time, so the accumulator never needs reallocating
+	static const unsigned int QUEUE_SIZE = 256;
+
+private:
+	struct Voice
+	{
+		const Sint16* samples;	//NULL when not playing
+		unsigned int frames;
+		unsigned int position;
+		unsigned int generation;
+		bool looping;
+		float volume;
+		float distance;
+	};
+
+	//Audio thread
+	std::vector<Voice> voices_;
+	std::vector<float> accumulator_;
+	unsigned int mixed_frames_;
+	unsigned int mixed_voice_frames_;
+
+	//Game thread
+	std::vector<unsigned int> generations_;
+	unsigned int dropped_commands_;
+
+	SPSCQueue<MixCommand> commands_;
+	SPSCQueue<MixCommand> finished_;
+	int frequency_;
+	bool simd_;
+
+	void Send(const MixCommand& _command);
+	void Apply(const MixCommand& _command);
+	void MixVoice(Voice& _voice, int _voice_index, int _frames);
+
+	SoftwareMixer(const SoftwareMixer&);
+	SoftwareMixer& operator=(const SoftwareMixer&);
+
+public:
+	SoftwareMixer(int _voices, int _frequency);
+
+	/* Game thread. Voices are numbered from 0 and the caller decides which to use */
+	void Play(int _voice, const Sint16* _samples, unsigned int _frames, float _volume, bool _looping);
+	void Stop(int _voice);
+	void SetVolume(int _voice, float _volume);
+	/* Same scale as Mix_SetDistance */
+	void SetDistance(int _voice, unsigned char _distance);
+	/* A voice that has played to the end since last asked. False once there are none left.
+	   Voices stopped or restarted by the game thread are never reported */
+	bool TakeFinished(int& _voice);
+	/* Commands lost because the audio thread fell too far behind to take them */
+	unsigned int GetDroppedCommands() const {return dropped_commands_;}
+
+	/* Audio thread. Applies the commands sent so far, then writes _frames stereo frames */
+	void Mix(Sint16* _out, int _frames);
+	/* For SDL_OpenAudio, with the mixer as userdata */
+	static void AudioCallback(void* _mixer, Uint8* _stream, int _length);
+	/* Frames written, and frames mixed summed over every voice playing */
+	unsigned int GetMixedFrames() const {return mixed_frames_;}
+	unsigned int GetMixedVoiceFrames() const {return mixed_voice_frames_;}
+
+	int GetVoiceCount() const {return static_cast<int>(voices_.size());}
+	int GetFrequency() const {return frequency_;}
+
+	/* Mixes without SSE2 when false, for comparing the two. Has no effect where SSE2 isn't available */
+	void SetSIMD(bool _simd);
+	bool GetSIMD() const {return simd_;}
+	static bool HasSIMD();
+
+	/* Loads a wav converted to 16 bit stereo at _frequency. Touches nothing shared, so can run on a worker */
+	static bool LoadWAV(const std::string& _filename, int _frequency, std::vector<Sint16>& _samples);
+};
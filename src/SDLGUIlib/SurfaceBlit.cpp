@@ -0,0 +1,181 @@
+#include "Logger.h"
+#include "SurfaceBlit.h"
+#include <SDL.h>
+#include <string.h>
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#include <emmintrin.h>
+#define SURFACEBLIT_SSE2
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SURFACEBLIT_SSE2
+#endif
+
+namespace
+{
+	bool DetectSIMD()
+	{
+#if defined(SURFACEBLIT_SSE2) && defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		return (info[3] & (1 << 26)) != 0;
+#elif defined(SURFACEBLIT_SSE2)
+		return true;
+#else
+		return false;
+#endif
+	}
+
+#ifdef SURFACEBLIT_SSE2
+	/* Copies a row 64 bytes at a time once the pointers are 16 byte aligned.
+	   Only worth it when both rows share the same alignment, otherwise memcpy is used */
+	void CopyRowWide(Uint8* _dest, const Uint8* _src, int _bytes)
+	{
+		while(_bytes > 0 && (reinterpret_cast<size_t>(_dest) & 15) != 0)
+		{
+			*_dest++ = *_src++;
+			_bytes--;
+		}
+		while(_bytes >= 64)
+		{
+			__m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(_src));
+			__m128i b = _mm_load_si128(reinterpret_cast<const __m128i*>(_src + 16));
+			__m128i c = _mm_load_si128(reinterpret_cast<const __m128i*>(_src + 32));
+			__m128i d = _mm_load_si128(reinterpret_cast<const __m128i*>(_src + 48));
+			_mm_store_si128(reinterpret_cast<__m128i*>(_dest), a);
+			_mm_store_si128(reinterpret_cast<__m128i*>(_dest + 16), b);
+			_mm_store_si128(reinterpret_cast<__m128i*>(_dest + 32), c);
+			_mm_store_si128(reinterpret_cast<__m128i*>(_dest + 48), d);
+			_src += 64;
+			_dest += 64;
+			_bytes -= 64;
+		}
+		while(_bytes >= 16)
+		{
+			_mm_store_si128(reinterpret_cast<__m128i*>(_dest), _mm_load_si128(reinterpret_cast<const __m128i*>(_src)));
+			_src += 16;
+			_dest += 16;
+			_bytes -= 16;
+		}
+		if(_bytes > 0)
+			memcpy(_dest, _src, _bytes);
+	}
+#endif
+}
+
+bool SurfaceBlit::HasSIMD()
+{
+	static bool has_simd = DetectSIMD();
+	return has_simd;
+}
+
+bool SurfaceBlit::Copy(SDL_Surface* _src, SDL_Surface* _dest, int _dest_x, int _dest_y)
+{
+	if(!_src)
+		return false;
+	return Copy(_src, 0, 0, _src->w, _src->h, _dest, _dest_x, _dest_y);
+}
+
+bool SurfaceBlit::Copy(SDL_Surface* _src, int _src_x, int _src_y, int _w, int _h,
+					   SDL_Surface* _dest, int _dest_x, int _dest_y)
+{
+	if(!_src || !_dest)
+		return false;
+	const int bpp = _src->format->BytesPerPixel;
+	if(bpp != _dest->format->BytesPerPixel)
+	{
+		Logger::ErrorOut() << "Unable to copy surface, source data and dest data have different bpp\n";
+		return false;
+	}
+
+	//Clip the left and top edges of both surfaces, moving the other origin by the same amount
+	if(_src_x < 0)
+	{
+		_w += _src_x;
+		_dest_x -= _src_x;
+		_src_x = 0;
+	}
+	if(_src_y < 0)
+	{
+		_h += _src_y;
+		_dest_y -= _src_y;
+		_src_y = 0;
+	}
+	//The destination is clipped to its clip rect, as SDL_BlitSurface does. SDL keeps that inside the surface
+	const SDL_Rect& clip = _dest->clip_rect;
+	if(_dest_x < clip.x)
+	{
+		_w -= clip.x - _dest_x;
+		_src_x += clip.x - _dest_x;
+		_dest_x = clip.x;
+	}
+	if(_dest_y < clip.y)
+	{
+		_h -= clip.y - _dest_y;
+		_src_y += clip.y - _dest_y;
+		_dest_y = clip.y;
+	}
+	//Then the right and bottom edges
+	if(_src_x + _w > _src->w)
+		_w = _src->w - _src_x;
+	if(_src_y + _h > _src->h)
+		_h = _src->h - _src_y;
+	if(_dest_x + _w > clip.x + clip.w)
+		_w = clip.x + clip.w - _dest_x;
+	if(_dest_y + _h > clip.y + clip.h)
+		_h = clip.y + clip.h - _dest_y;
+	if(_w <= 0 || _h <= 0)
+		return true;
+
+	SurfaceLock src_lock(_src);
+	SurfaceLock dest_lock(_dest);
+
+	const Uint8* src = static_cast<const Uint8*>(_src->pixels) + _src->pitch * _src_y + bpp * _src_x;
+	Uint8* dest = static_cast<Uint8*>(_dest->pixels) + _dest->pitch * _dest_y + bpp * _dest_x;
+	const int row_bytes = _w * bpp;
+
+	//Whole rows of surfaces with the same layout are one contiguous block
+	if(row_bytes == _src->pitch && row_bytes == _dest->pitch)
+	{
+		memcpy(dest, src, row_bytes * _h);
+		return true;
+	}
+
+#ifdef SURFACEBLIT_SSE2
+	if(row_bytes >= 64 && HasSIMD() &&
+	   (_src->pitch & 15) == 0 && (_dest->pitch & 15) == 0 &&
+	   (reinterpret_cast<size_t>(src) & 15) == (reinterpret_cast<size_t>(dest) & 15))
+	{
+		for(int y = 0; y < _h; y++)
+		{
+			CopyRowWide(dest, src, row_bytes);
+			src += _src->pitch;
+			dest += _dest->pitch;
+		}
+		return true;
+	}
+#endif
+
+	for(int y = 0; y < _h; y++)
+	{
+		memcpy(dest, src, row_bytes);
+		src += _src->pitch;
+		dest += _dest->pitch;
+	}
+	return true;
+}
+
+
+SurfaceLock::SurfaceLock(SDL_Surface* _surface)
+: surface_(_surface), locked_(false)
+{
+	if(surface_ && SDL_MUSTLOCK(surface_))
+		locked_ = SDL_LockSurface(surface_) == 0;
+}
+
+SurfaceLock::~SurfaceLock()
+{
+	if(locked_)
+		SDL_UnlockSurface(surface_);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+struct SDL_Surface;
+
+/* Raw pixel copies between surfaces of the same format.
+   Unlike SDL_BlitSurface the destination alpha is overwritten rather than blended,
+   which is what's needed to copy subimages out of and into RGBA surfaces */
+class SurfaceBlit
+{
+public:
+	/* Copies the _w x _h area at (_src_x, _src_y) of _src to (_dest_x, _dest_y) of _dest.
+	   The area is clipped against the source and the destination's clip rect, so offsets may be negative or run off either edge.
+	   Returns false if the surfaces can't be copied between */
+	static bool Copy(SDL_Surface* _src, int _src_x, int _src_y, int _w, int _h,
+					 SDL_Surface* _dest, int _dest_x, int _dest_y);
+	/* Copies the whole of _src to (_dest_x, _dest_y) of _dest */
+	static bool Copy(SDL_Surface* _src, SDL_Surface* _dest, int _dest_x, int _dest_y);
+
+	static bool HasSIMD();
+};
+
+/* Holds a surface locked for its lifetime, so a run of blits only locks once.
+   Does nothing for surfaces that don't need locking */
+class SurfaceLock
+{
+private:
+	SDL_Surface* surface_;
+	bool locked_;
+	SurfaceLock(const SurfaceLock&);
+	SurfaceLock& operator=(const SurfaceLock&);
+
+public:
+	explicit SurfaceLock(SDL_Surface* _surface);
+	~SurfaceLock();
+};
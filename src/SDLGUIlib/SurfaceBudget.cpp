@@ -0,0 +1,118 @@
+#include "Logger.h"
+#include "SurfaceBudget.h"
+#include <SDL.h>
+#include <algorithm>
+
+SurfaceBudget::SurfaceBudget()
+: total_(0), total_peak_(0), ceiling_(32 * 1024 * 1024), clock_(0), evictions_(0)
+{
+	for(int i = 0; i < SurfaceCategory::Count; i++)
+	{
+		bytes_[i] = 0;
+		peak_[i] = 0;
+	}
+}
+
+SurfaceBudget& SurfaceBudget::Instance()
+{
+	static SurfaceBudget instance;
+	return instance;
+}
+
+unsigned int SurfaceBudget::SurfaceBytes(SDL_Surface* _surface)
+{
+	if(!_surface)
+		return 0;
+	return _surface->pitch * _surface->h;
+}
+
+const char* SurfaceBudget::GetCategoryName(SurfaceCategory::Enum _category)
+{
+	switch(_category)
+	{
+	case SurfaceCategory::Rect:
+		return "Rects";
+	case SurfaceCategory::BackingStore:
+		return "Widget backing stores";
+	case SurfaceCategory::Image:
+		return "Images";
+	case SurfaceCategory::Scaled:
+		return "Scaled images";
+	case SurfaceCategory::Animation:
+		return "Animation frames";
+	default:
+		return "Unknown";
+	}
+}
+
+void SurfaceBudget::Add(SurfaceCategory::Enum _category, unsigned int _bytes)
+{
+	bytes_[_category] += _bytes;
+	total_ += _bytes;
+	if(bytes_[_category] > peak_[_category])
+		peak_[_category] = bytes_[_category];
+	if(total_ > total_peak_)
+		total_peak_ = total_;
+}
+
+void SurfaceBudget::Remove(SurfaceCategory::Enum _category, unsigned int _bytes)
+{
+	if(_bytes > bytes_[_category])
+	{
+		Logger::ErrorOut() << "Surface budget freeing more " << GetCategoryName(_category) << " than were added\n";
+		_bytes = bytes_[_category];
+	}
+	bytes_[_category] -= _bytes;
+	total_ -= _bytes;
+}
+
+void SurfaceBudget::Register(Evictable* _evictable)
+{
+	if(std::find(evictables_.begin(), evictables_.end(), _evictable) == evictables_.end())
+		evictables_.push_back(_evictable);
+}
+
+void SurfaceBudget::Unregister(Evictable* _evictable)
+{
+	evictables_.erase(std::remove(evictables_.begin(), evictables_.end(), _evictable), evictables_.end());
+}
+
+unsigned int SurfaceBudget::Enforce()
+{
+	unsigned int evicted = 0;
+	while(ceiling_ > 0 && total_ > ceiling_)
+	{
+		Evictable* oldest = NULL;
+		unsigned int oldest_used = 0;
+		for(std::vector<Evictable*>::iterator it = evictables_.begin(); it != evictables_.end(); ++it)
+		{
+			unsigned int last_used;
+			if((*it)->GetOldest(last_used) && (!oldest || last_used < oldest_used))
+			{
+				oldest = *it;
+				oldest_used = last_used;
+			}
+		}
+		if(!oldest)
+			break;
+		oldest->EvictOldest();
+		evicted++;
+	}
+	evictions_ += evicted;
+	return evicted;
+}
+
+void SurfaceBudget::Report(std::ostream& _out)
+{
+	for(int i = 0; i < SurfaceCategory::Count; i++)
+	{
+		SurfaceCategory::Enum category = static_cast<SurfaceCategory::Enum>(i);
+		_out << GetCategoryName(category) << ": " << bytes_[i] / 1024 << "KB, peak " << peak_[i] / 1024 << "KB\n";
+	}
+	_out << "Surface total: " << total_ / 1024 << "KB, peak " << total_peak_ / 1024 << "KB, ceiling ";
+	if(ceiling_ > 0)
+		_out << ceiling_ / 1024 << "KB";
+	else
+		_out << "none";
+	_out << ", " << evictions_ << " evicted\n";
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <vector>
+#include <ostream>
+
+struct SDL_Surface;
+
+namespace SurfaceCategory
+{
+	enum Enum
+	{
+		Rect,			//Surfaces owned by a BlittableRect
+		BackingStore,	//Widget front buffers
+		Image,			//Decoded images and tile compositions shared through ImageCache
+		Scaled,			//Resized images kept by ScaledImageCache
+		Animation,		//Animation frames
+		Count
+	};
+}
+
+/* Accounts for surface memory by category and keeps the total under a ceiling.
+   Caches of surfaces that can be made again register as evictable. When the total is over the
+   ceiling, Enforce frees their least recently used surfaces, oldest first across every cache.
+   Surfaces in use are never evicted, so the ceiling is a target rather than a hard limit */
+class SurfaceBudget
+{
+public:
+	class Evictable
+	{
+	public:
+		virtual ~Evictable(){}
+		/* Use stamp of the least recently used surface that could be freed, false if there is none */
+		virtual bool GetOldest(unsigned int& _last_used) = 0;
+		/* Frees the surface GetOldest found */
+		virtual void EvictOldest() = 0;
+	};
+
+private:
+	SurfaceBudget();
+	unsigned int bytes_[SurfaceCategory::Count];
+	unsigned int peak_[SurfaceCategory::Count];
+	unsigned int total_;
+	unsigned int total_peak_;
+	unsigned int ceiling_;
+	unsigned int clock_;
+	unsigned int evictions_;
+	std::vector<Evictable*> evictables_;
+
+public:
+	static SurfaceBudget& Instance();
+	static unsigned int SurfaceBytes(SDL_Surface* _surface);
+	static const char* GetCategoryName(SurfaceCategory::Enum _category);
+
+	void Add(SurfaceCategory::Enum _category, unsigned int _bytes);
+	void Remove(SurfaceCategory::Enum _category, unsigned int _bytes);
+	/* Stamp for the least recently used ordering, shared by every cache */
+	unsigned int Touch(){return ++clock_;}
+
+	void Register(Evictable* _evictable);
+	void Unregister(Evictable* _evictable);
+	/* Bytes to keep the total under, 0 for no limit */
+	void SetCeiling(unsigned int _bytes){ceiling_ = _bytes;}
+	unsigned int GetCeiling(){return ceiling_;}
+	/* Evicts until under the ceiling or nothing more can go. Returns the number of surfaces freed */
+	unsigned int Enforce();
+
+	unsigned int GetBytes(SurfaceCategory::Enum _category){return bytes_[_category];}
+	unsigned int GetPeak(SurfaceCategory::Enum _category){return peak_[_category];}
+	unsigned int GetTotal(){return total_;}
+	unsigned int GetTotalPeak(){return total_peak_;}
+	unsigned int GetEvictions(){return evictions_;}
+	/* One line per category with current and peak use, then the totals */
+	void Report(std::ostream& _out);
+};
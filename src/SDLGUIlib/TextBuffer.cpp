@@ -0,0 +1,111 @@
+#include "Logger.h"
+#include "TextBuffer.h"
+#include <cstring>
+
+namespace
+{
+	const unsigned int min_gap = 64;
+}
+
+TextBuffer::TextBuffer()
+: gap_start_(0), gap_end_(0)
+{
+}
+
+TextBuffer::TextBuffer(const std::string& _text)
+: gap_start_(0), gap_end_(0)
+{
+	Assign(_text);
+}
+
+void TextBuffer::MoveGap(unsigned int _position)
+{
+	if(_position < gap_start_)
+	{
+		unsigned int count = gap_start_ - _position;
+		memmove(&data_[gap_end_ - count], &data_[_position], count);
+		gap_start_ -= count;
+		gap_end_ -= count;
+	} else if(_position > gap_start_)
+	{
+		unsigned int count = _position - gap_start_;
+		memmove(&data_[gap_start_], &data_[gap_end_], count);
+		gap_start_ += count;
+		gap_end_ += count;
+	}
+}
+
+/* Grows the gap to at least _length, doubling the buffer so that runs of inserts stay amortised constant */
+void TextBuffer::Reserve(unsigned int _length)
+{
+	unsigned int gap = gap_end_ - gap_start_;
+	if(gap >= _length)
+		return;
+	unsigned int size = static_cast<unsigned int>(data_.size());
+	unsigned int new_size = size * 2;
+	if(new_size < size - gap + _length + min_gap)
+		new_size = size - gap + _length + min_gap;
+	unsigned int tail = size - gap_end_;
+	data_.resize(new_size);
+	if(tail > 0)
+		memmove(&data_[new_size - tail], &data_[gap_end_], tail);
+	gap_end_ = new_size - tail;
+}
+
+void TextBuffer::Assign(const std::string& _text)
+{
+	unsigned int length = static_cast<unsigned int>(_text.length());
+	data_.assign(length + min_gap, '\0');
+	if(length > 0)
+		memcpy(&data_[0], _text.data(), length);
+	gap_start_ = length;
+	gap_end_ = length + min_gap;
+}
+
+void TextBuffer::Insert(unsigned int _position, const std::string& _text)
+{
+	if(_position > GetLength())
+	{
+		Logger::ErrorOut() << "Text inserted past the end of a text buffer\n";
+		_position = GetLength();
+	}
+	unsigned int length = static_cast<unsigned int>(_text.length());
+	if(length == 0)
+		return;
+	Reserve(length);
+	MoveGap(_position);
+	memcpy(&data_[gap_start_], _text.data(), length);
+	gap_start_ += length;
+}
+
+void TextBuffer::Erase(unsigned int _position, unsigned int _count)
+{
+	unsigned int length = GetLength();
+	if(_position >= length)
+		return;
+	if(_count > length - _position)
+		_count = length - _position;
+	MoveGap(_position);
+	gap_end_ += _count;
+}
+
+void TextBuffer::AppendTo(unsigned int _position, unsigned int _count, std::string& _out) const
+{
+	unsigned int end = _position + _count;
+	if(_position < gap_start_)
+	{
+		unsigned int before = (end < gap_start_ ? end : gap_start_) - _position;
+		_out.append(&data_[_position], before);
+		_position += before;
+	}
+	if(_position < end)
+		_out.append(&data_[_position + gap_end_ - gap_start_], end - _position);
+}
+
+std::string TextBuffer::GetText() const
+{
+	std::string text;
+	text.reserve(GetLength());
+	AppendTo(0, GetLength(), text);
+	return text;
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <vector>
+#include <string>
+
+/* Gap buffer holding editable text. The unused space sits at the last edit, so typing and deleting
+   next to it only touches the characters being changed. Moving the edit point costs the distance moved */
+class TextBuffer
+{
+private:
+	std::vector<char> data_;
+	unsigned int gap_start_;
+	unsigned int gap_end_;
+
+	void MoveGap(unsigned int _position);
+	void Reserve(unsigned int _length);
+
+public:
+	TextBuffer();
+	explicit TextBuffer(const std::string& _text);
+
+	unsigned int GetLength() const {return static_cast<unsigned int>(data_.size()) - (gap_end_ - gap_start_);}
+	char At(unsigned int _position) const {return _position < gap_start_ ? data_[_position] : data_[_position + gap_end_ - gap_start_];}
+
+	void Assign(const std::string& _text);
+	void Insert(unsigned int _position, const std::string& _text);
+	/* Removes up to _count characters, clamped to the end of the text */
+	void Erase(unsigned int _position, unsigned int _count);
+
+	/* Copies _count characters from _position onto the end of _out */
+	void AppendTo(unsigned int _position, unsigned int _count, std::string& _out) const;
+	std::string GetText() const;
+};
@@ -0,0 +1,170 @@
+#include "TileCache.h"
+#include "BlittableRect.h"
+#include <sstream>
+#include <cmath>
+
+std::string TileCache::MakeKey(VerticalTile _tiles, int _height)
+{
+	std::ostringstream key;
+	key << "tile|v|" << _tiles.top << "|" << _tiles.middle << "|" << _tiles.bottom << "|" << _height;
+	return key.str();
+}
+
+std::string TileCache::MakeKey(HorizontalTile _tiles, int _width)
+{
+	std::ostringstream key;
+	key << "tile|h|" << _tiles.left << "|" << _tiles.middle << "|" << _tiles.right << "|" << _width;
+	return key.str();
+}
+
+std::string TileCache::MakeKey(NinePatch _tiles, int _width, int _height)
+{
+	std::ostringstream key;
+	key << "tile|9|" << _tiles.image << "|" << _tiles.top << "," << _tiles.left << "," << _tiles.bottom << "," << _tiles.right <<
+		   "|" << _width << "x" << _height;
+	return key.str();
+}
+
+BlittableRect* TileCache::Compose(VerticalTile _tiles, int _height)
+{
+	std::string key = MakeKey(_tiles, _height);
+	BlittableRect* cached = BlittableRect::FromImageCache(key);
+	if(cached)
+		return cached;
+
+	//Width is taken from top tile
+	BlittableRect toptile(_tiles.top);
+	BlittableRect middletile(_tiles.middle);
+	BlittableRect bottomtile(_tiles.bottom);
+
+	BlittableRect* back_rect = new BlittableRect(Vector2i(toptile.GetSize().x, _height));
+	back_rect->Fill(0, 0, 0, 0);
+	{
+		BlittableRect::ScopedLock back_lock(back_rect);
+		toptile.RawBlit(Vector2i(0,0), back_rect);
+		int center_reps = static_cast<int>(ceil(static_cast<double>(back_rect->GetSize().y - toptile.GetSize().y - bottomtile.GetSize().y) / static_cast<double>(middletile.GetSize().y)));
+		for(int i = 0; i < center_reps; i++)
+		{
+			middletile.RawBlit(Vector2i(0, i * middletile.GetSize().y + toptile.GetSize().y), back_rect);
+		}
+		bottomtile.RawBlit(Vector2i(0, back_rect->GetSize().y - bottomtile.GetSize().y), back_rect);
+	}
+
+	//Only remember complete compositions, so a missing tile is retried next time
+	if(!toptile.GetError() && !middletile.GetError() && !bottomtile.GetError())
+		back_rect->ShareAs(key);
+	return back_rect;
+}
+
+BlittableRect* TileCache::Compose(HorizontalTile _tiles, int _width)
+{
+	std::string key = MakeKey(_tiles, _width);
+	BlittableRect* cached = BlittableRect::FromImageCache(key);
+	if(cached)
+		return cached;
+
+	//Height is taken from left tile
+	BlittableRect lefttile(_tiles.left);
+	BlittableRect middletile(_tiles.middle);
+	BlittableRect righttile(_tiles.right);
+
+	BlittableRect* back_rect = new BlittableRect(Vector2i(_width, lefttile.GetSize().y));
+	back_rect->Fill(0, 0, 0, 0);
+	{
+		BlittableRect::ScopedLock back_lock(back_rect);
+		lefttile.RawBlit(Vector2i(0,0), back_rect);
+		int center_reps = static_cast<int>(ceil(static_cast<double>(back_rect->GetSize().x - lefttile.GetSize().x - righttile.GetSize().x) / static_cast<double>(middletile.GetSize().x)));
+		for(int i = 0; i < center_reps; i++)
+		{
+			middletile.RawBlit(Vector2i(i * middletile.GetSize().x + lefttile.GetSize().x, 0), back_rect);
+		}
+		righttile.RawBlit(Vector2i(back_rect->GetSize().x - righttile.GetSize().x, 0), back_rect);
+	}
+
+	if(!lefttile.GetError() && !middletile.GetError() && !righttile.GetError())
+		back_rect->ShareAs(key);
+	return back_rect;
+}
+
+BlittableRect* TileCache::Compose(NinePatch _tiles, int _width, int _height)
+{
+	std::string key = MakeKey(_tiles, _width, _height);
+	BlittableRect* cached = BlittableRect::FromImageCache(key);
+	if(cached)
+		return cached;
+
+	BlittableRect source(_tiles.image);
+	Vector2i size = Vector2i(_width, _height);
+	BlittableRect* back_rect = new BlittableRect(size);
+	back_rect->Fill(0, 0, 0, 0);
+	{
+		//Lock once for the whole composition rather than per RawBlit
+		BlittableRect::ScopedLock source_lock(&source);
+		BlittableRect::ScopedLock back_lock(back_rect);
+
+		int src_middle_w = source.GetSize().x - _tiles.left - _tiles.right;
+		int src_middle_h = source.GetSize().y - _tiles.top - _tiles.bottom;
+
+		//Top left
+		source.RawBlit(Vector2i(0, 0), Vector2i(_tiles.left, _tiles.top), Vector2i(0, 0), back_rect);
+
+		//Top right
+		source.RawBlit(Vector2i(source.GetSize().x - _tiles.right, 0), Vector2i(_tiles.right, _tiles.top), Vector2i(size.x - _tiles.right, 0), back_rect);
+
+		//Bottom left
+		source.RawBlit(Vector2i(0, source.GetSize().y - _tiles.bottom), Vector2i(_tiles.left, _tiles.bottom), Vector2i(0, size.y - _tiles.bottom), back_rect);
+
+		//Bottom right
+		source.RawBlit(Vector2i(source.GetSize().x - _tiles.right, source.GetSize().y - _tiles.bottom), Vector2i(_tiles.right, _tiles.bottom), Vector2i(size.x - _tiles.right, size.y - _tiles.bottom), back_rect);
+
+		//Top & bottom
+		int h_tiles = (size.x - _tiles.left - _tiles.right) / src_middle_w;
+		int h_remainder = (size.x - _tiles.left - _tiles.right) - h_tiles * src_middle_w;
+		for(int x = 0; x < h_tiles; x++)
+		{
+			source.RawBlit(Vector2i(_tiles.left, 0), Vector2i(source.GetSize().x - _tiles.left - _tiles.right, _tiles.top), Vector2i(_tiles.left + x * src_middle_w, 0), back_rect);
+			source.RawBlit(Vector2i(_tiles.left, source.GetSize().y - _tiles.bottom), Vector2i(source.GetSize().x - _tiles.left - _tiles.right, _tiles.bottom), Vector2i(_tiles.left + x * src_middle_w, size.y - _tiles.bottom), back_rect);
+		}
+		if(h_remainder > 0)
+		{
+			source.RawBlit(Vector2i(_tiles.left, 0), Vector2i(h_remainder, _tiles.top), Vector2i(_tiles.left + h_tiles * src_middle_w, 0), back_rect);
+			source.RawBlit(Vector2i(_tiles.left, source.GetSize().y - _tiles.bottom), Vector2i(h_remainder, _tiles.bottom), Vector2i(_tiles.left + h_tiles * src_middle_w, size.y - _tiles.bottom), back_rect);
+		}
+
+		//Left & right
+		int v_tiles = (size.y - _tiles.top- _tiles.bottom) / src_middle_h;
+		int v_remainder = (size.y - _tiles.top - _tiles.bottom) - v_tiles * src_middle_h;
+		for(int y = 0; y < v_tiles; y++)
+		{
+			source.RawBlit(Vector2i(0, _tiles.top), Vector2i(_tiles.left, src_middle_h), Vector2i(0, _tiles.top + y * src_middle_h), back_rect);
+			source.RawBlit(Vector2i(source.GetSize().x - _tiles.right, _tiles.top), Vector2i(_tiles.right, src_middle_h), Vector2i(size.x - _tiles.right, _tiles.top + y * src_middle_h), back_rect);
+		}
+		if(v_remainder > 0)
+		{
+			source.RawBlit(Vector2i(0, _tiles.top), Vector2i(_tiles.left, v_remainder), Vector2i(0, _tiles.top + v_tiles * src_middle_h), back_rect);
+			source.RawBlit(Vector2i(source.GetSize().x - _tiles.right, _tiles.top), Vector2i(_tiles.right, v_remainder), Vector2i(size.x - _tiles.right, _tiles.top + v_tiles * src_middle_h), back_rect);
+		}
+
+		//Fill centre
+		for(int x = 0; x < h_tiles; x++)
+		{
+			for(int y = 0; y < v_tiles; y++)
+			{
+				source.RawBlit(Vector2i(_tiles.left, _tiles.top), Vector2i(src_middle_w, src_middle_h), Vector2i(_tiles.left + x * src_middle_w, _tiles.top + y * src_middle_h), back_rect);
+			}
+		}
+		for(int x = 0; x < h_tiles; x++)
+		{
+			source.RawBlit(Vector2i(_tiles.left, _tiles.top), Vector2i(src_middle_w, v_remainder), Vector2i(_tiles.left + x * src_middle_w, _tiles.top + v_tiles * src_middle_h), back_rect);
+		}
+		for(int y = 0; y < v_tiles; y++)
+		{
+			source.RawBlit(Vector2i(_tiles.left, _tiles.top), Vector2i(h_remainder, src_middle_h), Vector2i(_tiles.left + h_tiles * src_middle_w, _tiles.top + y * src_middle_h), back_rect);
+		}
+		source.RawBlit(Vector2i(_tiles.left, _tiles.top), Vector2i(h_remainder, v_remainder), Vector2i(_tiles.left + h_tiles * src_middle_w, _tiles.top + v_tiles * src_middle_h), back_rect);
+	}
+
+	if(!source.GetError())
+		back_rect->ShareAs(key);
+	return back_rect;
+}
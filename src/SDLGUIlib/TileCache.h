@@ -0,0 +1,19 @@
+#pragma once
+#include <string>
+#include "Tiling.h"
+
+class BlittableRect;
+
+/* Composes tiled backgrounds and memoises the results in ImageCache, keyed by the full
+   tile specification. Identical specifications get rects sharing one copy on write surface */
+class TileCache
+{
+public:
+	static BlittableRect* Compose(VerticalTile _tiles, int _height);
+	static BlittableRect* Compose(HorizontalTile _tiles, int _width);
+	static BlittableRect* Compose(NinePatch _tiles, int _width, int _height);
+
+	static std::string MakeKey(VerticalTile _tiles, int _height);
+	static std::string MakeKey(HorizontalTile _tiles, int _width);
+	static std::string MakeKey(NinePatch _tiles, int _width, int _height);
+};
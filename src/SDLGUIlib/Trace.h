@@ -0,0 +1,52 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+/* Timeline of what each thread was doing over a range of frames, written as Chrome trace-event
+   JSON for chrome://tracing or Perfetto. Events go into a buffer of fixed size claimed when
+   recording starts, any thread may add them without locking, and ones that don't fit are counted
+   and dropped. While not recording a TraceScope costs a flag test */
+class Trace
+{
+private:
+	static volatile bool recording_;
+
+public:
+	/* Records frames _first to _first + _frames - 1, counting the frame being drawn now as 0,
+	   then writes them to _filename. Keeps at most _capacity events */
+	static void Start(unsigned int _first, unsigned int _frames, const std::string& _filename, unsigned int _capacity);
+	/* Call once a frame, after it's on screen. Writes the file once the range is over */
+	static void EndFrame();
+	/* Writes what has been recorded if the range isn't over yet, e.g. on exit */
+	static void Finish();
+
+	static bool IsRecording(){return recording_;}
+	/* _name must outlive the trace, e.g. a literal. _detail is copied, NULL for none */
+	static void Record(const char* _name, const char* _detail, double _start, double _end);
+	/* Seconds on the clock events are timed by */
+	static double Now();
+
+	static unsigned int GetRecorded();
+	static unsigned int GetDropped();
+};
+
+/* One event from construction to destruction, if recording when constructed */
+class TraceScope
+{
+private:
+	const char* name_;
+	const char* detail_;
+	double start_;
+
+	TraceScope(const TraceScope&);
+	TraceScope& operator=(const TraceScope&);
+
+public:
+	explicit TraceScope(const char* _name, const char* _detail = NULL)
+	: name_(_name), detail_(_detail), start_(Trace::IsRecording() ? Trace::Now() : -1){}
+	~TraceScope()
+	{
+		if(start_ >= 0)
+			Trace::Record(name_, detail_, start_, Trace::Now());
+	}
+};
@@ -0,0 +1,52 @@
+#pragma once
+#include <SDL_mutex.h>
+#include <algorithm>
+
+/* Passes the latest of a stream of values from one thread to another without either waiting
+   on the other. The writer fills GetWriteBuffer and publishes it; the reader takes whatever
+   was published most recently, skipping any it didn't get to. The lock only covers swapping
+   slot indices, never copying a value */
+template<typename T>
+class TripleBuffer
+{
+private:
+	T slots_[3];
+	int write_;
+	int ready_;
+	int read_;
+	bool fresh_;	//ready_ holds a value the reader hasn't taken
+	SDL_mutex* mutex_;
+
+	TripleBuffer(const TripleBuffer&);
+	TripleBuffer& operator=(const TripleBuffer&);
+
+public:
+	TripleBuffer() : write_(0), ready_(1), read_(2), fresh_(false), mutex_(SDL_CreateMutex()){}
+	~TripleBuffer(){SDL_DestroyMutex(mutex_);}
+
+	/* Writer only. Still holds what was written to it two publishes ago */
+	T& GetWriteBuffer(){return slots_[write_];}
+	void Publish()
+	{
+		SDL_mutexP(mutex_);
+		std::swap(write_, ready_);
+		fresh_ = true;
+		SDL_mutexV(mutex_);
+	}
+
+	/* Reader only. Moves the latest published value into the read buffer, false if nothing new was published */
+	bool Acquire()
+	{
+		bool acquired = false;
+		SDL_mutexP(mutex_);
+		if(fresh_)
+		{
+			std::swap(read_, ready_);
+			fresh_ = false;
+			acquired = true;
+		}
+		SDL_mutexV(mutex_);
+		return acquired;
+	}
+	const T& GetReadBuffer() const {return slots_[read_];}
+};
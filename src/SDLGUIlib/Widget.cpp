@@ -1,5 +1,8 @@
 #include "Logger.h"
 #include "Widget.h"
+#include "TileCache.h"
+#include "Trace.h"
+#include "AllocationTracker.h"
 #include <algorithm>
 #include "vmath-collisions.h"
 
@@ -10,6 +13,10 @@ Widget* Widget::widget_with_drag_ = NULL;
 Widget* Widget::widget_with_modal_ = NULL;
 Widget* Widget::widget_with_edit_ = NULL;
 bool Widget::event_lock_ = false;
+bool Widget::deferred_changes_ = false;
+bool Widget::root_unsorted_ = false;
+WidgetGrid Widget::hit_grid_;
+unsigned int Widget::next_sequence_ = 0;
 Widget::KeyEvent Widget::OnGlobalKeyUp;
 Widget::MouseEvent Widget::OnGlobalMouseMove;
 Widget::MouseEvent Widget::OnGlobalMouseUp;
@@ -27,6 +34,10 @@ BlittableRect* Widget::screen_fade_rect_ = NULL;
 BlittableRect* Widget::edit_cursor_rect_ = NULL;
 BlittableRect* Widget::mouse_cursor_rect_ = NULL;
 double Widget::sum_time_ = 0;
+unsigned int Widget::pixels_composed_ = 0;
+unsigned int Widget::frame_pixels_composed_ = 0;
+unsigned int Widget::frame_ = 0;
+Widget::BackingStoreEvictor Widget::evictor_;
 
 Vector2i Widget::mouse_position_ = Vector2i(0, 0);
 bool Widget::cursor_enabled_ = true;
@@ -48,8 +59,9 @@ Widget::Widget(void)
 {
 	position_ = Vector2i(0, 0);
 	size_ = Vector2i(128, 48);
-	blit_rect_ = new BlittableRect(size_);
-	back_rect_ = new BlittableRect(size_);
+	//No pixels of its own, so it composes solid black unless transparent_ is set. The front buffer is made on the first redraw
+	blit_rect_ = NULL;
+	back_rect_ = NULL;
 	left_link_ = NULL;
 	right_link_ = NULL;
 	up_link_ = NULL;
@@ -60,12 +72,17 @@ Widget::Widget(void)
 	down_inner_link_ = NULL;
 	parent_ = NULL;
 	invalidated_ = true;
+	children_unsorted_ = false;
+	opaque_ = false;
+	transparent_ = false;
 	rejects_focus_ = false;
 	hides_highlight_ = false;
 	allow_drag_ = false;
 	depressed_ = false;
 	ignore_dest_transparency_ = false;
 	visible_ = true;
+	hidden_since_ = 0;
+	hidden_stamp_ = 0;
 	allow_edit_ = false;
 	z_order_ = 0;
 	deletion_due_ = false;
@@ -77,16 +94,19 @@ Widget::Widget(void)
 	{
 		root_.push_back(this);
 		all_.push_back(this);
+		root_unsorted_ = true;
 	}
+	sequence_ = next_sequence_++;
+	UpdateHitArea();
 }
 
 Widget::Widget(std::string _filename)
 {
 	position_ = Vector2i(0, 0);
 	back_rect_ = new BlittableRect(_filename);
-	blit_rect_ = new BlittableRect(back_rect_->GetSize());
+	blit_rect_ = NULL;
 	
-	size_ = blit_rect_->GetSize();
+	size_ = back_rect_->GetSize();
 	left_link_ = NULL;
 	right_link_ = NULL;
 	up_link_ = NULL;
@@ -97,12 +117,17 @@ Widget::Widget(std::string _filename)
 	down_inner_link_ = NULL;
 	parent_ = NULL;
 	invalidated_ = true;
+	children_unsorted_ = false;
+	opaque_ = false;
+	transparent_ = false;
 	rejects_focus_ = false;
 	hides_highlight_ = false;
 	allow_drag_ = false;
 	depressed_ = false;
 	ignore_dest_transparency_ = false;
 	visible_ = true;
+	hidden_since_ = 0;
+	hidden_stamp_ = 0;
 	allow_edit_ = false;
 	z_order_ = 0;
 	deletion_due_ = false;
@@ -114,16 +139,19 @@ Widget::Widget(std::string _filename)
 	{
 		root_.push_back(this);
 		all_.push_back(this);
+		root_unsorted_ = true;
 	}
+	sequence_ = next_sequence_++;
+	UpdateHitArea();
 }
 
 Widget::Widget(BlittableRect* _blittable)
 {	
 	position_ = Vector2i(0, 0);
 	back_rect_ = _blittable;
-	blit_rect_ = new BlittableRect(back_rect_->GetSize());
+	blit_rect_ = NULL;
 	
-	size_ = blit_rect_->GetSize();
+	size_ = back_rect_->GetSize();
 	left_link_ = NULL;
 	right_link_ = NULL;
 	up_link_ = NULL;
@@ -134,12 +162,17 @@ Widget::Widget(BlittableRect* _blittable)
 	down_inner_link_ = NULL;
 	parent_ = NULL;
 	invalidated_ = true;
+	children_unsorted_ = false;
+	opaque_ = false;
+	transparent_ = false;
 	rejects_focus_ = false;
 	hides_highlight_ = false;
 	allow_drag_ = false;
 	depressed_ = false;
 	ignore_dest_transparency_ = false;
 	visible_ = true;
+	hidden_since_ = 0;
+	hidden_stamp_ = 0;
 	allow_edit_ = false;
 	z_order_ = 0;
 	deletion_due_ = false;
@@ -151,29 +184,18 @@ Widget::Widget(BlittableRect* _blittable)
 	{
 		root_.push_back(this);
 		all_.push_back(this);
+		root_unsorted_ = true;
 	}
+	sequence_ = next_sequence_++;
+	UpdateHitArea();
 }
 
 Widget::Widget(VerticalTile _tiles, int _height)
 {
-	//Width is taken from top tile
-	BlittableRect toptile(_tiles.top);
-	BlittableRect middletile(_tiles.middle);
-	BlittableRect bottomtile(_tiles.bottom);
-
 	position_ = Vector2i(0, 0);
-	size_ = Vector2i(toptile.GetSize().x, _height);
-	blit_rect_ = new BlittableRect(size_);
-	back_rect_ = new BlittableRect(size_);
-
-	back_rect_->Fill(0, 0, 0, 0);
-	toptile.RawBlit(Vector2i(0,0), back_rect_);
-	int center_reps = static_cast<int>(ceil(static_cast<double>(back_rect_->GetSize().y - toptile.GetSize().y - bottomtile.GetSize().y) / static_cast<double>(middletile.GetSize().y)));
-	for(int i = 0; i < center_reps; i++)
-	{
-		middletile.RawBlit(Vector2i(0, i * middletile.GetSize().y + toptile.GetSize().y), back_rect_);
-	}
-	bottomtile.RawBlit(Vector2i(0, back_rect_->GetSize().y - bottomtile.GetSize().y), back_rect_);
+	back_rect_ = TileCache::Compose(_tiles, _height);
+	size_ = back_rect_->GetSize();
+	blit_rect_ = NULL;
 
 	left_link_ = NULL;
 	right_link_ = NULL;
@@ -185,12 +207,17 @@ Widget::Widget(VerticalTile _tiles, int _height)
 	down_inner_link_ = NULL;
 	parent_ = NULL;
 	invalidated_ = true;
+	children_unsorted_ = false;
+	opaque_ = false;
+	transparent_ = false;
 	rejects_focus_ = false;
 	hides_highlight_ = false;
 	allow_drag_ = false;
 	depressed_ = false;
 	ignore_dest_transparency_ = false;
 	visible_ = true;
+	hidden_since_ = 0;
+	hidden_stamp_ = 0;
 	allow_edit_ = false;
 	z_order_ = 0;
 	deletion_due_ = false;
@@ -202,29 +229,18 @@ Widget::Widget(VerticalTile _tiles, int _height)
 	{
 		root_.push_back(this);
 		all_.push_back(this);
+		root_unsorted_ = true;
 	}
+	sequence_ = next_sequence_++;
+	UpdateHitArea();
 }
 
 Widget::Widget(HorizontalTile _tiles, int _width)
 {
-	//Height is taken from left tile
-	BlittableRect lefttile(_tiles.left);
-	BlittableRect middletile(_tiles.middle);
-	BlittableRect righttile(_tiles.right);
-
 	position_ = Vector2i(0, 0);
-	size_ = Vector2i(_width, lefttile.GetSize().y);
-	blit_rect_ = new BlittableRect(size_);
-	back_rect_ = new BlittableRect(size_);
-
-	back_rect_->Fill(0, 0, 0, 0);
-	lefttile.RawBlit(Vector2i(0,0), back_rect_);
-	int center_reps = static_cast<int>(ceil(static_cast<double>(back_rect_->GetSize().x - lefttile.GetSize().x - righttile.GetSize().x) / static_cast<double>(middletile.GetSize().x)));
-	for(int i = 0; i < center_reps; i++)
-	{
-		middletile.RawBlit(Vector2i(i * middletile.GetSize().x + lefttile.GetSize().x, 0), back_rect_);
-	}
-	righttile.RawBlit(Vector2i(back_rect_->GetSize().x - righttile.GetSize().x, 0), back_rect_);
+	back_rect_ = TileCache::Compose(_tiles, _width);
+	size_ = back_rect_->GetSize();
+	blit_rect_ = NULL;
 
 	left_link_ = NULL;
 	right_link_ = NULL;
@@ -236,12 +252,17 @@ Widget::Widget(HorizontalTile _tiles, int _width)
 	down_inner_link_ = NULL;
 	parent_ = NULL;
 	invalidated_ = true;
+	children_unsorted_ = false;
+	opaque_ = false;
+	transparent_ = false;
 	rejects_focus_ = false;
 	hides_highlight_ = false;
 	allow_drag_ = false;
 	depressed_ = false;
 	ignore_dest_transparency_ = false;
 	visible_ = true;
+	hidden_since_ = 0;
+	hidden_stamp_ = 0;
 	allow_edit_ = false;
 	z_order_ = 0;
 	deletion_due_ = false;
@@ -254,82 +275,18 @@ Widget::Widget(HorizontalTile _tiles, int _width)
 	{
 		root_.push_back(this);
 		all_.push_back(this);
+		root_unsorted_ = true;
 	}
+	sequence_ = next_sequence_++;
+	UpdateHitArea();
 }
 
 Widget::Widget(NinePatch _tiles, int _width, int _height)
 {
-	//Height is taken from left tile
-	BlittableRect source(_tiles.image);
-
 	position_ = Vector2i(0, 0);
 	size_ = Vector2i(_width, _height);
-	blit_rect_ = new BlittableRect(size_);
-	back_rect_ = new BlittableRect(size_);
-
-	back_rect_->Fill(0, 0, 0, 0);
-
-	int src_middle_w = source.GetSize().x - _tiles.left - _tiles.right;
-	int src_middle_h = source.GetSize().y - _tiles.top - _tiles.bottom;
-
-	//Top left
-	source.RawBlit(Vector2i(0, 0), Vector2i(_tiles.left, _tiles.top), Vector2i(0, 0), back_rect_);
-
-	//Top right
-	source.RawBlit(Vector2i(source.GetSize().x - _tiles.right, 0), Vector2i(_tiles.right, _tiles.top), Vector2i(size_.x - _tiles.right, 0), back_rect_);
-
-	//Bottom left
-	source.RawBlit(Vector2i(0, source.GetSize().y - _tiles.bottom), Vector2i(_tiles.left, _tiles.bottom), Vector2i(0, size_.y - _tiles.bottom), back_rect_);
-
-	//Bottom right
-	source.RawBlit(Vector2i(source.GetSize().x - _tiles.right, source.GetSize().y - _tiles.bottom), Vector2i(_tiles.right, _tiles.bottom), Vector2i(size_.x - _tiles.right, size_.y - _tiles.bottom), back_rect_);
-	
-	//Top & bottom
-	int h_tiles = (size_.x - _tiles.left - _tiles.right) / src_middle_w;
-	int h_remainder = (size_.x - _tiles.left - _tiles.right) - h_tiles * src_middle_w;
-	for(int x = 0; x < h_tiles; x++)
-	{
-		source.RawBlit(Vector2i(_tiles.left, 0), Vector2i(source.GetSize().x - _tiles.left - _tiles.right, _tiles.top), Vector2i(_tiles.left + x * src_middle_w, 0), back_rect_);
-		source.RawBlit(Vector2i(_tiles.left, source.GetSize().y - _tiles.bottom), Vector2i(source.GetSize().x - _tiles.left - _tiles.right, _tiles.bottom), Vector2i(_tiles.left + x * src_middle_w, size_.y - _tiles.bottom), back_rect_);
-	}
-	if(h_remainder > 0)
-	{
-		source.RawBlit(Vector2i(_tiles.left, 0), Vector2i(h_remainder, _tiles.top), Vector2i(_tiles.left + h_tiles * src_middle_w, 0), back_rect_);
-		source.RawBlit(Vector2i(_tiles.left, source.GetSize().y - _tiles.bottom), Vector2i(h_remainder, _tiles.bottom), Vector2i(_tiles.left + h_tiles * src_middle_w, size_.y - _tiles.bottom), back_rect_);
-	}
-
-	//Left & right
-	int v_tiles = (size_.y - _tiles.top- _tiles.bottom) / src_middle_h;
-	int v_remainder = (size_.y - _tiles.top - _tiles.bottom) - v_tiles * src_middle_h;
-	for(int y = 0; y < v_tiles; y++)
-	{
-		source.RawBlit(Vector2i(0, _tiles.top), Vector2i(_tiles.left, src_middle_h), Vector2i(0, _tiles.top + y * src_middle_h), back_rect_);
-		source.RawBlit(Vector2i(source.GetSize().x - _tiles.right, _tiles.top), Vector2i(_tiles.right, src_middle_h), Vector2i(size_.x - _tiles.right, _tiles.top + y * src_middle_h), back_rect_);
-	}
-	if(v_remainder > 0)
-	{
-		source.RawBlit(Vector2i(0, _tiles.top), Vector2i(_tiles.left, v_remainder), Vector2i(0, _tiles.top + v_tiles * src_middle_h), back_rect_);
-		source.RawBlit(Vector2i(source.GetSize().x - _tiles.right, _tiles.top), Vector2i(_tiles.right, v_remainder), Vector2i(size_.x - _tiles.right, _tiles.top + v_tiles * src_middle_h), back_rect_);
-	}
-
-	//Fill centre
-	for(int x = 0; x < h_tiles; x++)
-	{
-		for(int y = 0; y < v_tiles; y++)
-		{
-			source.RawBlit(Vector2i(_tiles.left, _tiles.top), Vector2i(src_middle_w, src_middle_h), Vector2i(_tiles.left + x * src_middle_w, _tiles.top + y * src_middle_h), back_rect_);
-		}
-	}
-	for(int x = 0; x < h_tiles; x++)
-	{
-		source.RawBlit(Vector2i(_tiles.left, _tiles.top), Vector2i(src_middle_w, v_remainder), Vector2i(_tiles.left + x * src_middle_w, _tiles.top + v_tiles * src_middle_h), back_rect_);
-	}
-	for(int y = 0; y < v_tiles; y++)
-	{
-		source.RawBlit(Vector2i(_tiles.left, _tiles.top), Vector2i(h_remainder, src_middle_h), Vector2i(_tiles.left + h_tiles * src_middle_w, _tiles.top + y * src_middle_h), back_rect_);
-	}
-	source.RawBlit(Vector2i(_tiles.left, _tiles.top), Vector2i(h_remainder, v_remainder), Vector2i(_tiles.left + h_tiles * src_middle_w, _tiles.top + v_tiles * src_middle_h), back_rect_);
-
+	back_rect_ = TileCache::Compose(_tiles, _width, _height);
+	blit_rect_ = NULL;
 
 	left_link_ = NULL;
 	right_link_ = NULL;
@@ -341,12 +298,17 @@ Widget::Widget(NinePatch _tiles, int _width, int _height)
 	down_inner_link_ = NULL;
 	parent_ = NULL;
 	invalidated_ = true;
+	children_unsorted_ = false;
+	opaque_ = false;
+	transparent_ = false;
 	rejects_focus_ = false;
 	hides_highlight_ = false;
 	allow_drag_ = false;
 	depressed_ = false;
 	ignore_dest_transparency_ = false;
 	visible_ = true;
+	hidden_since_ = 0;
+	hidden_stamp_ = 0;
 	allow_edit_ = false;
 	z_order_ = 0;
 	deletion_due_ = false;
@@ -359,11 +321,15 @@ Widget::Widget(NinePatch _tiles, int _width, int _height)
 	{
 		root_.push_back(this);
 		all_.push_back(this);
+		root_unsorted_ = true;
 	}
+	sequence_ = next_sequence_++;
+	UpdateHitArea();
 }
 
 Widget::~Widget(void)
 {
+	hit_grid_.Remove(this);
 	root_.erase(std::remove(root_.begin(), root_.end(), this), root_.end());
 	all_.erase(std::remove(all_.begin(), all_.end(), this), all_.end());
 	pending_root_.erase(std::remove(pending_root_.begin(), pending_root_.end(), this), pending_root_.end());
@@ -388,7 +354,7 @@ Widget::~Widget(void)
 	if(widget_with_drag_ == this)
 		widget_with_drag_ = NULL;
 	
-	delete blit_rect_;
+	ReleaseBackingStore(false);
 	delete back_rect_;
 }
 /* Complicated delete setup deserves an explanatory note.
@@ -401,6 +367,7 @@ void Widget::Delete()
 	if(event_lock_)
 	{
 		deletion_due_ = true;
+		deferred_changes_ = true;
 	} else
 	{
 		if(parent_)
@@ -428,13 +395,16 @@ void Widget::AddChild(Widget* _widget)
 	{
 		pending_root_.erase(std::remove(pending_root_.begin(), pending_root_.end(), _widget), pending_root_.end());
 		pending_children_.push_back(_widget);
+		deferred_changes_ = true;
 	} else
 	{
 		root_.erase(std::remove(root_.begin(), root_.end(), _widget), root_.end());
 		children_.push_back(_widget);
 		_widget->SetParent(this);
+		children_unsorted_ = true;
 	}
-	Invalidate();
+	_widget->sequence_ = next_sequence_++;
+	Damage(_widget->position_, _widget->size_);
 }
 
 /* Limitation, can only erase pending children while locked */
@@ -446,12 +416,16 @@ void Widget::RemoveChild(Widget* _widget)
 		pending_root_.push_back(_widget);
 		//pending_children_.erase(std::remove(pending_children_.begin(), pending_children_.end(), _widget), pending_children_.end());
 		pending_removal_children_.push_back(_widget);
+		deferred_changes_ = true;
 	} else
 	{
 		root_.push_back(_widget);
+		root_unsorted_ = true;
 		children_.erase(std::remove(children_.begin(), children_.end(), _widget), children_.end());
+		_widget->SetParent(NULL);
 	}	
-	Invalidate();
+	_widget->sequence_ = next_sequence_++;
+	Damage(_widget->position_, _widget->size_);
 }
 
 void Widget::ClearChildren()
@@ -469,17 +443,143 @@ void Widget::ClearChildren()
 
 void Widget::SetSize(Vector2i _size)
 {
-	delete blit_rect_;
+	if(parent_ && visible_)
+		parent_->Damage(position_, size_);
+	ReleaseBackingStore(false);
 	size_ = _size;
-	blit_rect_ = new BlittableRect(size_);
+	UpdateHitArea();
 	Invalidate();
 }
 
 void Widget::SetPosition(Vector2i _position)
 {
+	if(_position == position_)
+		return;
+	//Uncover where the widget was, and cover where it's going
+	if(parent_ && visible_)
+		parent_->Damage(position_, size_);
 	position_ = _position;
+	UpdateHitArea();
+	if(parent_ && visible_)
+		parent_->Damage(position_, size_);
+}
+
+void Widget::SetParent(Widget* _widget)
+{
+	parent_ = _widget;
+	UpdateHitArea();
+}
+
+void Widget::UpdateHitArea()
+{
+	global_position_ = parent_ ? parent_->global_position_ + position_ : position_;
+	hit_grid_.Update(this, DamageRect(global_position_, size_));
+	for(vector<Widget*>::iterator it = children_.begin(); it != children_.end(); ++it)
+	{
+		(*it)->UpdateHitArea();
+	}
+}
+
+void Widget::SetZOrder(int _z_order)
+{
+	if(_z_order == z_order_)
+		return;
+	z_order_ = _z_order;
+	if(parent_)
+	{
+		parent_->children_unsorted_ = true;
+		if(visible_)
+			parent_->Damage(position_, size_);
+	} else
+		root_unsorted_ = true;
+}
+
+void Widget::SetVisibility(bool _visibility)
+{
+	if(_visibility == visible_)
+		return;
+	visible_ = _visibility;
+	if(!visible_)
+	{
+		hidden_since_ = frame_;
+		hidden_stamp_ = SurfaceBudget::Instance().Touch();
+	}
 	if(parent_)
-		parent_->Invalidate();
+		parent_->Damage(position_, size_);
+}
+
+void Widget::AllocateBackingStore()
+{
+	if(blit_rect_)
+		return;
+	blit_rect_ = new BlittableRect(size_);
+	blit_rect_->SetCategory(SurfaceCategory::BackingStore);
+	invalidated_ = true;
+}
+
+void Widget::ReleaseBackingStore(bool _children)
+{
+	if(blit_rect_)
+	{
+		delete blit_rect_;
+		blit_rect_ = NULL;
+		invalidated_ = true;
+	}
+	if(_children)
+	{
+		for(vector<Widget*>::iterator it = children_.begin(); it != children_.end(); ++it)
+		{
+			(*it)->ReleaseBackingStore(true);
+		}
+	}
+}
+
+/* Front buffers of widgets hidden for a while are freed, along with those of their children.
+   They are made again on the first redraw after the widget is shown */
+void Widget::ReleaseHiddenBackingStores()
+{
+	for(vector<Widget*>::iterator it = all_.begin(); it != all_.end(); ++it)
+	{
+		if(!(*it)->visible_ && frame_ - (*it)->hidden_since_ >= release_hidden_frames)
+			(*it)->ReleaseBackingStore(true);
+	}
+}
+
+Widget::BackingStoreEvictor::BackingStoreEvictor()
+{
+	SurfaceBudget::Instance().Register(this);
+}
+
+Widget::BackingStoreEvictor::~BackingStoreEvictor()
+{
+	SurfaceBudget::Instance().Unregister(this);
+}
+
+Widget* Widget::BackingStoreEvictor::Oldest()
+{
+	Widget* oldest = NULL;
+	for(vector<Widget*>::iterator it = all_.begin(); it != all_.end(); ++it)
+	{
+		if(!(*it)->visible_ && (*it)->blit_rect_ && (!oldest || (*it)->hidden_stamp_ < oldest->hidden_stamp_))
+			oldest = *it;
+	}
+	return oldest;
+}
+
+bool Widget::BackingStoreEvictor::GetOldest(unsigned int& _last_used)
+{
+	Widget* oldest = Oldest();
+	if(!oldest)
+		return false;
+	_last_used = oldest->hidden_stamp_;
+	return true;
+}
+
+void Widget::BackingStoreEvictor::EvictOldest()
+{
+	Widget* oldest = Oldest();
+	if(oldest)
+		oldest->ReleaseBackingStore(true);
 }
 
 Widget* Widget::GetLeftParentLink()
@@ -534,6 +634,16 @@ Widget* Widget::GetDownParentLink()
 	return NULL;
 }
 
+void Widget::SortChildren()
+{
+	//Children only need sorting after one is added or changes z order
+	if(children_unsorted_)
+	{
+		std::stable_sort(children_.begin(), children_.end(), WidgetZSort<Widget*>());
+		children_unsorted_ = false;
+	}
+}
+
 void Widget::HandleEvent(Event _event)
 {
 	/* Mouse clicks */
@@ -542,8 +652,12 @@ void Widget::HandleEvent(Event _event)
 	{
 		if(_event.event_type == EventType::MouseUp || _event.event_type == EventType::MouseDown || _event.event_type == EventType::MouseMove)
 		{
-			for(vector<Widget*>::iterator it = children_.begin(); it != children_.end(); ++it)
+			//Topmost child first, as they're drawn. The order may be stale if z changed since the last redraw
+			SortChildren();
+			for(vector<Widget*>::reverse_iterator it = children_.rbegin(); it != children_.rend(); ++it)
 			{
+				if(!(*it)->visible_)
+					continue;
 				//Transform event to child frame
 				Event transformed_event = _event;
 				transformed_event.event.mouse_event.x -= (*it)->GetPosition().x;
@@ -555,73 +669,8 @@ void Widget::HandleEvent(Event _event)
 				}
 			}
 		}
-		if((!Widget::GetModalWidget() || HasOrInheritsModal()))
-		{
-			//No children consumed event, so parent consumes it 
-			if(_event.event_type == EventType::MouseDown && _event.event.mouse_event.btns == MouseButton::Left)
-			{
-				if(_event.event.mouse_event.x < size_.x && _event.event.mouse_event.x >= 0 &&
-				   _event.event.mouse_event.y < size_.y && _event.event.mouse_event.y >= 0)
-				{
-					SetDepresssed(true);
-				}
-			}
-			if(_event.event_type == EventType::MouseUp && _event.event.mouse_event.btns == MouseButton::Left)
-			{
-				if(_event.event.mouse_event.x < size_.x && _event.event.mouse_event.x >= 0 &&
-				   _event.event.mouse_event.y < size_.y && _event.event.mouse_event.y >= 0)
-				{
-					if(HasFocus())
-					{
-						OnFocusedClick(this);
-					}
-					SetDepresssed(false);
-					SetFocus();
-					OnClick(this);
-					if(allow_edit_)
-					{
-						if(HasEditting())
-						{
-							SetEditting(false);
-						} else
-						{
-							SetEditting(true);
-						}
-
-					}
-				}
-			}
-			//All mouse buttons fire mouse click events, but only left gains focus
-			if(_event.event_type == EventType::MouseUp && _event.event.mouse_event.btns != MouseButton::None)
-			{
-				if(_event.event.mouse_event.x < size_.x && _event.event.mouse_event.x >= 0 &&
-				   _event.event.mouse_event.y < size_.y && _event.event.mouse_event.y >= 0)
-				{
-					MouseEventArgs e;
-					e.x = _event.event.mouse_event.x;
-					e.y = _event.event.mouse_event.y;
-					e.btns = _event.event.mouse_event.btns;
-					OnMouseClick(this, e);
-				}
-			}
-
-			if(_event.event_type == EventType::MouseMove)
-			{
-				if(_event.event.mouse_event.x < size_.x && _event.event.mouse_event.x >= 0 &&
-				   _event.event.mouse_event.y < size_.y && _event.event.mouse_event.y >= 0)
-				{
-					MouseEventArgs e;
-					e.x = _event.event.mouse_event.x;
-					e.y = _event.event.mouse_event.y;
-					e.btns = _event.event.mouse_event.btns;
-					OnMouseMove(this, e);
-					SetHighlight();
-					/* Handle start of drag and drop*/
-					
-				}				
-			}
-		}
-
+		//No children consumed event, so parent consumes it 
+		ConsumeMouseEvent(_event);
 	}
 	/* Keyboard navigation */
 	if(_event.event_type == EventType::KeyLeft && !_event.event.key_event.key_up)
@@ -709,22 +758,89 @@ void Widget::HandleEvent(Event _event)
 				nc = static_cast<char>(_event.event.key_event.key_code + ((!_event.event.key_event.shift) ? 32 : 0));
 			if(_event.event.key_event.key_code >= 97 && _event.event.key_event.key_code <= 122)
 				nc = static_cast<char>(_event.event.key_event.key_code + (_event.event.key_event.shift ? -32 : 0));
-			std::string cur_text = widget_text_.GetText();
-			cur_text = cur_text + nc;
-			widget_text_.SetText(cur_text);
+			widget_text_.Insert(widget_text_.GetLength(), std::string(1, nc));
 			Invalidate();
 		}
 		if(_event.event.key_event.key_code == 8) //Backspace
 		{
-			if(widget_text_.GetText().length() > 0)
+			if(widget_text_.GetLength() > 0)
 			{
-				widget_text_.SetText(widget_text_.GetText().substr(0, widget_text_.GetText().length() - 1));
+				widget_text_.Erase(widget_text_.GetLength() - 1, 1);
 				Invalidate();
 			}
 		}
 	}
 }
 
+/* Mouse handling for the widget itself, once it's known none of its children are under the mouse */
+void Widget::ConsumeMouseEvent(Event _event)
+{
+	if(Widget::GetModalWidget() && !HasOrInheritsModal())
+		return;
+	if(_event.event_type == EventType::MouseDown && _event.event.mouse_event.btns == MouseButton::Left)
+	{
+		if(_event.event.mouse_event.x < size_.x && _event.event.mouse_event.x >= 0 &&
+		   _event.event.mouse_event.y < size_.y && _event.event.mouse_event.y >= 0)
+		{
+			SetDepresssed(true);
+		}
+	}
+	if(_event.event_type == EventType::MouseUp && _event.event.mouse_event.btns == MouseButton::Left)
+	{
+		if(_event.event.mouse_event.x < size_.x && _event.event.mouse_event.x >= 0 &&
+		   _event.event.mouse_event.y < size_.y && _event.event.mouse_event.y >= 0)
+		{
+			if(HasFocus())
+			{
+				OnFocusedClick(this);
+			}
+			SetDepresssed(false);
+			SetFocus();
+			OnClick(this);
+			if(allow_edit_)
+			{
+				if(HasEditting())
+				{
+					SetEditting(false);
+				} else
+				{
+					SetEditting(true);
+				}
+
+			}
+		}
+	}
+	//All mouse buttons fire mouse click events, but only left gains focus
+	if(_event.event_type == EventType::MouseUp && _event.event.mouse_event.btns != MouseButton::None)
+	{
+		if(_event.event.mouse_event.x < size_.x && _event.event.mouse_event.x >= 0 &&
+		   _event.event.mouse_event.y < size_.y && _event.event.mouse_event.y >= 0)
+		{
+			MouseEventArgs e;
+			e.x = _event.event.mouse_event.x;
+			e.y = _event.event.mouse_event.y;
+			e.btns = _event.event.mouse_event.btns;
+			OnMouseClick(this, e);
+		}
+	}
+
+	if(_event.event_type == EventType::MouseMove)
+	{
+		if(_event.event.mouse_event.x < size_.x && _event.event.mouse_event.x >= 0 &&
+		   _event.event.mouse_event.y < size_.y && _event.event.mouse_event.y >= 0)
+		{
+			MouseEventArgs e;
+			e.x = _event.event.mouse_event.x;
+			e.y = _event.event.mouse_event.y;
+			e.btns = _event.event.mouse_event.btns;
+			OnMouseMove(this, e);
+			SetHighlight();
+			/* Handle start of drag and drop*/
+		
+		}				
+	}
+}
+
 void Widget::SetText(std::string _text, TextAlignment::Enum _alignment)
 {
 	bool change = false;
@@ -750,41 +866,102 @@ void Widget::SetTextWrap(bool _wrap)
 }
 
 
+/* Recomposes the damaged areas of blit_rect_. Children are brought up to date first,
+   then each area is rebuilt from the back rect, text and children clipped to just that area */
 void Widget::Redraw()
 {
-	//Draw self - puts backbuffer onto front buffer. Use raw blit to copy alpha
-	back_rect_->RawBlit(Vector2i(0,0), blit_rect_);
-	//Superimpose text
-	blit_rect_->BlitText(widget_text_);
-	//Do any custom hooked drawing
-	OnDraw(this, blit_rect_);
-
-	if(widget_with_focus_ == this && !hides_highlight_)
-		blit_rect_->Fade(0.35f, 255, 255, 255);
-	if(widget_with_highlight_ == this && !hides_highlight_)
-		blit_rect_->Fade(0.20f, 0, 0, 255);
-	if(GetModalWidget() && !HasOrInheritsModal())
-		blit_rect_->Fade(0.6f, 0, 0, 0);
-	if(widget_with_depression_ == this && !(hides_highlight_ || rejects_focus_))
-		blit_rect_->Fade(0.5f, 255, 255, 255);
-
-	//Sort children by z order
-	std::sort(children_.begin(), children_.end(), WidgetZSort<Widget*>());
-	//Blit in children
+	TraceScope trace("Widget::Redraw", tag_.empty() ? NULL : tag_.c_str());
+	AllocateBackingStore();
+	if(invalidated_)
+	{
+		damage_.Clear();
+		damage_.Add(DamageRect(Vector2i(0, 0), size_));
+	}
+
+	SortChildren();
+
+	DamageRect bounds(Vector2i(0, 0), size_);
 	for(vector<Widget*>::iterator it = children_.begin(); it != children_.end(); ++it)
 	{
-		if((*it)->invalidated_)
+		//Children hidden or outside this widget stay dirty until they can be seen
+		if((*it)->IsDirty() && (*it)->visible_ && bounds.Intersects(DamageRect((*it)->position_, (*it)->size_)))
 			(*it)->Redraw();
-		if((*it)->GetVisibility())
+	}
+
+	const std::vector<DamageRect>& areas = damage_.GetRects();
+	for(std::vector<DamageRect>::const_iterator it = areas.begin(); it != areas.end(); ++it)
+	{
+		Compose(*it);
+	}
+	damage_.Clear();
+	invalidated_ = false;
+}
+
+void Widget::Compose(const DamageRect& _area)
+{
+	//Start from the topmost child hiding the whole area, nothing beneath it can show through
+	vector<Widget*>::iterator first = children_.begin();
+	bool occluded = false;
+	for(vector<Widget*>::reverse_iterator it = children_.rbegin(); it != children_.rend(); ++it)
+	{
+		if((*it)->Covers(_area))
 		{
-			if((*it)->ignore_dest_transparency_)
-			{
-				(*it)->blit_rect_->RawBlit((*it)->GetPosition(), blit_rect_);
-			} else
-				(*it)->blit_rect_->Blit((*it)->GetPosition(), blit_rect_);
+			first = it.base() - 1;
+			occluded = true;
+			break;
 		}
 	}
-	invalidated_ = false;
+
+	blit_rect_->SetClip(_area.position, _area.size);
+	if(!occluded)
+	{
+		//Draw self - puts backbuffer onto front buffer. Use raw blit to copy alpha
+		if(back_rect_)
+			back_rect_->RawBlit(_area.position, _area.size, _area.position, blit_rect_);
+		else if(transparent_)
+			blit_rect_->Fill(0, 0, 0, 0); //Only fills the clipped area
+		else
+			blit_rect_->Fill(255, 0, 0, 0);
+		pixels_composed_ += _area.GetArea();
+		//Superimpose text
+		blit_rect_->BlitText(widget_text_);
+		//Do any custom hooked drawing
+		OnDraw(this, blit_rect_);
+
+		if(widget_with_focus_ == this && !hides_highlight_)
+			blit_rect_->Fade(0.35f, 255, 255, 255);
+		if(widget_with_highlight_ == this && !hides_highlight_)
+			blit_rect_->Fade(0.20f, 0, 0, 255);
+		if(GetModalWidget() && !HasOrInheritsModal())
+			blit_rect_->Fade(0.6f, 0, 0, 0);
+		if(widget_with_depression_ == this && !(hides_highlight_ || rejects_focus_))
+			blit_rect_->Fade(0.5f, 255, 255, 255);
+	}
+
+	//Blit in children
+	for(vector<Widget*>::iterator it = first; it != children_.end(); ++it)
+	{
+		if(!(*it)->visible_ || !(*it)->blit_rect_)
+			continue;
+		DamageRect overlap = _area.Intersection(DamageRect((*it)->position_, (*it)->size_));
+		if(overlap.IsEmpty())
+			continue;
+		if((*it)->ignore_dest_transparency_)
+		{
+			(*it)->blit_rect_->RawBlit((*it)->GetPosition(), blit_rect_);
+		} else
+			(*it)->blit_rect_->Blit((*it)->GetPosition(), blit_rect_);
+		pixels_composed_ += overlap.GetArea();
+	}
+	blit_rect_->ClearClip();
+}
+
+/* Whether drawing this widget replaces every pixel of _area, which is in the parent's coordinates */
+bool Widget::Covers(const DamageRect& _area)
+{
+	if(!visible_ || !(opaque_ || ignore_dest_transparency_))
+		return false;
+	return DamageRect(position_, size_).Contains(_area);
 }
 
 void Widget::SetFocus()
@@ -930,9 +1107,19 @@ bool Widget::HasOrInheritsModal()
 
 void Widget::Invalidate()
 {
-	if(parent_)
-		parent_->Invalidate();
 	invalidated_ = true;
+	Damage(Vector2i(0, 0), size_);
+}
+
+void Widget::Damage(Vector2i _position, Vector2i _size)
+{
+	DamageRect area = DamageRect(_position, _size).Intersection(DamageRect(Vector2i(0, 0), size_));
+	if(area.IsEmpty())
+		return;
+	damage_.Add(area);
+	//A parent only has to recompose the part of itself this widget covers
+	if(parent_ && visible_)
+		parent_->Damage(position_ + area.position, area.size);
 }
 
 void Widget::InsertPending()
@@ -940,9 +1127,13 @@ void Widget::InsertPending()
 	for(vector<Widget*>::iterator it = pending_removal_children_.begin(); it != pending_removal_children_.end(); ++it)
 	{
 		children_.erase(std::remove(children_.begin(), children_.end(), *it), children_.end());
+		if((*it)->parent_ == this)
+			(*it)->SetParent(NULL);
 	}
 	
 	pending_removal_children_.clear();
+	if(!pending_children_.empty())
+		children_unsorted_ = true;
 	children_.insert(children_.end(), pending_children_.begin(), pending_children_.end());
 	for(vector<Widget*>::iterator it = pending_children_.begin(); it != pending_children_.end(); ++it)
 	{
@@ -977,16 +1168,47 @@ void Widget::ClearRoot()
 
 void Widget::RenderRoot(BlittableRect* _screen)
 {
-	std::sort(root_.begin(), root_.end(), WidgetZSort<Widget*>());
-	for(vector<Widget*>::iterator it = root_.begin(); it != root_.end(); ++it)
+	TraceScope trace("Widget::RenderRoot");
+	AllocationScope allocations(AllocationTag::Rendering);
+	pixels_composed_ = 0;
+	if(root_unsorted_)
+	{
+		std::stable_sort(root_.begin(), root_.end(), WidgetZSort<Widget*>());
+		root_unsorted_ = false;
+	}
+
+	//The screen is cleared every frame, so root widgets are always blitted. Skip any beneath an opaque one filling the screen
+	DamageRect screen(Vector2i(0, 0), _screen->GetSize());
+	vector<Widget*>::iterator first = root_.begin();
+	for(vector<Widget*>::reverse_iterator it = root_.rbegin(); it != root_.rend(); ++it)
 	{
-		if((*it)->invalidated_)
+		if((*it)->visible_ && (*it)->opaque_ && DamageRect((*it)->position_, (*it)->size_).Contains(screen))
 		{
-			(*it)->Redraw();
+			first = it.base() - 1;
+			break;
 		}
-		if((*it)->GetVisibility())
-			(*it)->blit_rect_->Blit((*it)->GetPosition(), _screen);
 	}
+	for(vector<Widget*>::iterator it = first; it != root_.end(); ++it)
+	{
+		if(!(*it)->GetVisibility())
+			continue;
+		//Widgets entirely off screen aren't composed, they stay dirty until they move on
+		DamageRect on_screen = screen.Intersection(DamageRect((*it)->position_, (*it)->size_));
+		if(on_screen.IsEmpty())
+			continue;
+		if((*it)->IsDirty())
+		{
+			(*it)->Redraw();
+		}
+		(*it)->blit_rect_->Blit((*it)->GetPosition(), _screen);
+		pixels_composed_ += on_screen.GetArea();
+	}
+	frame_pixels_composed_ = pixels_composed_;
+	frame_++;
+	if(frame_ % release_check_frames == 0)
+		ReleaseHiddenBackingStores();
+	//Between frames nothing holds on to a surface it didn't ask the caches for
+	SurfaceBudget::Instance().Enforce();
 	if(screen_fade_rect_ == NULL || screen_fade_rect_->GetSize() != _screen->GetSize())
 	{
 		delete screen_fade_rect_;
@@ -1007,7 +1229,7 @@ void Widget::RenderRoot(BlittableRect* _screen)
 		mouse_cursor_rect_ = new BlittableRect("Cursor0.png");
 	}
 
-	if(widget_with_edit_)
+	if(widget_with_edit_ && widget_with_edit_->blit_rect_)
 	{
 		if(fmod(sum_time_, 0.5) < 0.25)
 		{
@@ -1022,6 +1244,7 @@ void Widget::RenderRoot(BlittableRect* _screen)
 
 void Widget::DistributeSDLEvents(SDL_Event* event)
 {
+	AllocationScope allocations(AllocationTag::Widgets);
 	event_lock_ = true;
 	Event e;
 	if(event->type == SDL_MOUSEBUTTONUP || event->type == SDL_MOUSEBUTTONDOWN)
@@ -1123,12 +1346,13 @@ void Widget::DistributeSDLEvents(SDL_Event* event)
 
 	if(e.event_type == EventType::MouseUp || e.event_type == EventType::MouseDown)
 	{
-		for(vector<Widget*>::iterator it = root_.begin(); it != root_.end(); ++it)
+		Widget* target = WidgetAt(Vector2i(e.event.mouse_event.x, e.event.mouse_event.y));
+		if(target)
 		{
 			Event e2 = e;
-			e2.event.mouse_event.x -= (*it)->GetPosition().x;
-			e2.event.mouse_event.y -= (*it)->GetPosition().y;
-			(*it)->HandleEvent(e2);
+			e2.event.mouse_event.x -= target->GetGlobalPosition().x;
+			e2.event.mouse_event.y -= target->GetGlobalPosition().y;
+			target->ConsumeMouseEvent(e2);
 		}
 	}
 	
@@ -1156,19 +1380,14 @@ void Widget::DistributeSDLEvents(SDL_Event* event)
 
 	if(e.event_type == EventType::MouseMove)
 	{
-		bool move_handled = false;
-		for(vector<Widget*>::iterator it = all_.begin(); it != all_.end(); ++it)
+		Widget* target = WidgetAt(Vector2i(e.event.mouse_event.x, e.event.mouse_event.y));
+		if(target)
 		{
 			Event e2 = e;
-			e2.event.mouse_event.x -= (*it)->GetGlobalPosition().x;
-			e2.event.mouse_event.y -= (*it)->GetGlobalPosition().y;
-			if(Collisions2i::PointInRectangle(Vector2i(e2.event.mouse_event.x, e2.event.mouse_event.y), Vector2i(0, 0), (*it)->GetSize()))
-			{
-				(*it)->HandleEvent(e2);
-				move_handled = true;
-			}
-		}
-		if(!move_handled && widget_with_highlight_)
+			e2.event.mouse_event.x -= target->GetGlobalPosition().x;
+			e2.event.mouse_event.y -= target->GetGlobalPosition().y;
+			target->ConsumeMouseEvent(e2);
+		} else if(widget_with_highlight_)
 		{
 			widget_with_highlight_->Invalidate();
 			widget_with_highlight_ = NULL;
@@ -1200,6 +1419,39 @@ void Widget::DistributeSDLEvents(SDL_Event* event)
 	RemoveEventLock();
 }
 
+Widget* Widget::WidgetAt(Vector2i _point)
+{
+	//Kept between calls so a mouse move doesn't allocate
+	static vector<Widget*> candidates;
+	candidates.clear();
+	hit_grid_.Query(_point, candidates);
+
+	//Walk down from the topmost root under the point through its topmost child under the point
+	Widget* hit = NULL;
+	bool descended = true;
+	while(descended)
+	{
+		Widget* topmost = NULL;
+		for(vector<Widget*>::iterator it = candidates.begin(); it != candidates.end(); ++it)
+		{
+			if((*it)->parent_ == hit && (*it)->visible_ && (!topmost || (*it)->IsDrawnAbove(topmost)))
+				topmost = *it;
+		}
+		descended = topmost != NULL;
+		if(descended)
+			hit = topmost;
+	}
+	return hit;
+}
+
+bool Widget::IsDrawnAbove(Widget* _sibling)
+{
+	if(z_order_ != _sibling->z_order_)
+		return z_order_ > _sibling->z_order_;
+	//The z sort is stable, so equal z orders are drawn in the order they were added
+	return sequence_ > _sibling->sequence_;
+}
+
 bool Widget::InheritsDeleteDue(Widget* _widget)
 {
 	bool result = false;
@@ -1219,6 +1471,10 @@ bool Widget::InheritsDeleteDue(Widget* _widget)
 void Widget::RemoveEventLock()
 {
 	event_lock_ = false;
+	//Most events change nothing structural, so don't walk every widget for them
+	if(!deferred_changes_ && pending_all_.empty() && pending_root_.empty())
+		return;
+	deferred_changes_ = false;
 
 	/* Merge widgets created during this callback */
 	all_.insert(all_.end(), pending_all_.begin(), pending_all_.end());
@@ -1230,6 +1486,8 @@ void Widget::RemoveEventLock()
 	{
 		(*it)->InsertPending();
 	}	
+	if(!pending_root_.empty())
+		root_unsorted_ = true;
 	root_.insert(root_.end(), pending_root_.begin(), pending_root_.end());
 	pending_root_.clear();
 
@@ -1249,17 +1507,6 @@ void Widget::RemoveEventLock()
 	}
 }
 
-Vector2i Widget::GetGlobalPosition()
-{
-	if(parent_)
-	{
-		return position_ + parent_->GetGlobalPosition();
-	} else
-	{
-		return position_;
-	}
-}
-
 void Widget::SetFade(float _fade_amount)
 {
 	_fade_amount = _fade_amount < 0.0f ? 0.0f : _fade_amount > 1.0f ? 1.0f : _fade_amount;
@@ -1,12 +1,14 @@
 #pragma once
 #include "vmath.h"
 #include <vector>
-#include <boost/signal.hpp>
+#include "Signal.h"
 #include <boost/bind.hpp>
 #include "Event.h"
 #include "WidgetText.h"
 #include "BlittableRect.h"
 #include "Tiling.h"
+#include "DamageRegion.h"
+#include "WidgetGrid.h"
 #include <sdl.h>
 
 //Widgets should not be used on the stack - they are tracked automatically!
@@ -17,6 +19,7 @@ class Widget
 protected:
 	Vector2i position_;
 	Vector2i size_;
+	Vector2i global_position_; //Cached sum of position_ up the parent chain
 	vector<Widget*> children_;
 	vector<Widget*> pending_children_;
 	vector<Widget*> pending_removal_children_;
@@ -29,9 +32,10 @@ protected:
 	Widget* right_inner_link_;
 	Widget* up_inner_link_;
 	Widget* down_inner_link_;
-	BlittableRect* blit_rect_;
-	BlittableRect* back_rect_;
+	BlittableRect* blit_rect_;	//Composed front buffer, NULL until first drawn and after being hidden a while
+	BlittableRect* back_rect_;	//The widget's own pixels, NULL if it has none
 	int z_order_;
+	unsigned int sequence_; //When the widget joined its sibling list, which orders widgets of equal z
 	bool deletion_due_;
 
 	static Widget* widget_with_focus_;
@@ -49,16 +53,26 @@ protected:
 	static vector<Widget*> pending_root_; //Pending version are widgets added by a callback
 	static vector<Widget*> pending_all_;
 	static bool event_lock_;
+	static bool deferred_changes_; //Set when a callback deferred a delete or child change until the lock is removed
+	static bool root_unsorted_; //Set when root_ needs sorting by z order before it's drawn
+	static WidgetGrid hit_grid_; //Screen rects of all widgets, for finding the one under the mouse
+	static unsigned int next_sequence_;
 
 	static Vector2i mouse_position_;
 	static bool cursor_enabled_;
 
-	bool invalidated_;
+	bool invalidated_;		//The widget's own drawing is out of date, not just parts of its children
+	bool children_unsorted_;
+	bool opaque_;			//Every pixel of the widget is solid, so it hides whatever it covers
+	bool transparent_;		//With no pixels of its own, shows what is beneath rather than black
+	DamageRegion damage_;	//Areas of blit_rect_ to recompose on the next Redraw
 	bool rejects_focus_;
 	bool hides_highlight_; //For item browser widget to prevent background turning blue
 	bool allow_drag_;
 	bool depressed_;
 	bool visible_;
+	unsigned int hidden_since_;	//Frame the widget was last hidden on
+	unsigned int hidden_stamp_;	//SurfaceBudget stamp from when the widget was last hidden
 	bool ignore_dest_transparency_;
 	bool allow_edit_;
 
@@ -72,17 +86,46 @@ protected:
 	static Vector2i screen_size_;
 
 	static double sum_time_;
+	static unsigned int pixels_composed_;
+	static unsigned int frame_pixels_composed_;
+	static unsigned int frame_;
+
+	/* Lets SurfaceBudget free the front buffers of hidden widgets, longest hidden first */
+	class BackingStoreEvictor : public SurfaceBudget::Evictable
+	{
+	private:
+		Widget* Oldest();
+	public:
+		BackingStoreEvictor();
+		~BackingStoreEvictor();
+		bool GetOldest(unsigned int& _last_used);
+		void EvictOldest();
+	};
+	static BackingStoreEvictor evictor_;
+
+	void Compose(const DamageRect& _area);
+	/* Stable sorts children_ by z order if one was added or changed z since the last sort */
+	void SortChildren();
+	void AllocateBackingStore();
+	void ReleaseBackingStore(bool _children);
+	static void ReleaseHiddenBackingStores();
+	bool Covers(const DamageRect& _area);
+	/* Recalculates the global position of this widget and its children and moves them in hit_grid_.
+	   Needed after changing position_ or size_ directly */
+	void UpdateHitArea();
+	bool IsDrawnAbove(Widget* _sibling);
+	void ConsumeMouseEvent(Event _event);
 	void InsertPending();
 	void DeleteInternal();
 	static void RemoveEventLock();
 	static bool InheritsDeleteDue(Widget* _widget);
 public:
 	/* Typedefs etc */
-	typedef boost::signal<void (Widget*)> WidgetEvent;
-	typedef boost::signal<void (Widget*, MouseEventArgs)> MouseEvent;
-	typedef boost::signal<void (Widget*, KeyPressEventArgs)> KeyEvent;
-	typedef boost::signal<void (Widget*, DragEventArgs*)> DragEvent;
-	typedef boost::signal<void (Widget*, BlittableRect*)> DrawEvent;
+	typedef Signal<void (Widget*)> WidgetEvent;
+	typedef Signal<void (Widget*, MouseEventArgs)> MouseEvent;
+	typedef Signal<void (Widget*, KeyPressEventArgs)> KeyEvent;
+	typedef Signal<void (Widget*, DragEventArgs*)> DragEvent;
+	typedef Signal<void (Widget*, BlittableRect*)> DrawEvent;
 
 	/* Constructors */
 	Widget(void);
@@ -97,11 +140,11 @@ public:
 
 	/* Getters and setters */
 	Vector2i GetPosition(){return position_;}
-	Vector2i GetGlobalPosition();
+	Vector2i GetGlobalPosition(){return global_position_;}
 	void SetPosition(Vector2i _position);
 	Vector2i GetSize(){return size_;}
 	void SetSize(Vector2i _size);
-	void SetZOrder(int _z_order){z_order_ = _z_order;}
+	void SetZOrder(int _z_order);
 	int GetZOrder(){return z_order_;}
 	void SetTag(std::string _tag){tag_ = _tag;}
 	std::string GetTag(){return tag_;}
@@ -112,7 +155,7 @@ public:
 	void RemoveChild(Widget* _widget);
 	void ClearChildren();
 	/* Parent members */
-	void SetParent(Widget* _widget){parent_ = _widget;}
+	void SetParent(Widget* _widget);
 	Widget* GetParent(){return parent_;}
 
 	/* Signals */
@@ -162,7 +205,7 @@ public:
 
 	/* Visibility */
 	bool GetVisibility(){return visible_;}
-	void SetVisibility(bool _visibility){visible_ = _visibility;}
+	void SetVisibility(bool _visibility);
 
 	/* Focus */
 	bool HasFocus(){return widget_with_focus_ == this;}
@@ -188,6 +231,10 @@ public:
 	/* Drawing and redrawing */
 	void Redraw();
 	void Invalidate();
+	void Damage(Vector2i _position, Vector2i _size); //Recompose just this area of the widget
+	bool IsDirty(){return invalidated_ || !damage_.IsEmpty();}
+	void SetOpaque(bool _opaque){opaque_ = _opaque;}
+	bool GetOpaque(){return opaque_;}
 	void SetText(std::string _text, TextAlignment::Enum _alignment);
 	void SetTextWrap(bool _wrap);
 	BlittableRect* GetBackRect(){return back_rect_;}
@@ -198,7 +245,16 @@ public:
 	static vector<Widget*> GetRoot(){return root_;}
 	static void RenderRoot(BlittableRect* _screen);
 	static void DistributeSDLEvents(SDL_Event* event);
+	/* The visible widget drawn topmost at a screen position, or NULL if there's none */
+	static Widget* WidgetAt(Vector2i _point);
 	static void Tick(float _dt){sum_time_ += _dt;}	
+	/* Pixels copied or blended to compose widgets and put them on screen during the last RenderRoot */
+	static unsigned int GetPixelsComposed(){return frame_pixels_composed_;}
+	/* Memory held by widget front buffers */
+	static unsigned int GetBackingStoreBytes(){return SurfaceBudget::Instance().GetBytes(SurfaceCategory::BackingStore);}
+	/* Hidden widgets give up their front buffers after this many frames, checked every release_check_frames */
+	static const unsigned int release_hidden_frames = 100;
+	static const unsigned int release_check_frames = 25;
 
 	/* Modal widget */
 	static Widget* GetModalWidget(){return widget_with_modal_;}
@@ -0,0 +1,116 @@
+#include "WidgetGrid.h"
+#include <algorithm>
+
+WidgetGrid::WidgetGrid(int _cell_size)
+: cell_size_(_cell_size > 0 ? _cell_size : 64)
+{
+}
+
+int WidgetGrid::CellOf(int _coordinate) const
+{
+	//Round towards negative infinity so cells either side of zero don't overlap
+	if(_coordinate >= 0)
+		return _coordinate / cell_size_;
+	return -((-_coordinate + cell_size_ - 1) / cell_size_);
+}
+
+bool WidgetGrid::IsLarge(const DamageRect& _rect) const
+{
+	int columns = CellOf(_rect.position.x + _rect.size.x - 1) - CellOf(_rect.position.x) + 1;
+	int rows = CellOf(_rect.position.y + _rect.size.y - 1) - CellOf(_rect.position.y) + 1;
+	return columns * rows > max_cells;
+}
+
+void WidgetGrid::Link(Widget* _widget, const DamageRect& _rect)
+{
+	if(_rect.IsEmpty())
+		return;
+	if(IsLarge(_rect))
+	{
+		large_.push_back(Entry(_widget, _rect));
+		return;
+	}
+	int right = CellOf(_rect.position.x + _rect.size.x - 1);
+	int bottom = CellOf(_rect.position.y + _rect.size.y - 1);
+	for(int y = CellOf(_rect.position.y); y <= bottom; y++)
+	{
+		for(int x = CellOf(_rect.position.x); x <= right; x++)
+		{
+			cells_[Cell(x, y)].push_back(Entry(_widget, _rect));
+		}
+	}
+}
+
+void WidgetGrid::Unlink(Widget* _widget, const DamageRect& _rect)
+{
+	if(_rect.IsEmpty())
+		return;
+	if(IsLarge(_rect))
+	{
+		large_.erase(std::remove(large_.begin(), large_.end(), _widget), large_.end());
+		return;
+	}
+	int right = CellOf(_rect.position.x + _rect.size.x - 1);
+	int bottom = CellOf(_rect.position.y + _rect.size.y - 1);
+	for(int y = CellOf(_rect.position.y); y <= bottom; y++)
+	{
+		for(int x = CellOf(_rect.position.x); x <= right; x++)
+		{
+			CellMap::iterator cell = cells_.find(Cell(x, y));
+			if(cell == cells_.end())
+				continue;
+			cell->second.erase(std::remove(cell->second.begin(), cell->second.end(), _widget), cell->second.end());
+			if(cell->second.empty())
+				cells_.erase(cell);
+		}
+	}
+}
+
+void WidgetGrid::Update(Widget* _widget, const DamageRect& _rect)
+{
+	RectMap::iterator it = rects_.find(_widget);
+	if(it != rects_.end())
+	{
+		if(it->second.position == _rect.position && it->second.size == _rect.size)
+			return;
+		Unlink(_widget, it->second);
+		it->second = _rect;
+	} else
+		rects_.insert(RectMap::value_type(_widget, _rect));
+	Link(_widget, _rect);
+}
+
+void WidgetGrid::Remove(Widget* _widget)
+{
+	RectMap::iterator it = rects_.find(_widget);
+	if(it == rects_.end())
+		return;
+	Unlink(_widget, it->second);
+	rects_.erase(it);
+}
+
+void WidgetGrid::Clear()
+{
+	cells_.clear();
+	rects_.clear();
+	large_.clear();
+}
+
+void WidgetGrid::Query(Vector2i _point, std::vector<Widget*>& _found) const
+{
+	DamageRect point(_point, Vector2i(1, 1));
+	CellMap::const_iterator cell = cells_.find(Cell(CellOf(_point.x), CellOf(_point.y)));
+	if(cell != cells_.end())
+	{
+		for(EntryList::const_iterator it = cell->second.begin(); it != cell->second.end(); ++it)
+		{
+			if(it->rect.Contains(point))
+				_found.push_back(it->widget);
+		}
+	}
+	for(EntryList::const_iterator it = large_.begin(); it != large_.end(); ++it)
+	{
+		if(it->rect.Contains(point))
+			_found.push_back(it->widget);
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <map>
+#include <vector>
+#include "DamageRegion.h"
+
+class Widget;
+
+/* Uniform grid over the screen space rects of widgets, so finding the widgets under
+   a point only looks at those sharing its cell rather than every widget.
+   Rects spanning more than max_cells cells are kept in a short list checked by every query */
+class WidgetGrid
+{
+private:
+	struct Entry
+	{
+		Widget* widget;
+		DamageRect rect;
+		Entry(Widget* _widget, const DamageRect& _rect) : widget(_widget), rect(_rect){}
+		bool operator==(const Widget* _widget) const {return widget == _widget;}
+	};
+	typedef std::pair<int, int> Cell;
+	typedef std::vector<Entry> EntryList;
+	typedef std::map<Cell, EntryList> CellMap;
+	typedef std::map<Widget*, DamageRect> RectMap;
+
+	CellMap cells_;
+	RectMap rects_;		//Where each widget was linked, to unlink it again
+	EntryList large_;
+	int cell_size_;
+
+	int CellOf(int _coordinate) const;
+	bool IsLarge(const DamageRect& _rect) const;
+	void Unlink(Widget* _widget, const DamageRect& _rect);
+	void Link(Widget* _widget, const DamageRect& _rect);
+
+public:
+	static const int max_cells = 64;
+
+	explicit WidgetGrid(int _cell_size = 64);
+
+	/* Adds the widget, or moves it if it's already in the grid */
+	void Update(Widget* _widget, const DamageRect& _rect);
+	void Remove(Widget* _widget);
+	void Clear();
+	/* Appends every widget whose rect contains _point to _found, in no particular order */
+	void Query(Vector2i _point, std::vector<Widget*>& _found) const;
+
+	unsigned int GetCount() const {return static_cast<unsigned int>(rects_.size());}
+	int GetCellSize() const {return cell_size_;}
+};
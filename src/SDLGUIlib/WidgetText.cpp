@@ -0,0 +1,148 @@
+#include "Logger.h"
+#include "WidgetText.h"
+
+void WidgetText::LayoutText()
+{
+	text_lines_.clear();
+	paragraphs_.clear();
+	Relayout(0, 0, 0, text_.GetLength(), 0);
+}
+
+/* Breaks one paragraph into lines. With autowrap, words are added to a line until the next would
+   take it past line_break_length_ characters */
+void WidgetText::LayoutParagraph(const std::string& _paragraph, std::vector<std::string>& _lines)
+{
+	if(!autowrap_)
+	{
+		_lines.push_back(_paragraph);
+		return;
+	}
+	std::string builder;
+	std::string::size_type word_start = 0;
+	while(true)
+	{
+		std::string::size_type word_end = _paragraph.find(' ', word_start);
+		if(word_end == std::string::npos)
+			word_end = _paragraph.length();
+		std::string::size_type word_length = word_end - word_start;
+		if(builder.length() + word_length > static_cast<size_t>(line_break_length_))
+		{
+			_lines.push_back(builder);
+			builder.assign(_paragraph, word_start, word_length);
+		} else
+		{
+			if(builder.length() > 0)
+				builder += ' ';
+			builder.append(_paragraph, word_start, word_length);
+		}
+		if(word_end == _paragraph.length())
+			break;
+		word_start = word_end + 1;
+	}
+	_lines.push_back(builder);
+}
+
+/* Walks the paragraph lengths only, the text itself isn't read */
+unsigned int WidgetText::FindParagraph(unsigned int _position, unsigned int& _start, unsigned int& _first_line)
+{
+	_start = 0;
+	_first_line = 0;
+	unsigned int last = static_cast<unsigned int>(paragraphs_.size()) - 1;
+	for(unsigned int i = 0; i < last; i++)
+	{
+		if(_position <= _start + paragraphs_[i].length)
+			return i;
+		_start += paragraphs_[i].length + 1;
+		_first_line += paragraphs_[i].lines;
+	}
+	return last;
+}
+
+void WidgetText::Relayout(unsigned int _paragraph, unsigned int _count, unsigned int _start, unsigned int _length, unsigned int _first_line)
+{
+	unsigned int old_lines = 0;
+	for(unsigned int i = _paragraph; i < _paragraph + _count; i++)
+	{
+		old_lines += paragraphs_[i].lines;
+	}
+
+	std::string region;
+	region.reserve(_length);
+	text_.AppendTo(_start, _length, region);
+	std::vector<std::string> lines;
+	std::vector<Paragraph> paragraphs;
+	std::string::size_type paragraph_start = 0;
+	while(true)
+	{
+		std::string::size_type paragraph_end = region.find('\n', paragraph_start);
+		if(paragraph_end == std::string::npos)
+			paragraph_end = region.length();
+		Paragraph paragraph;
+		paragraph.length = static_cast<unsigned int>(paragraph_end - paragraph_start);
+		std::vector<std::string>::size_type lines_before = lines.size();
+		LayoutParagraph(region.substr(paragraph_start, paragraph.length), lines);
+		paragraph.lines = static_cast<unsigned int>(lines.size() - lines_before);
+		paragraphs.push_back(paragraph);
+		if(paragraph_end == region.length())
+			break;
+		paragraph_start = paragraph_end + 1;
+	}
+
+	//Lines laid out the same number as before are overwritten in place, the usual case while typing
+	unsigned int overlap = old_lines < lines.size() ? old_lines : static_cast<unsigned int>(lines.size());
+	for(unsigned int i = 0; i < overlap; i++)
+	{
+		text_lines_[_first_line + i].swap(lines[i]);
+	}
+	if(lines.size() > old_lines)
+		text_lines_.insert(text_lines_.begin() + _first_line + overlap, lines.begin() + overlap, lines.end());
+	else
+		text_lines_.erase(text_lines_.begin() + _first_line + overlap, text_lines_.begin() + _first_line + old_lines);
+
+	overlap = _count < paragraphs.size() ? _count : static_cast<unsigned int>(paragraphs.size());
+	for(unsigned int i = 0; i < overlap; i++)
+	{
+		paragraphs_[_paragraph + i] = paragraphs[i];
+	}
+	if(paragraphs.size() > _count)
+		paragraphs_.insert(paragraphs_.begin() + _paragraph + overlap, paragraphs.begin() + overlap, paragraphs.end());
+	else
+		paragraphs_.erase(paragraphs_.begin() + _paragraph + overlap, paragraphs_.begin() + _paragraph + _count);
+}
+
+void WidgetText::Insert(unsigned int _position, const std::string& _text)
+{
+	if(_position > text_.GetLength())
+	{
+		Logger::ErrorOut() << "Text inserted past the end of widget text\n";
+		_position = text_.GetLength();
+	}
+	unsigned int start;
+	unsigned int first_line;
+	unsigned int paragraph = FindParagraph(_position, start, first_line);
+	unsigned int length = paragraphs_[paragraph].length;
+	text_.Insert(_position, _text);
+	Relayout(paragraph, 1, start, length + static_cast<unsigned int>(_text.length()), first_line);
+}
+
+void WidgetText::Erase(unsigned int _position, unsigned int _count)
+{
+	unsigned int text_length = text_.GetLength();
+	if(_position >= text_length || _count == 0)
+		return;
+	if(_count > text_length - _position)
+		_count = text_length - _position;
+	unsigned int start;
+	unsigned int first_line;
+	unsigned int first = FindParagraph(_position, start, first_line);
+	//Erasing newlines joins the paragraphs either side of them
+	unsigned int last = first;
+	unsigned int end = start + paragraphs_[first].length;
+	while(end < _position + _count)
+	{
+		last++;
+		end += paragraphs_[last].length + 1;
+	}
+	text_.Erase(_position, _count);
+	Relayout(first, last - first + 1, start, end - start - _count, first_line);
+}
@@ -1,7 +1,7 @@
 #pragma once
 #include <string>
 #include <vector>
-#include <boost/algorithm/string.hpp>
+#include "TextBuffer.h"
 
 
 namespace TextAlignment
@@ -20,13 +20,22 @@ namespace TextSize
 	};
 }
 
+/* Text shown on a widget and its layout into lines. The text lives in a gap buffer and the
+   line breaks of each paragraph are kept, so an edit only lays out the paragraphs it touches */
 struct WidgetText
 {
 private:
+	struct Paragraph
+	{
+		unsigned int length;	//Characters, not counting the newline that ends it
+		unsigned int lines;		//Laid out lines it takes up in text_lines_
+	};
+
 	TextAlignment::Enum alignment_;
 	TextSize::Enum text_size_;
-	std::string text_;
+	TextBuffer text_;
 	std::vector<std::string> text_lines_;
+	std::vector<Paragraph> paragraphs_;
 	bool autowrap_;
 	int line_break_length_;
 	int margin_left_;
@@ -34,44 +43,16 @@ private:
 	int margin_top_;
 	int margin_bottom_;
 
-	void LayoutText()
-	{
-		if(!autowrap_)
-		{
-			boost::split(text_lines_, text_, boost::is_any_of("\n"));
-		} else
-		{
-			std::vector<std::string> lines;
-			boost::split(lines, text_, boost::is_any_of("\n"));
-			text_lines_.clear();
-			for(std::vector<std::string>::iterator it = lines.begin(); it != lines.end(); ++it)
-			{
-				std::vector<std::string> words;
-				std::string builder;
-				boost::split(words, *it, boost::is_any_of(" "));
-				for(std::vector<std::string>::iterator word = words.begin(); word != words.end(); ++word)
-				{
-					if(builder.length() + word->length() > static_cast<size_t>(line_break_length_))
-					{
-						text_lines_.push_back(builder);
-						builder = *word;
-					} else
-					{
-						if(builder.length() > 0)
-							builder = builder + " " + *word;
-						else
-							builder = *word;
-					}
-				}
-				text_lines_.push_back(builder);
-			}
-		}
-	}
+	void LayoutText();
+	void LayoutParagraph(const std::string& _paragraph, std::vector<std::string>& _lines);
+	/* Finds the paragraph holding _position, with the offset of its first character and first line */
+	unsigned int FindParagraph(unsigned int _position, unsigned int& _start, unsigned int& _first_line);
+	/* Lays out _length characters from _start again, replacing _count paragraphs from _paragraph */
+	void Relayout(unsigned int _paragraph, unsigned int _count, unsigned int _start, unsigned int _length, unsigned int _first_line);
 
 public:
 	WidgetText()
 	{
-		text_=""; 
 		alignment_ = TextAlignment::Centre;
 		autowrap_ = false; 
 		line_break_length_ = 1000;
@@ -80,15 +61,20 @@ public:
 		margin_top_ = 4;
 		margin_bottom_ = 4;
 		text_size_ = TextSize::Normal;
+		LayoutText();
 	}
 
-	std::string GetText() const {return text_;}
-	std::vector<std::string> GetTextLines() const {return text_lines_;}
+	std::string GetText() const {return text_.GetText();}
+	unsigned int GetLength() const {return text_.GetLength();}
+	const std::vector<std::string>& GetTextLines() const {return text_lines_;}
 	void SetText(std::string _text)
 	{
-		text_ = _text;
+		text_.Assign(_text);
 		LayoutText();
 	}
+	/* Edits in place, laying out only the paragraphs changed */
+	void Insert(unsigned int _position, const std::string& _text);
+	void Erase(unsigned int _position, unsigned int _count);
 
 	void SetTextSize(TextSize::Enum _text_size){text_size_ = _text_size;}
 	TextSize::Enum GetTextSize() const {return text_size_;}
@@ -118,4 +104,4 @@ public:
 			line_break_length_ = (_widget_width - margin_left_ - margin_right_) / 10;
 		LayoutText();
 	}
-};
\ No newline at end of file
+};
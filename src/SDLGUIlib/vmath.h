@@ -43,6 +43,17 @@
 #include <iostream>
 #include <cassert>
 
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <xmmintrin.h>
+#define VMATH_HAS_SSE
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#define VMATH_HAS_SSE
+#endif
+//Define VMATH_SSE for a whole project, never just some of its files, to run Vector4f through SSE
+#if defined(VMATH_SSE) && !defined(VMATH_HAS_SSE)
+#undef VMATH_SSE
+#endif
 
 #define VEC3IMPLICITVEC4 //Causes matrix multiplication to treat a vector3 as having an implicit 1 in w
 #ifdef VMATH_NAMESPACE
@@ -362,7 +373,7 @@ namespace VMATH_NAMESPACE
 	  * Get lenght of vector.
 	  * @return lenght of vector
 	  */
-	 T length()
+	 T length() const
 	 {
 	    return (T)std::sqrt(x * x + y * y);
 	 }
@@ -384,7 +395,7 @@ namespace VMATH_NAMESPACE
 	  * of length of two vector can be used just this value, instead
 	  * of computionaly more expensive length() method.
 	  */
-	 T lengthSq()
+	 T lengthSq() const
 	 {
 	    return x * x + y * y;
 	 }
@@ -1302,6 +1313,15 @@ namespace VMATH_NAMESPACE
 	 {
 	    return x * x + y * y + z * z + w * w;
 	 }
+
+	 /**
+	  * Dot product of two vectors.
+	  * @param rhs Right hand side argument of binary operator.
+	  */
+	 T dotProduct(const Vector4<T>& rhs) const 
+	 {
+	    return x * rhs.x + y * rhs.y + z * rhs.z + w * rhs.w;
+	 }
 	
 	 //--------------[ misc. operations ]-----------------------
 	 /**
@@ -1357,6 +1377,79 @@ namespace VMATH_NAMESPACE
    /// Three dimensional Vector of doubles
    typedef Vector4<double> Vector4d;
 
+#ifdef VMATH_HAS_SSE
+   /**
+    * Vector4f operations on SSE registers. Unaligned loads and stores keep the layout of
+    * Vector4f, and sums run in the same order as the scalar code so the results are the same.
+    * Vector4f uses these in place of its own when VMATH_SSE is defined
+    */
+   struct Vector4SSE
+   {
+	 static __m128 load(const Vector4<float>& v) { return _mm_loadu_ps(static_cast<const float*>(v)); }
+
+	 static Vector4<float> store(__m128 v)
+	 {
+	    Vector4<float> result;
+	    _mm_storeu_ps(static_cast<float*>(result), v);
+	    return result;
+	 }
+
+	 /**
+	  * ((x + y) + z) + w of the lane products, as written in Vector4::dotProduct
+	  */
+	 static __m128 dot(__m128 a, __m128 b)
+	 {
+	    __m128 products = _mm_mul_ps(a, b);
+	    __m128 sum = _mm_add_ss(products, _mm_shuffle_ps(products, products, _MM_SHUFFLE(1, 1, 1, 1)));
+	    sum = _mm_add_ss(sum, _mm_shuffle_ps(products, products, _MM_SHUFFLE(2, 2, 2, 2)));
+	    return _mm_add_ss(sum, _mm_shuffle_ps(products, products, _MM_SHUFFLE(3, 3, 3, 3)));
+	 }
+
+	 static float dotProduct(const Vector4<float>& a, const Vector4<float>& b)
+	 {
+	    float result;
+	    _mm_store_ss(&result, dot(load(a), load(b)));
+	    return result;
+	 }
+
+	 static float lengthSq(const Vector4<float>& v)
+	 {
+	    return dotProduct(v, v);
+	 }
+
+	 static float length(const Vector4<float>& v)
+	 {
+	    __m128 loaded = load(v);
+	    float result;
+	    _mm_store_ss(&result, _mm_sqrt_ss(dot(loaded, loaded)));
+	    return result;
+	 }
+
+	 static void normalize(Vector4<float>& v)
+	 {
+	    __m128 loaded = load(v);
+	    __m128 s = _mm_sqrt_ss(dot(loaded, loaded));
+	    v = store(_mm_div_ps(loaded, _mm_shuffle_ps(s, s, _MM_SHUFFLE(0, 0, 0, 0))));
+	 }
+
+	 static Vector4<float> add(const Vector4<float>& a, const Vector4<float>& b) { return store(_mm_add_ps(load(a), load(b))); }
+	 static Vector4<float> sub(const Vector4<float>& a, const Vector4<float>& b) { return store(_mm_sub_ps(load(a), load(b))); }
+	 static Vector4<float> mul(const Vector4<float>& a, const Vector4<float>& b) { return store(_mm_mul_ps(load(a), load(b))); }
+	 static Vector4<float> mul(const Vector4<float>& a, float b) { return store(_mm_mul_ps(load(a), _mm_set1_ps(b))); }
+   };
+#endif
+
+#ifdef VMATH_SSE
+   template<> inline Vector4<float> Vector4<float>::operator+(const Vector4<float>& rhs) const { return Vector4SSE::add(*this, rhs); }
+   template<> inline Vector4<float> Vector4<float>::operator-(const Vector4<float>& rhs) const { return Vector4SSE::sub(*this, rhs); }
+   template<> inline Vector4<float> Vector4<float>::operator*(const Vector4<float> rhs) const { return Vector4SSE::mul(*this, rhs); }
+   template<> inline Vector4<float> Vector4<float>::operator*(float rhs) const { return Vector4SSE::mul(*this, rhs); }
+   template<> inline float Vector4<float>::length() const { return Vector4SSE::length(*this); }
+   template<> inline float Vector4<float>::lengthSq() const { return Vector4SSE::lengthSq(*this); }
+   template<> inline float Vector4<float>::dotProduct(const Vector4<float>& rhs) const { return Vector4SSE::dotProduct(*this, rhs); }
+   template<> inline void Vector4<float>::normalize() { Vector4SSE::normalize(*this); }
+#endif
+
 
 
 
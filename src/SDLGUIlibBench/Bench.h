@@ -0,0 +1,34 @@
+#pragma once
+#include <string>
+#include <HighResClock.h>
+
+/* Measures elapsed wall time from construction */
+class BenchTimer
+{
+private:
+	double start_;
+public:
+	BenchTimer() : start_(HighResClock::Seconds()){}
+	double Elapsed() const {return HighResClock::Seconds() - start_;}
+};
+
+/* Prints one result line: what was measured, over how many items, and the time per iteration.
+   Results are also kept to be written as JSON at the end of the run */
+void ReportBench(const std::string& _name, int _items, int _iterations, double _seconds);
+
+/* Benchmarks */
+void RunCollisionBench(int _triangles);
+void RunConvexBench(int _shapes);
+void RunDeepRenderBench(int _depth);
+void RunDispatchBench(int _widgets);
+void RunHitTestBench(int _widgets);
+void RunItemBrowserBench(int _items);
+void RunLoggerBench();
+void RunMixerBench(int _voices);
+void RunModalBench(int _widgets);
+void RunSignalBench();
+void RunTextEditBench(int _length);
+void RunTextLayoutBench(int _length);
+void RunVectorBench(int _count);
+void RunWideRenderBench(int _widgets);
+void RunWidgetConstructionBench();
@@ -0,0 +1,173 @@
+#include "stdafx.h"
+#include <vmath-collisions.h>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+namespace
+{
+	/* One small triangle in each square of a checkerboard, black or white, so two meshes
+	   interleave without touching and the brute force test has to try every pair */
+	std::vector<Vector2f> CheckerMesh(int _triangles, bool _white)
+	{
+		int side = 1;
+		while(side * side < _triangles * 2)
+			side++;
+		std::vector<Vector2f> mesh;
+		for(int cell = 0; static_cast<int>(mesh.size()) < _triangles * 3; cell++)
+		{
+			int x = cell % side;
+			int y = cell / side;
+			if(((x + y) % 2 == 1) != _white)
+				continue;
+			mesh.push_back(Vector2f(x + 0.1f, y + 0.1f));
+			mesh.push_back(Vector2f(x + 0.9f, y + 0.2f));
+			mesh.push_back(Vector2f(x + 0.5f, y + 0.9f));
+		}
+		return mesh;
+	}
+
+	std::vector<Vector2f> Octagon(Vector2f _centre, float _radius)
+	{
+		std::vector<Vector2f> hull;
+		for(int i = 0; i < 8; i++)
+			hull.push_back(_centre + Vector2f(std::cos(0.785398f * i), std::sin(0.785398f * i)) * _radius);
+		return hull;
+	}
+
+	/* The per edge test the convex one replaces: does the closest point on the edge lie in the circle */
+	bool EdgeInCircle(const Vector2f _p1, const Vector2f _p2, const Vector2f _centre, float _radius)
+	{
+		Vector2f edge = _p2 - _p1;
+		float along = ((_centre.x - _p1.x) * edge.x + (_centre.y - _p1.y) * edge.y) / edge.lengthSq();
+		along = std::min(1.0f, std::max(0.0f, along));
+		return Collisions2f::DistanceSqr(_p1 + edge * along, _centre) < _radius * _radius;
+	}
+}
+
+/* Mesh against mesh and line segments against a mesh, brute force against the tree */
+void RunCollisionBench(int _triangles)
+{
+	std::vector<Vector2f> black = CheckerMesh(_triangles, false);
+	std::vector<Vector2f> white = CheckerMesh(_triangles, true);
+	//Read back each pass, so the compiler can't hoist a call whose arguments never change
+	const Vector2f* volatile black_mesh = &black[0];
+	int hits = 0;
+	//Brute force is quadratic, so fewer passes at larger sizes
+	int passes = std::max(1, 2000000 / (_triangles * _triangles));
+
+	BenchTimer brute_timer;
+	for(int pass = 0; pass < passes; pass++)
+		hits += Collisions2f::PolygonIntersectsPolygon(black_mesh, _triangles, &white[0], _triangles);
+	ReportBench("Collision.MeshBruteForce", _triangles, passes, brute_timer.Elapsed());
+
+	int build_passes = std::max(1, 100000 / _triangles);
+	BenchTimer build_timer;
+	for(int pass = 0; pass < build_passes; pass++)
+		hits += Collisions2f::MeshTree(black_mesh, _triangles).GetNodeCount() == 0;
+	ReportBench("Collision.MeshTreeBuild", _triangles, build_passes, build_timer.Elapsed());
+
+	Collisions2f::MeshTree black_tree(&black[0], _triangles);
+	Collisions2f::MeshTree white_tree(&white[0], _triangles);
+	const Collisions2f::MeshTree* volatile black_query = &black_tree;
+	int tree_passes = passes * 20;
+	BenchTimer tree_timer;
+	for(int pass = 0; pass < tree_passes; pass++)
+		hits += black_query->Intersects(white_tree);
+	ReportBench("Collision.MeshTree", _triangles, tree_passes, tree_timer.Elapsed());
+
+	//Segments across the board, from the middle of one edge to the far side
+	const int lines = 1000;
+	float extent = std::sqrt(static_cast<float>(_triangles * 2));
+	std::vector<Vector2f> starts, ends;
+	for(int i = 0; i < lines; i++)
+	{
+		float along = extent * i / lines;
+		starts.push_back(Vector2f(-1, along));
+		ends.push_back(Vector2f(extent + 1, extent - along));
+	}
+	//Both find the crossing nearest the start, as LineInPolygon does with an out parameter
+	BenchTimer line_brute_timer;
+	for(int i = 0; i < lines; i++)
+	{
+		float nearest = 0;
+		bool found = false;
+		for(int j = 0; j < _triangles * 3; j++)
+		{
+			Vector2f crossing;
+			if(Collisions2f::LineSegmentsIntersect(starts[i], ends[i], black[j], black[j % 3 == 2 ? j - 2 : j + 1], crossing) &&
+			   (!found || Collisions2f::DistanceSqr(crossing, starts[i]) < nearest))
+			{
+				nearest = Collisions2f::DistanceSqr(crossing, starts[i]);
+				found = true;
+			}
+		}
+		hits += found;
+	}
+	ReportBench("Collision.LineBruteForce", _triangles, lines, line_brute_timer.Elapsed());
+
+	BenchTimer line_tree_timer;
+	for(int i = 0; i < lines; i++)
+	{
+		Vector2f out;
+		hits += black_tree.LineIntersects(starts[i], ends[i], out);
+	}
+	ReportBench("Collision.LineTree", _triangles, lines, line_tree_timer.Elapsed());
+
+	if(hits < 0)
+		std::cout << "Collision hits went negative\n";
+}
+
+/* Convex and circle tests against the edge loops they replace, where the saving is the
+   precomputed normals rather than a tree */
+void RunConvexBench(int _shapes)
+{
+	int hits = 0;
+	std::vector<Collisions2f::Convex> convexes;
+	std::vector<std::vector<Vector2f> > fans;
+	for(int i = 0; i < _shapes; i++)
+	{
+		std::vector<Vector2f> hull = Octagon(Vector2f(static_cast<float>(i % 40), static_cast<float>(i / 40)), 0.4f + (i % 7) * 0.05f);
+		convexes.push_back(Collisions2f::Convex(&hull[0], static_cast<int>(hull.size())));
+		std::vector<Vector2f> fan;
+		for(unsigned int j = 1; j + 1 < hull.size(); j++)
+		{
+			fan.push_back(hull[0]);
+			fan.push_back(hull[j]);
+			fan.push_back(hull[j + 1]);
+		}
+		fans.push_back(fan);
+	}
+	BenchTimer fan_timer;
+	for(int i = 0; i < _shapes; i++)
+		hits += Collisions2f::PolygonIntersectsPolygon(&fans[i][0], 6, &fans[(i + 1) % _shapes][0], 6);
+	ReportBench("Collision.ConvexEdges", _shapes, _shapes, fan_timer.Elapsed());
+
+	BenchTimer convex_timer;
+	for(int i = 0; i < _shapes; i++)
+		hits += Collisions2f::ConvexIntersectsConvex(convexes[i], convexes[(i + 1) % _shapes]);
+	ReportBench("Collision.ConvexSAT", _shapes, _shapes, convex_timer.Elapsed());
+
+	BenchTimer circle_edges_timer;
+	for(int i = 0; i < _shapes; i++)
+	{
+		const std::vector<Vector2f>& hull = convexes[i].points;
+		for(unsigned int j = 0; j < hull.size(); j++)
+		{
+			if(EdgeInCircle(hull[j], hull[(j + 1) % hull.size()], Vector2f(i % 40 + 0.5f, i / 40 + 0.5f), 0.3f))
+			{
+				hits++;
+				break;
+			}
+		}
+	}
+	ReportBench("Collision.CircleEdges", _shapes, _shapes, circle_edges_timer.Elapsed());
+
+	BenchTimer circle_timer;
+	for(int i = 0; i < _shapes; i++)
+		hits += Collisions2f::CircleIntersectsConvex(Vector2f(i % 40 + 0.5f, i / 40 + 0.5f), 0.3f, convexes[i]);
+	ReportBench("Collision.CircleSAT", _shapes, _shapes, circle_timer.Elapsed());
+
+	if(hits < 0)
+		std::cout << "Convex hits went negative\n";
+}
@@ -0,0 +1,111 @@
+#include "stdafx.h"
+#include <Widget.h>
+#include <vmath-collisions.h>
+#include <sdl.h>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+	const int world_size = 2048;
+	const int queries = 20000;
+
+	/* How DistributeSDLEvents found the widgets under the mouse before the hit grid:
+	   every widget tested, with the global position found by walking up its parents */
+	int LinearHitCount(std::vector<Widget*>& _widgets, Vector2i _point)
+	{
+		int hits = 0;
+		for(std::vector<Widget*>::iterator it = _widgets.begin(); it != _widgets.end(); ++it)
+		{
+			Vector2i global = (*it)->GetPosition();
+			for(Widget* parent = (*it)->GetParent(); parent; parent = parent->GetParent())
+				global += parent->GetPosition();
+			if(Collisions2i::PointInRectangle(_point - global, Vector2i(0, 0), (*it)->GetSize()))
+				hits++;
+		}
+		return hits;
+	}
+}
+
+/* Scatters _widgets widgets over a large area, a tenth of them panels holding four children each,
+   then times finding the widget under random points both ways, and full mouse move dispatch */
+void RunHitTestBench(int _widgets)
+{
+	Widget::ClearRoot();
+	srand(1);
+	std::vector<Widget*> widgets;
+	while(static_cast<int>(widgets.size()) < _widgets)
+	{
+		Vector2i position(rand() % world_size, rand() % world_size);
+		if(widgets.size() % 10 == 0 && static_cast<int>(widgets.size()) + 5 <= _widgets)
+		{
+			Widget* panel = new Widget(new BlittableRect(Vector2i(48, 48)));
+			panel->SetPosition(position);
+			widgets.push_back(panel);
+			for(int child = 0; child < 4; child++)
+			{
+				Widget* button = new Widget(new BlittableRect(Vector2i(16, 16)));
+				button->SetPosition(Vector2i((child % 2) * 24 + 4, (child / 2) * 24 + 4));
+				panel->AddChild(button);
+				widgets.push_back(button);
+			}
+		} else
+		{
+			Widget* widget = new Widget(new BlittableRect(Vector2i(8 + rand() % 24, 8 + rand() % 24)));
+			widget->SetPosition(position);
+			widgets.push_back(widget);
+		}
+	}
+
+	std::vector<Vector2i> points;
+	for(int i = 0; i < queries; i++)
+	{
+		points.push_back(Vector2i(rand() % world_size, rand() % world_size));
+	}
+
+	int linear_hits = 0;
+	BenchTimer linear_timer;
+	for(std::vector<Vector2i>::iterator it = points.begin(); it != points.end(); ++it)
+	{
+		linear_hits += LinearHitCount(widgets, *it);
+	}
+	ReportBench("HitTest.Linear", _widgets, queries, linear_timer.Elapsed());
+
+	int grid_hits = 0;
+	BenchTimer grid_timer;
+	for(std::vector<Vector2i>::iterator it = points.begin(); it != points.end(); ++it)
+	{
+		if(Widget::WidgetAt(*it))
+			grid_hits++;
+	}
+	ReportBench("HitTest.WidgetAt", _widgets, queries, grid_timer.Elapsed());
+
+	SDL_Event event;
+	event.type = SDL_MOUSEMOTION;
+	BenchTimer dispatch_timer;
+	for(std::vector<Vector2i>::iterator it = points.begin(); it != points.end(); ++it)
+	{
+		event.motion.x = static_cast<Uint16>(it->x);
+		event.motion.y = static_cast<Uint16>(it->y);
+		Widget::DistributeSDLEvents(&event);
+	}
+	ReportBench("HitTest.MouseMoveDispatch", _widgets, queries, dispatch_timer.Elapsed());
+
+	//Moving a panel has to move its children in the grid too
+	BenchTimer move_timer;
+	int moves = 0;
+	for(std::vector<Widget*>::iterator it = widgets.begin(); it != widgets.end(); ++it)
+	{
+		if(!(*it)->GetParent())
+		{
+			(*it)->SetPosition((*it)->GetPosition() + Vector2i(1, 1));
+			moves++;
+		}
+	}
+	ReportBench("HitTest.SetPosition", _widgets, moves, move_timer.Elapsed());
+
+	//Every grid hit is also a linear hit, there may be more of those as overlaps count separately
+	if(grid_hits > linear_hits)
+		std::cout << "HitTest mismatch: " << grid_hits << " grid hits, " << linear_hits << " linear hits\n";
+	Widget::ClearRoot();
+}
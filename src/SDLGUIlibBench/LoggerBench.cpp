@@ -0,0 +1,21 @@
+#include "stdafx.h"
+#include <Logger.h>
+
+namespace
+{
+	const int lines = 1000000;
+}
+
+/* A typical diagnostic line logged with diagnostics switched off */
+void RunLoggerBench()
+{
+	LogLevel::Enum level = Logger::GetLevel();
+	Logger::SetLevel(LogLevel::Error);
+	BenchTimer timer;
+	for(int i = 0; i < lines; i++)
+	{
+		Logger::DiagnosticOut() << "Frame " << i << " took " << 0.016f << "s\n";
+	}
+	ReportBench("Logger.DisabledLine", 1, lines, timer.Elapsed());
+	Logger::SetLevel(level);
+}
@@ -0,0 +1,47 @@
+#include "stdafx.h"
+#include <SoftwareMixer.h>
+#include <vector>
+
+namespace
+{
+	const int callbacks = 2000;
+	const int callback_frames = 1024;	//What the game opens the audio device with
+	const unsigned int sample_frames = 44100;
+
+	void TimeMix(const std::string& _name, SoftwareMixer& _mixer, int _voices)
+	{
+		std::vector<Sint16> out(callback_frames * 2);
+		BenchTimer timer;
+		for(int i = 0; i < callbacks; i++)
+		{
+			_mixer.Mix(&out[0], callback_frames);
+		}
+		//Per voice per callback, so the cost of each extra voice can be read straight off
+		ReportBench(_name, _voices, callbacks * (_voices > 0 ? _voices : 1), timer.Elapsed());
+	}
+}
+
+/* Mixing one audio callback's worth of looping voices, with and without SSE2 */
+void RunMixerBench(int _voices)
+{
+	std::vector<Sint16> samples(sample_frames * 2);
+	for(unsigned int i = 0; i < samples.size(); i++)
+	{
+		samples[i] = static_cast<Sint16>((i * 7919) & 0x3fff) - 0x2000;
+	}
+
+	for(int simd = 1; simd >= 0; simd--)
+	{
+		SoftwareMixer mixer(_voices, 44100);
+		mixer.SetSIMD(simd != 0);
+		if(simd && !mixer.GetSIMD())
+			continue;
+		for(int voice = 0; voice < _voices; voice++)
+		{
+			//Staggered so the voices aren't reading the same samples in step
+			unsigned int offset = voice * 997;
+			mixer.Play(voice, &samples[offset * 2], sample_frames - offset, 0.5f, true);
+		}
+		TimeMix(simd ? "Mixer.VoiceSSE2" : "Mixer.VoiceScalar", mixer, _voices);
+	}
+}
@@ -0,0 +1,4 @@
+cd ../../bin/SDLGUIlibBench/Debug
+echo SDLGUIlib benchmarks
+echo Running the benchmarks via batch file to force working directory
+SDLGUIlibBench.exe
\ No newline at end of file
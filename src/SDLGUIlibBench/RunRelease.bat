@@ -0,0 +1,4 @@
+cd ../../bin/SDLGUIlibBench/Release
+echo SDLGUIlib benchmarks
+echo Running the benchmarks via batch file to force working directory
+SDLGUIlibBench.exe -json BenchResults.json
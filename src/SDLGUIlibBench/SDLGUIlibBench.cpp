@@ -0,0 +1,116 @@
+// SDLGUIlibBench.cpp : Defines the entry point for the console application.
+//
+
+#include "stdafx.h"
+#include <sdl.h>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <fstream>
+
+namespace
+{
+	struct BenchResult
+	{
+		std::string name;
+		int items;
+		int iterations;
+		double seconds;
+	};
+
+	std::vector<BenchResult> results;
+
+	/* One object per result, names being literals from the benches need no escaping */
+	bool WriteJson(const char* _filename)
+	{
+		std::ofstream out(_filename, std::ios::trunc);
+		if(!out)
+			return false;
+		out.setf(std::ios::fixed);
+		out.precision(1);
+		out << "{\"results\":[";
+		for(std::vector<BenchResult>::iterator it = results.begin(); it != results.end(); ++it)
+		{
+			double per_iteration = it->iterations > 0 ? it->seconds / it->iterations : 0.0;
+			out << (it == results.begin() ? "\n" : ",\n") << "{\"name\":\"" << it->name << "\",\"items\":" << it->items <<
+				   ",\"iterations\":" << it->iterations << ",\"ns_per_iteration\":" << per_iteration * 1e9 << "}";
+		}
+		out << "\n]}\n";
+		return true;
+	}
+}
+
+void ReportBench(const std::string& _name, int _items, int _iterations, double _seconds)
+{
+	double per_iteration = _iterations > 0 ? _seconds / _iterations : 0.0;
+	std::cout << _name << "\t" << _items << "\t" << per_iteration * 1e9 << " ns\n";
+	BenchResult result = {_name, _items, _iterations, _seconds};
+	results.push_back(result);
+}
+
+int main(int argc, char ** argv)
+{
+	//Nothing is shown, but BlittableRect needs a display format to convert to
+	SDL_putenv(const_cast<char*>("SDL_VIDEODRIVER=dummy"));
+	if(SDL_Init(SDL_INIT_VIDEO) != 0 || !SDL_SetVideoMode(640, 480, 32, SDL_SWSURFACE))
+	{
+		std::cout << "Error starting SDL\n";
+		return 1;
+	}
+
+	//Widget counts may be given on the command line, and -json <file> to keep the results
+	std::vector<int> sizes;
+	const char* json_filename = NULL;
+	for(int arg = 1; arg < argc; arg++)
+	{
+		if(strcmp(argv[arg], "-json") == 0 && arg + 1 < argc)
+		{
+			json_filename = argv[++arg];
+			continue;
+		}
+		int size = atoi(argv[arg]);
+		if(size > 0)
+			sizes.push_back(size);
+	}
+	if(sizes.empty())
+	{
+		sizes.push_back(1000);
+		sizes.push_back(2500);
+		sizes.push_back(5000);
+		sizes.push_back(10000);
+	}
+
+	std::cout << "Benchmark\tItems\tTime per iteration\n";
+	RunSignalBench();
+	RunLoggerBench();
+	RunTextEditBench(1000);
+	RunTextEditBench(8000);
+	RunMixerBench(1);
+	RunMixerBench(4);
+	RunMixerBench(16);
+	RunMixerBench(32);
+	RunVectorBench(1000);
+	RunVectorBench(100000);
+	RunConvexBench(1000);
+	RunCollisionBench(100);
+	RunCollisionBench(1000);
+	RunWidgetConstructionBench();
+	RunTextLayoutBench(10000);
+	RunTextLayoutBench(100000);
+	RunItemBrowserBench(1000);
+	RunDeepRenderBench(16);
+	RunDeepRenderBench(64);
+	RunDeepRenderBench(256);
+	for(std::vector<int>::iterator it = sizes.begin(); it != sizes.end(); ++it)
+	{
+		RunHitTestBench(*it);
+		RunDispatchBench(*it);
+		RunWideRenderBench(*it);
+		RunModalBench(*it);
+	}
+
+	if(json_filename && !WriteJson(json_filename))
+		std::cout << "Unable to write " << json_filename << "\n";
+	SDL_Quit();
+	return 0;
+}
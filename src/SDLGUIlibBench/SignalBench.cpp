@@ -0,0 +1,57 @@
+#include "stdafx.h"
+#include <Signal.h>
+#include <boost/signal.hpp>
+#include <boost/bind.hpp>
+
+namespace
+{
+	const int dispatches = 1000000;
+	const int connections = 10000;
+
+	struct Receiver
+	{
+		int total;
+		Receiver() : total(0){}
+		void Receive(int _value){total += _value;}
+	};
+
+	template<typename S>
+	void TimeDispatch(const std::string& _name, S& _signal, int _slots)
+	{
+		BenchTimer timer;
+		for(int i = 0; i < dispatches; i++)
+		{
+			_signal(i);
+		}
+		ReportBench(_name, _slots, dispatches, timer.Elapsed());
+	}
+
+	/* Fires with no slots, then one and four bound member functions connected */
+	template<typename S>
+	void TimeSignal(const std::string& _name)
+	{
+		Receiver receiver;
+		S signal;
+		TimeDispatch(_name + ".Dispatch", signal, 0);
+		signal.connect(boost::bind(&Receiver::Receive, &receiver, _1));
+		TimeDispatch(_name + ".Dispatch", signal, 1);
+		for(int i = 0; i < 3; i++)
+			signal.connect(boost::bind(&Receiver::Receive, &receiver, _1));
+		TimeDispatch(_name + ".Dispatch", signal, 4);
+		signal.disconnect_all_slots();
+
+		BenchTimer timer;
+		for(int i = 0; i < connections; i++)
+		{
+			signal.connect(boost::bind(&Receiver::Receive, &receiver, _1)).disconnect();
+		}
+		ReportBench(_name + ".ConnectDisconnect", 1, connections, timer.Elapsed());
+	}
+}
+
+/* Widget events fire far more often than they are connected - OnDraw on every redraw of every widget */
+void RunSignalBench()
+{
+	TimeSignal<boost::signal<void (int)> >("boost::signal");
+	TimeSignal<Signal<void (int)> >("Signal");
+}
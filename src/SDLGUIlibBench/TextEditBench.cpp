@@ -0,0 +1,56 @@
+#include "stdafx.h"
+#include <WidgetText.h>
+
+namespace
+{
+	const int keypresses = 2000;
+
+	/* A wrapped text field of roughly _length characters in paragraphs of a few lines */
+	std::string MakeText(int _length)
+	{
+		std::string text;
+		while(static_cast<int>(text.length()) < _length)
+		{
+			text += "some words to wrap ";
+			if(text.length() % 200 < 19)
+				text += "\n";
+		}
+		return text;
+	}
+}
+
+/* Typing then deleting at the end of a text field, rebuilding the string and laying out all of it
+   on each key as editing used to, against editing the buffer in place */
+void RunTextEditBench(int _length)
+{
+	std::string text = MakeText(_length);
+	{
+		WidgetText widget_text;
+		widget_text.SetAutowrap(true, 320);
+		widget_text.SetText(text);
+		BenchTimer timer;
+		for(int i = 0; i < keypresses; i++)
+		{
+			std::string cur_text = widget_text.GetText();
+			if(i % 2 == 0)
+				widget_text.SetText(cur_text + 'a');
+			else
+				widget_text.SetText(cur_text.substr(0, cur_text.length() - 1));
+		}
+		ReportBench("TextEdit.SetText", _length, keypresses, timer.Elapsed());
+	}
+	{
+		WidgetText widget_text;
+		widget_text.SetAutowrap(true, 320);
+		widget_text.SetText(text);
+		BenchTimer timer;
+		for(int i = 0; i < keypresses; i++)
+		{
+			if(i % 2 == 0)
+				widget_text.Insert(widget_text.GetLength(), "a");
+			else
+				widget_text.Erase(widget_text.GetLength() - 1, 1);
+		}
+		ReportBench("TextEdit.Insert", _length, keypresses, timer.Elapsed());
+	}
+}
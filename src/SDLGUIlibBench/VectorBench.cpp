@@ -0,0 +1,83 @@
+#include "stdafx.h"
+#include "VectorBatch.h"
+#include <vector>
+
+namespace
+{
+	const int passes = 200;
+
+	/* Folds results into something printed, so the work can't be optimised away */
+	float Checksum(const std::vector<Vector2f>& _vectors)
+	{
+		float sum = 0;
+		for(unsigned int i = 0; i < _vectors.size(); i += 64)
+			sum += _vectors[i].x + _vectors[i].y;
+		return sum;
+	}
+}
+
+/* Batch operations over _count vectors with and without SSE, per vector */
+void RunVectorBench(int _count)
+{
+	std::vector<Vector2f> source(_count);
+	std::vector<Vector4f> source4(_count);
+	for(int i = 0; i < _count; i++)
+	{
+		source[i] = Vector2f(static_cast<float>(i % 97) - 48.0f, static_cast<float>(i % 89) + 1.0f);
+		source4[i] = Vector4f(source[i].x, source[i].y, static_cast<float>(i % 13), 1.0f);
+	}
+	Matrix3f matrix;
+	matrix.at(0, 1) = 0.5f;
+	matrix.at(2, 0) = 16.0f;
+	Matrix4f matrix4 = Matrix4f::createTranslation(1.0f, 2.0f, 3.0f);
+	std::vector<Vector2f> vectors(_count);
+	std::vector<Vector4f> vectors4(_count);
+	std::vector<float> dots(_count);
+	float checksum = 0;
+	int iterations = passes * _count;
+
+	for(int simd = 1; simd >= 0; simd--)
+	{
+		VectorBatch::SetSIMD(simd != 0);
+		if(simd && !VectorBatch::GetSIMD())
+			continue;
+		std::string suffix = simd ? "SSE" : "Scalar";
+
+		BenchTimer transform_timer;
+		for(int pass = 0; pass < passes; pass++)
+			VectorBatch::Transform(matrix, &source[0], &vectors[0], _count);
+		ReportBench("Vector.Transform2" + suffix, _count, iterations, transform_timer.Elapsed());
+		checksum += Checksum(vectors);
+
+		BenchTimer transform4_timer;
+		for(int pass = 0; pass < passes; pass++)
+			VectorBatch::Transform(matrix4, &source4[0], &vectors4[0], _count);
+		ReportBench("Vector.Transform4" + suffix, _count, iterations, transform4_timer.Elapsed());
+
+		//Includes copying the inputs back each pass
+		BenchTimer normalize_timer;
+		for(int pass = 0; pass < passes; pass++)
+		{
+			vectors = source;
+			VectorBatch::Normalize(&vectors[0], _count);
+		}
+		ReportBench("Vector.Normalize2" + suffix, _count, iterations, normalize_timer.Elapsed());
+		checksum += Checksum(vectors);
+
+		BenchTimer dot_timer;
+		for(int pass = 0; pass < passes; pass++)
+			VectorBatch::Dot(&source[0], &vectors[0], &dots[0], _count);
+		ReportBench("Vector.Dot2" + suffix, _count, iterations, dot_timer.Elapsed());
+		checksum += dots[_count / 2];
+
+		BenchTimer minmax_timer;
+		Vector2f low, high;
+		for(int pass = 0; pass < passes; pass++)
+			VectorBatch::MinMax(&source[0], _count, low, high);
+		ReportBench("Vector.MinMax2" + suffix, _count, iterations, minmax_timer.Elapsed());
+		checksum += low.x + high.y;
+	}
+	VectorBatch::SetSIMD(true);
+	if(checksum != checksum)
+		std::cout << "Vector checksum is NaN\n";
+}
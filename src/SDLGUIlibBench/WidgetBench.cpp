@@ -0,0 +1,258 @@
+#include "stdafx.h"
+#include <Widget.h>
+#include <WidgetText.h>
+#include <ItemBrowserWidget.h>
+#include <ImageCache.h>
+#include <sdl.h>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+	const int constructions = 256;
+	const int frames = 200;
+	const int clicks = 5000;
+	const int layouts = 200;
+	const int page_turns = 200;
+	const int modal_toggles = 100;
+	const int world_size = 2048;
+
+	/* Puts a plain image in the cache under the name a BlittableRect would load it by, so the
+	   bench doesn't depend on what is in the working directory */
+	void AddImage(const std::string& _filename, Vector2i _size)
+	{
+		SDL_Surface* surface = SDL_CreateRGBSurface(SDL_SWSURFACE, _size.x, _size.y, 32,
+													0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000);
+		if(!surface)
+			return;
+		SDL_FillRect(surface, NULL, SDL_MapRGBA(surface->format, 96, 128, 160, 255));
+		ImageCache::Instance().AddDecoded("Animations/" + _filename, surface);
+	}
+
+	void AddImages()
+	{
+		AddImage("BenchTop.png", Vector2i(64, 8));
+		AddImage("BenchMiddle.png", Vector2i(64, 4));
+		AddImage("BenchBottom.png", Vector2i(64, 8));
+		AddImage("BenchLeft.png", Vector2i(8, 32));
+		AddImage("BenchCentre.png", Vector2i(4, 32));
+		AddImage("BenchRight.png", Vector2i(8, 32));
+		AddImage("BenchPatch.png", Vector2i(48, 48));
+		AddImage("BrowseLeft.png", Vector2i(32, 32));
+		AddImage("BrowseRight.png", Vector2i(32, 32));
+		AddImage("ErrorLoading.png", Vector2i(32, 32));
+	}
+
+	void RenderItem(Widget* /*_browser*/, BlittableRect** _rect, std::string /*_item*/)
+	{
+		*_rect = new BlittableRect(Vector2i(64, 64));
+		(*_rect)->Fill(255, 128, 0, 255);
+	}
+
+	std::string MakeText(int _length)
+	{
+		std::string text;
+		while(static_cast<int>(text.length()) < _length)
+		{
+			text += "a few more words to be wrapped ";
+			if(text.length() % 600 < 31)
+				text += "\n";
+		}
+		return text;
+	}
+
+	/* Times one RenderRoot with a single widget redrawn, and one with nothing changed */
+	void RenderBench(const std::string& _name, Widget* _changed, int _widgets)
+	{
+		BlittableRect screen(Vector2i(640, 480));
+		Widget::RenderRoot(&screen);
+		BenchTimer changed_timer;
+		for(int i = 0; i < frames; i++)
+		{
+			_changed->Invalidate();
+			Widget::RenderRoot(&screen);
+		}
+		ReportBench(_name + ".Redraw", _widgets, frames, changed_timer.Elapsed());
+
+		BenchTimer unchanged_timer;
+		for(int i = 0; i < frames; i++)
+		{
+			Widget::RenderRoot(&screen);
+		}
+		ReportBench(_name + ".Unchanged", _widgets, frames, unchanged_timer.Elapsed());
+	}
+}
+
+/* Widget construction for each tiling type, composing a new size each time then with the
+   composition already cached */
+void RunWidgetConstructionBench()
+{
+	Widget::ClearRoot();
+	AddImages();
+	VerticalTile vertical("BenchTop.png", "BenchMiddle.png", "BenchBottom.png");
+	HorizontalTile horizontal("BenchLeft.png", "BenchCentre.png", "BenchRight.png");
+	NinePatch nine_patch("BenchPatch.png", 16, 16, 16, 16);
+
+	BenchTimer vertical_timer;
+	for(int i = 0; i < constructions; i++)
+		new Widget(vertical, 64 + i);
+	ReportBench("Construct.VerticalTile", constructions, constructions, vertical_timer.Elapsed());
+	BenchTimer horizontal_timer;
+	for(int i = 0; i < constructions; i++)
+		new Widget(horizontal, 64 + i);
+	ReportBench("Construct.HorizontalTile", constructions, constructions, horizontal_timer.Elapsed());
+	BenchTimer nine_patch_timer;
+	for(int i = 0; i < constructions; i++)
+		new Widget(nine_patch, 64 + i, 64 + i / 2);
+	ReportBench("Construct.NinePatch", constructions, constructions, nine_patch_timer.Elapsed());
+	Widget::ClearRoot();
+
+	BenchTimer vertical_cached_timer;
+	for(int i = 0; i < constructions; i++)
+		new Widget(vertical, 64);
+	ReportBench("Construct.VerticalTile.Cached", constructions, constructions, vertical_cached_timer.Elapsed());
+	BenchTimer horizontal_cached_timer;
+	for(int i = 0; i < constructions; i++)
+		new Widget(horizontal, 64);
+	ReportBench("Construct.HorizontalTile.Cached", constructions, constructions, horizontal_cached_timer.Elapsed());
+	BenchTimer nine_patch_cached_timer;
+	for(int i = 0; i < constructions; i++)
+		new Widget(nine_patch, 64, 64);
+	ReportBench("Construct.NinePatch.Cached", constructions, constructions, nine_patch_cached_timer.Elapsed());
+	Widget::ClearRoot();
+}
+
+/* RenderRoot over a chain of widgets _depth deep, each inset a pixel inside its parent, redrawing
+   the innermost each frame so every level above it is recomposed */
+void RunDeepRenderBench(int _depth)
+{
+	Widget::ClearRoot();
+	Widget* deepest = NULL;
+	for(int depth = 0; depth < _depth; depth++)
+	{
+		Widget* parent = new Widget();
+		parent->SetSize(Vector2i(64 + depth * 2, 48 + depth * 2));
+		if(deepest)
+		{
+			deepest->SetPosition(Vector2i(1, 1));
+			parent->AddChild(deepest);
+		}
+		deepest = parent;
+	}
+	while(deepest->GetChildren().size() > 0)
+		deepest = deepest->GetChildren().front();
+	RenderBench("RenderRoot.Deep", deepest, _depth);
+	Widget::ClearRoot();
+}
+
+/* RenderRoot over one panel holding _widgets children, redrawing the last each frame */
+void RunWideRenderBench(int _widgets)
+{
+	Widget::ClearRoot();
+	Widget* panel = new Widget();
+	panel->SetSize(Vector2i(640, 480));
+	Widget* last = panel;
+	for(int child = 1; child < _widgets; child++)
+	{
+		last = new Widget();
+		last->SetSize(Vector2i(16, 16));
+		last->SetPosition(Vector2i((child * 20) % 620, ((child * 20) / 620 * 20) % 460));
+		panel->AddChild(last);
+	}
+	RenderBench("RenderRoot.Wide", last, _widgets);
+	Widget::ClearRoot();
+}
+
+/* Clicks at random points over _widgets widgets scattered over a large area */
+void RunDispatchBench(int _widgets)
+{
+	Widget::ClearRoot();
+	srand(2);
+	for(int i = 0; i < _widgets; i++)
+	{
+		Widget* widget = new Widget();
+		widget->SetSize(Vector2i(8 + rand() % 24, 8 + rand() % 24));
+		widget->SetPosition(Vector2i(rand() % world_size, rand() % world_size));
+	}
+
+	SDL_Event event;
+	event.button.button = SDL_BUTTON_LEFT;
+	BenchTimer timer;
+	for(int i = 0; i < clicks; i++)
+	{
+		event.button.x = static_cast<Uint16>(rand() % world_size);
+		event.button.y = static_cast<Uint16>(rand() % world_size);
+		event.type = SDL_MOUSEBUTTONDOWN;
+		Widget::DistributeSDLEvents(&event);
+		event.type = SDL_MOUSEBUTTONUP;
+		Widget::DistributeSDLEvents(&event);
+	}
+	ReportBench("Dispatch.Click", _widgets, clicks, timer.Elapsed());
+	Widget::ClearRoot();
+}
+
+/* Laying out _length characters of wrapped text from scratch */
+void RunTextLayoutBench(int _length)
+{
+	std::string text = MakeText(_length);
+	WidgetText widget_text;
+	widget_text.SetAutowrap(true, 480);
+	BenchTimer timer;
+	for(int i = 0; i < layouts; i++)
+	{
+		widget_text.SetText(text);
+	}
+	ReportBench("TextLayout.Wrapped", _length, layouts, timer.Elapsed());
+}
+
+/* Turning the pages of a browser over _items items, each rendered by the handler as it comes
+   into view */
+void RunItemBrowserBench(int _items)
+{
+	Widget::ClearRoot();
+	AddImages();
+	std::vector<std::string> items;
+	for(int i = 0; i < _items; i++)
+	{
+		items.push_back("Item");
+	}
+	ItemBrowserWidget* browser = new ItemBrowserWidget(items, Vector2i(6, 4), Vector2i(64, 64));
+	browser->OnItemRender.connect(&RenderItem);
+	BlittableRect screen(Vector2i(640, 480));
+	BenchTimer timer;
+	for(int i = 0; i < page_turns; i++)
+	{
+		browser->NextPage(NULL);
+		Widget::RenderRoot(&screen);
+	}
+	ReportBench("ItemBrowser.NextPage", _items, page_turns, timer.Elapsed());
+	Widget::ClearRoot();
+}
+
+/* Opening and closing a dialog over _widgets widgets, each drawn on screen; both invalidate
+   everything */
+void RunModalBench(int _widgets)
+{
+	Widget::ClearRoot();
+	for(int i = 1; i < _widgets; i++)
+	{
+		Widget* widget = new Widget();
+		widget->SetSize(Vector2i(16, 16));
+		widget->SetPosition(Vector2i((i * 20) % 620, ((i * 20) / 620 * 20) % 460));
+	}
+	Widget* dialog = new Widget();
+	dialog->SetSize(Vector2i(200, 100));
+	dialog->SetPosition(Vector2i(220, 190));
+	BlittableRect screen(Vector2i(640, 480));
+	Widget::RenderRoot(&screen);
+	BenchTimer timer;
+	for(int i = 0; i < modal_toggles; i++)
+	{
+		Widget::SetModalWidget(dialog);
+		Widget::RenderRoot(&screen);
+		dialog->SetModal(false);
+		Widget::RenderRoot(&screen);
+	}
+	ReportBench("Modal.OpenClose", _widgets, modal_toggles, timer.Elapsed());
+	Widget::ClearRoot();
+}
@@ -0,0 +1,289 @@
+#include "stdafx.h"
+#include "AllocationTracker.h"
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include <algorithm>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <intrin.h>
+#pragma intrinsic(_ReturnAddress)
+#define ALLOCATION_CALLER() _ReturnAddress()
+#define ALLOCATION_THREAD_LOCAL __declspec(thread)
+#else
+#define ALLOCATION_CALLER() __builtin_return_address(0)
+#define ALLOCATION_THREAD_LOCAL __thread
+#endif
+
+namespace
+{
+	const unsigned int sampleSlots = 512;	//Power of two
+	const unsigned int reportedSites = 10;
+
+	struct Counters
+	{
+		volatile long allocations;
+		volatile long bytes;
+	};
+
+	struct Totals
+	{
+		double allocations;
+		double bytes;
+		unsigned int peak_allocations;
+		unsigned int peak_bytes;
+	};
+
+	/* Allocations sampled at one call site */
+	struct CallSite
+	{
+		void* volatile caller;
+		volatile long count;
+		int tag;	//The first it was sampled under
+	};
+
+	volatile bool enabled = false;
+	volatile long sampleEvery = 64;
+	Counters current[AllocationTag::Count];
+	AllocationStats last[AllocationTag::Count];
+	Totals totals[AllocationTag::Count];
+	unsigned int frames = 0;
+	CallSite sites[sampleSlots];
+	volatile long unsampled = 0;	//Samples lost because every slot was taken
+	ALLOCATION_THREAD_LOCAL int threadTag = AllocationTag::Other;
+	const char* tagNames[AllocationTag::Count] = {"Other", "Simulation", "Widgets", "Rendering", "Audio"};
+
+#ifdef _WIN32
+	long Add(volatile long* _value, long _amount)
+	{
+		return InterlockedExchangeAdd(_value, _amount) + _amount;
+	}
+
+	long Take(volatile long* _value)
+	{
+		return InterlockedExchange(_value, 0);
+	}
+
+	bool Claim(void* volatile* _slot, void* _caller)
+	{
+		return InterlockedCompareExchangePointer(_slot, _caller, NULL) == NULL;
+	}
+#else
+	long Add(volatile long* _value, long _amount)
+	{
+		return __sync_add_and_fetch(_value, _amount);
+	}
+
+	long Take(volatile long* _value)
+	{
+		return __sync_lock_test_and_set(_value, 0);
+	}
+
+	bool Claim(void* volatile* _slot, void* _caller)
+	{
+		return __sync_bool_compare_and_swap(_slot, static_cast<void*>(NULL), _caller);
+	}
+#endif
+
+	/* Open addressing on the caller, so sampling never allocates or locks */
+	void SampleCaller(void* _caller, int _tag)
+	{
+		size_t hash = (reinterpret_cast<size_t>(_caller) >> 2) * 2654435761u;
+		for(unsigned int probe = 0; probe < sampleSlots; probe++)
+		{
+			CallSite& site = sites[(hash + probe) & (sampleSlots - 1)];
+			void* caller = site.caller;
+			if(!caller)
+			{
+				if(Claim(&site.caller, _caller))
+					site.tag = _tag;
+				caller = site.caller;
+			}
+			if(caller == _caller)
+			{
+				Add(&site.count, 1);
+				return;
+			}
+		}
+		Add(&unsampled, 1);
+	}
+
+	bool MoreSampled(const CallSite& _first, const CallSite& _second)
+	{
+		return _first.count > _second.count;
+	}
+}
+
+void AllocationTracker::Enable(bool _enabled)
+{
+	enabled = _enabled;
+}
+
+bool AllocationTracker::IsEnabled()
+{
+	return enabled;
+}
+
+void AllocationTracker::SetSampleRate(unsigned int _every)
+{
+	sampleEvery = static_cast<long>(_every);
+}
+
+void AllocationTracker::Count(size_t _bytes, void* _caller)
+{
+	if(!enabled)
+		return;
+	int tag = threadTag;
+	long count = Add(&current[tag].allocations, 1);
+	Add(&current[tag].bytes, static_cast<long>(_bytes));
+	long every = sampleEvery;
+	if(every > 0 && count % every == 0)
+		SampleCaller(_caller, tag);
+}
+
+AllocationTag::Enum AllocationTracker::SetTag(AllocationTag::Enum _tag)
+{
+	AllocationTag::Enum previous = static_cast<AllocationTag::Enum>(threadTag);
+	threadTag = _tag;
+	return previous;
+}
+
+const char* AllocationTracker::GetTagName(AllocationTag::Enum _tag)
+{
+	return tagNames[_tag];
+}
+
+void AllocationTracker::EndFrame()
+{
+	frames++;
+	for(int tag = 0; tag < AllocationTag::Count; tag++)
+	{
+		AllocationStats& frame = last[tag];
+		frame.allocations = static_cast<unsigned int>(Take(&current[tag].allocations));
+		frame.bytes = static_cast<unsigned int>(Take(&current[tag].bytes));
+		Totals& total = totals[tag];
+		total.allocations += frame.allocations;
+		total.bytes += frame.bytes;
+		total.peak_allocations = std::max(total.peak_allocations, frame.allocations);
+		total.peak_bytes = std::max(total.peak_bytes, frame.bytes);
+	}
+}
+
+void AllocationTracker::Reset()
+{
+	for(int tag = 0; tag < AllocationTag::Count; tag++)
+	{
+		Take(&current[tag].allocations);
+		Take(&current[tag].bytes);
+		last[tag].allocations = 0;
+		last[tag].bytes = 0;
+		Totals empty = {0, 0, 0, 0};
+		totals[tag] = empty;
+	}
+	for(unsigned int i = 0; i < sampleSlots; i++)
+	{
+		sites[i].count = 0;
+		sites[i].caller = NULL;
+	}
+	unsampled = 0;
+	frames = 0;
+}
+
+AllocationStats AllocationTracker::GetCurrent(AllocationTag::Enum _tag)
+{
+	AllocationStats stats = {static_cast<unsigned int>(current[_tag].allocations), static_cast<unsigned int>(current[_tag].bytes)};
+	return stats;
+}
+
+AllocationStats AllocationTracker::GetLastFrame(AllocationTag::Enum _tag)
+{
+	return last[_tag];
+}
+
+unsigned int AllocationTracker::GetFrames()
+{
+	return frames;
+}
+
+void AllocationTracker::Report(std::ostream& _out)
+{
+	_out << "Allocations per frame over " << frames << " frames:\n";
+	for(int tag = 0; tag < AllocationTag::Count && frames > 0; tag++)
+	{
+		const Totals& total = totals[tag];
+		if(total.allocations == 0)
+			continue;
+		_out << "  " << tagNames[tag] << ": " << total.allocations / frames << " allocations (peak " << total.peak_allocations <<
+				"), " << total.bytes / frames << " bytes (peak " << total.peak_bytes << ")\n";
+	}
+
+	std::vector<CallSite> sampled;
+	for(unsigned int i = 0; i < sampleSlots; i++)
+	{
+		if(sites[i].caller && sites[i].count > 0)
+			sampled.push_back(sites[i]);
+	}
+	if(sampled.empty())
+		return;
+	std::sort(sampled.begin(), sampled.end(), MoreSampled);
+	_out << "Allocation call sites, sampled 1 in " << sampleEvery << ":\n";
+	for(unsigned int i = 0; i < sampled.size() && i < reportedSites; i++)
+	{
+		_out << "  " << sampled[i].caller << " " << tagNames[sampled[i].tag] << ": " << sampled[i].count << " samples\n";
+	}
+	if(unsampled > 0)
+		_out << "  " << unsampled << " samples from sites that didn't fit\n";
+}
+
+/* Every allocation in the program comes through here, so this is only linked in once */
+void* operator new(size_t _bytes) throw(std::bad_alloc)
+{
+	AllocationTracker::Count(_bytes, ALLOCATION_CALLER());
+	void* block = malloc(_bytes ? _bytes : 1);
+	if(!block)
+		throw std::bad_alloc();
+	return block;
+}
+
+void* operator new[](size_t _bytes) throw(std::bad_alloc)
+{
+	AllocationTracker::Count(_bytes, ALLOCATION_CALLER());
+	void* block = malloc(_bytes ? _bytes : 1);
+	if(!block)
+		throw std::bad_alloc();
+	return block;
+}
+
+void* operator new(size_t _bytes, const std::nothrow_t&) throw()
+{
+	AllocationTracker::Count(_bytes, ALLOCATION_CALLER());
+	return malloc(_bytes ? _bytes : 1);
+}
+
+void* operator new[](size_t _bytes, const std::nothrow_t&) throw()
+{
+	AllocationTracker::Count(_bytes, ALLOCATION_CALLER());
+	return malloc(_bytes ? _bytes : 1);
+}
+
+void operator delete(void* _block) throw()
+{
+	free(_block);
+}
+
+void operator delete[](void* _block) throw()
+{
+	free(_block);
+}
+
+void operator delete(void* _block, const std::nothrow_t&) throw()
+{
+	free(_block);
+}
+
+void operator delete[](void* _block, const std::nothrow_t&) throw()
+{
+	free(_block);
+}
@@ -0,0 +1,148 @@
+#include "stdafx.h"
+#include <AssetBundle.h>
+#include <ImageCache.h>
+#include <BlittableRect.h>
+#include <sdl.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+	const char* bundle_path = "TestBundle.bundle";
+}
+
+TEST(AssetBundleRoundTripsData)
+{
+	AssetBundleWriter writer;
+	const char level[] = "level bytes";
+	const int table[] = {1, 2, 3, 4};
+	writer.AddData("Levels/B.Level", AssetType::Data, level, sizeof(level));
+	writer.AddData("Animations/A.animation", AssetType::Data, table, sizeof(table));
+	writer.AddData("Sounds/C.wav", AssetType::Sound, table, sizeof(table), 44100, 16, 2);
+	writer.AddData("Levels/A.Level", AssetType::Data, "old", 3);
+	writer.AddData("Levels/A.Level", AssetType::Data, "new!", 4); //Replaces
+	CHECK_EQUAL(4u, writer.GetCount());
+	CHECK(writer.Write(bundle_path));
+
+	AssetBundle bundle;
+	CHECK(!bundle.IsOpen());
+	CHECK(bundle.Find("Levels/A.Level") == NULL);
+	CHECK(bundle.Open(bundle_path));
+	CHECK_EQUAL(4u, bundle.GetCount());
+
+	const AssetBundle::Entry* entry = bundle.Find("Levels/B.Level");
+	CHECK(entry != NULL);
+	if(entry)
+	{
+		CHECK_EQUAL((unsigned int)sizeof(level), entry->size);
+		CHECK_EQUAL(0, memcmp(level, bundle.GetData(entry), sizeof(level)));
+		//Aligned, so tables of ints and floats can be read in place
+		CHECK_EQUAL(0u, entry->offset % 16);
+	}
+	entry = bundle.Find("Levels/A.Level");
+	CHECK(entry != NULL);
+	if(entry)
+		CHECK_EQUAL(std::string("new!"), std::string(bundle.GetData(entry), entry->size));
+	entry = bundle.Find("Sounds/C.wav");
+	CHECK(entry != NULL);
+	if(entry)
+	{
+		CHECK_EQUAL((unsigned int)AssetType::Sound, entry->type);
+		CHECK_EQUAL(44100u, entry->params[0]);
+		CHECK_EQUAL(2u, entry->params[2]);
+	}
+	CHECK(bundle.Find("Levels/C.Level") == NULL);
+	CHECK(bundle.Find("") == NULL);
+	CHECK(bundle.CreateSurface("Levels/A.Level") == NULL);
+
+	std::vector<std::string> levels;
+	bundle.List("Levels/", ".Level", levels);
+	CHECK_EQUAL(2u, levels.size());
+	if(levels.size() == 2)
+	{
+		CHECK_EQUAL(std::string("Levels/A.Level"), levels[0]);
+		CHECK_EQUAL(std::string("Levels/B.Level"), levels[1]);
+	}
+
+	bundle.Close();
+	CHECK(!bundle.IsOpen());
+	CHECK(bundle.Find("Levels/B.Level") == NULL);
+	std::remove(bundle_path);
+}
+
+TEST(AssetBundleRejectsDamagedFiles)
+{
+	AssetBundle bundle;
+	CHECK(!bundle.Open("Missing.bundle"));
+
+	{
+		std::ofstream out(bundle_path, std::ios::binary | std::ios::trunc);
+		out << "Not a bundle at all, but long enough to have a header";
+	}
+	CHECK(!bundle.Open(bundle_path));
+	CHECK(!bundle.IsOpen());
+
+	//A whole bundle cut short loses its index
+	AssetBundleWriter writer;
+	std::vector<char> data(1000, 'x');
+	writer.AddData("Big", AssetType::Data, &data[0], static_cast<unsigned int>(data.size()));
+	CHECK(writer.Write(bundle_path));
+	std::vector<char> whole;
+	{
+		std::ifstream in(bundle_path, std::ios::binary);
+		whole.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	}
+	{
+		std::ofstream out(bundle_path, std::ios::binary | std::ios::trunc);
+		out.write(&whole[0], whole.size() - 8);
+	}
+	CHECK(!bundle.Open(bundle_path));
+	std::remove(bundle_path);
+}
+
+TEST_FIXTURE(SDL_fixture, ImageCacheServesBundledImagesInPlace)
+{
+	CHECK(SDL_init_ok);
+	if(SDL_init_ok)
+	{
+		SDL_Surface* source = SDL_CreateRGBSurface(SDL_SWSURFACE, 8, 4, 32, 0xff, 0xff00, 0xff0000, 0xff000000);
+		SDL_Surface* image = SDL_DisplayFormatAlpha(source);
+		SDL_FreeSurface(source);
+		SDL_LockSurface(image);
+		for(int i = 0; i < 8 * 4; i++)
+		{
+			static_cast<Uint32*>(image->pixels)[i] = 0xff000000 | i;
+		}
+		SDL_UnlockSurface(image);
+
+		AssetBundleWriter writer;
+		CHECK(writer.AddImage("Animations/Bundled.png", image));
+		CHECK(writer.Write(bundle_path));
+		SDL_FreeSurface(image);
+
+		ImageCache::Instance().Purge();
+		CHECK(AssetBundle::Instance().Open(bundle_path));
+		{
+			//There is no Animations/Bundled.png on disk, it can only have come from the bundle
+			BlittableRect bundled("Bundled.png");
+			CHECK_EQUAL(false, bundled.GetError());
+			CHECK_EQUAL(true, bundled.IsShared());
+			CHECK_EQUAL(Vector2i(8, 4), bundled.GetSize());
+
+			SDL_Surface* cached = ImageCache::Instance().Acquire("Animations/Bundled.png");
+			CHECK(cached != NULL);
+			if(cached)
+			{
+				const AssetBundle::Entry* entry = AssetBundle::Instance().Find("Animations/Bundled.png");
+				const char* pixels = AssetBundle::Instance().GetData(entry) + sizeof(AssetBundle::ImageHeader);
+				CHECK(cached->pixels == pixels);
+				CHECK_EQUAL(0xff000000u | 9u, static_cast<Uint32*>(cached->pixels)[9]);
+				ImageCache::Instance().Release(cached);
+			}
+		}
+		ImageCache::Instance().Purge();
+		AssetBundle::Instance().Close();
+		std::remove(bundle_path);
+	}
+}
@@ -0,0 +1,101 @@
+#include "stdafx.h"
+#include <Widget.h>
+#include <sdl.h>
+
+TEST_FIXTURE(SDL_fixture, BackingStoreMadeOnFirstVisibleRedraw)
+{
+	CHECK(SDL_init_ok);
+	if(SDL_init_ok)
+	{
+		Widget::ClearRoot();
+		unsigned int before = Widget::GetBackingStoreBytes();
+		BlittableRect screen(Vector2i(640, 480));
+		Widget* container = new Widget();
+		CHECK(container->GetBackRect() == NULL);
+		container->SetSize(Vector2i(100, 100));
+		Widget* hidden = new Widget();
+		hidden->SetVisibility(false);
+		Widget* offscreen = new Widget();
+		offscreen->SetPosition(Vector2i(-1000, 0));
+		CHECK_EQUAL(before, Widget::GetBackingStoreBytes());
+
+		Widget::RenderRoot(&screen);
+		CHECK_EQUAL(before + 100u * 100u * 4u, Widget::GetBackingStoreBytes());
+
+		//Resizing drops the buffer until the next redraw
+		container->SetSize(Vector2i(50, 50));
+		CHECK_EQUAL(before, Widget::GetBackingStoreBytes());
+		Widget::RenderRoot(&screen);
+		CHECK_EQUAL(before + 50u * 50u * 4u, Widget::GetBackingStoreBytes());
+
+		Widget::ClearRoot();
+		CHECK_EQUAL(before, Widget::GetBackingStoreBytes());
+	}
+}
+
+TEST_FIXTURE(SDL_fixture, HiddenWidgetsReleaseBackingStore)
+{
+	CHECK(SDL_init_ok);
+	if(SDL_init_ok)
+	{
+		Widget::ClearRoot();
+		unsigned int before = Widget::GetBackingStoreBytes();
+		BlittableRect screen(Vector2i(640, 480));
+		Widget* panel = new Widget();
+		panel->SetSize(Vector2i(100, 100));
+		Widget* child = new Widget();
+		child->SetSize(Vector2i(10, 10));
+		panel->AddChild(child);
+		Widget::RenderRoot(&screen);
+		CHECK_EQUAL(before + (100u * 100u + 10u * 10u) * 4u, Widget::GetBackingStoreBytes());
+
+		//Kept while briefly hidden, so flicking visibility doesn't churn surfaces
+		panel->SetVisibility(false);
+		Widget::RenderRoot(&screen);
+		CHECK_EQUAL(before + (100u * 100u + 10u * 10u) * 4u, Widget::GetBackingStoreBytes());
+
+		for(unsigned int frame = 0; frame < Widget::release_hidden_frames + Widget::release_check_frames; frame++)
+		{
+			Widget::RenderRoot(&screen);
+		}
+		CHECK_EQUAL(before, Widget::GetBackingStoreBytes());
+		CHECK_EQUAL(true, panel->IsDirty());
+
+		panel->SetVisibility(true);
+		Widget::RenderRoot(&screen);
+		CHECK_EQUAL(before + (100u * 100u + 10u * 10u) * 4u, Widget::GetBackingStoreBytes());
+		CHECK_EQUAL(false, panel->IsDirty());
+		Widget::ClearRoot();
+	}
+}
+
+TEST_FIXTURE(SDL_fixture, WidgetWithoutPixelsComposesBlack)
+{
+	CHECK(SDL_init_ok);
+	if(SDL_init_ok)
+	{
+		Widget::ClearRoot();
+		SDL_Surface* surface = SDL_CreateRGBSurface(SDL_SWSURFACE, 640, 480, 32, 0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000);
+		BlittableRect screen(surface, true);
+		screen.Fill(255, 255, 0, 0);
+		Widget::SetFade(0);
+		//No back buffer, but solid as the buffer it used to be given was
+		Widget* panel = new Widget();
+		panel->SetSize(Vector2i(20, 20));
+		panel->SetPosition(Vector2i(10, 10));
+		CHECK(panel->GetBackRect() == NULL);
+		Widget::RenderRoot(&screen);
+
+		Uint8 r, g, b, a;
+		SDL_GetRGBA(reinterpret_cast<Uint32*>(static_cast<Uint8*>(surface->pixels) + surface->pitch * 15)[15], surface->format, &r, &g, &b, &a);
+		CHECK_EQUAL(0, r);
+		CHECK_EQUAL(0, g);
+		CHECK_EQUAL(0, b);
+		CHECK_EQUAL(255, a);
+		//Outside it the screen is untouched
+		SDL_GetRGBA(reinterpret_cast<Uint32*>(static_cast<Uint8*>(surface->pixels) + surface->pitch * 15)[40], surface->format, &r, &g, &b, &a);
+		CHECK_EQUAL(255, r);
+		Widget::ClearRoot();
+		SDL_FreeSurface(surface);
+	}
+}
@@ -0,0 +1,172 @@
+#include "stdafx.h"
+#include <Widget.h>
+#include <DamageRegion.h>
+#include <AllocationTracker.h>
+#include <sdl.h>
+
+TEST(DamageRegionMergesRects)
+{
+	DamageRegion region;
+	region.Add(DamageRect(Vector2i(0, 0), Vector2i(10, 10)));
+	region.Add(DamageRect(Vector2i(2, 2), Vector2i(4, 4)));		//Already covered
+	CHECK_EQUAL(1u, region.GetRects().size());
+	region.Add(DamageRect(Vector2i(10, 0), Vector2i(10, 10)));	//Adjacent, merges for free
+	CHECK_EQUAL(1u, region.GetRects().size());
+	CHECK_EQUAL(200, region.GetArea());
+	region.Add(DamageRect(Vector2i(100, 100), Vector2i(5, 5)));	//Far away, kept separate
+	CHECK_EQUAL(2u, region.GetRects().size());
+	CHECK_EQUAL(225, region.GetArea());
+	region.Add(DamageRect(Vector2i(100, 100), Vector2i(0, 5)));	//Empty
+	CHECK_EQUAL(2u, region.GetRects().size());
+
+	for(int i = 0; i < 20; i++)
+	{
+		region.Add(DamageRect(Vector2i(i * 20, 300), Vector2i(2, 2)));
+	}
+	//Collapsed to a bounding box rather than growing without limit
+	CHECK(region.GetRects().size() <= DamageRegion::max_rects);
+	CHECK(region.GetBounds().Contains(DamageRect(Vector2i(0, 0), Vector2i(382, 302))));
+}
+
+TEST_FIXTURE(SDL_fixture, ChildChangeRecomposesOnlyChild)
+{
+	CHECK(SDL_init_ok);
+	if(SDL_init_ok)
+	{
+		Widget::ClearRoot();
+		BlittableRect screen(Vector2i(640, 480));
+		Widget* parent = new Widget();
+		parent->SetSize(Vector2i(200, 200));
+		Widget* child = new Widget();
+		child->SetSize(Vector2i(20, 20));
+		child->SetPosition(Vector2i(10, 10));
+		parent->AddChild(child);
+
+		//Child, parent and the parent on screen
+		Widget::RenderRoot(&screen);
+		CHECK_EQUAL(400u + 40000u + 400u + 40000u, Widget::GetPixelsComposed());
+		CHECK_EQUAL(false, parent->IsDirty());
+
+		//Nothing changed, just the screen blit
+		Widget::RenderRoot(&screen);
+		CHECK_EQUAL(40000u, Widget::GetPixelsComposed());
+
+		child->Invalidate();
+		CHECK_EQUAL(true, parent->IsDirty());
+		Widget::RenderRoot(&screen);
+		CHECK_EQUAL(400u + 400u + 400u + 40000u, Widget::GetPixelsComposed());
+
+		//Moving recomposes where it was and where it went
+		child->SetPosition(Vector2i(100, 100));
+		Widget::RenderRoot(&screen);
+		CHECK_EQUAL(400u + 400u + 400u + 40000u, Widget::GetPixelsComposed());
+		Widget::ClearRoot();
+	}
+}
+
+TEST_FIXTURE(SDL_fixture, OpaqueChildOccludesParent)
+{
+	CHECK(SDL_init_ok);
+	if(SDL_init_ok)
+	{
+		Widget::ClearRoot();
+		BlittableRect screen(Vector2i(640, 480));
+		Widget* parent = new Widget();
+		parent->SetSize(Vector2i(100, 100));
+		Widget* cover = new Widget();
+		cover->SetSize(Vector2i(100, 100));
+		cover->SetOpaque(true);
+		parent->AddChild(cover);
+		Widget::RenderRoot(&screen);
+
+		//Only the cover is put into the parent
+		parent->Invalidate();
+		Widget::RenderRoot(&screen);
+		CHECK_EQUAL(10000u + 10000u, Widget::GetPixelsComposed());
+
+		cover->SetOpaque(false);
+		parent->Invalidate();
+		Widget::RenderRoot(&screen);
+		CHECK_EQUAL(10000u + 10000u + 10000u, Widget::GetPixelsComposed());
+		Widget::ClearRoot();
+	}
+}
+
+TEST_FIXTURE(SDL_fixture, CompositorSkipsHiddenAndOffscreenWidgets)
+{
+	CHECK(SDL_init_ok);
+	if(SDL_init_ok)
+	{
+		Widget::ClearRoot();
+		BlittableRect screen(Vector2i(640, 480));
+		Widget* offscreen = new Widget();
+		offscreen->SetPosition(Vector2i(1000, 1000));
+		Widget* hidden = new Widget();
+		hidden->SetVisibility(false);
+		Widget::RenderRoot(&screen);
+		CHECK_EQUAL(0u, Widget::GetPixelsComposed());
+		CHECK_EQUAL(true, offscreen->IsDirty());
+		CHECK_EQUAL(true, hidden->IsDirty());
+
+		offscreen->SetPosition(Vector2i(0, 0));
+		Widget::RenderRoot(&screen);
+		CHECK_EQUAL(false, offscreen->IsDirty());
+		Widget::ClearRoot();
+	}
+}
+
+TEST_FIXTURE(SDL_fixture, ChildrenSortedWhenZOrderChanges)
+{
+	CHECK(SDL_init_ok);
+	if(SDL_init_ok)
+	{
+		Widget::ClearRoot();
+		BlittableRect screen(Vector2i(640, 480));
+		Widget* parent = new Widget();
+		Widget* first = new Widget();
+		Widget* second = new Widget();
+		parent->AddChild(first);
+		parent->AddChild(second);
+		Widget::RenderRoot(&screen);
+		CHECK(parent->GetChildren()[0] == first);
+
+		first->SetZOrder(10);
+		CHECK_EQUAL(true, parent->IsDirty());
+		Widget::RenderRoot(&screen);
+		CHECK(parent->GetChildren()[0] == second);
+		CHECK(parent->GetChildren()[1] == first);
+		Widget::ClearRoot();
+	}
+}
+
+TEST_FIXTURE(SDL_fixture, UnchangedFrameStaysInItsAllocationBudget)
+{
+	CHECK(SDL_init_ok);
+	if(SDL_init_ok)
+	{
+		Widget::ClearRoot();
+		BlittableRect screen(Vector2i(640, 480));
+		Widget* parent = new Widget();
+		parent->SetSize(Vector2i(200, 200));
+		Widget* child = new Widget();
+		child->SetSize(Vector2i(20, 20));
+		parent->AddChild(child);
+		Widget::RenderRoot(&screen);
+
+		AllocationTracker::Reset();
+		AllocationTracker::Enable(true);
+		AllocationTracker::EndFrame();
+		Widget::RenderRoot(&screen);
+		AllocationStats unchanged = AllocationTracker::GetCurrent(AllocationTag::Rendering);
+		child->Invalidate();
+		AllocationTracker::EndFrame();
+		Widget::RenderRoot(&screen);
+		AllocationStats redrawn = AllocationTracker::GetCurrent(AllocationTag::Rendering);
+		AllocationTracker::Enable(false);
+		AllocationTracker::Reset();
+		//A frame where nothing changed only blits
+		CHECK_EQUAL(0u, unchanged.allocations);
+		CHECK(redrawn.allocations <= 4);
+		Widget::ClearRoot();
+	}
+}
@@ -0,0 +1,85 @@
+#include "stdafx.h"
+#include <FrameScheduler.h>
+#include <HighResClock.h>
+#include <sstream>
+
+namespace
+{
+	void BusyWait(double _seconds)
+	{
+		double end = HighResClock::Seconds() + _seconds;
+		while(HighResClock::Seconds() < end)
+		{
+		}
+	}
+}
+
+TEST(FrameHistogramPercentiles)
+{
+	FrameHistogram histogram;
+	CHECK_EQUAL(0.0, histogram.Percentile(0.95));
+	for(int i = 0; i < 95; i++)
+		histogram.Add(0.0101);
+	for(int i = 0; i < 4; i++)
+		histogram.Add(0.0201);
+	histogram.Add(0.5);
+	CHECK_EQUAL(100u, histogram.GetCount());
+	CHECK_CLOSE(0.01025, histogram.Percentile(0.95), 1e-9);
+	CHECK_CLOSE(0.02025, histogram.Percentile(0.99), 1e-9);
+	CHECK_CLOSE(0.5, histogram.Percentile(1.0), 1e-9); //Past the last bin, the worst time
+	CHECK_CLOSE(0.5, histogram.GetWorst(), 1e-9);
+
+	histogram.Remove(0.5);
+	CHECK_EQUAL(99u, histogram.GetCount());
+	CHECK_CLOSE(0.02025, histogram.Percentile(1.0), 1e-9);
+	CHECK_CLOSE((95 * 0.0101 + 4 * 0.0201) / 99, histogram.GetAverage(), 1e-9);
+}
+
+TEST(FrameSchedulerHoldsFramesToTheCap)
+{
+	FrameScheduler scheduler(100);
+	CHECK_CLOSE(0.01, scheduler.GetPeriod(), 1e-9);
+	double start = HighResClock::Seconds();
+	scheduler.Reset();
+	for(int i = 0; i < 10; i++)
+	{
+		scheduler.EndFrame();
+		CHECK(scheduler.GetLastFrameTime() >= 0.01);
+	}
+	CHECK(HighResClock::Seconds() - start >= 0.1);
+	FrameStats stats = scheduler.GetTotalStats();
+	CHECK_EQUAL(10u, stats.frames);
+	CHECK_EQUAL(0u, stats.missed);
+	CHECK(stats.average >= 0.01);
+}
+
+TEST(FrameSchedulerCountsMissedDeadlines)
+{
+	FrameScheduler scheduler(200);
+	scheduler.EndFrame();
+	BusyWait(0.01);
+	scheduler.EndFrame();
+	FrameStats recent = scheduler.GetRecentStats();
+	CHECK_EQUAL(2u, recent.frames);
+	CHECK_EQUAL(1u, recent.missed);
+	CHECK(recent.worst >= 0.01);
+
+	//Uncapped frames never wait and are never late
+	scheduler.SetCap(0);
+	scheduler.EndFrame();
+	CHECK(scheduler.GetLastFrameTime() < 0.005);
+	CHECK_EQUAL(1u, scheduler.GetTotalStats().missed);
+
+	std::ostringstream report;
+	scheduler.Report(report);
+	CHECK(report.str().find("missed deadlines: 1") != std::string::npos);
+}
+
+TEST(FrameSchedulerRecentStatsRollOver)
+{
+	FrameScheduler scheduler(0);
+	for(unsigned int i = 0; i < FrameScheduler::recent_frames + 20; i++)
+		scheduler.EndFrame();
+	CHECK_EQUAL(FrameScheduler::recent_frames, scheduler.GetRecentStats().frames);
+	CHECK_EQUAL(FrameScheduler::recent_frames + 20, scheduler.GetTotalStats().frames);
+}
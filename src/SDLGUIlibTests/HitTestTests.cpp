@@ -0,0 +1,169 @@
+#include "stdafx.h"
+#include <Widget.h>
+#include <WidgetGrid.h>
+#include <sdl.h>
+#include <algorithm>
+
+namespace
+{
+	bool Found(std::vector<Widget*>& _found, Widget* _widget)
+	{
+		return std::find(_found.begin(), _found.end(), _widget) != _found.end();
+	}
+
+	int top_click_count = 0;
+	int bottom_click_count = 0;
+	void TopClick(Widget* /*_widget*/)
+	{
+		top_click_count++;
+	}
+	void BottomClick(Widget* /*_widget*/)
+	{
+		bottom_click_count++;
+	}
+}
+
+TEST(WidgetGridFindsRectsUnderPoint)
+{
+	//The grid never dereferences the widgets, so any distinct pointers will do
+	Widget* a = reinterpret_cast<Widget*>(0x10);
+	Widget* b = reinterpret_cast<Widget*>(0x20);
+	Widget* c = reinterpret_cast<Widget*>(0x30);
+	WidgetGrid grid(16);
+	grid.Update(a, DamageRect(Vector2i(0, 0), Vector2i(40, 40)));
+	grid.Update(b, DamageRect(Vector2i(-20, -20), Vector2i(30, 30)));
+	grid.Update(c, DamageRect(Vector2i(-1000, -1000), Vector2i(5000, 5000))); //Too many cells, kept aside
+	CHECK_EQUAL(3u, grid.GetCount());
+
+	std::vector<Widget*> found;
+	grid.Query(Vector2i(5, 5), found);
+	CHECK_EQUAL(3u, found.size());
+
+	found.clear();
+	grid.Query(Vector2i(-5, -5), found);
+	CHECK_EQUAL(2u, found.size());
+	CHECK(Found(found, b));
+	CHECK(!Found(found, a));
+
+	//Right and bottom edges are exclusive
+	found.clear();
+	grid.Query(Vector2i(40, 20), found);
+	CHECK(!Found(found, a));
+
+	grid.Update(a, DamageRect(Vector2i(100, 100), Vector2i(10, 10)));
+	found.clear();
+	grid.Query(Vector2i(5, 5), found);
+	CHECK(!Found(found, a));
+	found.clear();
+	grid.Query(Vector2i(105, 105), found);
+	CHECK(Found(found, a));
+
+	grid.Remove(c);
+	grid.Remove(a);
+	found.clear();
+	grid.Query(Vector2i(105, 105), found);
+	CHECK_EQUAL(0u, found.size());
+	CHECK_EQUAL(1u, grid.GetCount());
+}
+
+TEST_FIXTURE(SDL_fixture, WidgetAtFindsTopmostDeepestWidget)
+{
+	CHECK(SDL_init_ok);
+	if(SDL_init_ok)
+	{
+		Widget::ClearRoot();
+		Widget* bottom = new Widget();
+		Widget* top = new Widget();
+		top->SetPosition(Vector2i(64, 0));
+		CHECK(Widget::WidgetAt(Vector2i(100, 10)) == top);
+		bottom->SetZOrder(1);
+		CHECK(Widget::WidgetAt(Vector2i(100, 10)) == bottom);
+		CHECK(Widget::WidgetAt(Vector2i(500, 400)) == NULL);
+
+		Widget* child = new Widget();
+		child->SetSize(Vector2i(16, 16));
+		child->SetPosition(Vector2i(8, 8));
+		bottom->AddChild(child);
+		CHECK(Widget::WidgetAt(Vector2i(10, 10)) == child);
+		CHECK(Widget::WidgetAt(Vector2i(2, 2)) == bottom);
+
+		//Moving the parent moves the child's hit area with it
+		bottom->SetPosition(Vector2i(200, 200));
+		CHECK_EQUAL(Vector2i(208, 208), child->GetGlobalPosition());
+		CHECK(Widget::WidgetAt(Vector2i(210, 210)) == child);
+		CHECK(Widget::WidgetAt(Vector2i(10, 10)) == NULL);
+
+		child->SetVisibility(false);
+		CHECK(Widget::WidgetAt(Vector2i(210, 210)) == bottom);
+
+		bottom->RemoveChild(child);
+		CHECK_EQUAL(Vector2i(8, 8), child->GetGlobalPosition());
+		Widget::ClearRoot();
+	}
+}
+
+TEST_FIXTURE(SDL_fixture, ClickGoesToTopmostWidgetOnly)
+{
+	CHECK(SDL_init_ok);
+	if(SDL_init_ok)
+	{
+		Widget::ClearRoot();
+		top_click_count = 0;
+		bottom_click_count = 0;
+		Widget* bottom = new Widget();
+		Widget* top = new Widget();
+		top->SetPosition(Vector2i(20, 20));
+		ScopedConnection c = bottom->OnClick.connect(BottomClick);
+		ScopedConnection c2 = top->OnClick.connect(TopClick);
+
+		SDL_Event event;
+		event.type = SDL_MOUSEBUTTONUP;
+		event.button.button = SDL_BUTTON_LEFT;
+		event.button.x = 30;
+		event.button.y = 30;
+		Widget::DistributeSDLEvents(&event);
+		CHECK_EQUAL(1, top_click_count);
+		CHECK_EQUAL(0, bottom_click_count);
+
+		event.button.x = 5;
+		event.button.y = 5;
+		Widget::DistributeSDLEvents(&event);
+		CHECK_EQUAL(1, top_click_count);
+		CHECK_EQUAL(1, bottom_click_count);
+		Widget::ClearRoot();
+	}
+}
+
+TEST_FIXTURE(SDL_fixture, HandleEventUsesZOrderChangedSinceRedraw)
+{
+	CHECK(SDL_init_ok);
+	if(SDL_init_ok)
+	{
+		Widget::ClearRoot();
+		top_click_count = 0;
+		bottom_click_count = 0;
+		BlittableRect screen(Vector2i(640, 480));
+		Widget* panel = new Widget();
+		panel->SetSize(Vector2i(200, 200));
+		Widget* bottom = new Widget();
+		Widget* top = new Widget();
+		top->SetPosition(Vector2i(20, 20));
+		panel->AddChild(bottom);
+		panel->AddChild(top);
+		ScopedConnection c = bottom->OnClick.connect(BottomClick);
+		ScopedConnection c2 = top->OnClick.connect(TopClick);
+		Widget::RenderRoot(&screen);
+
+		//Raised with no redraw between, so the children haven't been resorted for drawing yet
+		bottom->SetZOrder(1);
+		Event event;
+		event.event_type = EventType::MouseUp;
+		event.event.mouse_event.btns = MouseButton::Left;
+		event.event.mouse_event.x = 30;
+		event.event.mouse_event.y = 30;
+		panel->HandleEvent(event);
+		CHECK_EQUAL(0, top_click_count);
+		CHECK_EQUAL(1, bottom_click_count);
+		Widget::ClearRoot();
+	}
+}
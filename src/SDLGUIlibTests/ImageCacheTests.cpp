@@ -0,0 +1,108 @@
+#include "stdafx.h"
+#include <BlittableRect.h>
+#include <ImageCache.h>
+#include <JobSystem.h>
+#include <sdl.h>
+
+TEST_FIXTURE(SDL_fixture, ImageCacheSharesDecodedImage)
+{
+	CHECK(SDL_init_ok);
+	if(SDL_init_ok)
+	{
+		ImageCache::Instance().Purge();
+		unsigned int misses = ImageCache::Instance().GetMisses();
+		unsigned int hits = ImageCache::Instance().GetHits();
+
+		BlittableRect first("Present.png");
+		BlittableRect second("Present.png");
+		CHECK_EQUAL(false, first.GetError());
+		CHECK_EQUAL(true, first.IsShared());
+		CHECK_EQUAL(true, second.IsShared());
+		CHECK_EQUAL(misses + 1, ImageCache::Instance().GetMisses());
+		CHECK_EQUAL(hits + 1, ImageCache::Instance().GetHits());
+		CHECK_EQUAL(1u, ImageCache::Instance().GetCount());
+	}
+}
+
+TEST_FIXTURE(SDL_fixture, ImageCacheCopiesBeforeModify)
+{
+	CHECK(SDL_init_ok);
+	if(SDL_init_ok)
+	{
+		BlittableRect first("Present.png");
+		BlittableRect second("Present.png");
+		first.Fill(255, 255, 0, 0);
+		CHECK_EQUAL(false, first.IsShared());
+		CHECK_EQUAL(true, second.IsShared());
+
+		//Being the destination of a blit is also a modification
+		BlittableRect source(Vector2i(8, 8));
+		source.RawBlit(Vector2i(0, 0), &second);
+		CHECK_EQUAL(false, second.IsShared());
+
+		//Reading from a shared image doesn't copy it
+		BlittableRect third("Present.png");
+		BlittableRect dest(Vector2i(128, 128));
+		third.RawBlit(Vector2i(0, 0), &dest);
+		CHECK_EQUAL(true, third.IsShared());
+	}
+}
+
+TEST_FIXTURE(SDL_fixture, ImageCachePurgeKeepsReferencedImages)
+{
+	CHECK(SDL_init_ok);
+	if(SDL_init_ok)
+	{
+		ImageCache::Instance().Purge();
+		CHECK_EQUAL(true, ImageCache::Instance().Preload("Animations/Present.png"));
+		CHECK_EQUAL(1u, ImageCache::Instance().GetCount());
+		{
+			BlittableRect held("Present.png");
+			ImageCache::Instance().Purge();
+			CHECK_EQUAL(1u, ImageCache::Instance().GetCount());
+			CHECK_EQUAL(true, held.IsShared());
+		}
+		ImageCache::Instance().Purge();
+		CHECK_EQUAL(0u, ImageCache::Instance().GetCount());
+	}
+}
+
+TEST_FIXTURE(SDL_fixture, ImageCacheDoesNotCacheMissingImages)
+{
+	CHECK(SDL_init_ok);
+	if(SDL_init_ok)
+	{
+		ImageCache::Instance().Purge();
+		CHECK(ImageCache::Instance().Acquire("Animations/Missing.png") == NULL);
+		CHECK_EQUAL(false, ImageCache::Instance().Preload("Animations/Missing.png"));
+		CHECK_EQUAL(0u, ImageCache::Instance().GetCount());
+		BlittableRect missing("Missing.png");
+		CHECK_EQUAL(true, missing.GetError());
+		CHECK_EQUAL(false, missing.IsShared());
+	}
+}
+
+TEST_FIXTURE(SDL_fixture, ImageCachePreloadsOnWorker)
+{
+	CHECK(SDL_init_ok);
+	if(SDL_init_ok)
+	{
+		ImageCache::Instance().Purge();
+		JobSystem jobs(2);
+		ImageCache::Instance().Preload("Animations/Present.png", jobs);
+		ImageCache::Instance().Preload("Animations/Missing.png", jobs);
+		//Nothing reaches the cache until the jobs complete
+		CHECK_EQUAL(0u, ImageCache::Instance().GetCount());
+		jobs.WaitAll();
+		CHECK_EQUAL(1u, ImageCache::Instance().GetCount());
+
+		unsigned int misses = ImageCache::Instance().GetMisses();
+		BlittableRect loaded("Present.png");
+		CHECK_EQUAL(true, loaded.IsShared());
+		CHECK_EQUAL(misses, ImageCache::Instance().GetMisses());
+
+		//Already cached, nothing to do
+		ImageCache::Instance().Preload("Animations/Present.png", jobs);
+		CHECK(jobs.IsIdle());
+	}
+}
@@ -0,0 +1,183 @@
+#include "stdafx.h"
+#include <BlittableRect.h>
+#include <ImageScaler.h>
+#include <sdl.h>
+#include <cstdlib>
+
+namespace
+{
+	SDL_Surface* CreateTestSurface(int _w, int _h)
+	{
+		return SDL_CreateRGBSurface(SDL_SWSURFACE, _w, _h, 32, 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000);
+	}
+
+	Uint32& PixelAt(SDL_Surface* _surface, int _x, int _y)
+	{
+		return reinterpret_cast<Uint32*>(static_cast<Uint8*>(_surface->pixels) + _surface->pitch * _y)[_x];
+	}
+}
+
+TEST_FIXTURE(SDL_fixture, ScalerNearestPicksBlockOrigin)
+{
+	CHECK(SDL_init_ok);
+	if(SDL_init_ok)
+	{
+		SDL_Surface* src = CreateTestSurface(4, 4);
+		SDL_Surface* dest = CreateTestSurface(2, 2);
+		for(int y = 0; y < 4; y++)
+			for(int x = 0; x < 4; x++)
+				PixelAt(src, x, y) = y * 4 + x;
+
+		CHECK(ImageScaler::Scale(src, dest, ScaleFilter::Nearest));
+		CHECK_EQUAL(0u, PixelAt(dest, 0, 0));
+		CHECK_EQUAL(2u, PixelAt(dest, 1, 0));
+		CHECK_EQUAL(8u, PixelAt(dest, 0, 1));
+		CHECK_EQUAL(10u, PixelAt(dest, 1, 1));
+		SDL_FreeSurface(src);
+		SDL_FreeSurface(dest);
+	}
+}
+
+TEST_FIXTURE(SDL_fixture, ScalerNearestUpscaleRepeatsPixels)
+{
+	CHECK(SDL_init_ok);
+	if(SDL_init_ok)
+	{
+		SDL_Surface* src = CreateTestSurface(2, 1);
+		SDL_Surface* dest = CreateTestSurface(4, 3);
+		PixelAt(src, 0, 0) = 0x11223344;
+		PixelAt(src, 1, 0) = 0x55667788;
+
+		CHECK(ImageScaler::Scale(src, dest, ScaleFilter::Nearest));
+		for(int y = 0; y < 3; y++)
+		{
+			CHECK_EQUAL(0x11223344u, PixelAt(dest, 1, y));
+			CHECK_EQUAL(0x55667788u, PixelAt(dest, 2, y));
+		}
+		SDL_FreeSurface(src);
+		SDL_FreeSurface(dest);
+	}
+}
+
+TEST_FIXTURE(SDL_fixture, ScalerBoxAveragesEachChannel)
+{
+	CHECK(SDL_init_ok);
+	if(SDL_init_ok)
+	{
+		//Odd width exercises the single pixel tail of the wide path
+		SDL_Surface* src = CreateTestSurface(6, 2);
+		SDL_Surface* dest = CreateTestSurface(2, 1);
+		for(int y = 0; y < 2; y++)
+		{
+			for(int x = 0; x < 3; x++)
+			{
+				PixelAt(src, x, y) = (x + y) % 2 ? 0xff402000 : 0xff000000;
+				PixelAt(src, x + 3, y) = 0x80808080;
+			}
+		}
+
+		CHECK(ImageScaler::Scale(src, dest, ScaleFilter::Box));
+		CHECK_EQUAL(0xff201000u, PixelAt(dest, 0, 0));
+		CHECK_EQUAL(0x80808080u, PixelAt(dest, 1, 0));
+		SDL_FreeSurface(src);
+		SDL_FreeSurface(dest);
+	}
+}
+
+TEST_FIXTURE(SDL_fixture, ScalerBoxSIMDMatchesScalar)
+{
+	CHECK(SDL_init_ok);
+	if(SDL_init_ok)
+	{
+		srand(7);
+		SDL_Surface* src = CreateTestSurface(301, 299);
+		for(int y = 0; y < src->h; y++)
+			for(int x = 0; x < src->w; x++)
+				PixelAt(src, x, y) = (static_cast<Uint32>(rand() & 0xffff) << 16) | static_cast<Uint32>(rand() & 0xffff);
+
+		//Halving gives exact .5 averages, and one pixel for the whole image is past the float exact range
+		const int sizes[][2] = {{150, 149}, {37, 29}, {100, 3}, {7, 150}, {1, 1}, {301, 299}};
+		for(int i = 0; i < 6; i++)
+		{
+			SDL_Surface* scalar = CreateTestSurface(sizes[i][0], sizes[i][1]);
+			SDL_Surface* simd = CreateTestSurface(sizes[i][0], sizes[i][1]);
+			ImageScaler::SetSIMD(false);
+			CHECK(ImageScaler::Scale(src, scalar, ScaleFilter::Box));
+			ImageScaler::SetSIMD(true);
+			CHECK(ImageScaler::Scale(src, simd, ScaleFilter::Box));
+			int mismatches = 0;
+			for(int y = 0; y < scalar->h; y++)
+				for(int x = 0; x < scalar->w; x++)
+					mismatches += PixelAt(scalar, x, y) != PixelAt(simd, x, y);
+			CHECK_EQUAL(0, mismatches);
+			SDL_FreeSurface(scalar);
+			SDL_FreeSurface(simd);
+		}
+		SDL_FreeSurface(src);
+	}
+}
+
+TEST_FIXTURE(SDL_fixture, ScalerRejectsMismatchedFormats)
+{
+	CHECK(SDL_init_ok);
+	if(SDL_init_ok)
+	{
+		SDL_Surface* src = CreateTestSurface(4, 4);
+		SDL_Surface* dest = SDL_CreateRGBSurface(SDL_SWSURFACE, 2, 2, 16, 0xf800, 0x07e0, 0x001f, 0);
+		CHECK_EQUAL(false, ImageScaler::Scale(src, dest, ScaleFilter::Nearest));
+		SDL_FreeSurface(src);
+		SDL_FreeSurface(dest);
+	}
+}
+
+TEST_FIXTURE(SDL_fixture, ResizeReusesCachedResult)
+{
+	CHECK(SDL_init_ok);
+	if(SDL_init_ok)
+	{
+		ScaledImageCache::Instance().Clear();
+		BlittableRect br(Vector2i(64, 64));
+		br.SetSourceKey("ResizeReusesCachedResult");
+		unsigned int hits = ScaledImageCache::Instance().GetHits();
+
+		BlittableRect* first = br.Resize(Vector2i(16, 16), ScaleFilter::Box);
+		CHECK_EQUAL(hits, ScaledImageCache::Instance().GetHits());
+		BlittableRect* second = br.Resize(Vector2i(16, 16), ScaleFilter::Box);
+		CHECK_EQUAL(hits + 1, ScaledImageCache::Instance().GetHits());
+		CHECK_EQUAL(Vector2i(16, 16), second->GetSize());
+
+		//A different size or filter is a different entry
+		BlittableRect* third = br.Resize(Vector2i(16, 16));
+		CHECK_EQUAL(hits + 1, ScaledImageCache::Instance().GetHits());
+		CHECK_EQUAL(2u, ScaledImageCache::Instance().GetCount());
+
+		//Modifying the source drops its key, so stale results are not returned
+		br.Fill(255, 255, 0, 0);
+		CHECK_EQUAL(std::string(""), br.GetSourceKey());
+		delete first;
+		delete second;
+		delete third;
+		ScaledImageCache::Instance().Clear();
+	}
+}
+
+TEST_FIXTURE(SDL_fixture, ScaledCacheEvictsLeastRecentlyUsed)
+{
+	CHECK(SDL_init_ok);
+	if(SDL_init_ok)
+	{
+		ScaledImageCache& cache = ScaledImageCache::Instance();
+		cache.Clear();
+		unsigned int old_capacity = cache.GetCapacity();
+		cache.SetCapacity(2);
+		cache.Insert("a", Vector2i(1, 1), ScaleFilter::Nearest, CreateTestSurface(1, 1));
+		cache.Insert("b", Vector2i(1, 1), ScaleFilter::Nearest, CreateTestSurface(1, 1));
+		CHECK(cache.Find("a", Vector2i(1, 1), ScaleFilter::Nearest) != NULL);
+		cache.Insert("c", Vector2i(1, 1), ScaleFilter::Nearest, CreateTestSurface(1, 1));
+		CHECK_EQUAL(2u, cache.GetCount());
+		CHECK(cache.Find("a", Vector2i(1, 1), ScaleFilter::Nearest) != NULL);
+		CHECK(cache.Find("b", Vector2i(1, 1), ScaleFilter::Nearest) == NULL);
+		cache.SetCapacity(old_capacity);
+		cache.Clear();
+	}
+}
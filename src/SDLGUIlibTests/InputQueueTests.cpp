@@ -0,0 +1,113 @@
+#include "stdafx.h"
+#include <Widget.h>
+#include <InputQueue.h>
+#include <sdl.h>
+
+namespace
+{
+	SDL_Event Motion(int _x, int _y, int _xrel, int _yrel)
+	{
+		SDL_Event event;
+		event.type = SDL_MOUSEMOTION;
+		event.motion.state = 0;
+		event.motion.x = static_cast<Uint16>(_x);
+		event.motion.y = static_cast<Uint16>(_y);
+		event.motion.xrel = static_cast<Sint16>(_xrel);
+		event.motion.yrel = static_cast<Sint16>(_yrel);
+		return event;
+	}
+
+	SDL_Event Button(Uint8 _type, int _x, int _y)
+	{
+		SDL_Event event;
+		event.type = _type;
+		event.button.button = SDL_BUTTON_LEFT;
+		event.button.x = static_cast<Uint16>(_x);
+		event.button.y = static_cast<Uint16>(_y);
+		return event;
+	}
+
+	int global_move_count = 0;
+	MouseEventArgs last_move;
+	void CountMove(Widget* /*_widget*/, MouseEventArgs _args)
+	{
+		global_move_count++;
+		last_move = _args;
+	}
+}
+
+TEST(InputQueueMergesConsecutiveMotion)
+{
+	InputQueue queue;
+	queue.Push(Motion(10, 10, 1, 1), 1.0);
+	queue.Push(Motion(12, 11, 2, 1), 2.0);
+	queue.Push(Motion(15, 11, 3, 0), 3.0);
+	CHECK_EQUAL(1u, queue.GetEvents().size());
+	const InputQueue::TimedEvent& merged = queue.GetEvents()[0];
+	CHECK_EQUAL(15, merged.event.motion.x);
+	CHECK_EQUAL(11, merged.event.motion.y);
+	CHECK_EQUAL(6, merged.event.motion.xrel);
+	CHECK_EQUAL(2, merged.event.motion.yrel);
+	CHECK_CLOSE(1.0, merged.time, 0.0001);
+}
+
+TEST(InputQueueKeepsButtonOrder)
+{
+	InputQueue queue;
+	queue.Push(Motion(10, 10, 0, 0), 1.0);
+	queue.Push(Motion(20, 20, 0, 0), 1.0);
+	queue.Push(Button(SDL_MOUSEBUTTONDOWN, 20, 20), 1.0);
+	queue.Push(Motion(30, 30, 0, 0), 1.0);
+	queue.Push(Motion(40, 40, 0, 0), 1.0);
+	queue.Push(Button(SDL_MOUSEBUTTONUP, 40, 40), 1.0);
+	queue.Push(Motion(50, 50, 0, 0), 1.0);
+
+	//A drag still sees where it started and ended
+	const std::vector<InputQueue::TimedEvent>& events = queue.GetEvents();
+	CHECK_EQUAL(5u, events.size());
+	CHECK(events[0].event.type == SDL_MOUSEMOTION);
+	CHECK_EQUAL(20, events[0].event.motion.x);
+	CHECK(events[1].event.type == SDL_MOUSEBUTTONDOWN);
+	CHECK_EQUAL(40, events[2].event.motion.x);
+	CHECK(events[3].event.type == SDL_MOUSEBUTTONUP);
+	CHECK_EQUAL(50, events[4].event.motion.x);
+
+	SDL_Event quit;
+	quit.type = SDL_QUIT;
+	CHECK_EQUAL(false, queue.QuitRequested());
+	queue.Push(quit, 1.0);
+	CHECK_EQUAL(true, queue.QuitRequested());
+}
+
+TEST_FIXTURE(SDL_fixture, InputQueueDispatchesOncePerFrame)
+{
+	CHECK(SDL_init_ok);
+	if(SDL_init_ok)
+	{
+		Widget::ClearRoot();
+		global_move_count = 0;
+		ScopedConnection c = Widget::OnGlobalMouseMove.connect(CountMove);
+
+		InputQueue queue;
+		for(int i = 0; i < 100; i++)
+		{
+			queue.Push(Motion(i, i, 1, 1), 0.0);
+		}
+		queue.Dispatch();
+		CHECK_EQUAL(1, global_move_count);
+		CHECK_EQUAL(99, last_move.x);
+		CHECK_EQUAL(0u, queue.GetEvents().size());
+
+		const InputStats& stats = queue.GetFrameStats();
+		CHECK_EQUAL(100u, stats.received);
+		CHECK_EQUAL(1u, stats.dispatched);
+		CHECK_EQUAL(99u, stats.motion_coalesced);
+
+		queue.Push(Motion(5, 5, 0, 0), 0.0);
+		queue.Dispatch();
+		CHECK_EQUAL(1u, queue.GetFrameStats().received);
+		CHECK_EQUAL(101u, queue.GetTotalStats().received);
+		CHECK_EQUAL(2u, queue.GetFrames());
+		Widget::ClearRoot();
+	}
+}
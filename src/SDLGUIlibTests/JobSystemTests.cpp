@@ -0,0 +1,117 @@
+#include "stdafx.h"
+#include <JobSystem.h>
+#include <SDL.h>
+#include <SDL_thread.h>
+#include <vector>
+
+namespace
+{
+	/* Records which thread each half ran on */
+	class RecordingJob : public Job
+	{
+	public:
+		Uint32* run_thread;
+		Uint32* complete_thread;
+		std::vector<int>* completed;
+		int index;
+
+		RecordingJob(Uint32* _run_thread, Uint32* _complete_thread, std::vector<int>* _completed, int _index)
+		: run_thread(_run_thread), complete_thread(_complete_thread), completed(_completed), index(_index){}
+		void Run()
+		{
+			*run_thread = SDL_ThreadID();
+		}
+		void Complete()
+		{
+			*complete_thread = SDL_ThreadID();
+			completed->push_back(index);
+		}
+	};
+
+	class CountingJob : public Job
+	{
+	public:
+		int* completed;
+		explicit CountingJob(int* _completed) : completed(_completed){}
+		void Run(){}
+		void Complete(){(*completed)++;}
+	};
+}
+
+TEST(JobSystemCompletesOnPumpingThread)
+{
+	const int job_count = 32;
+	std::vector<Uint32> run_threads(job_count, 0);
+	std::vector<Uint32> complete_threads(job_count, 0);
+	std::vector<int> completed;
+	{
+		JobSystem jobs(3);
+		CHECK_EQUAL(3u, jobs.GetWorkerCount());
+		for(int i = 0; i < job_count; i++)
+		{
+			jobs.Submit(new RecordingJob(&run_threads[i], &complete_threads[i], &completed, i));
+		}
+		CHECK_EQUAL(job_count, (int)(jobs.GetOutstanding() + jobs.GetCompleted()));
+		jobs.WaitAll();
+		CHECK(jobs.IsIdle());
+		CHECK_EQUAL(job_count, (int)jobs.GetCompleted());
+	}
+
+	CHECK_EQUAL(job_count, (int)completed.size());
+	Uint32 main_thread = SDL_ThreadID();
+	int on_main = 0;
+	for(int i = 0; i < job_count; i++)
+	{
+		CHECK_EQUAL(main_thread, complete_threads[i]);
+		if(run_threads[i] == main_thread)
+			on_main++;
+	}
+	CHECK_EQUAL(0, on_main);
+}
+
+TEST(JobSystemWithoutWorkersRunsInline)
+{
+	Uint32 run_thread = 0;
+	Uint32 complete_thread = 0;
+	std::vector<int> completed;
+	JobSystem jobs(0);
+	CHECK_EQUAL(0u, jobs.GetWorkerCount());
+	jobs.Submit(new RecordingJob(&run_thread, &complete_thread, &completed, 0));
+	//Run has happened, Complete still waits for the pump
+	CHECK_EQUAL(SDL_ThreadID(), run_thread);
+	CHECK_EQUAL(0u, (unsigned int)completed.size());
+	CHECK_EQUAL(1u, jobs.GetOutstanding());
+	CHECK_EQUAL(1u, jobs.Pump(0.0));
+	CHECK_EQUAL(1u, (unsigned int)completed.size());
+	CHECK(jobs.IsIdle());
+	CHECK_EQUAL(0u, jobs.Pump(0.0));
+}
+
+TEST(JobSystemPumpStopsAtBudget)
+{
+	int completed = 0;
+	JobSystem jobs(0);
+	for(int i = 0; i < 10; i++)
+	{
+		jobs.Submit(new CountingJob(&completed));
+	}
+	//Any positive budget completes at least one job per pump
+	CHECK_EQUAL(1u, jobs.Pump(1e-9));
+	CHECK_EQUAL(1, completed);
+	jobs.WaitAll();
+	CHECK_EQUAL(10, completed);
+}
+
+TEST(JobSystemDeletesUnfinishedJobs)
+{
+	int completed = 0;
+	{
+		JobSystem jobs(2);
+		for(int i = 0; i < 10; i++)
+		{
+			jobs.Submit(new CountingJob(&completed));
+		}
+	}
+	//Destroyed without pumping, nothing completes
+	CHECK_EQUAL(0, completed);
+}
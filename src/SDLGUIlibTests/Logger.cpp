@@ -1,7 +1,338 @@
 #include "stdafx.h"
 #include "Logger.h"
+#include "SPSCQueue.h"
+#include <cstdio>
+#include <vector>
+#include <algorithm>
 
-Logger::Logger(std::string _filename)
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#define LOGGER_THREAD_LOCAL __declspec(thread)
+#else
+#include <pthread.h>
+#include <time.h>
+#define LOGGER_THREAD_LOCAL __thread
+#endif
+
+namespace LogFormat
+{
+	/* How a record's value is turned into text */
+	enum Enum
+	{
+		Int,
+		Unsigned,
+		Float,
+		Double,
+		Text,
+		Vector2,
+		Vector3
+	};
+}
+
+/* One logged value as queued for the writer, a cache line each. Longer text takes several */
+struct LogRecord
+{
+	double time;
+	unsigned char level;
+	unsigned char format;
+	unsigned char length;	//Bytes of text used
+	union
+	{
+		int i;
+		unsigned int u;
+		float f;
+		double d;
+		float v[3];
+		char text[48];
+	} value;
+};
+
+/* Records from one thread. The thread logging only pushes, the writer only pops, so neither
+   locks. Rings are kept until exit, so there's one per thread that has ever logged */
+struct LogRing
+{
+	LogRing();
+	SPSCQueue<LogRecord> records;
+	LogRing* next;
+	volatile unsigned int dropped;	//Only written by the thread logging
+	//The writer's
+	unsigned int reported;
+	std::string pending[LogLevel::Count];	//Unfinished line at each level
+	double started[LogLevel::Count];		//When it was started
+};
+
+/* A finished line waiting to be written */
+struct LogLine
+{
+	double time;
+	LogLevel::Enum level;
+	std::string text;
+};
+
+/* Everything behind Logger once the writer is running */
+class LogWriter
+{
+public:
+	static LogRecord Begin(LogLevel::Enum _level, LogFormat::Enum _format);
+	static void Log(const LogRecord& _record);
+	static void Format(const LogRecord& _record, std::string& _text);
+	/* Writes whatever has been queued, including unfinished lines if _all. False if there was nothing */
+	static bool Drain(bool _all);
+	static void Run();
+	static LogRing* GetThreadRing();
+};
+
+namespace
+{
+	const unsigned int ringRecords = 2048;
+	const unsigned int writerNap = 2;	//Milliseconds the writer sleeps when there's nothing to write
+
+	LogRing* volatile rings = NULL;
+	LOGGER_THREAD_LOCAL LogRing* threadRing = NULL;
+	volatile bool writing = false;		//Loggers queue records rather than writing them
+	volatile bool stopping = false;
+	volatile unsigned int passes = 0;	//Drains the writer has finished
+	std::vector<LogLine> lines;			//The writer's, kept to save reallocating
+
+	bool EarlierLine(const LogLine& _first, const LogLine& _second)
+	{
+		return _first.time < _second.time;
+	}
+
+#ifdef _WIN32
+	HANDLE writerThread = NULL;
+	double clockPeriod = 0;
+
+	double Now()
+	{
+		LARGE_INTEGER count;
+		QueryPerformanceCounter(&count);
+		return static_cast<double>(count.QuadPart) * clockPeriod;
+	}
+
+	void Nap(unsigned int _milliseconds)
+	{
+		Sleep(_milliseconds);
+	}
+
+	void AddRing(LogRing* _ring)
+	{
+		do
+		{
+			_ring->next = rings;
+		} while(InterlockedCompareExchangePointer(reinterpret_cast<PVOID volatile*>(&rings), _ring, _ring->next) != _ring->next);
+	}
+
+	DWORD WINAPI WriterMain(LPVOID)
+	{
+		LogWriter::Run();
+		return 0;
+	}
+
+	void StartThread()
+	{
+		LARGE_INTEGER frequency;
+		QueryPerformanceFrequency(&frequency);
+		clockPeriod = 1.0 / static_cast<double>(frequency.QuadPart);
+		writerThread = CreateThread(NULL, 0, WriterMain, NULL, 0, NULL);
+	}
+
+	void JoinThread()
+	{
+		WaitForSingleObject(writerThread, INFINITE);
+		CloseHandle(writerThread);
+	}
+#else
+	pthread_t writerThread;
+
+	double Now()
+	{
+		timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		return static_cast<double>(now.tv_sec) + static_cast<double>(now.tv_nsec) * 1e-9;
+	}
+
+	void Nap(unsigned int _milliseconds)
+	{
+		timespec nap = {0, static_cast<long>(_milliseconds) * 1000000};
+		nanosleep(&nap, NULL);
+	}
+
+	void AddRing(LogRing* _ring)
+	{
+		do
+		{
+			_ring->next = rings;
+		} while(!__sync_bool_compare_and_swap(&rings, _ring->next, _ring));
+	}
+
+	void* WriterMain(void*)
+	{
+		LogWriter::Run();
+		return NULL;
+	}
+
+	void StartThread()
+	{
+		pthread_create(&writerThread, NULL, WriterMain, NULL);
+	}
+
+	void JoinThread()
+	{
+		pthread_join(writerThread, NULL);
+	}
+#endif
+}
+
+LogLevel::Enum Logger::threshold_ = LogLevel::Diagnostic;
+
+LogRing::LogRing()
+: records(ringRecords), next(NULL), dropped(0), reported(0)
+{
+	for(int level = 0; level < LogLevel::Count; level++)
+	{
+		started[level] = 0;
+	}
+}
+
+LogRing* LogWriter::GetThreadRing()
+{
+	if(!threadRing)
+	{
+		threadRing = new LogRing();
+		AddRing(threadRing);
+	}
+	return threadRing;
+}
+
+LogRecord LogWriter::Begin(LogLevel::Enum _level, LogFormat::Enum _format)
+{
+	LogRecord record;
+	record.time = writing ? Now() : 0;
+	record.level = static_cast<unsigned char>(_level);
+	record.format = static_cast<unsigned char>(_format);
+	record.length = 0;
+	return record;
+}
+
+void LogWriter::Log(const LogRecord& _record)
+{
+	if(writing)
+	{
+		LogRing* ring = GetThreadRing();
+		//Never wait for the writer, better to lose a value than stall a frame
+		if(!ring->records.Push(_record))
+			ring->dropped++;
+		return;
+	}
+	std::string text;
+	Format(_record, text);
+	Logger::ForLevel(static_cast<LogLevel::Enum>(_record.level)).Output(text);
+}
+
+void LogWriter::Format(const LogRecord& _record, std::string& _text)
+{
+	if(_record.format == LogFormat::Text)
+	{
+		_text.append(_record.value.text, _record.length);
+		return;
+	}
+	std::ostringstream stream;
+	switch(_record.format)
+	{
+	case LogFormat::Int:
+		stream << _record.value.i;
+		break;
+	case LogFormat::Unsigned:
+		stream << _record.value.u;
+		break;
+	case LogFormat::Float:
+		stream << _record.value.f;
+		break;
+	case LogFormat::Double:
+		stream << _record.value.d;
+		break;
+	case LogFormat::Vector2:
+		stream << "(" << _record.value.v[0] << "," << _record.value.v[1] << ")";
+		break;
+	case LogFormat::Vector3:
+		stream << "(" << _record.value.v[0] << "," << _record.value.v[1] << "," << _record.value.v[2] << ")";
+		break;
+	}
+	_text += stream.str();
+}
+
+bool LogWriter::Drain(bool _all)
+{
+	bool drained = false;
+	lines.clear();
+	for(LogRing* ring = rings; ring; ring = ring->next)
+	{
+		LogRecord record;
+		while(ring->records.Pop(record))
+		{
+			drained = true;
+			std::string& pending = ring->pending[record.level];
+			double& started = ring->started[record.level];
+			if(pending.empty())
+				started = record.time;
+			Format(record, pending);
+			if(record.format != LogFormat::Text || !memchr(record.value.text, '\n', record.length))
+				continue;
+			//Hand over every finished line, anything after the last newline waits for the rest
+			size_t end = pending.rfind('\n') + 1;
+			LogLine line = {started, static_cast<LogLevel::Enum>(record.level), pending.substr(0, end)};
+			lines.push_back(line);
+			pending.erase(0, end);
+			started = record.time;
+		}
+		for(int level = 0; _all && level < LogLevel::Count; level++)
+		{
+			if(ring->pending[level].empty())
+				continue;
+			LogLine line = {ring->started[level], static_cast<LogLevel::Enum>(level), ring->pending[level]};
+			lines.push_back(line);
+			ring->pending[level].clear();
+		}
+		unsigned int dropped = ring->dropped;
+		if(dropped != ring->reported)
+		{
+			std::ostringstream report;
+			report << "Logger: " << dropped - ring->reported << " records dropped\n";
+			LogLine line = {Now(), LogLevel::Error, report.str()};
+			lines.push_back(line);
+			ring->reported = dropped;
+		}
+	}
+
+	std::stable_sort(lines.begin(), lines.end(), EarlierLine);
+	for(std::vector<LogLine>::iterator it = lines.begin(); it != lines.end(); ++it)
+	{
+		Logger::ForLevel(it->level).Output(it->text);
+	}
+	if(!lines.empty())
+	{
+		Logger::ErrorOut().output_.flush();
+		Logger::DiagnosticOut().output_.flush();
+		fflush(stdout);
+	}
+	return drained;
+}
+
+void LogWriter::Run()
+{
+	while(!stopping)
+	{
+		bool drained = Drain(false);
+		passes++;
+		if(!drained)
+			Nap(writerNap);
+	}
+}
+
+Logger::Logger(LogLevel::Enum _level, std::string _filename)
+: level_(_level)
 {
 	output_.open(_filename.c_str(), std::ios::trunc);
 }
@@ -13,54 +344,133 @@ Logger::~Logger(void)
 
 Logger& Logger::ErrorOut()
 {
-	static Logger logger("ErrorLog.txt");
+	static Logger logger(LogLevel::Error, "ErrorLog.txt");
 	return logger;
 }
 
 Logger& Logger::DiagnosticOut()
 {
-	static Logger logger("Diagnostic.txt");
+	static Logger logger(LogLevel::Diagnostic, "Diagnostic.txt");
 	return logger;
 }
 
-Logger& Logger::operator <<( int i )
+Logger& Logger::ForLevel(LogLevel::Enum _level)
 {
-	output_ << i;
-	printf("%d", i);
-	return *this;
+	return _level == LogLevel::Error ? ErrorOut() : DiagnosticOut();
 }
 
-Logger& Logger::operator <<( float i )
+void Logger::StartWriter()
 {
-	output_ << i;
-	printf("%f", i);
-	return *this;
+	if(writing)
+		return;
+	//Constructed here, before there's another thread that could race to do it
+	ErrorOut();
+	DiagnosticOut();
+	stopping = false;
+	StartThread();
+	writing = true;
 }
 
-Logger& Logger::operator <<( double i )
+void Logger::StopWriter()
 {
-	output_ << i;
-	printf("%e", i);
-	return *this;
+	if(!writing)
+		return;
+	//Loggers keep queueing until the writer has gone, so nothing writes alongside it or jumps ahead
+	//of older records. The last drain picks up whatever was queued meanwhile
+	stopping = true;
+	JoinThread();
+	LogWriter::Drain(true);
+	writing = false;
 }
 
-Logger& Logger::operator <<( std::string i )
+void Logger::Flush()
 {
-	output_ << i;
-	printf("%s", i.c_str());
-	return *this;
+	if(writing)
+	{
+		//The pass running now may have missed the latest records, the one after it won't
+		unsigned int target = passes + 2;
+		while(writing && static_cast<int>(passes - target) < 0)
+		{
+			Nap(1);
+		}
+		return;
+	}
+	ErrorOut().output_.flush();
+	DiagnosticOut().output_.flush();
+	fflush(stdout);
 }
 
-Logger& Logger::operator <<(Vector3f v)
+unsigned int Logger::GetDropped()
 {
-	output_ << "(" << v.x << "," << v.y << "," << v.z << ")";
-	printf("(%f,%f,%f)", v.x, v.y, v.z);
-	return *this;
+	unsigned int dropped = 0;
+	for(LogRing* ring = rings; ring; ring = ring->next)
+	{
+		dropped += ring->dropped;
+	}
+	return dropped;
 }
 
-Logger& Logger::operator <<(Vector2f v)
+void Logger::Output(const std::string& _text)
 {
-	output_ << "(" << v.x << "," << v.y << ")";
-	printf("(%f,%f)", v.x, v.y);
-	return *this;
-}
\ No newline at end of file
+	output_ << _text;
+	fputs(_text.c_str(), stdout);
+}
+
+void Logger::Write(int _value)
+{
+	LogRecord record = LogWriter::Begin(level_, LogFormat::Int);
+	record.value.i = _value;
+	LogWriter::Log(record);
+}
+
+void Logger::Write(unsigned int _value)
+{
+	LogRecord record = LogWriter::Begin(level_, LogFormat::Unsigned);
+	record.value.u = _value;
+	LogWriter::Log(record);
+}
+
+void Logger::Write(float _value)
+{
+	LogRecord record = LogWriter::Begin(level_, LogFormat::Float);
+	record.value.f = _value;
+	LogWriter::Log(record);
+}
+
+void Logger::Write(double _value)
+{
+	LogRecord record = LogWriter::Begin(level_, LogFormat::Double);
+	record.value.d = _value;
+	LogWriter::Log(record);
+}
+
+void Logger::Write(const char* _text, size_t _length)
+{
+	while(_length > 0)
+	{
+		LogRecord record = LogWriter::Begin(level_, LogFormat::Text);
+		size_t length = std::min(_length, sizeof(record.value.text));
+		memcpy(record.value.text, _text, length);
+		record.length = static_cast<unsigned char>(length);
+		LogWriter::Log(record);
+		_text += length;
+		_length -= length;
+	}
+}
+
+void Logger::Write(const Vector3f& _value)
+{
+	LogRecord record = LogWriter::Begin(level_, LogFormat::Vector3);
+	record.value.v[0] = _value.x;
+	record.value.v[1] = _value.y;
+	record.value.v[2] = _value.z;
+	LogWriter::Log(record);
+}
+
+void Logger::Write(const Vector2f& _value)
+{
+	LogRecord record = LogWriter::Begin(level_, LogFormat::Vector2);
+	record.value.v[0] = _value.x;
+	record.value.v[1] = _value.y;
+	LogWriter::Log(record);
+}
@@ -0,0 +1,223 @@
+#include "stdafx.h"
+#include <BlittableRect.h>
+#include <SurfaceBlit.h>
+#include <sdl.h>
+#include <vector>
+
+namespace
+{
+	SDL_Surface* CreateTestSurface(int _w, int _h)
+	{
+		return SDL_CreateRGBSurface(SDL_SWSURFACE, _w, _h, 32, 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000);
+	}
+
+	Uint32& PixelAt(SDL_Surface* _surface, int _x, int _y)
+	{
+		return reinterpret_cast<Uint32*>(static_cast<Uint8*>(_surface->pixels) + _surface->pitch * _y)[_x];
+	}
+
+	/* Each source pixel holds its own coordinates, so a copied pixel says where it came from */
+	void FillCoordinates(SDL_Surface* _surface)
+	{
+		for(int y = 0; y < _surface->h; y++)
+			for(int x = 0; x < _surface->w; x++)
+				PixelAt(_surface, x, y) = 0xff000000 | (y << 8) | x;
+	}
+
+	void FillValue(SDL_Surface* _surface, Uint32 _value)
+	{
+		for(int y = 0; y < _surface->h; y++)
+			for(int x = 0; x < _surface->w; x++)
+				PixelAt(_surface, x, y) = _value;
+	}
+}
+
+TEST_FIXTURE(SDL_fixture, RawBlitNegativeOffsetClipsTopLeft)
+{
+	CHECK(SDL_init_ok);
+	if(SDL_init_ok)
+	{
+		SDL_Surface* src = CreateTestSurface(8, 8);
+		SDL_Surface* dest = CreateTestSurface(8, 8);
+		FillCoordinates(src);
+		FillValue(dest, 0);
+
+		CHECK(SurfaceBlit::Copy(src, dest, -3, -2));
+		//Dest (0,0) comes from src (3,2)
+		CHECK_EQUAL(0xff000203u, PixelAt(dest, 0, 0));
+		CHECK_EQUAL(0xff000707u, PixelAt(dest, 4, 5));
+		//Nothing written past the clipped source
+		CHECK_EQUAL(0u, PixelAt(dest, 5, 0));
+		CHECK_EQUAL(0u, PixelAt(dest, 0, 6));
+		SDL_FreeSurface(src);
+		SDL_FreeSurface(dest);
+	}
+}
+
+TEST_FIXTURE(SDL_fixture, RawBlitClipsBottomRight)
+{
+	CHECK(SDL_init_ok);
+	if(SDL_init_ok)
+	{
+		SDL_Surface* src = CreateTestSurface(8, 8);
+		SDL_Surface* dest = CreateTestSurface(10, 10);
+		FillCoordinates(src);
+		FillValue(dest, 0);
+
+		CHECK(SurfaceBlit::Copy(src, dest, 6, 7));
+		CHECK_EQUAL(0xff000000u, PixelAt(dest, 6, 7));
+		CHECK_EQUAL(0xff000203u, PixelAt(dest, 9, 9));
+		CHECK_EQUAL(0u, PixelAt(dest, 5, 7));
+		CHECK_EQUAL(0u, PixelAt(dest, 6, 6));
+		SDL_FreeSurface(src);
+		SDL_FreeSurface(dest);
+	}
+}
+
+TEST_FIXTURE(SDL_fixture, RawBlitClipsSourceRect)
+{
+	CHECK(SDL_init_ok);
+	if(SDL_init_ok)
+	{
+		SDL_Surface* src = CreateTestSurface(8, 8);
+		SDL_Surface* dest = CreateTestSurface(8, 8);
+		FillCoordinates(src);
+		FillValue(dest, 0);
+
+		//Area starts left of and runs below the source
+		CHECK(SurfaceBlit::Copy(src, -2, 6, 4, 4, dest, 0, 0));
+		CHECK_EQUAL(0u, PixelAt(dest, 0, 0));
+		CHECK_EQUAL(0u, PixelAt(dest, 1, 0));
+		CHECK_EQUAL(0xff000600u, PixelAt(dest, 2, 0));
+		CHECK_EQUAL(0xff000701u, PixelAt(dest, 3, 1));
+		CHECK_EQUAL(0u, PixelAt(dest, 2, 2));
+		CHECK_EQUAL(0u, PixelAt(dest, 4, 0));
+		SDL_FreeSurface(src);
+		SDL_FreeSurface(dest);
+	}
+}
+
+TEST_FIXTURE(SDL_fixture, RawBlitEntirelyOutsideWritesNothing)
+{
+	CHECK(SDL_init_ok);
+	if(SDL_init_ok)
+	{
+		SDL_Surface* src = CreateTestSurface(4, 4);
+		SDL_Surface* dest = CreateTestSurface(4, 4);
+		FillCoordinates(src);
+		FillValue(dest, 0x12345678);
+
+		CHECK(SurfaceBlit::Copy(src, dest, 4, 0));
+		CHECK(SurfaceBlit::Copy(src, dest, -4, 0));
+		CHECK(SurfaceBlit::Copy(src, dest, 0, 100));
+		CHECK(SurfaceBlit::Copy(src, 10, 10, 4, 4, dest, 0, 0));
+		for(int y = 0; y < 4; y++)
+			for(int x = 0; x < 4; x++)
+				CHECK_EQUAL(0x12345678u, PixelAt(dest, x, y));
+		SDL_FreeSurface(src);
+		SDL_FreeSurface(dest);
+	}
+}
+
+TEST_FIXTURE(SDL_fixture, RawBlitHonoursPitch)
+{
+	CHECK(SDL_init_ok);
+	if(SDL_init_ok)
+	{
+		//A 5 pixel wide view onto rows 32 pixels apart
+		std::vector<Uint32> backing(32 * 4, 0);
+		SDL_Surface* padded = SDL_CreateRGBSurfaceFrom(&backing[0], 5, 4, 32, 32 * 4, 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000);
+		SDL_Surface* src = CreateTestSurface(5, 4);
+		FillCoordinates(src);
+
+		CHECK(SurfaceBlit::Copy(src, padded, 0, 0));
+		CHECK_EQUAL(0xff000000u, backing[0]);
+		CHECK_EQUAL(0xff000104u, backing[32 + 4]);
+		CHECK_EQUAL(0xff000304u, backing[3 * 32 + 4]);
+		CHECK_EQUAL(0u, backing[5]);
+
+		SDL_Surface* back = CreateTestSurface(5, 4);
+		CHECK(SurfaceBlit::Copy(padded, back, 0, 0));
+		CHECK_EQUAL(0xff000203u, PixelAt(back, 3, 2));
+		SDL_FreeSurface(padded);
+		SDL_FreeSurface(src);
+		SDL_FreeSurface(back);
+	}
+}
+
+TEST_FIXTURE(SDL_fixture, RawBlitWideRows)
+{
+	CHECK(SDL_init_ok);
+	if(SDL_init_ok)
+	{
+		//Wide enough for the vector path, and offset so rows start unaligned
+		SDL_Surface* src = CreateTestSurface(100, 3);
+		SDL_Surface* dest = CreateTestSurface(120, 3);
+		FillCoordinates(src);
+		FillValue(dest, 0);
+
+		CHECK(SurfaceBlit::Copy(src, 1, 0, 99, 3, dest, 1, 0));
+		CHECK_EQUAL(0u, PixelAt(dest, 0, 0));
+		for(int x = 1; x < 100; x++)
+			CHECK_EQUAL(0xff000200u | x, PixelAt(dest, x, 2));
+		CHECK_EQUAL(0u, PixelAt(dest, 100, 2));
+		SDL_FreeSurface(src);
+		SDL_FreeSurface(dest);
+	}
+}
+
+TEST_FIXTURE(SDL_fixture, RawBlitRejectsMismatchedFormats)
+{
+	CHECK(SDL_init_ok);
+	if(SDL_init_ok)
+	{
+		SDL_Surface* src = CreateTestSurface(4, 4);
+		SDL_Surface* dest = SDL_CreateRGBSurface(SDL_SWSURFACE, 4, 4, 16, 0xf800, 0x07e0, 0x001f, 0);
+		CHECK_EQUAL(false, SurfaceBlit::Copy(src, dest, 0, 0));
+		SDL_FreeSurface(src);
+		SDL_FreeSurface(dest);
+	}
+}
+
+TEST_FIXTURE(SDL_fixture, BlittableRawBlitOffEdges)
+{
+	CHECK(SDL_init_ok);
+	if(SDL_init_ok)
+	{
+		BlittableRect dest(Vector2i(32, 32));
+		BlittableRect src(Vector2i(16, 16));
+		BlittableRect::ScopedLock lock(&dest);
+		src.RawBlit(Vector2i(-8, -8), &dest);
+		src.RawBlit(Vector2i(24, 24), &dest);
+		src.RawBlit(Vector2i(-4, -4), Vector2i(24, 24), Vector2i(-2, 20), &dest);
+		CHECK_EQUAL(false, dest.GetError());
+	}
+}
+
+TEST_FIXTURE(SDL_fixture, RawBlitHonoursDestClipRect)
+{
+	CHECK(SDL_init_ok);
+	if(SDL_init_ok)
+	{
+		SDL_Surface* src = CreateTestSurface(8, 8);
+		SDL_Surface* dest = CreateTestSurface(8, 8);
+		FillCoordinates(src);
+		FillValue(dest, 0);
+
+		SDL_Rect clip;
+		clip.x = 2;
+		clip.y = 3;
+		clip.w = 4;
+		clip.h = 2;
+		SDL_SetClipRect(dest, &clip);
+		CHECK(SurfaceBlit::Copy(src, dest, 0, 0));
+		CHECK_EQUAL(0xff000302u, PixelAt(dest, 2, 3));
+		CHECK_EQUAL(0xff000405u, PixelAt(dest, 5, 4));
+		CHECK_EQUAL(0u, PixelAt(dest, 1, 3));
+		CHECK_EQUAL(0u, PixelAt(dest, 6, 4));
+		CHECK_EQUAL(0u, PixelAt(dest, 2, 5));
+		CHECK_EQUAL(0u, PixelAt(dest, 2, 2));
+		SDL_FreeSurface(src);
+		SDL_FreeSurface(dest);
+	}
+}
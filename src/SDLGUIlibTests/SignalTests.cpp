@@ -0,0 +1,120 @@
+#include "stdafx.h"
+#include <Signal.h>
+#include <boost/bind.hpp>
+
+namespace
+{
+	int free_calls = 0;
+	void FreeSlot(int _value)
+	{
+		free_calls += _value;
+	}
+
+	struct Counter
+	{
+		int calls;
+		Counter() : calls(0){}
+		void Add(int _value){calls += _value;}
+	};
+
+	/* Too large for the inline buffer */
+	struct BigFunctor
+	{
+		int* target;
+		char padding[128];
+		explicit BigFunctor(int* _target) : target(_target){}
+		void operator()(int _value){*target += _value;}
+	};
+
+	typedef Signal<void (int)> IntSignal;
+
+	/* Slots that change the signal they're called from */
+	struct SelfDisconnect
+	{
+		SignalConnection* connection;
+		int* calls;
+		void operator()(int){(*calls)++; connection->disconnect();}
+	};
+	struct ConnectMore
+	{
+		IntSignal* signal;
+		Counter* counter;
+		void operator()(int){signal->connect(boost::bind(&Counter::Add, counter, _1));}
+	};
+}
+
+TEST(SignalCallsConnectedSlots)
+{
+	IntSignal signal;
+	CHECK(signal.empty());
+	signal(1); //Nothing connected, nothing happens
+
+	free_calls = 0;
+	Counter counter;
+	int big_total = 0;
+	SignalConnection free_connection = signal.connect(FreeSlot);
+	signal.connect(boost::bind(&Counter::Add, &counter, _1));
+	signal.connect(BigFunctor(&big_total));
+	CHECK_EQUAL(3u, signal.num_slots());
+
+	signal(2);
+	CHECK_EQUAL(2, free_calls);
+	CHECK_EQUAL(2, counter.calls);
+	CHECK_EQUAL(2, big_total);
+
+	CHECK(free_connection.connected());
+	free_connection.disconnect();
+	CHECK(!free_connection.connected());
+	signal(3);
+	CHECK_EQUAL(2, free_calls);
+	CHECK_EQUAL(5, counter.calls);
+
+	signal.disconnect_all_slots();
+	CHECK(signal.empty());
+}
+
+TEST(ScopedConnectionDisconnectsWhenDestroyed)
+{
+	IntSignal signal;
+	Counter counter;
+	{
+		ScopedConnection c = signal.connect(boost::bind(&Counter::Add, &counter, _1));
+		signal(1);
+		CHECK_EQUAL(1u, signal.num_slots());
+	}
+	CHECK(signal.empty());
+	signal(1);
+	CHECK_EQUAL(1, counter.calls);
+
+	//Outliving the signal is harmless
+	IntSignal* short_lived = new IntSignal();
+	ScopedConnection c = short_lived->connect(FreeSlot);
+	CHECK(c.connected());
+	delete short_lived;
+	CHECK(!c.connected());
+}
+
+TEST(SignalChangesDuringDispatchAreSafe)
+{
+	IntSignal signal;
+	int self_calls = 0;
+	SignalConnection self_connection;
+	SelfDisconnect self_disconnect = {&self_connection, &self_calls};
+	self_connection = signal.connect(self_disconnect);
+
+	Counter counter;
+	ConnectMore connect_more = {&signal, &counter};
+	SignalConnection more_connection = signal.connect(connect_more);
+
+	//The slot connected during dispatch isn't called until the next one
+	signal(1);
+	CHECK_EQUAL(1, self_calls);
+	CHECK_EQUAL(0, counter.calls);
+	CHECK_EQUAL(2u, signal.num_slots());
+
+	more_connection.disconnect();
+	signal(1);
+	CHECK_EQUAL(1, self_calls);
+	CHECK_EQUAL(1, counter.calls);
+	CHECK_EQUAL(1u, signal.num_slots());
+}
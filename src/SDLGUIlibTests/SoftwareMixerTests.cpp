@@ -0,0 +1,214 @@
+#include "stdafx.h"
+#include <SoftwareMixer.h>
+#include <SPSCQueue.h>
+#include <sdl.h>
+#include <vector>
+#include <cstdlib>
+#include <algorithm>
+
+namespace
+{
+	const unsigned int queued_values = 100000;
+
+	int Producer(void* _queue)
+	{
+		SPSCQueue<unsigned int>* queue = static_cast<SPSCQueue<unsigned int>*>(_queue);
+		for(unsigned int i = 1; i <= queued_values; i++)
+		{
+			while(!queue->Push(i)){}
+		}
+		return 0;
+	}
+
+	/* Stereo frames of noise, the same every run */
+	std::vector<Sint16> Noise(unsigned int _frames, unsigned int _seed)
+	{
+		std::vector<Sint16> samples(_frames * 2);
+		for(unsigned int i = 0; i < samples.size(); i++)
+		{
+			_seed = _seed * 1103515245 + 12345;
+			samples[i] = static_cast<Sint16>((_seed >> 8) & 0xffff);
+		}
+		return samples;
+	}
+}
+
+TEST(SPSCQueueOrderAndCapacity)
+{
+	SPSCQueue<int> queue(4);
+	CHECK_EQUAL(3u, queue.GetCapacity());
+	CHECK(queue.IsEmpty());
+	int value = 0;
+	CHECK(!queue.Pop(value));
+	CHECK(queue.Push(1));
+	CHECK(queue.Push(2));
+	CHECK(queue.Push(3));
+	CHECK(!queue.Push(4));
+	CHECK(queue.Pop(value));
+	CHECK_EQUAL(1, value);
+	//Wraps round
+	CHECK(queue.Push(4));
+	CHECK(queue.Pop(value));
+	CHECK_EQUAL(2, value);
+	CHECK(queue.Pop(value));
+	CHECK_EQUAL(3, value);
+	CHECK(queue.Pop(value));
+	CHECK_EQUAL(4, value);
+	CHECK(!queue.Pop(value));
+}
+
+TEST(SPSCQueueAcrossThreads)
+{
+	SPSCQueue<unsigned int> queue(64);
+	SDL_Thread* thread = SDL_CreateThread(Producer, &queue);
+	CHECK(thread != NULL);
+	if(thread)
+	{
+		//Nothing lost, duplicated or reordered
+		unsigned int expected = 1;
+		bool ordered = true;
+		while(expected <= queued_values)
+		{
+			unsigned int value;
+			if(queue.Pop(value))
+			{
+				ordered = ordered && value == expected;
+				expected++;
+			}
+		}
+		SDL_WaitThread(thread, NULL);
+		CHECK(ordered);
+		CHECK(queue.IsEmpty());
+	}
+}
+
+TEST(SoftwareMixerMixesAndReportsFinishedVoices)
+{
+	SoftwareMixer mixer(4, 44100);
+	std::vector<Sint16> out(100 * 2, 1);
+	mixer.Mix(&out[0], 100);
+	CHECK_EQUAL(0, out[0]);
+	CHECK_EQUAL(0, out[199]);
+
+	Sint16 tone[] = {1000, -1000, 2000, -2000, 3000, -3000};
+	mixer.Play(0, tone, 3, 1.0f, false);
+	mixer.Play(1, tone, 3, 0.5f, false);
+	//Nothing is mixed until the audio side asks
+	int voice = -1;
+	CHECK(!mixer.TakeFinished(voice));
+	mixer.Mix(&out[0], 5);
+	CHECK_EQUAL(1500, out[0]);
+	CHECK_EQUAL(-1500, out[1]);
+	CHECK_EQUAL(4500, out[4]);
+	CHECK_EQUAL(-4500, out[5]);
+	CHECK_EQUAL(0, out[6]);
+	CHECK_EQUAL(0, out[9]);
+
+	CHECK(mixer.TakeFinished(voice));
+	CHECK_EQUAL(0, voice);
+	CHECK(mixer.TakeFinished(voice));
+	CHECK_EQUAL(1, voice);
+	CHECK(!mixer.TakeFinished(voice));
+	CHECK_EQUAL(105u, mixer.GetMixedFrames());
+	CHECK_EQUAL(6u, mixer.GetMixedVoiceFrames());
+}
+
+TEST(SoftwareMixerLoopsClipsAndAttenuates)
+{
+	SoftwareMixer mixer(2, 44100);
+	Sint16 loud[] = {30000, -30000};
+	mixer.Play(0, loud, 1, 1.0f, true);
+	mixer.Play(1, loud, 1, 1.0f, true);
+	std::vector<Sint16> out(10 * 2);
+	mixer.Mix(&out[0], 10);
+	CHECK_EQUAL(32767, out[18]);
+	CHECK_EQUAL(-32768, out[19]);
+	int voice;
+	CHECK(!mixer.TakeFinished(voice));
+
+	mixer.Stop(1);
+	mixer.SetDistance(0, 255);
+	mixer.Mix(&out[0], 1);
+	CHECK_EQUAL(0, out[0]);
+	mixer.SetDistance(0, 0);
+	mixer.SetVolume(0, 0.5f);
+	mixer.Mix(&out[0], 1);
+	CHECK_EQUAL(15000, out[0]);
+	//Stopped voices aren't reported as finished
+	CHECK(!mixer.TakeFinished(voice));
+}
+
+TEST(SoftwareMixerIgnoresVoicesRestartedSinceFinishing)
+{
+	SoftwareMixer mixer(1, 44100);
+	Sint16 click[] = {100, 100};
+	std::vector<Sint16> out(4 * 2);
+	mixer.Play(0, click, 1, 1.0f, false);
+	mixer.Mix(&out[0], 4);
+	//Finished, but restarted before the game side noticed
+	mixer.Play(0, click, 1, 1.0f, true);
+	int voice;
+	CHECK(!mixer.TakeFinished(voice));
+	mixer.Mix(&out[0], 4);
+	CHECK_EQUAL(100, out[6]);
+}
+
+TEST(SoftwareMixerSIMDMatchesScalar)
+{
+	const unsigned int frames = SoftwareMixer::BLOCK_FRAMES * 3 + 7;
+	std::vector<Sint16> first = Noise(frames, 1);
+	std::vector<Sint16> second = Noise(frames - 11, 2);
+	std::vector<Sint16> outputs[2];
+	for(int pass = 0; pass < 2; pass++)
+	{
+		SoftwareMixer mixer(3, 44100);
+		mixer.SetSIMD(pass == 0);
+		mixer.Play(0, &first[0], frames, 0.7f, false);
+		mixer.Play(1, &second[0], frames - 11, 0.9f, false);
+		mixer.Play(2, &first[0] + 3 * 2, frames - 3, 0.3f, true);
+		mixer.SetDistance(1, 40);
+		outputs[pass].resize(frames * 2);
+		mixer.Mix(&outputs[pass][0], frames);
+	}
+	int worst = 0;
+	for(unsigned int i = 0; i < frames * 2; i++)
+	{
+		worst = std::max(worst, std::abs(outputs[0][i] - outputs[1][i]));
+	}
+	//Summing three voices in another precision may still land either side of a half
+	CHECK(worst <= 1);
+}
+
+TEST(SoftwareMixerSIMDRoundsHalvesAsScalar)
+{
+	//Odd samples at half volume give exact halves either side of zero, and the largest clip
+	std::vector<Sint16> samples;
+	for(int i = -41; i <= 41; i += 2)
+	{
+		samples.push_back(static_cast<Sint16>(i));
+		samples.push_back(static_cast<Sint16>(-i));
+	}
+	samples.push_back(-32767);
+	samples.push_back(32767);
+	const unsigned int frames = static_cast<unsigned int>(samples.size() / 2);
+	std::vector<Sint16> outputs[2];
+	for(int pass = 0; pass < 2; pass++)
+	{
+		SoftwareMixer mixer(3, 44100);
+		mixer.SetSIMD(pass == 0);
+		mixer.Play(0, &samples[0], frames, 0.5f, false);
+		mixer.Play(1, &samples[0], frames, 1.0f, false);
+		mixer.Play(2, &samples[0], frames, 1.0f, false);
+		outputs[pass].resize(frames * 2);
+		mixer.Mix(&outputs[pass][0], frames);
+	}
+	int mismatches = 0;
+	for(unsigned int i = 0; i < frames * 2; i++)
+	{
+		mismatches += outputs[0][i] != outputs[1][i];
+	}
+	CHECK_EQUAL(0, mismatches);
+	//3 and -3 at a combined volume of 2.5, so 7.5 and -7.5 rounded half up
+	CHECK_EQUAL(8, outputs[1][(41 + 3) / 2 * 2]);
+	CHECK_EQUAL(-7, outputs[1][(41 + 3) / 2 * 2 + 1]);
+}
@@ -0,0 +1,132 @@
+#include "stdafx.h"
+#include <BlittableRect.h>
+#include <ImageCache.h>
+#include <SurfaceBudget.h>
+#include <Widget.h>
+#include <sdl.h>
+#include <sstream>
+
+namespace
+{
+	/* Puts a runtime image of _size in ImageCache under _key with no references left */
+	void CacheUnreferenced(const std::string& _key, Vector2i _size)
+	{
+		BlittableRect rect(_size);
+		rect.ShareAs(_key);
+	}
+
+	bool IsCached(const std::string& _key)
+	{
+		BlittableRect* rect = BlittableRect::FromImageCache(_key);
+		delete rect;
+		return rect != NULL;
+	}
+}
+
+TEST_FIXTURE(SDL_fixture, SurfaceBudgetCountsOwnedSurfacesByCategory)
+{
+	CHECK(SDL_init_ok);
+	if(SDL_init_ok)
+	{
+		SurfaceBudget& budget = SurfaceBudget::Instance();
+		unsigned int rects = budget.GetBytes(SurfaceCategory::Rect);
+		unsigned int images = budget.GetBytes(SurfaceCategory::Image);
+		unsigned int stores = budget.GetBytes(SurfaceCategory::BackingStore);
+		{
+			BlittableRect rect(Vector2i(10, 10));
+			CHECK_EQUAL(rects + 400u, budget.GetBytes(SurfaceCategory::Rect));
+			rect.SetCategory(SurfaceCategory::BackingStore);
+			CHECK_EQUAL(rects, budget.GetBytes(SurfaceCategory::Rect));
+			CHECK_EQUAL(stores + 400u, budget.GetBytes(SurfaceCategory::BackingStore));
+			rect.SetCategory(SurfaceCategory::Rect);
+
+			//Handing the surface to the image cache moves it to Images
+			rect.ShareAs("SurfaceBudgetCounts");
+			CHECK_EQUAL(rects, budget.GetBytes(SurfaceCategory::Rect));
+			CHECK_EQUAL(images + 400u, budget.GetBytes(SurfaceCategory::Image));
+
+			//A shared image only costs again once it is copied
+			rect.Fill(255, 0, 0, 0);
+			CHECK_EQUAL(rects + 400u, budget.GetBytes(SurfaceCategory::Rect));
+		}
+		CHECK_EQUAL(rects, budget.GetBytes(SurfaceCategory::Rect));
+		ImageCache::Instance().Purge("SurfaceBudgetCounts");
+		CHECK_EQUAL(images, budget.GetBytes(SurfaceCategory::Image));
+	}
+}
+
+TEST_FIXTURE(SDL_fixture, SurfaceBudgetEvictsLeastRecentlyUsedFirst)
+{
+	CHECK(SDL_init_ok);
+	if(SDL_init_ok)
+	{
+		Widget::ClearRoot();
+		ImageCache::Instance().Purge();
+		ScaledImageCache::Instance().Clear();
+		SurfaceBudget& budget = SurfaceBudget::Instance();
+		unsigned int ceiling = budget.GetCeiling();
+		unsigned int evictions = budget.GetEvictions();
+
+		CacheUnreferenced("SurfaceBudgetA", Vector2i(32, 32));
+		CacheUnreferenced("SurfaceBudgetB", Vector2i(32, 32));
+		CHECK(IsCached("SurfaceBudgetA")); //A is now more recently used than B
+
+		budget.SetCeiling(0);
+		CHECK_EQUAL(0u, budget.Enforce());
+		budget.SetCeiling(budget.GetTotal() - 1);
+		CHECK_EQUAL(1u, budget.Enforce());
+		CHECK(!IsCached("SurfaceBudgetB"));
+		CHECK(IsCached("SurfaceBudgetA"));
+
+		//Images in use are never evicted, however far over the ceiling
+		BlittableRect* held = BlittableRect::FromImageCache("SurfaceBudgetA");
+		budget.SetCeiling(1);
+		CHECK_EQUAL(0u, budget.Enforce());
+		CHECK(held->IsShared());
+		delete held;
+		CHECK_EQUAL(1u, budget.Enforce());
+		CHECK(!IsCached("SurfaceBudgetA"));
+		CHECK_EQUAL(evictions + 2, budget.GetEvictions());
+
+		budget.SetCeiling(ceiling);
+	}
+}
+
+TEST_FIXTURE(SDL_fixture, SurfaceBudgetEvictsHiddenBackingStores)
+{
+	CHECK(SDL_init_ok);
+	if(SDL_init_ok)
+	{
+		Widget::ClearRoot();
+		ImageCache::Instance().Purge();
+		ScaledImageCache::Instance().Clear();
+		SurfaceBudget& budget = SurfaceBudget::Instance();
+		unsigned int ceiling = budget.GetCeiling();
+		unsigned int stores = budget.GetBytes(SurfaceCategory::BackingStore);
+		BlittableRect screen(Vector2i(640, 480));
+		Widget* shown = new Widget();
+		shown->SetSize(Vector2i(10, 10));
+		Widget* hidden = new Widget();
+		hidden->SetSize(Vector2i(10, 10));
+		Widget::RenderRoot(&screen);
+		CHECK_EQUAL(stores + 800u, budget.GetBytes(SurfaceCategory::BackingStore));
+
+		hidden->SetVisibility(false);
+		budget.SetCeiling(1);
+		Widget::RenderRoot(&screen);
+		//Only the hidden widget's buffer can go, the one on screen is still needed
+		CHECK_EQUAL(stores + 400u, budget.GetBytes(SurfaceCategory::BackingStore));
+
+		budget.SetCeiling(ceiling);
+		Widget::ClearRoot();
+	}
+}
+
+TEST(SurfaceBudgetReportListsCategories)
+{
+	std::ostringstream report;
+	SurfaceBudget::Instance().Report(report);
+	CHECK(report.str().find("Images") != std::string::npos);
+	CHECK(report.str().find("Widget backing stores") != std::string::npos);
+	CHECK(report.str().find("Surface total") != std::string::npos);
+}
@@ -0,0 +1,109 @@
+#include "stdafx.h"
+#include <TextBuffer.h>
+#include <WidgetText.h>
+
+namespace
+{
+	/* Small deterministic generator so failures repeat */
+	unsigned int NextRandom(unsigned int& _seed)
+	{
+		_seed = _seed * 1103515245 + 12345;
+		return (_seed >> 16) & 0x7fff;
+	}
+
+	bool SameLines(const WidgetText& _a, const WidgetText& _b)
+	{
+		return _a.GetTextLines() == _b.GetTextLines();
+	}
+}
+
+TEST(TextBufferEditsAnywhere)
+{
+	TextBuffer buffer("Hello world");
+	CHECK_EQUAL(11u, buffer.GetLength());
+	buffer.Insert(5, ",");
+	buffer.Insert(buffer.GetLength(), "!");
+	buffer.Insert(0, ">");
+	CHECK_EQUAL(">Hello, world!", buffer.GetText());
+	CHECK_EQUAL('H', buffer.At(1));
+	CHECK_EQUAL('!', buffer.At(13));
+
+	buffer.Erase(0, 1);
+	buffer.Erase(5, 100); //Clamped to the end
+	CHECK_EQUAL("Hello", buffer.GetText());
+	buffer.Erase(5, 1); //Past the end, nothing to do
+	CHECK_EQUAL("Hello", buffer.GetText());
+
+	std::string out = "[";
+	buffer.Insert(2, "__");
+	buffer.AppendTo(1, 4, out); //Spans the gap
+	CHECK_EQUAL("[e__l", out);
+
+	//Growing well past the first gap keeps the text intact
+	std::string expected = buffer.GetText();
+	for(int i = 0; i < 500; i++)
+	{
+		buffer.Insert(i % 7, "x");
+		expected.insert(i % 7, "x");
+	}
+	CHECK_EQUAL(expected, buffer.GetText());
+}
+
+TEST(WidgetTextTypingMatchesFullLayout)
+{
+	WidgetText typed;
+	typed.SetAutowrap(true, 168); //10 characters a line
+	std::string sentence = "the quick brown fox jumps over the lazy dog\nand then\n\nsome more words";
+	for(std::string::size_type i = 0; i < sentence.length(); i++)
+	{
+		typed.Insert(typed.GetLength(), sentence.substr(i, 1));
+	}
+	WidgetText laid_out;
+	laid_out.SetAutowrap(true, 168);
+	laid_out.SetText(sentence);
+	CHECK_EQUAL(sentence, typed.GetText());
+	CHECK(SameLines(laid_out, typed));
+	CHECK_EQUAL(9u, typed.GetTextLines().size());
+
+	//Backspacing over everything leaves the single empty line an empty text has
+	while(typed.GetLength() > 0)
+	{
+		typed.Erase(typed.GetLength() - 1, 1);
+	}
+	CHECK_EQUAL(1u, typed.GetTextLines().size());
+	CHECK_EQUAL("", typed.GetTextLines()[0]);
+}
+
+TEST(WidgetTextRandomEditsMatchFullLayout)
+{
+	const char* pieces[] = {"a", " ", "\n", "word ", "two\nlines", "  ", "longerword"};
+	for(int wrap = 0; wrap < 2; wrap++)
+	{
+		unsigned int seed = 42;
+		WidgetText edited;
+		edited.SetAutowrap(wrap == 1, 120);
+		std::string expected;
+		bool all_same = true;
+		for(int i = 0; i < 400; i++)
+		{
+			unsigned int position = expected.empty() ? 0 : NextRandom(seed) % (expected.length() + 1);
+			if(NextRandom(seed) % 3 == 0 && !expected.empty())
+			{
+				unsigned int count = NextRandom(seed) % 6 + 1;
+				edited.Erase(position, count);
+				if(position < expected.length())
+					expected.erase(position, count);
+			} else
+			{
+				std::string piece = pieces[NextRandom(seed) % 7];
+				edited.Insert(position, piece);
+				expected.insert(position, piece);
+			}
+			WidgetText fresh;
+			fresh.SetAutowrap(wrap == 1, 120);
+			fresh.SetText(expected);
+			all_same = all_same && SameLines(fresh, edited) && expected == edited.GetText();
+		}
+		CHECK(all_same);
+	}
+}
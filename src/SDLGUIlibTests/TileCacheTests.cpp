@@ -0,0 +1,68 @@
+#include "stdafx.h"
+#include <Widget.h>
+#include <TileCache.h>
+#include <ImageCache.h>
+
+TEST_FIXTURE(SDL_fixture, NinePatchWidgetsShareComposition)
+{
+	CHECK(SDL_init_ok);
+	if(SDL_init_ok)
+	{
+		ImageCache::Instance().Purge();
+		Widget* first = new Widget(NinePatch("NavyButton.png", 16, 16, 16, 16), 160, 40);
+		unsigned int count = ImageCache::Instance().GetCount();
+		Widget* second = new Widget(NinePatch("NavyButton.png", 16, 16, 16, 16), 160, 40);
+		CHECK_EQUAL(Vector2i(160, 40), second->GetSize());
+		CHECK_EQUAL(true, first->GetBackRect()->IsShared());
+		CHECK_EQUAL(true, second->GetBackRect()->IsShared());
+		CHECK_EQUAL(count, ImageCache::Instance().GetCount());
+
+		//A different size is a different composition
+		Widget* third = new Widget(NinePatch("NavyButton.png", 16, 16, 16, 16), 96, 32);
+		CHECK_EQUAL(count + 1, ImageCache::Instance().GetCount());
+		CHECK_EQUAL(Vector2i(96, 32), third->GetSize());
+	}
+}
+
+TEST_FIXTURE(SDL_fixture, TiledWidgetsShareComposition)
+{
+	CHECK(SDL_init_ok);
+	if(SDL_init_ok)
+	{
+		ImageCache::Instance().Purge();
+		Widget* first = new Widget(VerticalTile("Top.png", "Middle.png", "Bottom.png"), 100);
+		Widget* second = new Widget(VerticalTile("Top.png", "Middle.png", "Bottom.png"), 100);
+		Widget* third = new Widget(HorizontalTile("Left.png", "Middle.png", "Right.png"), 100);
+		Widget* fourth = new Widget(HorizontalTile("Left.png", "Middle.png", "Right.png"), 100);
+		CHECK_EQUAL(first->GetSize(), second->GetSize());
+		CHECK_EQUAL(third->GetSize(), fourth->GetSize());
+		if(!first->GetBackRect()->GetError())
+		{
+			CHECK_EQUAL(true, second->GetBackRect()->IsShared());
+			CHECK_EQUAL(true, fourth->GetBackRect()->IsShared());
+		}
+	}
+}
+
+TEST_FIXTURE(SDL_fixture, SharedCompositionCopiedOnModify)
+{
+	CHECK(SDL_init_ok);
+	if(SDL_init_ok)
+	{
+		BlittableRect* first = TileCache::Compose(NinePatch("NavyButton.png", 16, 16, 16, 16), 64, 64);
+		BlittableRect* second = TileCache::Compose(NinePatch("NavyButton.png", 16, 16, 16, 16), 64, 64);
+		second->Fill(255, 0, 255, 0);
+		CHECK_EQUAL(false, second->IsShared());
+		CHECK_EQUAL(true, first->IsShared());
+		delete first;
+		delete second;
+	}
+}
+
+TEST(TileKeysDistinguishSpecifications)
+{
+	CHECK(TileCache::MakeKey(NinePatch("a.png", 1, 2, 3, 4), 10, 20) != TileCache::MakeKey(NinePatch("a.png", 1, 2, 3, 4), 20, 10));
+	CHECK(TileCache::MakeKey(NinePatch("a.png", 1, 2, 3, 4), 10, 20) != TileCache::MakeKey(NinePatch("a.png", 4, 3, 2, 1), 10, 20));
+	CHECK(TileCache::MakeKey(VerticalTile("a.png", "b.png", "c.png"), 10) != TileCache::MakeKey(HorizontalTile("a.png", "b.png", "c.png"), 10));
+	CHECK_EQUAL(TileCache::MakeKey(NinePatch("a.png", 1, 2, 3, 4), 10, 20), TileCache::MakeKey(NinePatch("a.png", 1, 2, 3, 4), 10, 20));
+}
@@ -0,0 +1,66 @@
+#include "stdafx.h"
+#include <TripleBuffer.h>
+#include <sdl.h>
+
+namespace
+{
+	const int published_values = 20000;
+
+	int Publisher(void* _buffer)
+	{
+		TripleBuffer<int>* buffer = static_cast<TripleBuffer<int>*>(_buffer);
+		for(int i = 1; i <= published_values; i++)
+		{
+			buffer->GetWriteBuffer() = i;
+			buffer->Publish();
+		}
+		return 0;
+	}
+}
+
+TEST(TripleBufferReadsLatestPublished)
+{
+	TripleBuffer<int> buffer;
+	CHECK(!buffer.Acquire());
+	buffer.GetWriteBuffer() = 1;
+	buffer.Publish();
+	buffer.GetWriteBuffer() = 2;
+	buffer.Publish();
+	//1 was never read, 2 replaced it
+	CHECK(buffer.Acquire());
+	CHECK_EQUAL(2, buffer.GetReadBuffer());
+	CHECK(!buffer.Acquire());
+	CHECK_EQUAL(2, buffer.GetReadBuffer());
+
+	//Writing doesn't disturb what is being read
+	buffer.GetWriteBuffer() = 3;
+	CHECK_EQUAL(2, buffer.GetReadBuffer());
+	buffer.Publish();
+	CHECK_EQUAL(2, buffer.GetReadBuffer());
+	CHECK(buffer.Acquire());
+	CHECK_EQUAL(3, buffer.GetReadBuffer());
+}
+
+TEST(TripleBufferAcrossThreads)
+{
+	TripleBuffer<int> buffer;
+	SDL_Thread* thread = SDL_CreateThread(Publisher, &buffer);
+	CHECK(thread != NULL);
+	if(thread)
+	{
+		//Values may be skipped but never go backwards
+		int last = 0;
+		bool ordered = true;
+		while(last < published_values)
+		{
+			if(buffer.Acquire())
+			{
+				ordered = ordered && buffer.GetReadBuffer() > last;
+				last = buffer.GetReadBuffer();
+			}
+		}
+		SDL_WaitThread(thread, NULL);
+		CHECK(ordered);
+		CHECK_EQUAL(published_values, last);
+	}
+}
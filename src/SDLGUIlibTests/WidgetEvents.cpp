@@ -31,7 +31,7 @@ TEST_FIXTURE(SDL_fixture, WidgetClickFiresCallback)
 		
 		Widget* w = new Widget();
 
-		boost::signals::scoped_connection c = w->OnClick.connect(parent_callback);
+		ScopedConnection c = w->OnClick.connect(parent_callback);
 		w->HandleEvent(e);
 		CHECK_EQUAL(1, parent_click_count);
 		Widget::ClearRoot();
@@ -52,7 +52,7 @@ TEST_FIXTURE(SDL_fixture, WidgetSecondClickFiresCallback)
 		
 		Widget* w = new Widget();
 
-		boost::signals::scoped_connection c = w->OnFocusedClick.connect(parent_callback);
+		ScopedConnection c = w->OnFocusedClick.connect(parent_callback);
 		w->HandleEvent(e);
 		CHECK_EQUAL(0, parent_click_count);
 		w->HandleEvent(e);
@@ -84,8 +84,8 @@ TEST_FIXTURE(SDL_fixture, HierachalMouseClickHandling)
 		child->SetPosition(Vector2i(40, 5));
 		parent->AddChild(child);
 
-		boost::signals::scoped_connection c = parent->OnClick.connect(parent_callback);
-		boost::signals::scoped_connection c2 = child->OnClick.connect(child_callback);
+		ScopedConnection c = parent->OnClick.connect(parent_callback);
+		ScopedConnection c2 = child->OnClick.connect(child_callback);
 
 		parent->HandleEvent(e);
 		CHECK_EQUAL(1, child_click_count);
@@ -32,7 +32,7 @@ TEST_FIXTURE(SDL_fixture, FlatWidgets)
 		right_bottom->LinkLeft(left_bottom);
 
 
-		boost::signals::scoped_connection c = left->OnGainFocus.connect(widgetevent_callback);
+		ScopedConnection c = left->OnGainFocus.connect(widgetevent_callback);
 		left->SetFocus();
 		CHECK_EQUAL(1, widgetevent_callback_count);
 